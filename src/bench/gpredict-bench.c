@@ -0,0 +1,634 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2012  Alexandru Csete, OZ9AEC.
+
+    Authors: Alexandru Csete <oz9aec@gmail.com>
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+/** \brief Benchmarks of the prediction code.
+ *
+ * gpredict-bench times the functions on the hot paths of gpredict with
+ * fixed satellites, fixed ground stations and a fixed start time, so two
+ * runs on the same machine measure the same work. It is built and run by
+ * "make bench".
+ *
+ * The micro benchmarks run one function on one satellite over one ground
+ * station. The macro benchmarks run a complete prediction of all satellites
+ * over all ground stations, like the pass predictions of a module.
+ *
+ * The results are written to stdout as CSV with one line per benchmark,
+ * satellite and ground station:
+ *
+ *     benchmark,fixture,qth,iterations,ns_per_op,allocs_per_op
+ *
+ * allocs_per_op counts the GLib allocations and is -1 if GLib can not count
+ * them (GLib 2.46 and later ignore g_mem_set_vtable).
+ *
+ * The user configuration is not read; the default settings are used.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <locale.h>
+#include <glib.h>
+#include <glib/gi18n.h>
+#ifdef HAVE_CONFIG_H
+#  include <build-config.h>
+#endif
+#include "sgpsdp/sgp4sdp4.h"
+#include "sat-log.h"
+#include "gtk-sat-data.h"
+#include "qth-data.h"
+#include "orbit-tools.h"
+#include "predict-tools.h"
+#include "sat-vis.h"
+#include "sat-ephem-cache.h"
+
+
+/** \brief Start time of all benchmarks: 2008-09-21 00:00 UTC.
+ *
+ * This is a day after the epochs of the fixtures, so the elements are fresh
+ * and the decaying satellite is still in orbit.
+ */
+#define BENCH_T0         2454730.5
+
+/** \brief Default minimum run time of a benchmark in seconds. */
+#define BENCH_MIN_TIME   0.2
+
+/** \brief Length of the time window of get_passes in days. */
+#define BENCH_PASS_DAYS  1.0
+
+/** \brief Length of the time window of the macro benchmarks in days. */
+#define BENCH_MACRO_DAYS 10.0
+
+
+/** \brief A fixed ground station. */
+typedef struct {
+    const gchar *name;  /*!< Name used in the output */
+    gdouble      lat;   /*!< Latitude in dec. deg. North */
+    gdouble      lon;   /*!< Longitude in dec. deg. East */
+    gint         alt;   /*!< Altitude in meters */
+} bench_qth_t;
+
+
+/** \brief A satellite read from the fixture file. */
+typedef struct {
+    sat_t   *sat;       /*!< The satellite */
+    gchar   *line1;     /*!< First line of the elements */
+    gchar   *line2;     /*!< Second line of the elements */
+} bench_sat_t;
+
+
+/** \brief The data a benchmark works on. */
+typedef struct {
+    bench_sat_t *fixture;  /*!< The satellite, or NULL for the macro benchmarks */
+    qth_t       *qth;      /*!< The ground station */
+    GPtrArray   *sats;     /*!< All satellites (bench_sat_t) */
+    GPtrArray   *qths;     /*!< All ground stations (qth_t) */
+    gdouble      aos;      /*!< An AOS of the satellite after BENCH_T0 */
+    sat_ephem_cache_t *ephem; /*!< Ephemeris cache of the satellite */
+    guint        i;        /*!< Number of the operation */
+} bench_ctx_t;
+
+
+/** \brief A benchmark.
+ *
+ * The run-function performs one operation. Benchmarks that need a satellite
+ * with passes are skipped for satellites that never reach AOS.
+ */
+typedef struct {
+    const gchar  *name;              /*!< Name used in the output */
+    gboolean      macro;             /*!< Runs on all satellites and ground stations */
+    gboolean      needs_aos;         /*!< The satellite must have passes */
+    gboolean      needs_qth;         /*!< The result depends on the ground station */
+    void        (*run) (bench_ctx_t *ctx);  /*!< Performs one operation */
+} bench_t;
+
+
+static void bench_sgp4sdp4      (bench_ctx_t *ctx);
+static void bench_predict_calc  (bench_ctx_t *ctx);
+static void bench_predict_cached (bench_ctx_t *ctx);
+static void bench_find_aos      (bench_ctx_t *ctx);
+static void bench_find_los      (bench_ctx_t *ctx);
+static void bench_get_pass      (bench_ctx_t *ctx);
+static void bench_get_passes    (bench_ctx_t *ctx);
+static void bench_get_sat_vis   (bench_ctx_t *ctx);
+static void bench_footprint     (bench_ctx_t *ctx);
+static void bench_ground_track  (bench_ctx_t *ctx);
+static void bench_tle_parse     (bench_ctx_t *ctx);
+static void bench_macro_passes  (bench_ctx_t *ctx);
+static void bench_macro_summary (bench_ctx_t *ctx);
+
+
+/** \brief The fixed ground stations. */
+static const bench_qth_t qths[] = {
+    { "mid-latitude", 55.6761,   12.5683,   10 },  /* Copenhagen */
+    { "equatorial",   -0.1807,  -78.4678, 2850 },  /* Quito */
+    { "polar",        78.2232,   15.6267,  475 }   /* Svalbard */
+};
+
+
+/** \brief The benchmarks in the order they are run. */
+static const bench_t benchmarks[] = {
+    { "sgp4sdp4",       FALSE, FALSE, FALSE, bench_sgp4sdp4 },
+    { "tle_parse",      FALSE, FALSE, FALSE, bench_tle_parse },
+    { "predict_calc",   FALSE, FALSE, TRUE,  bench_predict_calc },
+    { "predict_cached", FALSE, FALSE, TRUE,  bench_predict_cached },
+    { "get_sat_vis",    FALSE, FALSE, TRUE,  bench_get_sat_vis },
+    { "footprint",      FALSE, FALSE, FALSE, bench_footprint },
+    { "ground_track",   FALSE, FALSE, FALSE, bench_ground_track },
+    { "find_aos",       FALSE, TRUE,  TRUE,  bench_find_aos },
+    { "find_los",       FALSE, TRUE,  TRUE,  bench_find_los },
+    { "get_pass",       FALSE, TRUE,  TRUE,  bench_get_pass },
+    { "get_passes",     FALSE, TRUE,  TRUE,  bench_get_passes },
+    { "passes_10d",     TRUE,  FALSE, TRUE,  bench_macro_passes },
+    { "summaries_10d",  TRUE,  FALSE, TRUE,  bench_macro_summary },
+};
+
+
+/* allocation counter */
+static volatile gint allocs = 0;
+static gboolean      count_allocs = FALSE;
+
+/* command line options */
+static gdouble   mintime  = BENCH_MIN_TIME;
+static gchar    *filter   = NULL;
+
+static GOptionEntry entries[] =
+{
+    { "min-time", 't', 0, G_OPTION_ARG_DOUBLE, &mintime,
+      N_("Minimum run time of each benchmark in seconds (default 0.2)"), N_("SECONDS") },
+    { "filter", 'f', 0, G_OPTION_ARG_STRING, &filter,
+      N_("Only run the benchmarks whose name contains STRING"), N_("STRING") },
+    { NULL }
+};
+
+
+static void       bench_mem_init (void);
+static GPtrArray *bench_load     (const gchar *file);
+static void       bench_run      (const bench_t *bench, bench_ctx_t *ctx,
+                                  const gchar *fixture, const gchar *qth);
+
+
+int main (int argc, char *argv[])
+{
+    GError         *err = NULL;
+    GOptionContext *context;
+    bench_ctx_t     ctx;
+    bench_sat_t    *fixture;
+    GPtrArray      *sats;
+    GPtrArray      *qtharr;
+    qth_t          *qth;
+    guint           b, s, q;
+
+
+    /* must be the first GLib calls so that every allocation is counted */
+    bench_mem_init ();
+
+    setlocale (LC_ALL, "");
+    /* numbers are written with a decimal point in every locale */
+    setlocale (LC_NUMERIC, "C");
+
+    context = g_option_context_new (_("FIXTURES"));
+    g_option_context_add_main_entries (context, entries, GETTEXT_PACKAGE);
+    g_option_context_set_summary (context,
+                                  _("Benchmark the prediction code with the satellites "\
+                                    "in the FIXTURES file (three line elements)."));
+    if (!g_option_context_parse (context, &argc, &argv, &err)) {
+        g_printerr (_("Option parsing failed: %s\n"), err->message);
+        g_clear_error (&err);
+        g_option_context_free (context);
+        return 1;
+    }
+    g_option_context_free (context);
+
+    if (argc != 2) {
+        g_printerr (_("Usage: %s [OPTION...] FIXTURES\n"), argv[0]);
+        return 1;
+    }
+
+    /* the configuration is not loaded, so do not complain about it */
+    sat_log_set_level (SAT_LOG_LEVEL_NONE);
+
+    sats = bench_load (argv[1]);
+    if (sats == NULL || sats->len == 0)
+        return 1;
+
+    qtharr = g_ptr_array_new ();
+    for (q = 0; q < G_N_ELEMENTS (qths); q++) {
+        qth = g_new0 (qth_t, 1);
+        qth_init (qth);
+        qth->name = g_strdup (qths[q].name);
+        qth->lat = qths[q].lat;
+        qth->lon = qths[q].lon;
+        qth->alt = qths[q].alt;
+        g_ptr_array_add (qtharr, qth);
+    }
+
+    memset (&ctx, 0, sizeof (ctx));
+    ctx.sats = sats;
+    ctx.qths = qtharr;
+    ctx.ephem = sat_ephem_cache_new ();
+
+    g_print ("benchmark,fixture,qth,iterations,ns_per_op,allocs_per_op\n");
+
+    for (b = 0; b < G_N_ELEMENTS (benchmarks); b++) {
+
+        if (filter != NULL && strstr (benchmarks[b].name, filter) == NULL)
+            continue;
+
+        if (benchmarks[b].macro) {
+            ctx.fixture = NULL;
+            ctx.qth = NULL;
+            bench_run (&benchmarks[b], &ctx, "all", "all");
+            continue;
+        }
+
+        for (s = 0; s < sats->len; s++) {
+            fixture = g_ptr_array_index (sats, s);
+
+            for (q = 0; q < qtharr->len; q++) {
+                qth = g_ptr_array_index (qtharr, q);
+
+                /* results that do not depend on the QTH are only written once */
+                if (!benchmarks[b].needs_qth && q > 0)
+                    break;
+
+                /* start every benchmark from the same state */
+                predict_calc (fixture->sat, qth, BENCH_T0);
+                sat_ephem_cache_invalidate (ctx.ephem);
+
+                if (benchmarks[b].needs_aos) {
+                    if (!has_aos (fixture->sat, qth))
+                        continue;
+                    ctx.aos = find_aos (fixture->sat, qth, BENCH_T0, BENCH_PASS_DAYS, 0.0);
+                    if (ctx.aos <= 0.0)
+                        continue;
+                }
+
+                ctx.fixture = fixture;
+                ctx.qth = qth;
+                bench_run (&benchmarks[b], &ctx, fixture->sat->nickname,
+                           benchmarks[b].needs_qth ? qth->name : "-");
+            }
+        }
+    }
+
+    for (s = 0; s < sats->len; s++) {
+        fixture = g_ptr_array_index (sats, s);
+        gtk_sat_data_free_sat (fixture->sat);
+        g_free (fixture->line1);
+        g_free (fixture->line2);
+        g_free (fixture);
+    }
+    g_ptr_array_free (sats, TRUE);
+
+    for (q = 0; q < qtharr->len; q++) {
+        qth = g_ptr_array_index (qtharr, q);
+        qth_data_free (qth);
+        g_free (qth);
+    }
+    g_ptr_array_free (qtharr, TRUE);
+    sat_ephem_cache_free (ctx.ephem);
+
+    return 0;
+}
+
+
+/** \brief Run a benchmark and write the result.
+ *  \param bench The benchmark.
+ *  \param ctx The data the benchmark works on.
+ *  \param fixture Name of the satellite in the output.
+ *  \param qth Name of the ground station in the output.
+ *
+ * The number of operations is doubled until they take at least mintime
+ * seconds. The allocations of the final run are counted.
+ */
+static void
+bench_run (const bench_t *bench, bench_ctx_t *ctx, const gchar *fixture, const gchar *qth)
+{
+    GTimer  *timer;
+    gdouble  elapsed;
+    guint    n = 1;
+    guint    i;
+    gint     count;
+
+
+    timer = g_timer_new ();
+
+    /* one untimed operation to warm up the caches */
+    ctx->i = 0;
+    bench->run (ctx);
+
+    for (;;) {
+        g_atomic_int_set (&allocs, 0);
+        g_timer_start (timer);
+
+        for (i = 0; i < n; i++) {
+            ctx->i = i;
+            bench->run (ctx);
+        }
+
+        g_timer_stop (timer);
+        elapsed = g_timer_elapsed (timer, NULL);
+
+        if (elapsed >= mintime || n >= G_MAXUINT / 2)
+            break;
+
+        n *= 2;
+    }
+
+    count = g_atomic_int_get (&allocs);
+    g_timer_destroy (timer);
+
+    if (count_allocs)
+        g_print ("%s,%s,%s,%u,%.1f,%.2f\n", bench->name, fixture, qth, n,
+                 1.0e9 * elapsed / n, (gdouble) count / n);
+    else
+        g_print ("%s,%s,%s,%u,%.1f,-1\n", bench->name, fixture, qth, n,
+                 1.0e9 * elapsed / n);
+}
+
+
+/** \brief Time of operation i; steps through one day in one minute steps. */
+static gdouble
+bench_time (bench_ctx_t *ctx)
+{
+    return BENCH_T0 + (ctx->i % 1440) / 1440.0;
+}
+
+
+/** \brief SGP4 or SDP4, depending on the satellite, at the epoch + i minutes. */
+static void
+bench_sgp4sdp4 (bench_ctx_t *ctx)
+{
+    sat_t *sat = ctx->fixture->sat;
+
+    if (sat->flags & DEEP_SPACE_EPHEM_FLAG)
+        SDP4 (sat, (gdouble) (ctx->i % 1440));
+    else
+        SGP4 (sat, (gdouble) (ctx->i % 1440));
+}
+
+
+/** \brief Convert the elements and initialise a satellite. */
+static void
+bench_tle_parse (bench_ctx_t *ctx)
+{
+    sat_t *sat;
+
+    sat = g_new0 (sat_t, 1);
+    gtk_sat_data_read_tle (ctx->fixture->sat->name, ctx->fixture->line1,
+                           ctx->fixture->line2, sat);
+    gtk_sat_data_free_sat (sat);
+}
+
+
+/** \brief Position of the satellite as seen from the ground station. */
+static void
+bench_predict_calc (bench_ctx_t *ctx)
+{
+    predict_calc (ctx->fixture->sat, ctx->qth, bench_time (ctx));
+}
+
+
+/** \brief Same as predict_calc with the ephemeris cache of a module.
+ *
+ * Steps through one day in one second steps like a module with the default
+ * refresh rate, so the fits of the spans are included in the time.
+ */
+static void
+bench_predict_cached (bench_ctx_t *ctx)
+{
+    obs_frame_t frame;
+
+    predict_init_frame (&frame, ctx->qth, BENCH_T0 + (ctx->i % 86400) / 86400.0);
+    predict_calc_cached (ctx->fixture->sat, ctx->ephem, &frame);
+}
+
+
+/** \brief Visibility of the satellite. */
+static void
+bench_get_sat_vis (bench_ctx_t *ctx)
+{
+    gdouble t = bench_time (ctx);
+
+    predict_calc (ctx->fixture->sat, ctx->qth, t);
+    get_sat_vis (ctx->fixture->sat, ctx->qth, t);
+}
+
+
+/** \brief Range circle at the start time; the sat is calculated by main. */
+static void
+bench_footprint (bench_ctx_t *ctx)
+{
+    gdouble lat[180], lon[180];
+
+    footprint_points (ctx->fixture->sat, lat, lon);
+}
+
+
+/** \brief Ground track of one orbit. */
+static void
+bench_ground_track (bench_ctx_t *ctx)
+{
+    GSList *track;
+
+    track = predict_ground_track (ctx->fixture->sat, ctx->qth, BENCH_T0, 1);
+    g_slist_foreach (track, (GFunc) g_free, NULL);
+    g_slist_free (track);
+}
+
+
+/** \brief Next AOS after the start time. */
+static void
+bench_find_aos (bench_ctx_t *ctx)
+{
+    find_aos (ctx->fixture->sat, ctx->qth, BENCH_T0, BENCH_PASS_DAYS, 0.0);
+}
+
+
+/** \brief LOS of the first pass after the start time. */
+static void
+bench_find_los (bench_ctx_t *ctx)
+{
+    find_los (ctx->fixture->sat, ctx->qth, ctx->aos + 0.0001, BENCH_PASS_DAYS, 0.0);
+}
+
+
+/** \brief First pass after the start time, with details. */
+static void
+bench_get_pass (bench_ctx_t *ctx)
+{
+    free_pass (get_pass (ctx->fixture->sat, ctx->qth, BENCH_T0, BENCH_PASS_DAYS));
+}
+
+
+/** \brief All passes of one day, with details. */
+static void
+bench_get_passes (bench_ctx_t *ctx)
+{
+    free_passes (get_passes (ctx->fixture->sat, ctx->qth, BENCH_T0,
+                             BENCH_PASS_DAYS, G_MAXINT));
+}
+
+
+/** \brief Passes with details of all satellites over all ground stations. */
+static void
+bench_macro_passes (bench_ctx_t *ctx)
+{
+    bench_sat_t *fixture;
+    guint        s, q;
+
+    for (s = 0; s < ctx->sats->len; s++) {
+        fixture = g_ptr_array_index (ctx->sats, s);
+        for (q = 0; q < ctx->qths->len; q++)
+            free_passes (get_passes (fixture->sat, g_ptr_array_index (ctx->qths, q),
+                                     BENCH_T0, BENCH_MACRO_DAYS, G_MAXINT));
+    }
+}
+
+
+/** \brief Pass summaries of all satellites over all ground stations. */
+static void
+bench_macro_summary (bench_ctx_t *ctx)
+{
+    bench_sat_t *fixture;
+    guint        s, q;
+
+    for (s = 0; s < ctx->sats->len; s++) {
+        fixture = g_ptr_array_index (ctx->sats, s);
+        for (q = 0; q < ctx->qths->len; q++)
+            free_passes (get_passes_summary (fixture->sat, g_ptr_array_index (ctx->qths, q),
+                                             BENCH_T0, BENCH_MACRO_DAYS, G_MAXINT));
+    }
+}
+
+
+/** \brief Read the fixtures.
+ *  \param file The file with three line elements.
+ *  \return The satellites (bench_sat_t), or NULL if the file can not be read.
+ */
+static GPtrArray *
+bench_load (const gchar *file)
+{
+    GError      *error = NULL;
+    GPtrArray   *sats;
+    bench_sat_t *fixture;
+    gchar       *contents;
+    gchar      **lines;
+    guint        i;
+
+
+    if (!g_file_get_contents (file, &contents, NULL, &error)) {
+        g_printerr (_("Could not read %s (%s)\n"), file, error->message);
+        g_clear_error (&error);
+        return NULL;
+    }
+
+    lines = g_strsplit (contents, "\n", 0);
+    g_free (contents);
+
+    sats = g_ptr_array_new ();
+
+    for (i = 0; lines[i] != NULL && lines[i+1] != NULL && lines[i+2] != NULL; i += 3) {
+        g_strstrip (lines[i]);
+        g_strchomp (lines[i+1]);
+        g_strchomp (lines[i+2]);
+
+        fixture = g_new0 (bench_sat_t, 1);
+        fixture->sat = g_new0 (sat_t, 1);
+        fixture->line1 = g_strdup (lines[i+1]);
+        fixture->line2 = g_strdup (lines[i+2]);
+
+        if (gtk_sat_data_read_tle (lines[i], fixture->line1, fixture->line2, fixture->sat)) {
+            g_printerr (_("Skipping %s: the elements could not be read\n"), lines[i]);
+            gtk_sat_data_free_sat (fixture->sat);
+            g_free (fixture->line1);
+            g_free (fixture->line2);
+            g_free (fixture);
+            continue;
+        }
+
+        g_ptr_array_add (sats, fixture);
+    }
+
+    g_strfreev (lines);
+
+    return sats;
+}
+
+
+#if !GLIB_CHECK_VERSION(2,46,0)
+/* GLib memory functions that count the allocations */
+static gpointer
+bench_malloc (gsize n_bytes)
+{
+    g_atomic_int_inc (&allocs);
+    return malloc (n_bytes);
+}
+
+static gpointer
+bench_realloc (gpointer mem, gsize n_bytes)
+{
+    g_atomic_int_inc (&allocs);
+    return realloc (mem, n_bytes);
+}
+
+static gpointer
+bench_calloc (gsize n_blocks, gsize n_block_bytes)
+{
+    g_atomic_int_inc (&allocs);
+    return calloc (n_blocks, n_block_bytes);
+}
+#endif
+
+
+/** \brief Install the allocation counter.
+ *
+ * g_slice is told to use g_malloc, so the list nodes are counted too.
+ * GLib 2.46 and later always use the system allocator; the allocations
+ * are then not counted.
+ */
+static void
+bench_mem_init (void)
+{
+#if !GLIB_CHECK_VERSION(2,46,0)
+    static GMemVTable vtable = {
+        bench_malloc,
+        bench_realloc,
+        free,
+        bench_calloc,
+        bench_malloc,
+        bench_realloc
+    };
+
+    g_setenv ("G_SLICE", "always-malloc", TRUE);
+    g_mem_set_vtable (&vtable);
+
+    /* check that the vtable is used */
+    g_free (g_malloc (1));
+    count_allocs = (g_atomic_int_get (&allocs) > 0);
+#endif
+}
@@ -0,0 +1,58 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2012  Alexandru Csete, OZ9AEC.
+
+    Authors: Alexandru Csete <oz9aec@gmail.com>
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+#ifndef DOPPLER_CURVE_H
+#define DOPPLER_CURVE_H 1
+
+#include <glib.h>
+#include "sgpsdp/sgp4sdp4.h"
+#include "qth-data.h"
+
+
+/** \brief Range rate of a satellite over a time window.
+ *
+ * The points are equally spaced in time, so the range rate at any time is
+ * found by indexing and linear interpolation.
+ */
+typedef struct {
+    gdouble   start;  /*!< Time of the first point (Julian date) */
+    gdouble   end;    /*!< Time of the last point (Julian date) */
+    gdouble   step;   /*!< Time between two points [days] */
+    guint     num;    /*!< Number of points */
+    gdouble  *rr;     /*!< Range rate of each point [km/sec] */
+    gdouble   epoch;  /*!< Epoch of the TLE the curve was computed with */
+} doppler_curve_t;
+
+
+doppler_curve_t *doppler_curve_new  (sat_t *sat, qth_t *qth,
+                                     gdouble start, gdouble end);
+gboolean         doppler_curve_get  (doppler_curve_t *curve, gdouble t,
+                                     gdouble *rr);
+void             doppler_curve_free (doppler_curve_t *curve);
+
+
+#endif
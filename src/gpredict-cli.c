@@ -0,0 +1,759 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2012  Alexandru Csete, OZ9AEC.
+
+    Authors: Alexandru Csete <oz9aec@gmail.com>
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+/** \brief Headless pass predictor.
+ *
+ * gpredict-cli predicts the passes of a set of satellites over a ground
+ * station and writes them as CSV or JSON Lines. It uses the configuration,
+ * the QTH files, the modules and the satellite data of gpredict, so the
+ * passes are the same as in the pass dialogs of the GUI.
+ *
+ * The satellites are predicted in chunks by the pass service. A few chunks
+ * are in flight at any time and each chunk is written and freed as soon as
+ * it and all earlier chunks are done, so the output does not depend on the
+ * number of threads and the memory use does not grow with the number of
+ * satellites.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <locale.h>
+#include <glib.h>
+#include <glib/gi18n.h>
+#include <glib/gstdio.h>
+#ifdef HAVE_CONFIG_H
+#  include <build-config.h>
+#endif
+#include "sgpsdp/sgp4sdp4.h"
+#include "sat-log.h"
+#include "sat-cfg.h"
+#include "config-keys.h"
+#include "compat.h"
+#include "mod-cfg-get-param.h"
+#include "gtk-sat-data.h"
+#include "qth-data.h"
+#include "time-tools.h"
+#include "predict-tools.h"
+#include "pass-service.h"
+
+
+/** \brief Number of satellites per pass job and thread. */
+#define CLI_CHUNK_PER_THREAD   8
+
+/** \brief Number of pass jobs in flight. */
+#define CLI_JOBS               3
+
+
+/** \brief Output formats. */
+typedef enum {
+    CLI_FORMAT_CSV = 0,   /*!< Comma separated values with a header line */
+    CLI_FORMAT_JSONL      /*!< One JSON object per line */
+} cli_format_t;
+
+
+/** \brief State of a prediction run. */
+typedef struct {
+    GPtrArray     *sats;     /*!< The satellites (sat_t) in output order */
+    qth_t          qth;      /*!< The ground station */
+    pass_filter_t  filter;   /*!< Filters passed to the pass jobs */
+    gdouble        start;    /*!< Start of the time window */
+    gdouble        end;      /*!< End of the time window */
+    guint          chunk;    /*!< Number of satellites per pass job */
+    guint          next;     /*!< Index of the first satellite not in a job */
+    GQueue        *jobs;     /*!< Running jobs (cli_job_t) in output order */
+    cli_format_t   format;   /*!< Output format */
+    gchar         *timefmt;  /*!< strftime format of the times */
+    FILE          *out;      /*!< Output stream */
+    guint          count;    /*!< Number of passes written */
+    GMainLoop     *loop;     /*!< Main loop running the pass jobs */
+} cli_t;
+
+
+/** \brief A pass job and the satellites it predicts. */
+typedef struct {
+    cli_t      *cli;    /*!< The prediction run */
+    pass_job_t *job;    /*!< The job */
+    guint       first;  /*!< Index of the first satellite of the job */
+    guint       num;    /*!< Number of satellites in the job */
+    gboolean    done;   /*!< The job is done but not written yet */
+} cli_job_t;
+
+
+/* command line options */
+static gchar    *qthfile   = NULL;
+static gchar   **modfiles  = NULL;
+static gchar   **satfiles  = NULL;
+static gchar   **tlefiles  = NULL;
+static gchar   **catnums   = NULL;
+static gchar    *startstr  = NULL;
+static gchar    *endstr    = NULL;
+static gint      days      = 0;
+static gint      numpass   = 0;
+static gdouble   minel     = -1.0;
+static gboolean  visible   = FALSE;
+static gchar    *formatstr = NULL;
+static gchar    *timefmt   = NULL;
+static gchar    *outfile   = NULL;
+static gint      threads   = 0;
+static gboolean  verbose   = FALSE;
+
+
+/** \brief Command line options. */
+static GOptionEntry entries[] =
+{
+  { "qth", 'q', 0, G_OPTION_ARG_FILENAME, &qthfile, "Ground station (.qth) file; default is the QTH of the first module or the default QTH", "FILE" },
+  { "module", 'm', 0, G_OPTION_ARG_FILENAME_ARRAY, &modfiles, "Predict the satellites of a module (.mod) file", "FILE" },
+  { "sat", 's', 0, G_OPTION_ARG_FILENAME_ARRAY, &satfiles, "Predict the satellite in a .sat file", "FILE" },
+  { "tle", 't', 0, G_OPTION_ARG_FILENAME_ARRAY, &tlefiles, "Predict the satellites in a NASA two-line element file", "FILE" },
+  { "catnum", 'c', 0, G_OPTION_ARG_STRING_ARRAY, &catnums, "Predict a satellite from the gpredict satellite data", "NUM" },
+  { "start", 'b', 0, G_OPTION_ARG_STRING, &startstr, "Start of the time window in UTC; default is now", "\"YYYY-MM-DD [HH:MM[:SS]]\"" },
+  { "end", 'e', 0, G_OPTION_ARG_STRING, &endstr, "End of the time window in UTC; passes start before it", "\"YYYY-MM-DD [HH:MM[:SS]]\"" },
+  { "days", 'd', 0, G_OPTION_ARG_INT, &days, "Length of the time window if no end is given; default is the look-ahead of the pass predictions", "DAYS" },
+  { "num", 'n', 0, G_OPTION_ARG_INT, &numpass, "Maximum number of passes per satellite; default is no limit", "NUM" },
+  { "min-el", 'l', 0, G_OPTION_ARG_DOUBLE, &minel, "Minimum elevation of the passes; default is the configured minimum", "DEG" },
+  { "visible", 'V', 0, G_OPTION_ARG_NONE, &visible, "Only write passes during which the satellite is visible", NULL },
+  { "format", 'f', 0, G_OPTION_ARG_STRING, &formatstr, "Output format: csv (default) or jsonl", "FORMAT" },
+  { "time-format", 'T', 0, G_OPTION_ARG_STRING, &timefmt, "strftime format of the times; default is the configured time format", "FORMAT" },
+  { "output", 'o', 0, G_OPTION_ARG_FILENAME, &outfile, "Write to a file instead of the standard output", "FILE" },
+  { "threads", 'j', 0, G_OPTION_ARG_INT, &threads, "Number of prediction threads; default is one per CPU", "NUM" },
+  { "verbose", 'v', 0, G_OPTION_ARG_NONE, &verbose, "Log with the configured log level instead of errors only", NULL },
+  { NULL }
+};
+
+
+static gboolean cli_parse_time   (const gchar *str, gdouble *t);
+static gboolean cli_load_qth     (qth_t *qth);
+static void     cli_load_module  (const gchar *file, GPtrArray *sats);
+static void     cli_load_tle     (const gchar *file, GPtrArray *sats);
+static void     cli_add_sat      (GPtrArray *sats, sat_t *sat, gint err, const gchar *source);
+static void     cli_fill         (cli_t *cli);
+static void     cli_job_done     (pass_job_t *job, gpointer data);
+static void     cli_write_header (cli_t *cli);
+static void     cli_write_passes (cli_t *cli, sat_t *sat, GSList *passes);
+static void     cli_write_csv_str  (FILE *out, const gchar *str);
+static void     cli_write_json_str (FILE *out, const gchar *str);
+
+
+int main (int argc, char *argv[])
+{
+    GError         *err = NULL;
+    GOptionContext *context;
+    cli_t           cli;
+    sat_t          *sat;
+    gchar          *end;
+    guint           i;
+    gint            ret = 0;
+
+
+    setlocale (LC_ALL, "");
+    /* numbers are written with a decimal point in every locale */
+    setlocale (LC_NUMERIC, "C");
+
+#ifdef ENABLE_NLS
+    bindtextdomain (PACKAGE, PACKAGE_LOCALE_DIR);
+    bind_textdomain_codeset (PACKAGE, "UTF-8");
+    textdomain (PACKAGE);
+#endif
+
+    context = g_option_context_new ("");
+    g_option_context_add_main_entries (context, entries, GETTEXT_PACKAGE);
+    g_option_context_set_summary (context,
+                                  _("Predict the passes of satellites over a ground station "\
+                                    "and write them as CSV or JSON Lines.\n"\
+                                    "The configuration and the satellite data of gpredict are used, "\
+                                    "so the passes are the same as in the pass dialogs."));
+    if (!g_option_context_parse (context, &argc, &argv, &err)) {
+        g_printerr (_("Option parsing failed: %s\n"), err->message);
+        g_clear_error (&err);
+        g_option_context_free (context);
+        return 1;
+    }
+    g_option_context_free (context);
+
+    if (!g_thread_supported ())
+        g_thread_init (NULL);
+
+    /* errors go to stderr; the log file of the GUI is left alone */
+    sat_cfg_load ();
+    if (verbose)
+        sat_log_set_level (sat_cfg_get_int (SAT_CFG_INT_LOG_LEVEL));
+    else
+        sat_log_set_level (SAT_LOG_LEVEL_ERROR);
+
+    memset (&cli, 0, sizeof (cli));
+
+    /* output format */
+    if (formatstr == NULL || !g_ascii_strcasecmp (formatstr, "csv"))
+        cli.format = CLI_FORMAT_CSV;
+    else if (!g_ascii_strcasecmp (formatstr, "jsonl") || !g_ascii_strcasecmp (formatstr, "json"))
+        cli.format = CLI_FORMAT_JSONL;
+    else {
+        g_printerr (_("Unknown output format: %s\n"), formatstr);
+        return 1;
+    }
+
+    /* time window */
+    if (startstr != NULL) {
+        if (!cli_parse_time (startstr, &cli.start)) {
+            g_printerr (_("Invalid start time: %s\n"), startstr);
+            return 1;
+        }
+    }
+    else
+        cli.start = get_current_daynum ();
+
+    if (endstr != NULL) {
+        if (!cli_parse_time (endstr, &cli.end)) {
+            g_printerr (_("Invalid end time: %s\n"), endstr);
+            return 1;
+        }
+    }
+    else if (days > 0)
+        cli.end = cli.start + days;
+    else
+        cli.end = cli.start + sat_cfg_get_int (SAT_CFG_INT_PRED_LOOK_AHEAD);
+
+    if (cli.end <= cli.start) {
+        g_printerr (_("The end of the time window is before its start\n"));
+        return 1;
+    }
+
+    /* ground station */
+    qth_init (&cli.qth);
+    if (!cli_load_qth (&cli.qth))
+        return 1;
+
+    /* satellites of the modules, .sat files, TLE files and catalog numbers,
+       each in the order of the command line */
+    cli.sats = g_ptr_array_new ();
+
+    for (i = 0; modfiles != NULL && modfiles[i] != NULL; i++)
+        cli_load_module (modfiles[i], cli.sats);
+
+    for (i = 0; satfiles != NULL && satfiles[i] != NULL; i++) {
+        sat = g_new0 (sat_t, 1);
+        cli_add_sat (cli.sats, sat, gtk_sat_data_read_sat_file (satfiles[i], sat), satfiles[i]);
+    }
+
+    for (i = 0; tlefiles != NULL && tlefiles[i] != NULL; i++)
+        cli_load_tle (tlefiles[i], cli.sats);
+
+    for (i = 0; catnums != NULL && catnums[i] != NULL; i++) {
+        gint catnum = (gint) g_ascii_strtoll (catnums[i], &end, 10);
+
+        if (*end != '\0' || catnum <= 0) {
+            g_printerr (_("Invalid catalog number: %s\n"), catnums[i]);
+            continue;
+        }
+        sat = g_new0 (sat_t, 1);
+        cli_add_sat (cli.sats, sat, gtk_sat_data_read_sat (catnum, sat), catnums[i]);
+    }
+
+    if (cli.sats->len == 0) {
+        g_printerr (_("No satellites to predict; use --module, --sat, --tle or --catnum\n"));
+        return 1;
+    }
+
+    /* filters; the defaults are those of the pass dialogs, except that the
+       number of passes is only limited by the time window */
+    cli.filter.num = (numpass > 0) ? (guint) numpass : G_MAXINT;
+    cli.filter.min_el = (minel >= 0.0) ? minel : sat_cfg_get_int (SAT_CFG_INT_PRED_MIN_EL);
+    cli.filter.visible = visible;
+    cli.filter.summary = FALSE;
+
+    cli.timefmt = (timefmt != NULL) ? g_strdup (timefmt) : sat_cfg_get_str (SAT_CFG_STR_TIME_FORMAT);
+
+    /* output */
+    if (outfile != NULL) {
+        cli.out = g_fopen (outfile, "w");
+        if (cli.out == NULL) {
+            g_printerr (_("Could not open %s for writing\n"), outfile);
+            return 1;
+        }
+    }
+    else
+        cli.out = stdout;
+
+    if (threads > 0)
+        pass_service_set_threads (threads);
+#if GLIB_CHECK_VERSION(2,36,0)
+    else
+        threads = g_get_num_processors ();
+#else
+    else
+        threads = 4;
+#endif
+    cli.chunk = CLI_CHUNK_PER_THREAD * threads;
+
+    cli_write_header (&cli);
+
+    /* the pass jobs report to the main loop */
+    cli.jobs = g_queue_new ();
+    cli.loop = g_main_loop_new (NULL, FALSE);
+    cli_fill (&cli);
+    if (!g_queue_is_empty (cli.jobs))
+        g_main_loop_run (cli.loop);
+    g_main_loop_unref (cli.loop);
+    g_queue_free (cli.jobs);
+
+    if (fflush (cli.out) != 0 || ferror (cli.out)) {
+        g_printerr (_("Error writing the passes\n"));
+        ret = 1;
+    }
+    if (cli.out != stdout)
+        fclose (cli.out);
+
+    sat_log_log (SAT_LOG_LEVEL_INFO,
+                 _("%s: Wrote %d passes of %d satellites"),
+                 __FUNCTION__, cli.count, cli.sats->len);
+
+    for (i = 0; i < cli.sats->len; i++)
+        gtk_sat_data_free_sat (g_ptr_array_index (cli.sats, i));
+    g_ptr_array_free (cli.sats, TRUE);
+    g_free (cli.timefmt);
+    qth_data_free (&cli.qth);
+    sat_cfg_close ();
+
+    return ret;
+}
+
+
+/** \brief Parse a UTC time.
+ *  \param str The time as "YYYY-MM-DD", "YYYY-MM-DD HH:MM" or
+ *             "YYYY-MM-DD HH:MM:SS"; a T may separate the date and time.
+ *  \param t Where the Julian date is stored.
+ *  \return TRUE if the time is valid.
+ */
+static gboolean
+cli_parse_time (const gchar *str, gdouble *t)
+{
+    struct tm tm;
+    gint      n;
+
+
+    memset (&tm, 0, sizeof (tm));
+
+    n = sscanf (str, "%d-%d-%d%*[ T]%d:%d:%d",
+                &tm.tm_year, &tm.tm_mon, &tm.tm_mday,
+                &tm.tm_hour, &tm.tm_min, &tm.tm_sec);
+
+    if (n != 3 && n != 5 && n != 6)
+        return FALSE;
+
+    if (tm.tm_mon < 1 || tm.tm_mon > 12 || tm.tm_mday < 1 || tm.tm_mday > 31 ||
+        tm.tm_hour < 0 || tm.tm_hour > 23 || tm.tm_min < 0 || tm.tm_min > 59 ||
+        tm.tm_sec < 0 || tm.tm_sec > 60)
+        return FALSE;
+
+    /* Julian_Date expects the full year and months starting at 1 */
+    *t = Julian_Date (&tm);
+
+    return TRUE;
+}
+
+
+/** \brief Load the ground station.
+ *
+ * The QTH is read from --qth, the QTH of the first module or the default
+ * QTH, in this order. Unlike the GUI, there is no fallback to built-in
+ * values, since passes for a wrong location are worse than no passes.
+ */
+static gboolean
+cli_load_qth (qth_t *qth)
+{
+    GKeyFile *cfg;
+    gchar    *confdir, *buffer, *file;
+    gboolean  ok;
+
+
+    if (qthfile != NULL) {
+        file = g_strdup (qthfile);
+    }
+    else {
+        buffer = NULL;
+
+        if (modfiles != NULL && modfiles[0] != NULL) {
+            cfg = g_key_file_new ();
+            g_key_file_set_list_separator (cfg, ';');
+            if (g_key_file_load_from_file (cfg, modfiles[0], G_KEY_FILE_NONE, NULL))
+                buffer = mod_cfg_get_str (cfg,
+                                          MOD_CFG_GLOBAL_SECTION,
+                                          MOD_CFG_QTH_FILE_KEY,
+                                          SAT_CFG_STR_DEF_QTH);
+            g_key_file_free (cfg);
+        }
+
+        if (buffer == NULL)
+            buffer = sat_cfg_get_str (SAT_CFG_STR_DEF_QTH);
+
+        confdir = get_user_conf_dir ();
+        file = g_strconcat (confdir, G_DIR_SEPARATOR_S, buffer, NULL);
+        g_free (confdir);
+        g_free (buffer);
+    }
+
+    ok = qth_data_read (file, qth);
+    if (!ok)
+        g_printerr (_("Could not read the QTH file %s\n"), file);
+
+    g_free (file);
+
+    return ok;
+}
+
+
+/** \brief Load the satellites of a module.
+ *  \param file The .mod file.
+ *  \param sats The array to add the satellites to.
+ */
+static void
+cli_load_module (const gchar *file, GPtrArray *sats)
+{
+    GKeyFile *cfg;
+    GError   *error = NULL;
+    gint     *catnums;
+    gsize     length;
+    gchar    *source;
+    sat_t    *sat;
+    guint     i, j;
+
+
+    cfg = g_key_file_new ();
+    g_key_file_set_list_separator (cfg, ';');
+
+    if (!g_key_file_load_from_file (cfg, file, G_KEY_FILE_NONE, &error)) {
+        sat_log_log (SAT_LOG_LEVEL_ERROR,
+                     _("%s: Could not load config data from %s (%s)."),
+                     __FUNCTION__, file, error->message);
+        g_clear_error (&error);
+        g_key_file_free (cfg);
+        return;
+    }
+
+    catnums = g_key_file_get_integer_list (cfg,
+                                           MOD_CFG_GLOBAL_SECTION,
+                                           MOD_CFG_SATS_KEY,
+                                           &length,
+                                           &error);
+    if (error != NULL) {
+        sat_log_log (SAT_LOG_LEVEL_ERROR,
+                     _("%s: Failed to get list of satellites from %s (%s)"),
+                     __FUNCTION__, file, error->message);
+        g_clear_error (&error);
+        length = 0;
+    }
+
+    for (i = 0; i < length; i++) {
+        /* like in the GUI, a satellite is in a module only once */
+        for (j = 0; j < i && catnums[j] != catnums[i]; j++);
+        if (j < i)
+            continue;
+
+        sat = g_new0 (sat_t, 1);
+        source = g_strdup_printf ("%s #%d", file, catnums[i]);
+        cli_add_sat (sats, sat, gtk_sat_data_read_sat (catnums[i], sat), source);
+        g_free (source);
+    }
+
+    g_free (catnums);
+    g_key_file_free (cfg);
+}
+
+
+/** \brief Load the satellites of a NASA two-line element file.
+ *  \param file The file.
+ *  \param sats The array to add the satellites to.
+ *
+ * Both the two-line and the three-line format are accepted; in the latter
+ * the line before the elements is the name of the satellite.
+ */
+static void
+cli_load_tle (const gchar *file, GPtrArray *sats)
+{
+    GError  *error = NULL;
+    gchar   *contents;
+    gchar  **lines;
+    gchar   *name;
+    sat_t   *sat;
+    guint    i;
+
+
+    if (!g_file_get_contents (file, &contents, NULL, &error)) {
+        sat_log_log (SAT_LOG_LEVEL_ERROR,
+                     _("%s: Could not read %s (%s)"),
+                     __FUNCTION__, file, error->message);
+        g_clear_error (&error);
+        return;
+    }
+
+    lines = g_strsplit (contents, "\n", 0);
+    g_free (contents);
+
+    name = NULL;
+    for (i = 0; lines[i] != NULL; i++) {
+        /* strip the carriage returns of DOS files and trailing blanks */
+        g_strchomp (lines[i]);
+
+        if (lines[i][0] == '1' && lines[i+1] != NULL) {
+            g_strchomp (lines[i+1]);
+
+            if (lines[i+1][0] == '2') {
+                sat = g_new0 (sat_t, 1);
+                cli_add_sat (sats, sat,
+                             gtk_sat_data_read_tle (name, lines[i], lines[i+1], sat),
+                             file);
+                name = NULL;
+                i++;
+                continue;
+            }
+        }
+
+        name = (lines[i][0] != '\0') ? g_strstrip (lines[i]) : NULL;
+    }
+
+    g_strfreev (lines);
+}
+
+
+/** \brief Add a satellite that has been read.
+ *  \param sats The satellites.
+ *  \param sat The satellite.
+ *  \param err The return value of the function that read the satellite.
+ *  \param source The file or number the satellite was read from.
+ *
+ * Satellites that could not be read are reported and freed.
+ */
+static void
+cli_add_sat (GPtrArray *sats, sat_t *sat, gint err, const gchar *source)
+{
+    if (err) {
+        g_printerr (_("Skipping %s: the satellite data could not be read\n"), source);
+        g_free (sat->name);
+        g_free (sat->nickname);
+        g_free (sat->website);
+        g_free (sat);
+        return;
+    }
+
+    g_ptr_array_add (sats, sat);
+}
+
+
+/** \brief Start pass jobs until CLI_JOBS are running.
+ *
+ * Quits the main loop when all satellites have been predicted and written.
+ */
+static void
+cli_fill (cli_t *cli)
+{
+    cli_job_t *cjob;
+    guint      i;
+
+
+    while (g_queue_get_length (cli->jobs) < CLI_JOBS && cli->next < cli->sats->len) {
+        cjob = g_new0 (cli_job_t, 1);
+        cjob->cli = cli;
+        cjob->first = cli->next;
+        cjob->num = MIN (cli->chunk, cli->sats->len - cli->next);
+        cjob->job = pass_job_new (&cli->qth, &cli->filter, NULL, cli_job_done, cjob);
+
+        for (i = 0; i < cjob->num; i++)
+            pass_job_add (cjob->job, g_ptr_array_index (cli->sats, cjob->first + i),
+                          cli->start, cli->end);
+
+        cli->next += cjob->num;
+        g_queue_push_tail (cli->jobs, cjob);
+        pass_job_start (cjob->job);
+    }
+
+    if (g_queue_is_empty (cli->jobs))
+        g_main_loop_quit (cli->loop);
+}
+
+
+/** \brief Write the jobs that are done, in order.
+ *
+ * Jobs that are done before an earlier job wait in the queue.
+ */
+static void
+cli_job_done (pass_job_t *job, gpointer data)
+{
+    cli_job_t *cjob = (cli_job_t *) data;
+    cli_t     *cli = cjob->cli;
+    GSList    *passes;
+    guint      i;
+
+    (void) job; /* avoid unused parameter compiler warning */
+
+    cjob->done = TRUE;
+
+    while (!g_queue_is_empty (cli->jobs) &&
+           ((cli_job_t *) g_queue_peek_head (cli->jobs))->done) {
+
+        cjob = g_queue_pop_head (cli->jobs);
+
+        for (i = 0; i < cjob->num; i++) {
+            passes = pass_job_steal_passes (cjob->job, i);
+            cli_write_passes (cli, g_ptr_array_index (cli->sats, cjob->first + i), passes);
+            free_passes (passes);
+        }
+
+        pass_job_free (cjob->job);
+        g_free (cjob);
+
+        /* keep the workers busy while the next job is waited for */
+        cli_fill (cli);
+    }
+}
+
+
+/** \brief Write the CSV header line. */
+static void
+cli_write_header (cli_t *cli)
+{
+    if (cli->format == CLI_FORMAT_CSV)
+        fputs ("satellite,catnum,aos,tca,los,duration,max_el,aos_az,max_el_az,los_az,orbit,visibility\n",
+               cli->out);
+}
+
+
+/** \brief Write the passes of a satellite.
+ *  \param cli The prediction run.
+ *  \param sat The satellite.
+ *  \param passes The passes.
+ *
+ * The values are formatted like in the multi-pass dialog.
+ */
+static void
+cli_write_passes (cli_t *cli, sat_t *sat, GSList *passes)
+{
+    gchar    aos[TIME_FORMAT_MAX_LENGTH];
+    gchar    tca[TIME_FORMAT_MAX_LENGTH];
+    gchar    los[TIME_FORMAT_MAX_LENGTH];
+    gchar    dur[16];
+    pass_t  *pass;
+    guint    h, m, s;
+
+
+    for ( ; passes != NULL; passes = passes->next) {
+        pass = PASS (passes->data);
+
+        /* the last search may find a pass that starts after the window */
+        if (pass->aos >= cli->end)
+            break;
+
+        daynum_to_str (aos, TIME_FORMAT_MAX_LENGTH, cli->timefmt, pass->aos);
+        daynum_to_str (tca, TIME_FORMAT_MAX_LENGTH, cli->timefmt, pass->tca);
+        daynum_to_str (los, TIME_FORMAT_MAX_LENGTH, cli->timefmt, pass->los);
+
+        /* duration */
+        s = (guint) ((pass->los - pass->aos) * 86400);
+        h = s / 3600;
+        s -= 3600 * h;
+        m = s / 60;
+        s -= 60 * m;
+        g_snprintf (dur, sizeof (dur), "%02d:%02d:%02d", h, m, s);
+
+        if (cli->format == CLI_FORMAT_CSV) {
+            cli_write_csv_str (cli->out, sat->nickname);
+            fprintf (cli->out, ",%d,", sat->tle.catnr);
+            cli_write_csv_str (cli->out, aos);
+            fputc (',', cli->out);
+            cli_write_csv_str (cli->out, tca);
+            fputc (',', cli->out);
+            cli_write_csv_str (cli->out, los);
+            fprintf (cli->out, ",%s,%.2f,%.2f,%.2f,%.2f,%d,%s\n",
+                     dur, pass->max_el, pass->aos_az, pass->maxel_az, pass->los_az,
+                     pass->orbit, pass->vis);
+        }
+        else {
+            fputs ("{\"satellite\":", cli->out);
+            cli_write_json_str (cli->out, sat->nickname);
+            fprintf (cli->out, ",\"catnum\":%d,\"aos\":", sat->tle.catnr);
+            cli_write_json_str (cli->out, aos);
+            fputs (",\"tca\":", cli->out);
+            cli_write_json_str (cli->out, tca);
+            fputs (",\"los\":", cli->out);
+            cli_write_json_str (cli->out, los);
+            fprintf (cli->out,
+                     ",\"duration\":\"%s\",\"max_el\":%.2f,\"aos_az\":%.2f,"
+                     "\"max_el_az\":%.2f,\"los_az\":%.2f,\"orbit\":%d,\"visibility\":\"%s\"}\n",
+                     dur, pass->max_el, pass->aos_az, pass->maxel_az, pass->los_az,
+                     pass->orbit, pass->vis);
+        }
+
+        cli->count++;
+    }
+}
+
+
+/** \brief Write a CSV field, quoted if necessary. */
+static void
+cli_write_csv_str (FILE *out, const gchar *str)
+{
+    const gchar *p;
+
+    if (str == NULL)
+        return;
+
+    if (strpbrk (str, ",\"\r\n") == NULL) {
+        fputs (str, out);
+        return;
+    }
+
+    fputc ('"', out);
+    for (p = str; *p != '\0'; p++) {
+        if (*p == '"')
+            fputc ('"', out);
+        fputc (*p, out);
+    }
+    fputc ('"', out);
+}
+
+
+/** \brief Write a JSON string. */
+static void
+cli_write_json_str (FILE *out, const gchar *str)
+{
+    const gchar *p;
+
+    if (str == NULL) {
+        fputs ("null", out);
+        return;
+    }
+
+    fputc ('"', out);
+    for (p = str; *p != '\0'; p++) {
+        if (*p == '"' || *p == '\\')
+            fprintf (out, "\\%c", *p);
+        else if ((guchar) *p < 0x20)
+            fprintf (out, "\\u%04x", (guchar) *p);
+        else
+            fputc (*p, out);
+    }
+    fputc ('"', out);
+}
@@ -181,9 +181,9 @@ gtk_azel_plot_new (qth_t *qth, pass_t *pass)
      GTK_AZEL_PLOT (polv)->cursinfo = TRUE;
 
      /* check maximum Az */
-     n = g_slist_length (pass->details);
+     n = get_pass_num_details (pass);
      for (i = 0; i < n; i++) {
-          detail = PASS_DETAIL (g_slist_nth_data (pass->details, i));
+          detail = get_pass_detail (pass, i);
 
           if (detail->az > GTK_AZEL_PLOT (polv)->maxaz) {
                GTK_AZEL_PLOT (polv)->maxaz = detail->az;
@@ -552,11 +552,11 @@ size_allocate_cb (GtkWidget *widget, GtkAllocation *allocation, gpointer data)
                            NULL);
 
           /* Az graph */
-          n = g_slist_length (polv->pass->details);
+          n = get_pass_num_details (polv->pass);
           pts = goo_canvas_points_new (n);
 
           for (i = 0; i < n; i++) {
-               detail = PASS_DETAIL (g_slist_nth_data (polv->pass->details, i));
+               detail = get_pass_detail (polv->pass, i);
                az_to_xy (polv, detail->time, detail->az, &dx, &dy);
                pts->coords[2*i] = dx;
                pts->coords[2*i+1] = dy;
@@ -567,11 +567,11 @@ size_allocate_cb (GtkWidget *widget, GtkAllocation *allocation, gpointer data)
           goo_canvas_points_unref (pts);
 
           /* El graph */
-          n = g_slist_length (polv->pass->details);
+          n = get_pass_num_details (polv->pass);
           pts = goo_canvas_points_new (n);
 
           for (i = 0; i < n; i++) {
-               detail = PASS_DETAIL (g_slist_nth_data (polv->pass->details, i));
+               detail = get_pass_detail (polv->pass, i);
                el_to_xy (polv, detail->time, detail->el, &dx, &dy);
                pts->coords[2*i] = dx;
                pts->coords[2*i+1] = dy;
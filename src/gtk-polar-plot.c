@@ -915,7 +915,7 @@ static void create_track(GtkPolarPlot * pv)
     guint           tres, ttidx;
 
     /* create points */
-    num = g_slist_length(pv->pass->details);
+    num = get_pass_num_details(pv->pass);
     if(num > 0) {
 
     root = goo_canvas_get_root_item_model(GOO_CANVAS(pv->canvas));
@@ -937,7 +937,7 @@ static void create_track(GtkPolarPlot * pv)
 
         for (i = 1; i < num - 1; i++)
         {
-            detail = PASS_DETAIL(g_slist_nth_data(pv->pass->details, i));
+            detail = get_pass_detail(pv->pass, i);
             if (detail->el >= 0.0)
                 azel_to_xy(pv, detail->az, detail->el, &x, &y);
             points->coords[2 * i] = (double)x;
@@ -1021,7 +1021,7 @@ static void update_track(GtkPolarPlot * pv)
 
 
     /* create points */
-    num = g_slist_length(pv->pass->details);
+    num = get_pass_num_details(pv->pass);
 
     points = goo_canvas_points_new(num);
 
@@ -1041,7 +1041,7 @@ static void update_track(GtkPolarPlot * pv)
 
     for (i = 1; i < num - 1; i++)
     {
-        detail = PASS_DETAIL(g_slist_nth_data(pv->pass->details, i));
+        detail = get_pass_detail(pv->pass, i);
         if (detail->el >= 0.0)
             azel_to_xy(pv, detail->az, detail->el, &x, &y);
         points->coords[2 * i] = (double)x;
@@ -49,6 +49,7 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <stdio.h>
+#include <string.h>
 #include "compat.h"
 #include "sat-log.h"
 #include "predict-tools.h"
@@ -60,23 +61,35 @@
 #ifdef HAVE_CONFIG_H
 #  include <build-config.h>
 #endif
-
-/* NETWORK */
-//#include <sys/types.h>
-#ifndef WIN32
-#include <sys/socket.h>     /* socket(), connect(), send() */
-#include <netinet/in.h>     /* struct sockaddr_in */
-#include <arpa/inet.h>      /* htons() */
-#include <netdb.h>          /* gethostbyname() */
-#else
-#include <winsock2.h>
-#endif
-/* END */
 #include "gtk-rig-ctrl.h"
+#include "gtk-rot-ctrl.h"
 
 #define AZEL_FMTSTR "%7.2f\302\260"
 #define MAX_ERROR_COUNT 5
-#define WR_DEL 5000 /* delay in usec to wait between write and read commands */
+
+/** \brief Time covered by a Doppler curve outside a pass [days] (10 min). */
+#define DOPPLER_SPAN    (1.0/144.0)
+
+/** \brief Largest believable time rate; faster changes are time jumps. */
+#define MAX_TIME_RATE   100.0
+
+/** \brief A set command of a job and what to do with its answer. */
+typedef struct {
+    guint        cmd;       /*!< Index of the set command in the batch */
+    gint         readback;  /*!< Index of the command reading the frequency back or -1 */
+    gdouble      freq;      /*!< The frequency that has been set */
+    gdouble     *last;      /*!< Where to store the frequency or NULL */
+    const gchar *function;  /*!< Name of the function for error messages */
+} rig_set_t;
+
+/** \brief Commands of one controller cycle for one radio. */
+struct _rig_job {
+    GtkRigCtrl     *ctrl;     /*!< The controller */
+    hamlib_batch_t *batch;    /*!< The commands */
+    GArray         *sets;     /*!< The set commands (rig_set_t) */
+    gboolean        counted;  /*!< The job is part of ctrl->pending */
+};
+
 
 static void gtk_rig_ctrl_class_init (GtkRigCtrlClass *class);
 static void gtk_rig_ctrl_init       (GtkRigCtrl      *list);
@@ -93,6 +106,7 @@ static GtkWidget *create_count_down_widgets (GtkRigCtrl *ctrl);
 static void sat_selected_cb (GtkCellRendererToggle *cell_renderer, gchar *path_str, gpointer data);
 static void sat_increased_priority_cb(GtkButton *button, gpointer data);
 static void sat_decreased_priority_cb(GtkButton *button, gpointer data);
+static void save_schedule_cb(GtkButton *button, gpointer data);
 static void sat_changed_minCommunication_cb(GtkCellRendererText *cellrenderertext, gchar *arg1, gchar *arg2, gpointer data);
 static void track_toggle_cb (GtkToggleButton *button, gpointer data);
 static void delay_changed_cb (GtkSpinButton *spin, gpointer data);
@@ -110,6 +124,7 @@ static void manage_ptt_event (GtkRigCtrl *ctrl);
 
 /* Targeting functions */
 static void update_tracked_elem(GtkRigCtrl * ctrl);
+static void load_target_lists(GtkRigCtrl * ctrl);
 
 /* radio control functions */
 static void exec_rx_cycle (GtkRigCtrl *ctrl);
@@ -120,21 +135,36 @@ static void exec_toggle_tx_cycle (GtkRigCtrl *ctrl);
 static void exec_duplex_cycle (GtkRigCtrl *ctrl);
 static void exec_duplex_tx_cycle(GtkRigCtrl *ctrl);
 static void exec_dual_rig_cycle (GtkRigCtrl *ctrl);
-static gboolean set_freq_simplex (GtkRigCtrl *ctrl, gint sock, gdouble freq);
-static gboolean get_freq_simplex (GtkRigCtrl *ctrl, gint sock, gdouble *freq);
-static gboolean set_freq_toggle (GtkRigCtrl *ctrl, gint sock, gdouble freq);
-static gboolean set_toggle (GtkRigCtrl *ctrl, gint sock);
-static gboolean unset_toggle (GtkRigCtrl *ctrl, gint sock);
-static gboolean get_freq_toggle (GtkRigCtrl *ctrl, gint sock, gdouble *freq);
-static gboolean get_ptt (GtkRigCtrl *ctrl, gint sock);
-static gboolean set_ptt (GtkRigCtrl *ctrl, gint sock, gboolean ptt);
+static void exec_ptt_toggle (GtkRigCtrl *ctrl);
+static void exec_cycle (GtkRigCtrl *ctrl);
+static void start_cycle (GtkRigCtrl *ctrl);
+static void finish_cycle (GtkRigCtrl *ctrl);
+static void poll_done_cb (hamlib_batch_t *batch, gpointer data);
+static void poll2_done_cb (hamlib_batch_t *batch, gpointer data);
+static void poll_finished (GtkRigCtrl *ctrl);
+static void set_freq_simplex (GtkRigCtrl *ctrl, hamlib_io_t *io, gdouble freq, gdouble *last);
+static void set_freq_toggle (GtkRigCtrl *ctrl, hamlib_io_t *io, gdouble freq, gdouble *last, gboolean readback);
+static void set_toggle (GtkRigCtrl *ctrl, hamlib_io_t *io);
+static void unset_toggle (GtkRigCtrl *ctrl, hamlib_io_t *io);
+static gboolean get_ptt (const gchar *buffback);
+static gboolean get_freq (const gchar *buffback, gdouble *freq, const gchar *function);
+static void set_ptt (GtkRigCtrl *ctrl, hamlib_io_t *io, gboolean ptt);
 #if 0
-static gboolean set_vfo (GtkRigCtrl *ctrl, vfo_t vfo);
+static void set_vfo (GtkRigCtrl *ctrl, vfo_t vfo);
 #endif
-static gboolean setup_split(GtkRigCtrl *ctrl);
+static void setup_split(GtkRigCtrl *ctrl);
 static void update_count_down (GtkRigCtrl *ctrl, gdouble t);
-static gboolean open_rigctld_socket(radio_conf_t *conf, gint *sock);
-static gboolean close_rigctld_socket(gint *sock);
+static void update_doppler (GtkRigCtrl *ctrl);
+static void close_rigctld (GtkRigCtrl *ctrl);
+
+/* command queue of the controller cycle */
+static void queue_set (GtkRigCtrl *ctrl, hamlib_io_t *io, const gchar *cmd,
+                       const gchar *readback, gdouble freq, gdouble *last,
+                       const gchar *function);
+static void send_jobs (GtkRigCtrl *ctrl, gboolean counted);
+static void job_done_cb (hamlib_batch_t *batch, gpointer data);
+static void job_free (gpointer data);
+static void check_error_count (GtkRigCtrl *ctrl);
 
 /* misc utility functions */
 static void load_trsp_list (GtkRigCtrl *ctrl);
@@ -143,9 +173,8 @@ static gboolean have_conf (void);
 static void track_downlink (GtkRigCtrl *ctrl);
 static void track_uplink (GtkRigCtrl *ctrl);
 static gboolean is_rig_tx_capable (const gchar *confname);
-static gboolean send_rigctld_command(GtkRigCtrl *ctrl, gint sock, gchar *buff, gchar *buffout, gint sizeout);
-static inline gboolean check_set_response (gchar *buff,gboolean retcode,const gchar* filename);
-static inline gboolean check_get_response (gchar *buff,gboolean retcode,const gchar* filename);
+static inline gboolean check_set_response (const gchar *buff,const gchar* function);
+static inline gboolean check_get_response (const gchar *buff,const gchar* function);
 static gint sat_name_compare (sat_t* a,sat_t*b);
 static gint rig_name_compare (const gchar* a,const gchar *b);
 
@@ -206,6 +235,8 @@ static void gtk_rig_ctrl_init (GtkRigCtrl *ctrl)
 {
     ctrl->sats = NULL;
     ctrl->target = NULL;
+    ctrl->queue_serial = 0;
+    ctrl->target_serial = 0;
     ctrl->qth = NULL;
     ctrl->conf = NULL;
     ctrl->conf2 = NULL;
@@ -213,9 +244,12 @@ static void gtk_rig_ctrl_init (GtkRigCtrl *ctrl)
     ctrl->trsplist = NULL;
     ctrl->trsplock = FALSE;
     ctrl->tracking = FALSE;
-    ctrl->sock = 0;
-    ctrl->sock2 = 0;
-    g_static_mutex_init(&(ctrl->busy));
+    ctrl->io = NULL;
+    ctrl->io2 = NULL;
+    ctrl->job = NULL;
+    ctrl->job2 = NULL;
+    ctrl->pending = 0;
+    ctrl->ptt_event = FALSE;
     ctrl->engaged = FALSE;
     ctrl->delay = 1000;
     ctrl->timerid = 0;
@@ -223,6 +257,10 @@ static void gtk_rig_ctrl_init (GtkRigCtrl *ctrl)
     ctrl->lastrxf = 0.0;
     ctrl->lasttxf = 0.0;
     ctrl->last_toggle_tx = -1;
+    ctrl->t = 0.0;
+    ctrl->rate = 1.0;
+    ctrl->curve = NULL;
+    ctrl->curvesat = NULL;
 }
 
 static void gtk_rig_ctrl_destroy (GtkObject *object)
@@ -253,11 +291,18 @@ static void gtk_rig_ctrl_destroy (GtkObject *object)
         ctrl->trsplist = NULL;   /* destroy might be called twice (?) so we need to NULL it */
     }
 
-    /* close sockets if they are open*/
-    if (ctrl->sock)
-        close_rigctld_socket(&(ctrl->sock));
-    if (ctrl->sock2)
-        close_rigctld_socket(&(ctrl->sock2));
+    /* close connections if they are open */
+    close_rigctld (ctrl);
+
+    doppler_curve_free (ctrl->curve);
+    ctrl->curve = NULL;
+
+    /* release the priority queue, which the rotator controller may still use */
+    if (ctrl->target != NULL) {
+        free_priority_queue (ctrl->target);
+        ctrl->target = NULL;
+    }
+
     (* GTK_OBJECT_CLASS (parent_class)->destroy) (object);
 }
 
@@ -287,11 +332,22 @@ GtkWidget *gtk_rig_ctrl_new (GtkSatModule *module)
     /* store satellites */
     g_hash_table_foreach (module->satellites, store_sats, widget);
     
-    num_sats = g_slist_length (GTK_RIG_CTRL (widget)->sats);
-    GTK_RIG_CTRL (widget)->target = new_priority_queue(num_sats);
+    /* the priority queue is shared with the rotator controller */
+    if (module->rotctrl != NULL) {
+        GTK_RIG_CTRL (widget)->target = ref_priority_queue (GTK_ROT_CTRL (module->rotctrl)->target);
+    }
+    else {
+        num_sats = g_slist_length (GTK_RIG_CTRL (widget)->sats);
+        GTK_RIG_CTRL (widget)->target = new_priority_queue(num_sats);
+        set_sats_priority_queue (GTK_RIG_CTRL (widget)->target, GTK_RIG_CTRL (widget)->sats);
+    }
     
     /* store QTH */
     GTK_RIG_CTRL (widget)->qth = module->qth;
+
+    /* store current time (don't know if real or simulated) */
+    GTK_RIG_CTRL (widget)->t = module->tmgCdnum;
+    g_get_current_time (&GTK_RIG_CTRL (widget)->tstamp);
    
     /* initialise custom colors */
     gdk_rgb_find_color (gtk_widget_get_colormap (widget), &ColBlack);
@@ -333,8 +389,24 @@ GtkWidget *gtk_rig_ctrl_new (GtkSatModule *module)
  */
 void gtk_rig_ctrl_update   (GtkRigCtrl *ctrl, gdouble t)
 {
-    gdouble satfreq;
-    gchar *buff;
+    GTimeVal now;
+    gdouble  wall;
+    gchar   *buff;
+
+    /* measure the rate of the module time, which may be throttled */
+    g_get_current_time (&now);
+    wall = (now.tv_sec - ctrl->tstamp.tv_sec) + 1.0e-6 * (now.tv_usec - ctrl->tstamp.tv_usec);
+    if ((ctrl->t > 0.0) && (wall > 0.0)) {
+        ctrl->rate = (t - ctrl->t) * secday / wall;
+        if (fabs (ctrl->rate) > MAX_TIME_RATE)
+            ctrl->rate = 1.0;
+    }
+    ctrl->t = t;
+    ctrl->tstamp = now;
+
+    /* the rotator controller may have changed the shared priority queue */
+    if (ctrl->queue_serial != ctrl->target->serial)
+        load_target_lists (ctrl);
 
     if (ctrl->target->targeting) {
 
@@ -369,36 +441,25 @@ void gtk_rig_ctrl_update   (GtkRigCtrl *ctrl, gdouble t)
         gtk_label_set_text (GTK_LABEL (ctrl->SatRngRate), buff);
         g_free (buff);
         
-        /* Doppler shift down */
-        satfreq = gtk_freq_knob_get_value (GTK_FREQ_KNOB (ctrl->SatFreqDown));
-        ctrl->dd = -satfreq * (ctrl->target->targeting->range_rate / 299792.4580); // Hz
-        buff = g_strdup_printf ("%.0f Hz", ctrl->dd);
-        gtk_label_set_text (GTK_LABEL (ctrl->SatDopDown), buff);
-        g_free (buff);
-        
-        /* Doppler shift up */
-        satfreq = gtk_freq_knob_get_value (GTK_FREQ_KNOB (ctrl->SatFreqUp));
-        ctrl->du = satfreq * (ctrl->target->targeting->range_rate / 299792.4580); // Hz
-        buff = g_strdup_printf ("%.0f Hz", ctrl->du);
-        gtk_label_set_text (GTK_LABEL (ctrl->SatDopUp), buff);
-        g_free (buff);
-
-        /* update next pass if necessary */
-        if (ctrl->target->pass != NULL) {
-            if (ctrl->target->targeting->aos > ctrl->target->pass->aos) {
-                /* update pass */
-                free_pass (ctrl->target->pass);
-                ctrl->target->pass = get_next_pass (ctrl->target->targeting, ctrl->qth, 3.0);
-            }
-        }
-        else {
-            /* we don't have any current pass; store the current one */
-            ctrl->target->pass = get_next_pass (ctrl->target->targeting, ctrl->qth, 3.0);
-        }
-        
+        update_doppler (ctrl);
     }
 }
 
+/** \brief Set the slew rates of the rotator used with the radio.
+ * \param ctrl Pointer to the GtkRigCtrl.
+ * \param azrate The azimuth rate [deg/sec]; 0 if there is no rotator.
+ * \param elrate The elevation rate [deg/sec]; 0 if there is no rotator.
+ *
+ * The radio shares its priority queue and schedule with the rotator
+ * controller of the module, if there is one, so the rates are those of
+ * the rotator; without one they are 0. The schedule is only computed again
+ * if the rates have changed.
+ */
+void gtk_rig_ctrl_set_slew (GtkRigCtrl *ctrl, gdouble azrate, gdouble elrate)
+{
+    set_slew_priority_queue (ctrl->target, azrate, elrate);
+}
+
 
 /** \brief Create freq control widgets for downlink.
  * \param ctrl Pointer to the GtkRigCtrl widget.
@@ -535,7 +596,7 @@ static GtkWidget *create_uplink_widgets (GtkRigCtrl *ctrl)
  */
 static GtkWidget *create_target_widgets (GtkRigCtrl *ctrl)
 {
-    GtkWidget *frame,*table,*satsel, *tree, *high_but, *low_but;
+    GtkWidget *frame,*table,*satsel, *tree, *high_but, *low_but, *save_but;
     GtkTreeViewColumn *sat_nickname, *checkbox, *minCommunication;
     GtkCellRenderer *rend_sat_nickname, *rend_checkbox, *rend_minCommunication;
     guint i, num_sats;
@@ -543,7 +604,7 @@ static GtkWidget *create_target_widgets (GtkRigCtrl *ctrl)
     GtkTreeIter iter;
 
     
-    table = gtk_table_new (4, 4, FALSE);
+    table = gtk_table_new (7, 5, FALSE);
     gtk_container_set_border_width (GTK_CONTAINER (table), 5);
     gtk_table_set_col_spacings (GTK_TABLE (table), 5);
     gtk_table_set_row_spacings (GTK_TABLE (table), 5);
@@ -557,8 +618,6 @@ static GtkWidget *create_target_widgets (GtkRigCtrl *ctrl)
         if (sat) {
             gtk_list_store_append(ctrl->checkSatsList, &iter);
             gtk_list_store_set(ctrl->checkSatsList, &iter, TEXT_COLUMN, sat->nickname, TOGGLE_COLUMN, FALSE, QNT_COLUMN, "0.000000", -1);
-            ctrl->target->sats[i] = NOT_IN_PRIORITY_QUEUE;
-            ctrl->target->minCommunication[i] = 0.0f;
         }
     }
     tree = gtk_tree_view_new_with_model(GTK_TREE_MODEL(ctrl->checkSatsList));
@@ -593,7 +652,7 @@ static GtkWidget *create_target_widgets (GtkRigCtrl *ctrl)
     satsel = gtk_scrolled_window_new(NULL, NULL);
     gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(satsel), GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
     gtk_container_add(GTK_CONTAINER(satsel), tree);
-    gtk_table_attach_defaults(GTK_TABLE (table), satsel, 0, 3, 0, 6);
+    gtk_table_attach_defaults(GTK_TABLE (table), satsel, 0, 3, 0, 7);
 
     /* Callback functions for the minimun communication and the checkbox */
     g_signal_connect (rend_checkbox, "toggled", G_CALLBACK (sat_selected_cb), ctrl);
@@ -603,6 +662,7 @@ static GtkWidget *create_target_widgets (GtkRigCtrl *ctrl)
      * satellite priority Column
      */
     ctrl->prioritySatsList =  gtk_list_store_new(N_COLUMN_PRIORITY, G_TYPE_STRING);
+    load_target_lists(ctrl);
     ctrl->prioritySats = gtk_tree_view_new_with_model(GTK_TREE_MODEL(ctrl->prioritySatsList));
     gtk_widget_set_usize (ctrl->prioritySats, 150, -1);
     
@@ -643,7 +703,14 @@ static GtkWidget *create_target_widgets (GtkRigCtrl *ctrl)
     gtk_table_attach (GTK_TABLE (table), low_but, 4, 5, 0, 1,
                       GTK_SHRINK, GTK_SHRINK, 0, 0);
 
-   
+    /* Create SAVE Button */
+    save_but = gpredict_hstock_button (GTK_STOCK_SAVE, _("Schedule"),
+                                       _("Save the pass schedule of the priority list to a file."));
+    g_signal_connect (save_but, "clicked", G_CALLBACK (save_schedule_cb), ctrl);
+    gtk_table_attach (GTK_TABLE (table), save_but, 3, 5, 6, 7,
+                      GTK_FILL, GTK_SHRINK, 0, 0);
+
+
     frame = gtk_frame_new (_("Target"));
 
     gtk_container_add (GTK_CONTAINER (frame), table);
@@ -977,11 +1044,13 @@ static void
             gtk_list_store_set(ctrl->prioritySatsList, &iter, TEXT_COLUMN, sat->nickname, -1);
             /* Adds the satellite to the priorityQueue */
             append_elem_priority_queue(ctrl->target, i);
+            ctrl->queue_serial = ctrl->target->serial;
         } 
     }
     else if(!enable && i >= 0){
         index_priority_list = get_elem_index_priority_queue(ctrl->target, i);
         remove_elem_priority_queue(ctrl->target, i);
+        ctrl->queue_serial = ctrl->target->serial;
         /* Gets the new iter of the priority list*/
         gtk_tree_path_free (path);
         path = gtk_tree_path_new_from_indices(index_priority_list ,-1);
@@ -1132,6 +1201,7 @@ static void
 
         gtk_list_store_swap (ctrl->prioritySatsList, iter1, iter2);
         swap_elem_priority_queue (ctrl->target, i, j);
+        ctrl->queue_serial = ctrl->target->serial;
         update_tracked_elem (ctrl);
     }
 }
@@ -1167,10 +1237,68 @@ static void
 
         gtk_list_store_swap (ctrl->prioritySatsList, iter1, iter2);
         swap_elem_priority_queue(ctrl->target, i, j);
+        ctrl->queue_serial = ctrl->target->serial;
         update_tracked_elem (ctrl);
     }
 }
 
+/** \brief Save the schedule of the priority list.
+ *  \param button Pointer to the GtkButton that received the signal.
+ *  \param data Pointer to the GtkRigCtrl structure.
+ *
+ * This function is called when the user presses the "Schedule" button. It
+ * asks for a file name and writes the pass schedule of the priority list
+ * to it as a text table.
+ */
+static void
+        save_schedule_cb(GtkButton *button, gpointer data)
+{
+    GtkRigCtrl *ctrl = GTK_RIG_CTRL (data);
+    GtkWidget *toplevel = gtk_widget_get_toplevel (GTK_WIDGET (button));
+    GtkWidget *dialog;
+    GError    *err = NULL;
+    gchar     *filename;
+    gchar     *text;
+
+    /* make sure that the schedule is up to date */
+    update_tracked_elem (ctrl);
+
+    dialog = gtk_file_chooser_dialog_new (_("Save Schedule"),
+                                          GTK_WINDOW (toplevel),
+                                          GTK_FILE_CHOOSER_ACTION_SAVE,
+                                          GTK_STOCK_CANCEL, GTK_RESPONSE_CANCEL,
+                                          GTK_STOCK_SAVE, GTK_RESPONSE_ACCEPT,
+                                          NULL);
+    gtk_file_chooser_set_do_overwrite_confirmation (GTK_FILE_CHOOSER (dialog), TRUE);
+    gtk_file_chooser_set_current_name (GTK_FILE_CHOOSER (dialog), "schedule.txt");
+
+    if (gtk_dialog_run (GTK_DIALOG (dialog)) == GTK_RESPONSE_ACCEPT) {
+        filename = gtk_file_chooser_get_filename (GTK_FILE_CHOOSER (dialog));
+        text = export_priority_queue (ctrl->target);
+
+        if (!g_file_set_contents (filename, text, -1, &err)) {
+            sat_log_log (SAT_LOG_LEVEL_ERROR,
+                         _("%s: Could not save schedule to %s (%s)"),
+                         __FUNCTION__, filename, err->message);
+            gtk_widget_destroy (dialog);
+            dialog = gtk_message_dialog_new (GTK_WINDOW (toplevel),
+                                             GTK_DIALOG_MODAL |
+                                             GTK_DIALOG_DESTROY_WITH_PARENT,
+                                             GTK_MESSAGE_ERROR,
+                                             GTK_BUTTONS_OK,
+                                             _("Could not save schedule to\n%s\n\n%s"),
+                                             filename, err->message);
+            gtk_dialog_run (GTK_DIALOG (dialog));
+            g_clear_error (&err);
+        }
+
+        g_free (text);
+        g_free (filename);
+    }
+
+    gtk_widget_destroy (dialog);
+}
+
 /** \brief Set new minimal time of communication to selected sattelite
  * \param cellrederertext Pointer to the GtkCellRendererText. 
  * \param arg1 String of the i-th changed cell
@@ -1212,6 +1340,8 @@ static void
     ctrl->target->minCommunication[i] = num;
 
     /* Resets the next passes if there is a satellite*/
+    invalidate_priority_queue(ctrl->target);
+    ctrl->queue_serial = ctrl->target->serial;
     update_tracked_elem(ctrl);
 }
 
@@ -1437,7 +1567,7 @@ static void rig_engaged_cb (GtkToggleButton *button, gpointer data)
 
 
     if (!gtk_toggle_button_get_active (button)) {
-        /* close socket */
+        /* close connections */
         gtk_widget_set_sensitive (ctrl->DevSel, TRUE);
         gtk_widget_set_sensitive (ctrl->DevSel2, TRUE);
         ctrl->engaged = FALSE;
@@ -1446,16 +1576,11 @@ static void rig_engaged_cb (GtkToggleButton *button, gpointer data)
 
         if ((ctrl->conf->type == RIG_TYPE_TOGGLE_AUTO) ||
             (ctrl->conf->type == RIG_TYPE_TOGGLE_MAN)) {
-            unset_toggle (ctrl,ctrl->sock);
+            unset_toggle (ctrl, ctrl->io);
+            send_jobs (ctrl, FALSE);
         }
 
-        if (ctrl->conf2 != NULL) {
-
-            close_rigctld_socket(&(ctrl->sock2));
-        }
-        close_rigctld_socket(&(ctrl->sock));
-        
-
+        close_rigctld (ctrl);
     }
     else {
 
@@ -1464,97 +1589,73 @@ static void rig_engaged_cb (GtkToggleButton *button, gpointer data)
         ctrl->engaged = TRUE;
         ctrl->wrops = 0;
 
-        open_rigctld_socket(ctrl->conf,&(ctrl->sock));
+        ctrl->io = hamlib_io_new (ctrl->conf->host, ctrl->conf->port);
+        if (ctrl->conf2 != NULL)
+            ctrl->io2 = hamlib_io_new (ctrl->conf2->host, ctrl->conf2->port);
 
-        /* set initial frequency */
-        if (ctrl->conf2 != NULL) {
-            open_rigctld_socket(ctrl->conf2,&(ctrl->sock2));
-            /* set initial dual mode */
-            exec_dual_rig_cycle (ctrl);
-        }
-        else {
+        /* prepare the radio; the commands are answered before the
+           first cycle sets the initial frequency */
+        if (ctrl->conf2 == NULL) {
             switch (ctrl->conf->type) {
-                
-            case RIG_TYPE_RX:
-                exec_rx_cycle (ctrl);
-                break;
-
-            case RIG_TYPE_TX:
-                exec_tx_cycle (ctrl);
-                break;
-
-            case RIG_TYPE_TRX:
-                exec_trx_cycle (ctrl);
-                break;
 
             case RIG_TYPE_DUPLEX:
                 /* set rig into SAT mode (hamlib needs it even if rig already in SAT) */
-                setup_split(ctrl);
-                exec_duplex_cycle (ctrl);
+                setup_split (ctrl);
                 break;
 
             case RIG_TYPE_TOGGLE_AUTO:
             case RIG_TYPE_TOGGLE_MAN:
-                set_toggle (ctrl,ctrl->sock);
+                set_toggle (ctrl, ctrl->io);
                 ctrl->last_toggle_tx = -1;
-                exec_toggle_cycle (ctrl);
                 break;
 
             default:
-                /* this is an error! */
-                ctrl->conf->type = RIG_TYPE_RX;
-                exec_rx_cycle (ctrl);
                 break;
             }
+            send_jobs (ctrl, FALSE);
         }
+
+        start_cycle (ctrl);
     }
 }
 
 
 /** \brief Setup VFOs for split operation (simplex or duplex)
  *  \param ctrl Pointer to the GtkRigCtrl structure.
- *  \return TRUE if the operation was succesful, FALSE if an error occurred.
  * 
  * This function is used to setup the VFOs for split operation. For full
  * duplex radios this will enable the SAT mode (True for FT847 but TBC for others).
  * See bug #3272993
  */
-static gboolean setup_split(GtkRigCtrl *ctrl)
+static void setup_split(GtkRigCtrl *ctrl)
 {
-    gchar  *buff;
-    gchar  buffback[128];
-    gboolean retcode;
+    const gchar *buff;
 
     /* select TX VFO */
     switch (ctrl->conf->vfoUp) {
         case VFO_A:
-            buff = g_strdup("S 1 A\x0a");
+            buff = "S 1 A";
             break;
         
         case VFO_B:
-            buff = g_strdup("S 1 B\x0a");
+            buff = "S 1 B";
             break;
 
         case VFO_MAIN:
-            buff = g_strdup("S 1 Main\x0a");
+            buff = "S 1 Main";
             break;
 
         case VFO_SUB:
-            buff = g_strdup("S 1 Sub\x0a");
+            buff = "S 1 Sub";
             break;
             
         default:
             sat_log_log(SAT_LOG_LEVEL_ERROR,
                         _("%s called but TX VFO is %d."), __FUNCTION__, ctrl->conf->vfoUp);
-            return FALSE;
+            return;
         }
 
-    retcode=send_rigctld_command(ctrl, ctrl->sock, buff, buffback, 128);
-    
-    g_free(buff);
-    
-    return(check_set_response(buffback, retcode, __FUNCTION__));
-
+    queue_set (ctrl, ctrl->io, buff, NULL, 0.0, NULL, __FUNCTION__);
 }
 
 
@@ -1597,6 +1698,9 @@ static void uplink_changed_cb (GtkFreqKnob *knob, gpointer data)
 /** \brief Rigator controller timeout function
  * \param data Pointer to the GtkRigCtrl widget.
  * \return Always TRUE to let the timer continue.
+ *
+ * If the device is engaged this function only starts a new cycle by reading
+ * the radio status; the cycle is executed when the answers arrive.
  */
 static gboolean rig_ctrl_timeout_cb (gpointer data)
 {
@@ -1612,11 +1716,144 @@ static gboolean rig_ctrl_timeout_cb (gpointer data)
     /* Update the tracking object */
     update_tracked_elem(ctrl);
 
-    if (g_static_mutex_trylock(&(ctrl->busy))==FALSE) {
+    if (ctrl->pending > 0) {
         sat_log_log (SAT_LOG_LEVEL_ERROR,_("%s missed the deadline"),__FUNCTION__);
         return TRUE;
     }
-    
+
+    if (ctrl->engaged) {
+        start_cycle (ctrl);
+    }
+    else {
+        /* only update the frequency knobs */
+        exec_cycle (ctrl);
+        finish_cycle (ctrl);
+    }
+
+    return TRUE;
+}
+
+
+/** \brief Start a controller cycle.
+ *  \param ctrl Pointer to the GtkRigCtrl widget.
+ *
+ * This function reads the PTT status and the frequencies of the radio(s)
+ * with one batch of commands per radio. The commands of a batch are
+ * pipelined and the cycle continues in poll_finished() when all of them
+ * have been answered.
+ */
+static void start_cycle (GtkRigCtrl *ctrl)
+{
+    hamlib_batch_t *batch;
+
+    ctrl->ptt = FALSE;
+    ctrl->readf_ok = FALSE;
+    ctrl->readi_ok = FALSE;
+    ctrl->readf2_ok = FALSE;
+
+    /* the PTT status is always needed to handle a PTT event */
+    ctrl->pollptt = (ctrl->conf->ptt || ctrl->ptt_event);
+
+    batch = hamlib_batch_new ();
+    if (ctrl->pollptt) {
+        if (ctrl->conf->ptt == PTT_TYPE_CAT) {
+            /* get_ptt (t) */
+            hamlib_batch_add (batch, 1, "t");
+        }
+        else {
+            /* \get_dcd */
+            hamlib_batch_add (batch, 1, "%c", 0x8b);
+        }
+    }
+    hamlib_batch_add (batch, 1, "f");
+    if ((ctrl->conf2 == NULL) && (ctrl->conf->type == RIG_TYPE_DUPLEX))
+        hamlib_batch_add (batch, 1, "i");
+
+    ctrl->pending = 1;
+    ctrl->wrops += hamlib_batch_size (batch);
+    hamlib_io_send (ctrl->io, batch, poll_done_cb, ctrl, NULL);
+
+    if (ctrl->conf2 != NULL) {
+        batch = hamlib_batch_new ();
+        hamlib_batch_add (batch, 1, "f");
+
+        ctrl->pending++;
+        ctrl->wrops += hamlib_batch_size (batch);
+        hamlib_io_send (ctrl->io2, batch, poll2_done_cb, ctrl, NULL);
+    }
+}
+
+
+/** \brief Store the status of the primary radio.
+ *  \param batch The answered commands sent by start_cycle().
+ *  \param data Pointer to the GtkRigCtrl widget.
+ */
+static void poll_done_cb (hamlib_batch_t *batch, gpointer data)
+{
+    GtkRigCtrl *ctrl = GTK_RIG_CTRL (data);
+    guint       i = 0;
+
+    if (ctrl->pollptt)
+        ctrl->ptt = get_ptt (hamlib_batch_reply (batch, i++));
+
+    ctrl->readf_ok = get_freq (hamlib_batch_reply (batch, i++), &ctrl->readf, __FUNCTION__);
+
+    if (i < hamlib_batch_size (batch))
+        ctrl->readi_ok = get_freq (hamlib_batch_reply (batch, i), &ctrl->readi, __FUNCTION__);
+
+    poll_finished (ctrl);
+}
+
+
+/** \brief Store the status of the secondary radio.
+ *  \param batch The answered commands sent by start_cycle().
+ *  \param data Pointer to the GtkRigCtrl widget.
+ */
+static void poll2_done_cb (hamlib_batch_t *batch, gpointer data)
+{
+    GtkRigCtrl *ctrl = GTK_RIG_CTRL (data);
+
+    ctrl->readf2_ok = get_freq (hamlib_batch_reply (batch, 0), &ctrl->readf2, __FUNCTION__);
+
+    poll_finished (ctrl);
+}
+
+
+/** \brief Continue the cycle when the status of all radios has been read.
+ *  \param ctrl Pointer to the GtkRigCtrl widget.
+ *
+ * A pending PTT event is handled instead of the normal cycle, since the
+ * frequencies must not be changed while the PTT status changes.
+ */
+static void poll_finished (GtkRigCtrl *ctrl)
+{
+    if (--ctrl->pending > 0)
+        return;
+
+    if (ctrl->ptt_event && ctrl->pollptt) {
+        ctrl->ptt_event = FALSE;
+        exec_ptt_toggle (ctrl);
+    }
+    else {
+        exec_cycle (ctrl);
+    }
+
+    finish_cycle (ctrl);
+}
+
+
+/** \brief Execute the controller cycle of the current radio type.
+ *  \param ctrl Pointer to the GtkRigCtrl widget.
+ *
+ * The cycle functions use the radio status read by start_cycle() and queue
+ * the commands to send with queue_set().
+ */
+static void exec_cycle (GtkRigCtrl *ctrl)
+{
+    /* the radio status was read since the timeout; tune for the time
+       when the commands of this cycle arrive */
+    update_doppler (ctrl);
+
     if (ctrl->conf2 != NULL) {
         exec_dual_rig_cycle (ctrl);
     }
@@ -1654,8 +1891,29 @@ static gboolean rig_ctrl_timeout_cb (gpointer data)
             
         }
     }
+}
+
 
-    /* perform error count checking */
+/** \brief Send the commands queued in the cycle.
+ *  \param ctrl Pointer to the GtkRigCtrl widget.
+ *
+ * The error count is checked when all commands have been answered, or
+ * right away if there is nothing to send.
+ */
+static void finish_cycle (GtkRigCtrl *ctrl)
+{
+    send_jobs (ctrl, TRUE);
+
+    if (ctrl->pending == 0)
+        check_error_count (ctrl);
+}
+
+
+/** \brief Disengage the device if there have been too many errors.
+ *  \param ctrl Pointer to the GtkRigCtrl widget.
+ */
+static void check_error_count (GtkRigCtrl *ctrl)
+{
     if (ctrl->errcnt >= MAX_ERROR_COUNT) {
         /* disengage device */
         gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (ctrl->LockBut), FALSE);
@@ -1664,15 +1922,7 @@ static gboolean rig_ctrl_timeout_cb (gpointer data)
         sat_log_log (SAT_LOG_LEVEL_ERROR,
                      _("%s: MAX_ERROR_COUNT (%d) reached. Disengaging device!"),
                      __FUNCTION__, MAX_ERROR_COUNT);
-        
-        //g_print ("ERROR. WROPS = %d\n", ctrl->wrops);
     }
-    
-    //g_print ("       WROPS = %d\n", ctrl->wrops);
-    
-    g_static_mutex_unlock(&(ctrl->busy));
-    
-    return TRUE;
 }
 
 
@@ -1690,7 +1940,7 @@ static void exec_rx_cycle (GtkRigCtrl *ctrl)
     
     /* get PTT status */
     if (ctrl->engaged && ctrl->conf->ptt)
-        ptt = get_ptt (ctrl, ctrl->sock);
+        ptt = ctrl->ptt;
     
     
     /* Dial feedback:
@@ -1704,7 +1954,10 @@ static void exec_rx_cycle (GtkRigCtrl *ctrl)
     if ((ctrl->engaged) && (ctrl->lastrxf > 0.0)) {
         
         if (ptt == FALSE) {
-            if (!get_freq_simplex (ctrl, ctrl->sock, &readfreq)) {
+            if (ctrl->readf_ok) {
+                readfreq = ctrl->readf;
+            }
+            else {
                 /* error => use a passive value */
                 readfreq = ctrl->lastrxf;
                 ctrl->errcnt++;
@@ -1768,24 +2021,8 @@ static void exec_rx_cycle (GtkRigCtrl *ctrl)
 
 
     /* if device is engaged, send freq command to radio */
-    if ((ctrl->engaged) && (ptt == FALSE) && (fabs(ctrl->lastrxf - tmpfreq) >= 1.0)) {
-        if (set_freq_simplex (ctrl, ctrl->sock, tmpfreq)) {
-            /* reset error counter */
-            ctrl->errcnt = 0;
-            
-            /* give radio a chance to set frequency */
-            g_usleep (WR_DEL);
-
-            /* The actual frequency might be different from what we have set because
-               the tuning step is larger than what we work with (e.g. FT-817 has a
-               smallest tuning step of 10 Hz). Therefore we read back the actual
-               frequency from the rig. */
-            get_freq_simplex (ctrl, ctrl->sock, &tmpfreq);
-            ctrl->lastrxf = tmpfreq;
-        }
-        else {
-            ctrl->errcnt++;
-        }
+    if ((ctrl->engaged) && (ptt == FALSE) && (fabs(ctrl->lastrxf - tmpfreq) >= ctrl->conf->fstep)) {
+        set_freq_simplex (ctrl, ctrl->io, tmpfreq, &ctrl->lastrxf);
     }
     
 }
@@ -1805,7 +2042,7 @@ static void exec_tx_cycle (GtkRigCtrl *ctrl)
     
     /* get PTT status */
     if (ctrl->engaged && ctrl->conf->ptt) {
-        ptt = get_ptt (ctrl, ctrl->sock);
+        ptt = ctrl->ptt;
     }
 
     /* Dial feedback:
@@ -1819,7 +2056,10 @@ static void exec_tx_cycle (GtkRigCtrl *ctrl)
     if ((ctrl->engaged) && (ctrl->lasttxf > 0.0)) {
         
         if (ptt == TRUE) {
-            if (!get_freq_simplex (ctrl, ctrl->sock, &readfreq)) {
+            if (ctrl->readf_ok) {
+                readfreq = ctrl->readf;
+            }
+            else {
                 /* error => use a passive value */
                 readfreq = ctrl->lasttxf;
                 ctrl->errcnt++;
@@ -1881,24 +2121,8 @@ static void exec_tx_cycle (GtkRigCtrl *ctrl)
     tmpfreq = gtk_freq_knob_get_value(GTK_FREQ_KNOB(ctrl->RigFreqUp));
 
     /* if device is engaged, send freq command to radio */
-    if ((ctrl->engaged) && (ptt == TRUE) && (fabs(ctrl->lasttxf - tmpfreq) >= 1.0)) {
-        if (set_freq_simplex (ctrl, ctrl->sock, tmpfreq)) {
-            /* reset error counter */
-            ctrl->errcnt = 0;
-
-            /* give radio a chance to set frequency */
-            g_usleep (WR_DEL);
-
-            /* The actual frequency migh be different from what we have set because
-               the tuning step is larger than what we work with (e.g. FT-817 has a
-               smallest tuning step of 10 Hz). Therefore we read back the actual
-               frequency from the rig. */
-            get_freq_simplex (ctrl, ctrl->sock, &tmpfreq);
-            ctrl->lasttxf = tmpfreq;
-        }
-        else {
-            ctrl->errcnt++;
-        }
+    if ((ctrl->engaged) && (ptt == TRUE) && (fabs(ctrl->lasttxf - tmpfreq) >= ctrl->conf->fstep)) {
+        set_freq_simplex (ctrl, ctrl->io, tmpfreq, &ctrl->lasttxf);
     }
     
 }
@@ -1970,7 +2194,7 @@ static void exec_toggle_tx_cycle (GtkRigCtrl *ctrl)
 
     
     if (ctrl->engaged && ctrl->conf->ptt) {
-        ptt = get_ptt (ctrl, ctrl->sock);
+        ptt = ctrl->ptt;
     }
     
     /* if we are in TX mode do nothing */
@@ -1982,17 +2206,9 @@ static void exec_toggle_tx_cycle (GtkRigCtrl *ctrl)
     tmpfreq = gtk_freq_knob_get_value(GTK_FREQ_KNOB(ctrl->RigFreqUp));
 
     /* if device is engaged, send freq command to radio */
-    if ((ctrl->engaged) && (fabs(ctrl->lasttxf - tmpfreq) >= 10.0)) {
-        if (set_freq_toggle (ctrl, ctrl->sock, tmpfreq)) {
-            /* reset error counter */
-            ctrl->errcnt = 0;          
-        }
-        else {
-            ctrl->errcnt++;
-        }
-        
-        /* store the last sent frequency even if an error occurred */
-        ctrl->lasttxf = tmpfreq;
+    if ((ctrl->engaged) && (fabs(ctrl->lasttxf - tmpfreq) >= MAX (10.0, ctrl->conf->fstep))) {
+        /* the last sent frequency is stored even if an error occurs */
+        set_freq_toggle (ctrl, ctrl->io, tmpfreq, &ctrl->lasttxf, FALSE);
     }
     
 }
@@ -2022,7 +2238,10 @@ static void exec_duplex_tx_cycle(GtkRigCtrl *ctrl)
     if ((ctrl->engaged) && (ctrl->lasttxf > 0.0)) {
         
 
-        if (!get_freq_toggle (ctrl, ctrl->sock, &readfreq)) {
+        if (ctrl->readi_ok) {
+            readfreq = ctrl->readi;
+        }
+        else {
             /* error => use a passive value */
             readfreq = ctrl->lasttxf;
             ctrl->errcnt++;
@@ -2080,24 +2299,8 @@ static void exec_duplex_tx_cycle(GtkRigCtrl *ctrl)
     tmpfreq = gtk_freq_knob_get_value(GTK_FREQ_KNOB(ctrl->RigFreqUp));
 
     /* if device is engaged, send freq command to radio */
-    if ((ctrl->engaged) && (fabs(ctrl->lasttxf - tmpfreq) >= 1.0)) {
-        if (set_freq_toggle (ctrl, ctrl->sock, tmpfreq)) {
-            /* reset error counter */
-            ctrl->errcnt = 0;
-
-            /* give radio a chance to set frequency */
-            g_usleep (WR_DEL);
-
-            /* The actual frequency migh be different from what we have set because
-               the tuning step is larger than what we work with (e.g. FT-817 has a
-               smallest tuning step of 10 Hz). Therefore we read back the actual
-               frequency from the rig. */
-            get_freq_toggle (ctrl, ctrl->sock, &tmpfreq);
-            ctrl->lasttxf = tmpfreq;
-        }
-        else {
-            ctrl->errcnt++;
-        }
+    if ((ctrl->engaged) && (fabs(ctrl->lasttxf - tmpfreq) >= ctrl->conf->fstep)) {
+        set_freq_toggle (ctrl, ctrl->io, tmpfreq, &ctrl->lasttxf, TRUE);
     }
 
 }
@@ -2130,7 +2333,10 @@ static void exec_dual_rig_cycle (GtkRigCtrl *ctrl)
     if (ctrl->engaged && (ctrl->lastrxf > 0.0)) {
         
         /* get frequency from receiver */
-        if (!get_freq_simplex (ctrl, ctrl->sock, &readfreq)) {
+        if (ctrl->readf_ok) {
+            readfreq = ctrl->readf;
+        }
+        else {
             /* error => use a passive value */
             readfreq = ctrl->lastrxf;
             ctrl->errcnt++;
@@ -2174,21 +2380,8 @@ static void exec_dual_rig_cycle (GtkRigCtrl *ctrl)
         tmpfreq = gtk_freq_knob_get_value(GTK_FREQ_KNOB(ctrl->RigFreqUp));
         
         /* if device is engaged, send freq command to radio */
-        if ((ctrl->engaged) && (fabs(ctrl->lasttxf - tmpfreq) >= 1.0)) {
-            if (set_freq_simplex (ctrl, ctrl->sock2, tmpfreq)) {
-                /* reset error counter */
-                ctrl->errcnt = 0;
-
-                /* give radio a chance to set frequency */
-                g_usleep (WR_DEL);
-
-                /* The actual frequency migh be different from what we have set */
-                get_freq_simplex (ctrl, ctrl->sock2, &tmpfreq);
-                ctrl->lasttxf = tmpfreq;
-            }
-            else {
-                ctrl->errcnt++;
-            }
+        if ((ctrl->engaged) && (fabs(ctrl->lasttxf - tmpfreq) >= ctrl->conf2->fstep)) {
+            set_freq_simplex (ctrl, ctrl->io2, tmpfreq, &ctrl->lasttxf);
         }
         
     }  /* dialchanged on downlink */
@@ -2211,21 +2404,8 @@ static void exec_dual_rig_cycle (GtkRigCtrl *ctrl)
         tmpfreq = gtk_freq_knob_get_value(GTK_FREQ_KNOB(ctrl->RigFreqDown));
 
         /* if device is engaged, send freq command to radio */
-        if ((ctrl->engaged) && (fabs(ctrl->lastrxf - tmpfreq) >= 1.0)) {
-            if (set_freq_simplex (ctrl, ctrl->sock, tmpfreq)) {
-                /* reset error counter */
-                ctrl->errcnt = 0;
-
-                /* give radio a chance to set frequency */
-                g_usleep (WR_DEL);
-
-                /* The actual frequency migh be different from what we have set */
-                get_freq_simplex (ctrl, ctrl->sock, &tmpfreq);
-                ctrl->lastrxf = tmpfreq;
-            }
-            else {
-                ctrl->errcnt++;
-            }
+        if ((ctrl->engaged) && (fabs(ctrl->lastrxf - tmpfreq) >= ctrl->conf->fstep)) {
+            set_freq_simplex (ctrl, ctrl->io, tmpfreq, &ctrl->lastrxf);
         }
 
         /*** Now execute uplink controller ***/
@@ -2233,7 +2413,10 @@ static void exec_dual_rig_cycle (GtkRigCtrl *ctrl)
         /* check if uplink dial has changed */
         if ((ctrl->engaged) && (ctrl->lasttxf > 0.0)) {
 
-            if (!get_freq_simplex (ctrl, ctrl->sock2, &readfreq)) {
+            if (ctrl->readf2_ok) {
+                readfreq = ctrl->readf2;
+            }
+            else {
                 /* error => use a passive value */
                 readfreq = ctrl->lasttxf;
                 ctrl->errcnt++;
@@ -2276,21 +2459,8 @@ static void exec_dual_rig_cycle (GtkRigCtrl *ctrl)
             tmpfreq = gtk_freq_knob_get_value(GTK_FREQ_KNOB(ctrl->RigFreqDown));
 
             /* if device is engaged, send freq command to radio */
-            if ((ctrl->engaged) && (fabs(ctrl->lastrxf - tmpfreq) >= 1.0)) {
-                if (set_freq_simplex (ctrl, ctrl->sock, tmpfreq)) {
-                    /* reset error counter */
-                    ctrl->errcnt = 0;
-
-                    /* give radio a chance to set frequency */
-                    g_usleep (WR_DEL);
-
-                    /* The actual frequency migh be different from what we have set */
-                    get_freq_simplex (ctrl, ctrl->sock, &tmpfreq);
-                    ctrl->lastrxf = tmpfreq;
-                }
-                else {
-                    ctrl->errcnt++;
-                }
+            if ((ctrl->engaged) && (fabs(ctrl->lastrxf - tmpfreq) >= ctrl->conf->fstep)) {
+                set_freq_simplex (ctrl, ctrl->io, tmpfreq, &ctrl->lastrxf);
             }
         } /* dialchanged on uplink */
         else {
@@ -2308,21 +2478,8 @@ static void exec_dual_rig_cycle (GtkRigCtrl *ctrl)
             tmpfreq = gtk_freq_knob_get_value(GTK_FREQ_KNOB(ctrl->RigFreqUp));
 
             /* if device is engaged, send freq command to radio */
-            if ((ctrl->engaged) && (fabs(ctrl->lasttxf - tmpfreq) >= 1.0)) {
-                if (set_freq_simplex (ctrl, ctrl->sock2, tmpfreq)) {
-                    /* reset error counter */
-                    ctrl->errcnt = 0;
-
-                    /* give radio a chance to set frequency */
-                    g_usleep (WR_DEL);
-
-                    /* The actual frequency might be different from what we have set. */
-                    get_freq_simplex (ctrl, ctrl->sock2, &tmpfreq);
-                    ctrl->lasttxf = tmpfreq;
-                }
-                else {
-                    ctrl->errcnt++;
-                }
+            if ((ctrl->engaged) && (fabs(ctrl->lasttxf - tmpfreq) >= ctrl->conf2->fstep)) {
+                set_freq_simplex (ctrl, ctrl->io2, tmpfreq, &ctrl->lasttxf);
             }
         } /* else dialchange on uplink */
 
@@ -2333,36 +2490,21 @@ static void exec_dual_rig_cycle (GtkRigCtrl *ctrl)
 
 
 /** \brief Get PTT status
- *  \param ctrl Pointer to the GtkRigVtrl widget.
+ *  \param buffback The answer to get_ptt (t) or \get_dcd.
  *  \return TRUE if PTT is ON, FALSE if PTT is OFF or an error occurred.
  *
  */
-static gboolean get_ptt (GtkRigCtrl *ctrl, gint sock)
+static gboolean get_ptt (const gchar *buffback)
 {
-    gchar  *buff,**vbuff;
-    gchar  buffback[128];
-    gboolean retcode;
+    gchar  **vbuff;
     guint64  pttstat = 0;
 
-    
-    if (ctrl->conf->ptt == PTT_TYPE_CAT) {
-
-        /* send command get_ptt (t) */
-        buff = g_strdup_printf ("t\x0a");
-    }
-    else {
-        /* send command \get_dcd */
-        buff = g_strdup_printf ("%c\x0a",0x8b);
-    }
-    
-    retcode=send_rigctld_command(ctrl,sock,buff,buffback,128);
-    if (retcode) {
+    if (check_get_response (buffback, __FUNCTION__)) {
         vbuff = g_strsplit (buffback, "\n", 3);
         if (vbuff[0])
             pttstat = g_ascii_strtoull (vbuff[0], NULL, 0);  //FIXME base = 0 ok?
         g_strfreev (vbuff);
     }
-    g_free (buff);
 
     return (pttstat == 1) ? TRUE : FALSE;
 
@@ -2371,253 +2513,269 @@ static gboolean get_ptt (GtkRigCtrl *ctrl, gint sock)
 
 /** \brief Set PTT status
  * \param ctrl Pointer to the GtkRigCtrl data
- * \param conf Pointer to the radio conf data
+ * \param io The connection to the radio
  * \param ptt The new PTT value (TRUE=ON, FALSE=OFF)
- * \return TRUE if the operation was successful, FALSE if an error has occurred
  */
-static gboolean set_ptt (GtkRigCtrl *ctrl, gint sock, gboolean ptt)
+static void set_ptt (GtkRigCtrl *ctrl, hamlib_io_t *io, gboolean ptt)
 {
-    gchar  *buff;
-    gchar  buffback[128];
-    gboolean retcode;
-    
-    /* send command */
-    if (ptt == TRUE) {
-        buff = g_strdup_printf ("T 1\x0aq\x0a");
-    }
-    else {
-        buff = g_strdup_printf ("T 0\x0aq\x0a");
-    }
-    
-    retcode=send_rigctld_command(ctrl,sock,buff,buffback,128);
-    
-    g_free (buff);
-    return(check_set_response(buffback,retcode,__FUNCTION__));
-
+    queue_set (ctrl, io, (ptt == TRUE) ? "T 1" : "T 0", NULL, 0.0, NULL, __FUNCTION__);
 }
 
 
 
 /** \brief Set frequency in simplex mode
  * \param ctrl Pointer to the GtkRigCtrl structure.
+ * \param io The connection to the radio.
  * \param freq The new frequency.
- * \return TRUE if the operation was successful, FALSE if a connection error
- *         occurred.
- * 
- * \note freq is not strictly necessary for normal use since we could have
- *       gotten the current frequency from the ctrl; however, the param
- *       might become useful in the future.
+ * \param last Where to store the frequency of the radio (lastrxf or lasttxf).
+ *
+ * The actual frequency might be different from what we have set because
+ * the tuning step is larger than what we work with (e.g. FT-817 has a
+ * smallest tuning step of 10 Hz). Therefore we read back the actual
+ * frequency from the rig right after the set command and store it in
+ * \a last when the answers arrive. Nothing is stored if the command fails.
  */
-static gboolean set_freq_simplex (GtkRigCtrl *ctrl, gint sock, gdouble freq)
+static void set_freq_simplex (GtkRigCtrl *ctrl, hamlib_io_t *io, gdouble freq, gdouble *last)
 {
     gchar  *buff;
-    gchar  buffback[128];
-    gboolean retcode;
-
-    buff = g_strdup_printf ("F %10.0f\x0a", freq);    
-
-    retcode=send_rigctld_command(ctrl,sock,buff,buffback,128);
-    
-    g_free(buff);
-    return(check_set_response(buffback,retcode,__FUNCTION__));
 
+    buff = g_strdup_printf ("F %10.0f", freq);
+    queue_set (ctrl, io, buff, "f", freq, last, __FUNCTION__);
+    g_free (buff);
 }
 
 
 /** \brief Set frequency in toggle mode
  * \param ctrl Pointer to the GtkRigCtrl structure.
+ * \param io The connection to the radio.
  * \param freq The new frequency.
- * \return TRUE if the operation was successful, FALSE if a connection error
- *         occurred.
- * 
- * \note freq is not strictly necessary for normal use since we could have
- *       gotten the current frequency from the ctrl; however, the param
- *       might become useful in the future.
+ * \param last Where to store the frequency of the radio (lasttxf).
+ * \param readback Whether to read back the actual frequency like
+ *                 set_freq_simplex(). If FALSE, \a freq is stored in
+ *                 \a last even if the command fails.
  */
-
-static gboolean set_freq_toggle (GtkRigCtrl *ctrl, gint sock, gdouble freq)
+static void set_freq_toggle (GtkRigCtrl *ctrl, hamlib_io_t *io, gdouble freq,
+                             gdouble *last, gboolean readback)
 {
     gchar  *buff;
-    gchar   buffback[128];
-    gboolean retcode;
-
-    /* send command */
-    buff = g_strdup_printf ("I %10.0f\x0a", freq);
-
-    retcode=send_rigctld_command(ctrl,sock,buff,buffback,128);
-    
-    g_free(buff);
-
-    return(check_set_response(buffback,retcode,__FUNCTION__));
 
+    buff = g_strdup_printf ("I %10.0f", freq);
+    queue_set (ctrl, io, buff, readback ? "i" : NULL, freq, last, __FUNCTION__);
+    g_free (buff);
 }
 
 
 /** \brief Turn on the radios toggle mode
  * \param ctrl Pointer to the GtkRigCtrl structure.
- * \return TRUE if the operation was successful, FALSE if a connection error
- *         occurred.
- * 
+ * \param io The connection to the radio.
  */
-static gboolean set_toggle (GtkRigCtrl *ctrl, gint sock)
+static void set_toggle (GtkRigCtrl *ctrl, hamlib_io_t *io)
 {
     gchar  *buff;
-    gchar buffback[128];
-    gboolean retcode;
-
-    buff = g_strdup_printf ("S 1 %d\x0a",ctrl->conf->vfoDown);
-    
-    retcode=send_rigctld_command(ctrl,sock,buff,buffback,128);
-    
-    g_free(buff);
-    return(check_set_response(buffback,retcode,__FUNCTION__));
 
+    buff = g_strdup_printf ("S 1 %d", ctrl->conf->vfoDown);
+    queue_set (ctrl, io, buff, NULL, 0.0, NULL, __FUNCTION__);
+    g_free (buff);
 }
 
 /** \brief Turn off the radios toggle mode
  * \param ctrl Pointer to the GtkRigCtrl structure.
- * \return TRUE if the operation was successful, FALSE if a connection error
- *         occurred.
- * 
+ * \param io The connection to the radio.
  */
-
-static gboolean unset_toggle (GtkRigCtrl *ctrl, gint sock)
+static void unset_toggle (GtkRigCtrl *ctrl, hamlib_io_t *io)
 {
     gchar  *buff;
-    gchar buffback[128];
-    gboolean retcode;
-
-    /* send command */
-    buff = g_strdup_printf ("S 0 %d\x0a",ctrl->conf->vfoDown);
-
-    retcode=send_rigctld_command(ctrl,sock,buff,buffback,128);
-    
-    g_free(buff);
-
-    return(check_set_response(buffback,retcode,__FUNCTION__));
 
+    buff = g_strdup_printf ("S 0 %d", ctrl->conf->vfoDown);
+    queue_set (ctrl, io, buff, NULL, 0.0, NULL, __FUNCTION__);
+    g_free (buff);
 }
 
 
-
-
-
 /** \brief Get frequency
- * \param ctrl Pointer to the GtkRigCtrl structure.
- * \param freq The current frequency of the radio.
- * \return TRUE if the operation was successful, FALSE if a connection error
- *         occurred.
+ * \param buffback The answer to get_freq (f) or get_split_freq (i).
+ * \param freq Where to store the frequency; unchanged if an error occurred.
+ * \param function The name of the calling function for error messages.
+ * \return TRUE if the operation was successful, FALSE if an error occurred.
  */
-static gboolean get_freq_simplex (GtkRigCtrl *ctrl, gint sock, gdouble *freq)
+static gboolean get_freq (const gchar *buffback, gdouble *freq, const gchar *function)
 {
-    gchar  *buff,**vbuff;
-    gchar buffback[128];
-    gboolean retcode;
-    gboolean retval = TRUE;
+    gchar  **vbuff;
+    gboolean retval = FALSE;
 
-    buff = g_strdup_printf ("f\x0a");
-
-    retcode=send_rigctld_command(ctrl,sock,buff,buffback,128);
-    retcode=check_get_response(buffback,retcode,__FUNCTION__);
-    if (retcode) {
+    if (check_get_response (buffback, function)) {
         vbuff = g_strsplit (buffback, "\n", 3);
-        if (vbuff[0])
+        if (vbuff[0]) {
             *freq = g_ascii_strtod (vbuff[0], NULL);
-        else
-            retval = FALSE;
+            retval = TRUE;
+        }
         g_strfreev (vbuff);
-    } else {
-       retval = FALSE;
     }
-    return retval;
-}
-
-/** \brief Get frequency when the radio is working toggle
- * \param ctrl Pointer to the GtkRigCtrl structure.
- * \param freq The current frequency of the radio.
- * \return TRUE if the operation was successful, FALSE if a connection error
- *         occurred.
- */
-
-static gboolean get_freq_toggle (GtkRigCtrl *ctrl, gint sock, gdouble *freq)
-{
-    gchar  *buff,**vbuff;
-    gchar   buffback[128];
-    gboolean retcode;
-    gboolean retval=TRUE;
-
-    if (freq == NULL) {
-        sat_log_log (SAT_LOG_LEVEL_ERROR,
-                     _("%s:%d: NULL storage."),
-                     __FILE__, __LINE__);
-        return FALSE;
-    }
-    
-    /* send command */
-    buff = g_strdup_printf ("i\x0a");    
-
-    retcode=send_rigctld_command(ctrl,sock,buff,buffback,128);
-    retcode=check_get_response(buffback,retcode,__FUNCTION__);
-    if (retcode) {
-        vbuff = g_strsplit (buffback, "\n", 3);
-        if (vbuff[0]) 
-            *freq = g_ascii_strtod (vbuff[0], NULL);
-        else
-            retval = FALSE;
 
-        g_strfreev (vbuff);
-    } else {
-        retval = FALSE;
-    }
     return retval;
 }
 
 /** \brief Select target VFO
  * \param ctrl Pointer to the GtkRigCtrl structure.
  * \param vfo The VFO to select
- * \return TRUE if the operation was successful, FALSE if a connection error
- *         occurred.
  * 
  */
 #if 0
-static gboolean set_vfo (GtkRigCtrl *ctrl, vfo_t vfo)
+static void set_vfo (GtkRigCtrl *ctrl, vfo_t vfo)
 {
-    gchar  *buff;
-    gchar   buffback[128];
-    gboolean retcode;
+    const gchar *buff;
+
     switch (vfo) {
     case VFO_A:
-        buff = g_strdup_printf ("V VFOA\x0a");
+        buff = "V VFOA";
         break;
         
     case VFO_B:
-        buff = g_strdup_printf ("V VFOB\x0a");
+        buff = "V VFOB";
         break;
         
     case VFO_MAIN:
-        buff = g_strdup_printf ("V Main\x0a");
+        buff = "V Main";
         break;
         
     case VFO_SUB:
-        buff = g_strdup_printf ("V Sub\x0a");
+        buff = "V Sub";
         break;
         
     default:
         sat_log_log (SAT_LOG_LEVEL_ERROR,
                      _("%s: Invalid VFO argument. Using VFOA."),
                      __FUNCTION__);
-        buff = g_strdup_printf ("V VFOA\x0a");
+        buff = "V VFOA";
         break;
     }
 
-    retcode=send_rigctld_command(ctrl,ctrl->sock,buff,buffback,128);
- 
-    g_free(buff);
-    
-    return(check_set_response(buffback,retcode,__FUNCTION__));
+    queue_set (ctrl, ctrl->io, buff, NULL, 0.0, NULL, __FUNCTION__);
 }
 #endif
 
+
+/** \brief Queue a set command.
+ * \param ctrl Pointer to the GtkRigCtrl structure.
+ * \param io The connection to the radio.
+ * \param cmd The command without newline.
+ * \param readback Command reading back the frequency after it has been set,
+ *                 or NULL.
+ * \param freq The frequency that is set.
+ * \param last Where to store the frequency, or NULL for commands that don't
+ *             set a frequency. Only these commands count as errors.
+ * \param function The name of the calling function for error messages.
+ *
+ * The commands of a cycle are collected per radio and sent by send_jobs().
+ * Since rigctld answers the commands in order, the readback command reads
+ * the frequency after it has been set without waiting in between.
+ */
+static void queue_set (GtkRigCtrl *ctrl, hamlib_io_t *io, const gchar *cmd,
+                       const gchar *readback, gdouble freq, gdouble *last,
+                       const gchar *function)
+{
+    rig_job_t **job;
+    rig_set_t   set;
+
+    job = (io == ctrl->io2) ? &ctrl->job2 : &ctrl->job;
+    if (*job == NULL) {
+        *job = g_new0 (rig_job_t, 1);
+        (*job)->ctrl = ctrl;
+        (*job)->batch = hamlib_batch_new ();
+        (*job)->sets = g_array_new (FALSE, FALSE, sizeof (rig_set_t));
+    }
+
+    set.cmd = hamlib_batch_add ((*job)->batch, 1, "%s", cmd);
+    set.readback = (readback != NULL) ?
+        (gint) hamlib_batch_add ((*job)->batch, 1, "%s", readback) : -1;
+    set.freq = freq;
+    set.last = last;
+    set.function = function;
+
+    g_array_append_val ((*job)->sets, set);
+}
+
+
+/** \brief Send the queued commands.
+ * \param ctrl Pointer to the GtkRigCtrl structure.
+ * \param counted Whether the commands are part of the controller cycle, i.e.
+ *                whether the next cycle has to wait for them.
+ */
+static void send_jobs (GtkRigCtrl *ctrl, gboolean counted)
+{
+    rig_job_t  **job[2] = { &ctrl->job, &ctrl->job2 };
+    hamlib_io_t *io[2] = { ctrl->io, ctrl->io2 };
+    guint        i;
+
+    for (i = 0; i < 2; i++) {
+        if (*job[i] == NULL)
+            continue;
+
+        (*job[i])->counted = counted;
+        if (counted)
+            ctrl->pending++;
+        ctrl->wrops += hamlib_batch_size ((*job[i])->batch);
+
+        hamlib_io_send (io[i], (*job[i])->batch, job_done_cb, *job[i], job_free);
+
+        /* the batch is owned by hamlib-io now */
+        *job[i] = NULL;
+    }
+}
+
+
+/** \brief Check the answers to the set commands of a job.
+ * \param batch The answered commands.
+ * \param data The job.
+ */
+static void job_done_cb (hamlib_batch_t *batch, gpointer data)
+{
+    rig_job_t  *job = (rig_job_t *) data;
+    GtkRigCtrl *ctrl = job->ctrl;
+    rig_set_t  *set;
+    gboolean    ok;
+    guint       i;
+
+    for (i = 0; i < job->sets->len; i++) {
+        set = &g_array_index (job->sets, rig_set_t, i);
+
+        ok = check_set_response (hamlib_batch_reply (batch, set->cmd), set->function);
+        if (set->last == NULL)
+            continue;
+
+        if (set->readback < 0) {
+            /* store the last sent frequency even if an error occurred */
+            *set->last = set->freq;
+        }
+        else if (ok) {
+            *set->last = set->freq;
+            get_freq (hamlib_batch_reply (batch, set->readback), set->last, set->function);
+        }
+
+        if (ok) {
+            /* reset error counter */
+            ctrl->errcnt = 0;
+        }
+        else {
+            ctrl->errcnt++;
+        }
+    }
+
+    if (job->counted && (--ctrl->pending == 0))
+        check_error_count (ctrl);
+}
+
+
+/** \brief Free a job; the batch is freed by hamlib-io. */
+static void job_free (gpointer data)
+{
+    rig_job_t *job = (rig_job_t *) data;
+
+    g_array_free (job->sets, TRUE);
+    g_free (job);
+}
+
+
 /** \brief Update count down label.
  * \param[in] ctrl Pointer to the RigCtrl widget.
  * \param[in] t The current time.
@@ -2672,6 +2830,75 @@ static void update_count_down (GtkRigCtrl *ctrl, gdouble t)
 }
 
 
+/** \brief Update the Doppler shifts.
+ *  \param ctrl Pointer to the RigCtrl widget.
+ *
+ * The Doppler shifts are computed for the time when the commands sent now
+ * reach the radio: the time of the last module update plus the wall clock
+ * time since then and the mean round trip of the rigctld commands, scaled
+ * by the rate of the module time. The range rate at that time is
+ * interpolated from a curve that covers the current or next pass, or the
+ * next DOPPLER_SPAN if there is none, and is computed again when the time
+ * leaves the curve, the target changes or its TLE is updated.
+ */
+static void update_doppler (GtkRigCtrl *ctrl)
+{
+    hamlib_io_stats_t stats;
+    sat_t    *sat = ctrl->target->targeting;
+    pass_t   *pass = ctrl->target->pass;
+    sat_t     copy;
+    GTimeVal  now;
+    gdouble   delay, t, end, rr, satfreq;
+    gchar    *buff;
+
+    if ((sat == NULL) || (ctrl->t == 0.0))
+        return;
+
+    g_get_current_time (&now);
+    delay = (now.tv_sec - ctrl->tstamp.tv_sec) + 1.0e-6 * (now.tv_usec - ctrl->tstamp.tv_usec);
+    if (delay < 0.0)
+        delay = 0.0;
+    if (ctrl->io != NULL) {
+        hamlib_io_get_stats (ctrl->io, &stats);
+        delay += stats.mean;
+    }
+    t = ctrl->t + delay * ctrl->rate / secday;
+
+    if ((ctrl->curve == NULL) || (ctrl->curvesat != sat) ||
+        (ctrl->curve->epoch != sat->tle.epoch) ||
+        (t < ctrl->curve->start) || (t > ctrl->curve->end)) {
+
+        /* cover the whole pass if it is on or starts soon */
+        end = ctrl->t + DOPPLER_SPAN;
+        if ((pass != NULL) && (pass->aos < end) && (pass->los > ctrl->t))
+            end = pass->los;
+
+        /* the curve is computed on a copy so the target is not disturbed */
+        memcpy (&copy, sat, sizeof (sat_t));
+        doppler_curve_free (ctrl->curve);
+        ctrl->curve = doppler_curve_new (&copy, ctrl->qth, ctrl->t, end);
+        ctrl->curvesat = sat;
+    }
+
+    if ((ctrl->curve == NULL) || !doppler_curve_get (ctrl->curve, t, &rr))
+        rr = sat->range_rate;
+
+    /* Doppler shift down */
+    satfreq = gtk_freq_knob_get_value (GTK_FREQ_KNOB (ctrl->SatFreqDown));
+    ctrl->dd = -satfreq * (rr / 299792.4580); // Hz
+    buff = g_strdup_printf ("%.0f Hz", ctrl->dd);
+    gtk_label_set_text (GTK_LABEL (ctrl->SatDopDown), buff);
+    g_free (buff);
+    
+    /* Doppler shift up */
+    satfreq = gtk_freq_knob_get_value (GTK_FREQ_KNOB (ctrl->SatFreqUp));
+    ctrl->du = satfreq * (rr / 299792.4580); // Hz
+    buff = g_strdup_printf ("%.0f Hz", ctrl->du);
+    gtk_label_set_text (GTK_LABEL (ctrl->SatDopUp), buff);
+    g_free (buff);
+}
+
+
 /** \brief Load the transponder list for the target satellite.
  *  \param ctrl Pointer to the GtkRigCtrl structure.
  *
@@ -2881,56 +3108,6 @@ static gboolean is_rig_tx_capable (const gchar *confname)
 
 
 
-gboolean send_rigctld_command(GtkRigCtrl *ctrl, gint sock, gchar *buff, gchar *buffout, gint sizeout)
-{
-    gint    written;
-    gint    size;
-    
-    size = strlen(buff)-1;
-
-    sat_log_log (SAT_LOG_LEVEL_DEBUG,
-                 _("%s:%s: sending %d bytes to rigctld as \"%s\""),
-                 __FILE__, __FUNCTION__, size, buff);
-    /* send command */
-    written = send(sock, buff, strlen(buff), 0);
-    if (written != size) {
-        sat_log_log (SAT_LOG_LEVEL_ERROR,
-                     _("%s: SIZE ERROR %d / %d"),
-                     __FUNCTION__, written, size);
-    }
-    if (written == -1) {
-        sat_log_log (SAT_LOG_LEVEL_ERROR,
-                     _("%s: rigctld port closed"),
-                     __FUNCTION__);
-        return FALSE;
-    }
-    /* try to read answer */
-    size = recv (sock, buffout, sizeout - 1, 0);
-    if (size == -1) {
-        sat_log_log (SAT_LOG_LEVEL_ERROR,
-                     _("%s: rigctld port closed"),
-                     __FUNCTION__);
-        return FALSE;
-    }
-
-    buffout[size]='\0';
-    if (size == 0) {
-        sat_log_log (SAT_LOG_LEVEL_ERROR,
-                     _("%s:%s: Got 0 bytes from rigctld"),
-                     __FILE__, __FUNCTION__);
-    }
-    else {
-        sat_log_log (SAT_LOG_LEVEL_DEBUG,
-                     _("%s:%s: Read %d bytes from rigctld"),
-                     __FILE__, __FUNCTION__, size);
-        
-    }
-    ctrl->wrops++;
-    
-    return TRUE;
-}
-
-
 /** \brief Manage key press event on the controller widget
   * \param widget Pointer to the GtkRigCtrl widget that received the event
   * \param pKey Pointer to the event that has happened
@@ -2986,142 +3163,85 @@ static gboolean key_press_cb (GtkWidget *widget, GdkEventKey *pKey, gpointer dat
  * the spacebar. It is only useful for RIG_TYPE_TOGGLE_MAN and possibly for 
  * RIG_TYPE_TOGGLE_AUTO.
  * 
- * First, the function will try to lock the controller. If the lock is acquired
- * the function checks the current PTT status.
- * If PTT status is FALSE (off), it will set the TX frequency and set PTT to TRUE (on).
- * If PTT status is TRUE (on) it will simply set the PTT to FALSE (off).
+ * The event is stored and the PTT status is read right away, unless a
+ * controller cycle is running; then it is read by the next cycle. The event
+ * is executed by exec_ptt_toggle() when the PTT status is known.
  * 
  * \warning This function assumes that the radio supprot set/get PTT, otherwise
  *          it makes no sense to use it!
  */
 static void manage_ptt_event (GtkRigCtrl *ctrl)
 {
-    guint timeout = 1;
-    gboolean ptt = FALSE;
-    
-
-    /* wait for controller to be idle or until the timeout triggers */
-    while (timeout < 5) {
-        if (g_static_mutex_trylock(&(ctrl->busy)) == TRUE) {
-            timeout = 17; /* use an arbitrary value that is large enough */
-        }
-        else {
-            /* wait for 100 msec */
-            g_usleep (100000);
-            timeout++;
-        }
-    }
-
-    if (timeout == 17) {
-        /* timeout did not expire, we've got the controller lock */
-        sat_log_log (SAT_LOG_LEVEL_DEBUG,
-                     _("%s: Acquired controller lock"),
+    if (ctrl->engaged == FALSE) {       
+        sat_log_log (SAT_LOG_LEVEL_INFO,
+                     _("%s: Controller not engaged; PTT event ignored (Hint: Enable the Engage button)"),
                      __FUNCTION__);
+        return;
+    }
 
-        if (ctrl->engaged == FALSE) {       
-            sat_log_log (SAT_LOG_LEVEL_INFO,
-                         _("%s: Controller not engaged; PTT event ignored (Hint: Enable the Engage button)"),
-                         __FUNCTION__);
-        }
-        else {
+    ctrl->ptt_event = TRUE;
 
-            ptt = get_ptt (ctrl, ctrl->sock);        
-        
-            if (ptt == FALSE) {
-                /* PTT is OFF => set TX freq then set PTT to ON */
-                sat_log_log (SAT_LOG_LEVEL_DEBUG,
-                             _("%s: PTT is OFF => Set TX freq and PTT=ON"),
-                             __FUNCTION__);
-                             
-                exec_toggle_tx_cycle (ctrl);
-                set_ptt(ctrl, ctrl->sock, TRUE);
-            }
-            else {
-                /* PTT is ON => set to OFF */
-                sat_log_log (SAT_LOG_LEVEL_DEBUG,
-                             _("%s: PTT is ON = Set PTT=OFF"),
-                             __FUNCTION__);
-                             
-                set_ptt(ctrl, ctrl->sock, FALSE);
-            }
-        }
-        
-        /* release controller lock */
-        g_static_mutex_unlock(&(ctrl->busy));
-    }
-    else {
-        sat_log_log (SAT_LOG_LEVEL_ERROR,
-                     _("%s: Failed to acquire controller lock; PTT event not handled"),
-                     __FUNCTION__);
-    }
-   
+    if (ctrl->pending == 0)
+        start_cycle (ctrl);
 }
 
 
-static gboolean open_rigctld_socket (radio_conf_t *conf, gint *sock) {
-    struct sockaddr_in ServAddr;
-    struct hostent *h;
-    gint status;
-
-    *sock=socket(PF_INET,SOCK_STREAM,IPPROTO_TCP);
-    if (*sock < 0) {
-        sat_log_log (SAT_LOG_LEVEL_ERROR,
-                     _("%s: Failed to create socket"),
+/** \brief Toggle PTT.
+ * \param ctrl Pointer to the radio controller data.
+ * 
+ * If PTT status is FALSE (off), the TX frequency is set followed by PTT ON.
+ * If PTT status is TRUE (on) it will simply set the PTT to FALSE (off).
+ */
+static void exec_ptt_toggle (GtkRigCtrl *ctrl)
+{
+    if (ctrl->ptt == FALSE) {
+        /* PTT is OFF => set TX freq then set PTT to ON */
+        sat_log_log (SAT_LOG_LEVEL_DEBUG,
+                     _("%s: PTT is OFF => Set TX freq and PTT=ON"),
                      __FUNCTION__);
-        *sock = 0;
-        return FALSE;
+                     
+        exec_toggle_tx_cycle (ctrl);
+        set_ptt (ctrl, ctrl->io, TRUE);
     }
     else {
+        /* PTT is ON => set to OFF */
         sat_log_log (SAT_LOG_LEVEL_DEBUG,
-                     _("%s: Network socket created successfully"),
+                     _("%s: PTT is ON = Set PTT=OFF"),
                      __FUNCTION__);
+                     
+        set_ptt (ctrl, ctrl->io, FALSE);
     }
+}
 
-    memset(&ServAddr, 0, sizeof(ServAddr));     /* Zero out structure */
-    ServAddr.sin_family = AF_INET;             /* Internet address family */
-    h = gethostbyname(conf->host);
-    memcpy((char *) &ServAddr.sin_addr.s_addr, h->h_addr_list[0], h->h_length);
-    ServAddr.sin_port = htons(conf->port); /* Server port */
 
-    /* establish connection */
-    status = connect(*sock, (struct sockaddr *) &ServAddr, sizeof(ServAddr));
-    if (status < 0) {
-        sat_log_log (SAT_LOG_LEVEL_ERROR,
-                     _("%s: Failed to connect to %s:%d"),
-                     __FUNCTION__, conf->host, conf->port);
-        *sock = 0;
-        return FALSE;
-    }
-    else {
-        sat_log_log (SAT_LOG_LEVEL_DEBUG,
-                     _("%s: Connection opened to %s:%d"),
-                     __FUNCTION__, conf->host, conf->port);
-    }
+/** \brief Close the connections to rigctld.
+ * \param ctrl Pointer to the radio controller data.
+ *
+ * Commands that have been sent are still written but their answers are
+ * ignored. The cycle in progress, if any, is abandoned.
+ */
+static void close_rigctld (GtkRigCtrl *ctrl)
+{
+    hamlib_io_t       **io[2] = { &ctrl->io, &ctrl->io2 };
+    hamlib_io_stats_t   stats;
+    guint               i;
 
-    return TRUE;
-}
+    for (i = 0; i < 2; i++) {
+        if (*io[i] == NULL)
+            continue;
 
-static gboolean close_rigctld_socket (gint *sock) {
-  gint written;
-  /*shutdown the rigctld connect*/
-  written = send(*sock, "q\x0a", 2, 0);
-  if (written != 2) {
-      sat_log_log (SAT_LOG_LEVEL_ERROR,
-                   _("%s:%s: Sent 2 bytes but sent %d."),
-                   __FILE__, __FUNCTION__, written);
-  }
-#ifndef WIN32
-  shutdown (*sock, SHUT_RDWR);
-  close (*sock);
-#else
-  shutdown (*sock, SD_BOTH);
-  closesocket (*sock);
-#endif
-  
+        hamlib_io_get_stats (*io[i], &stats);
+        sat_log_log (SAT_LOG_LEVEL_DEBUG,
+                     _("%s: %d commands, %d errors, round trip %.1f ms (max %.1f ms)"),
+                     __FUNCTION__, stats.num, stats.errors,
+                     1000.0 * stats.mean, 1000.0 * stats.max);
 
-  *sock = 0;
+        hamlib_io_close (*io[i]);
+        *io[i] = NULL;
+    }
 
-  return TRUE;
+    ctrl->pending = 0;
+    ctrl->ptt_event = FALSE;
 }
 
 /** \brief Simple function to sort the list of satellites in the combo box.
@@ -3139,150 +3259,60 @@ static gint rig_name_compare (const gchar *a, const gchar *b){
     return (gpredict_strcmp(a,b));
 }
 
-/** \brief Check hamlib rigctld response
- *  \param buffback
- *  \param retcode
- *  \param function
- *  \return TRUE if the check was successful?
+/** \brief Check hamlib rigctld response to a set command
+ *  \param buffback The answer, or NULL if the connection failed.
+ *  \param function The name of the calling function.
+ *  \return TRUE if the command was successful.
  */
-static inline gboolean check_set_response (gchar *buffback, gboolean retcode, const gchar *function){
-    if (retcode==TRUE)
-        if (strncmp(buffback,"RPRT 0",6)!=0) {
-            sat_log_log (SAT_LOG_LEVEL_ERROR,
-                         _("%s: %s rigctld returned error (%s)"),
-                         __FILE__,function,buffback);
-            
-            retcode=FALSE;
-        }
-    return retcode;
-}
+static inline gboolean check_set_response (const gchar *buffback, const gchar *function){
+    if (buffback == NULL)
+        return FALSE;
 
-/** \brief Check hamlib rigctld response
- *  \param buffback
- *  \param retcode
- *  \param function
- *  \return TRUE if the check was successful?
- */
-static inline gboolean check_get_response (gchar *buffback,gboolean retcode,const gchar *function){
-    if (retcode==TRUE)
-        if (strncmp(buffback,"RPRT",4)==0) {
-            sat_log_log (SAT_LOG_LEVEL_ERROR,
-                         _("%s: %s rigctld returned error (%s)"),
-                         __FILE__,function,buffback);
-            
-            retcode=FALSE;
-        }
-    return retcode;
+    if (strncmp(buffback,"RPRT 0",6)!=0) {
+        sat_log_log (SAT_LOG_LEVEL_ERROR,
+                     _("%s: %s rigctld returned error (%s)"),
+                     __FILE__,function,buffback);
+        return FALSE;
+    }
+
+    return TRUE;
 }
 
-/** \brief Chooses the Next Element to be Tracked
- *  \param ctrl Pointer to GtkRigCtrl
- *
- *  This function chooses the next satellite to be tracked according to
- *  the order of the satellites in the priority list. If the LOS - AOS 
- *  of a satellite is smaller than the minimum communication time of that 
- *  satellite, this one is not choosen. 
- *
- *  TODO : Implementation that takes in account minimum elevation
+/** \brief Check hamlib rigctld response to a get command
+ *  \param buffback The answer, or NULL if the connection failed.
+ *  \param function The name of the calling function.
+ *  \return TRUE if the answer contains a value.
  */
-static void
-        next_elem_to_track(GtkRigCtrl* ctrl)
-{
-    int i, num_sats;
-    gdouble aos_old, los_old, aos, los;
-    gboolean trackable_sat = FALSE, passing;
-    sat_t *sat_old, *sat_new;
-    pass_t *pass;
-    guint dt;
-
-    /* set variables */
-    num_sats = ctrl->target->numSatToTrack;
+static inline gboolean check_get_response (const gchar *buffback, const gchar *function){
+    if (buffback == NULL)
+        return FALSE;
 
-    if(num_sats <= 0)
+    if (strncmp(buffback,"RPRT",4)==0) {
         sat_log_log (SAT_LOG_LEVEL_ERROR,
-                     _("%s:%d: Error tracking new satellite"),
-                     __FILE__, __LINE__);
-
-    /* Gets the first possible satellite of the priority queue */
-    for(i=0; i < num_sats; i++){
-        sat_old = SAT (g_slist_nth_data(ctrl->sats, ctrl->target->priorityQueue[i]));
-        if(sat_old->el > 0.0f && sat_old->aos > 0) {
-            pass = get_current_pass(sat_old, ctrl->qth, 0.0);
-            aos_old = pass->aos;
-            los_old = pass->los;
-            free_pass(pass);
-        }
-        else {
-            aos_old = sat_old->aos;
-            los_old = sat_old->los;
-        }
-
-        /* convert julian date to seconds */
-        dt = (guint) ((los_old - aos_old) * 86400);
-
-        /* if we have the minimal communication time needded */
-        if(dt > ctrl->target->minCommunication[ctrl->target->priorityQueue[i]] || (aos_old < FLT_MIN && sat_old->el > 0.0f)){
-            trackable_sat = TRUE;
-            i++;
-            break;
-        }
+                     _("%s: %s rigctld returned error (%s)"),
+                     __FILE__,function,buffback);
+        return FALSE;
     }
 
-    for(;i < num_sats; i++){
-        /* Gets the next satellite in the priority queue */
-        sat_new = SAT (g_slist_nth_data(ctrl->sats, ctrl->target->priorityQueue[i]));
-        passing = FALSE;
-        if(sat_new->el > 0.0f && sat_new->aos > 0) {
-            passing = TRUE;
-            pass = get_current_pass(sat_new, ctrl->qth, 0.0);
-            aos = pass->aos;
-            los = pass->los;
-            free_pass(pass);
-        }
-        else {
-            aos = sat_new->aos;
-            los = sat_new->los;
-        }
-
-        /* convert julian date to seconds */
-        dt = (guint) ((los - aos) * 86400);
-
-        /* if we have the minimal communication time needded */
-        if(dt > ctrl->target->minCommunication[ctrl->target->priorityQueue[i]] || (aos < FLT_MIN && sat_new->el > 0.0f)){
-            /* if the new satellite will set before the rise of the old one */
-            if((aos_old > los && sat_old->el < FLT_MIN) || (passing && aos_old < FLT_MIN)){
-                sat_old = sat_new;
-                aos_old = aos;
-            }
-        }
-    }
-    if(trackable_sat == TRUE){
-        ctrl->target->targeting = sat_old;
-        if(sat_old->el > 0.0f) 
-            ctrl->target->pass = get_current_pass(sat_old, ctrl->qth, 0.0);
-        else 
-            ctrl->target->pass = get_pass(sat_old, ctrl->qth, 0.0, 3.0f);
-    }
-    else {
-        ctrl->target->targeting = NULL;
-        ctrl->target->pass = NULL;
-    }
+    return TRUE;
 }
 
 /** \brief Updates the Next Element to be Tracked
  *  \param ctrl Pointer to GtkRigCtrl
  *
- *  This function updates the fields:
+ *  This function looks up the target in the schedule of the priority
+ *  queue, which updates the fields:
  *  * ctrl->target->targeting
  *  * ctrl->target->pass
- *  setting the new satellite to target
+ *  The label and the transponders are only updated when the target or its
+ *  pass has changed.
  */
 static void
         update_tracked_elem(GtkRigCtrl * ctrl)
 {
-    if(ctrl->target->numSatToTrack > 0){
-        next_elem_to_track(ctrl);
-    }
+    if(!schedule_priority_queue(ctrl->target, ctrl->qth, ctrl->t, &ctrl->target_serial))
+        return;
+
     if(ctrl->target->targeting != NULL){
         gtk_label_set_text((GtkLabel *)ctrl->track_sat, ctrl->target->targeting->nickname); 
 
@@ -3293,3 +3323,38 @@ static void
         gtk_label_set_text((GtkLabel *)ctrl->track_sat, " --- ");
     }
 }
+
+/** \brief Show the priority queue in the satellite lists.
+ *  \param ctrl Pointer to the GtkRigCtrl widget.
+ *
+ * The queue is shared with the rotator controller of the module, so the lists
+ * are loaded when they are created and whenever the other controller has
+ * changed the queue.
+ */
+static void
+        load_target_lists(GtkRigCtrl * ctrl)
+{
+    GtkTreeIter iter;
+    gboolean valid;
+    gchar *buff;
+    gint i;
+
+    valid = gtk_tree_model_get_iter_first(GTK_TREE_MODEL(ctrl->checkSatsList), &iter);
+    for(i = 0; valid; i++){
+        buff = g_strdup_printf("%f", ctrl->target->minCommunication[i]);
+        gtk_list_store_set(ctrl->checkSatsList, &iter,
+                           TOGGLE_COLUMN, ctrl->target->sats[i] != NOT_IN_PRIORITY_QUEUE,
+                           QNT_COLUMN, buff, -1);
+        g_free(buff);
+        valid = gtk_tree_model_iter_next(GTK_TREE_MODEL(ctrl->checkSatsList), &iter);
+    }
+
+    gtk_list_store_clear(ctrl->prioritySatsList);
+    for(i = 0; i < ctrl->target->numSatToTrack; i++){
+        gtk_list_store_append(ctrl->prioritySatsList, &iter);
+        gtk_list_store_set(ctrl->prioritySatsList, &iter, TEXT_COLUMN,
+                           ctrl->target->satv[ctrl->target->priorityQueue[i]]->nickname, -1);
+    }
+
+    ctrl->queue_serial = ctrl->target->serial;
+}
@@ -37,6 +37,8 @@
 #include "radio-conf.h"
 #include "trsp-conf.h"
 #include "target-sat.h"
+#include "hamlib-io.h"
+#include "doppler-curve.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -57,6 +59,9 @@ extern "C" {
 typedef struct _gtk_rig_ctrl      GtkRigCtrl;
 typedef struct _GtkRigCtrlClass   GtkRigCtrlClass;
 
+/** \brief Commands of one controller cycle for one radio (private). */
+typedef struct _rig_job           rig_job_t;
+
 
 
 struct _gtk_rig_ctrl
@@ -80,6 +85,8 @@ struct _gtk_rig_ctrl
     GtkListStore *prioritySatsList;
     GtkListStore *checkSatsList;
     TargetSat    *target;   /*!< Priority list and target satellite */  
+    guint         queue_serial;  /*!< Serial of the queue shown in the lists */
+    guint         target_serial; /*!< Serial of the target last seen */
 
     /* other widgets */
     GtkWidget *TrspSel;  /*!< Transponder selector */
@@ -100,18 +107,36 @@ struct _gtk_rig_ctrl
     guint timerid;     /*!< Timer ID */
     
     gboolean tracking;  /*!< Flag set when we are tracking a target. */
-    GStaticMutex busy;/*!< Flag set when control algorithm is busy. */
+    guint    pending;   /*!< Number of unanswered batches of the current cycle. */
     gboolean engaged;   /*!< Flag indicating that rig device is engaged. */
     gint     errcnt;    /*!< Error counter. */
     
     gdouble lastrxf;    /*!< Last frequency sent to receiver. */
     gdouble lasttxf;    /*!< Last frequency sent to tranmitter. */
-    gdouble du,dd;      /*!< Last computed up/down Doppler shift; computed in update() */
+    gdouble du,dd;      /*!< Last computed up/down Doppler shift; computed in update_doppler() */
+    
+    gdouble   t;        /*!< Time of the last update from the module (Julian date). */
+    GTimeVal  tstamp;   /*!< Wall clock time of the last update. */
+    gdouble   rate;     /*!< Module time per wall clock time (throttle). */
+    doppler_curve_t *curve;     /*!< Range rate of the target around t. */
+    sat_t           *curvesat;  /*!< Satellite the curve was computed for. */
     
     glong last_toggle_tx;  /*!< Last time when exec_toggle_tx_cycle() was executed (seconds)
                                 -1 indicates that an update should be performed ASAP */
     
-    gint sock, sock2;   /*!< Sockets for controlling the radio(s). */
+    hamlib_io_t *io, *io2;   /*!< Connections to rigctld of the radio(s). */
+    rig_job_t   *job, *job2; /*!< Commands queued in the current cycle. */
+
+    /* radio state read at the beginning of the cycle */
+    gboolean ptt_event;  /*!< User requested to toggle PTT (spacebar). */
+    gboolean pollptt;    /*!< PTT status has been read in this cycle. */
+    gboolean ptt;        /*!< PTT status of the primary radio. */
+    gboolean readf_ok;   /*!< readf is valid. */
+    gboolean readi_ok;   /*!< readi is valid. */
+    gboolean readf2_ok;  /*!< readf2 is valid. */
+    gdouble  readf;      /*!< Frequency of the primary radio. */
+    gdouble  readi;      /*!< TX frequency of the primary radio (duplex). */
+    gdouble  readf2;     /*!< Frequency of the secondary radio. */
 
     /* debug related */
     guint    wrops;
@@ -128,6 +153,7 @@ struct _GtkRigCtrlClass
 GType      gtk_rig_ctrl_get_type (void);
 GtkWidget* gtk_rig_ctrl_new      (GtkSatModule *module);
 void       gtk_rig_ctrl_update   (GtkRigCtrl *ctrl, gdouble t);
+void       gtk_rig_ctrl_set_slew (GtkRigCtrl *ctrl, gdouble azrate, gdouble elrate);
 
 
 #ifdef __cplusplus
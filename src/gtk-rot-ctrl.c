@@ -48,6 +48,7 @@
 #include "gtk-polar-plot.h"
 #include "gtk-rot-knob.h"
 #include "gtk-rot-ctrl.h"
+#include "gtk-rig-ctrl.h"
 #include "orbit-tools.h"
 #include "sat-cfg.h"
 #include "target-sat.h"
@@ -55,22 +56,15 @@
 #  include <build-config.h>
 #endif
 
-/* NETWORK */
-//#include <sys/types.h>
 #ifndef WIN32
-#include <sys/socket.h>     /* socket(), connect(), send() */
-#include <netinet/in.h>     /* struct sockaddr_in */
-#include <arpa/inet.h>      /* htons() */
-#include <netdb.h>          /* gethostbyname() */
 #include <sys/stat.h>
 #include <fcntl.h>
-#else
-#include <winsock2.h>
 #endif
-/* END */
 
 #define FMTSTR "%7.2f\302\260"
-#define MAX_ERROR_COUNT 5
+
+/** \brief Largest believable time rate; faster changes are time jumps. */
+#define MAX_TIME_RATE   100.0
 
 
 static void gtk_rot_ctrl_class_init (GtkRotCtrlClass *class);
@@ -89,6 +83,7 @@ static void store_sats (gpointer key, gpointer value, gpointer user_data);
 static void sat_selected_cb (GtkCellRendererToggle *cell_renderer, gchar *path_str, gpointer user_data);
 static void sat_increased_priority_cb(GtkButton *button, gpointer data);
 static void sat_decreased_priority_cb(GtkButton *button, gpointer data);
+static void save_schedule_cb(GtkButton *button, gpointer data);
 static void sat_changed_minCommunication_cb(GtkCellRendererText *cellrenderertext, gchar *arg1, gchar *arg2, gpointer user_data);
 static void track_toggle_cb (GtkToggleButton *button, gpointer data);
 static void delay_changed_cb (GtkSpinButton *spin, gpointer data);
@@ -99,12 +94,8 @@ static gboolean rot_ctrl_timeout_cb (gpointer data);
 static void update_count_down (GtkRotCtrl *ctrl, gdouble t);
 static void targeting_to_fifo(GtkRotCtrl *ctrl);
 
-static gboolean get_pos (GtkRotCtrl *ctrl, gdouble *az, gdouble *el);
-static gboolean set_pos (GtkRotCtrl *ctrl, gdouble az, gdouble el);
-
-static gboolean send_rotctld_command(GtkRotCtrl *ctrl, gchar *buff, gchar *buffout, gint sizeout);
-static gboolean open_rotctld_socket (GtkRotCtrl *ctrl);
-static gboolean close_rotctld_socket (gint *sock);
+static void rot_state_cb (const rotor_state_t *state, gpointer data);
+static void stop_loop (GtkRotCtrl *ctrl);
 
 static gboolean have_conf (void);
 static gint sat_name_compare (sat_t* a,sat_t*b);
@@ -113,8 +104,8 @@ static gint rot_name_compare (const gchar* a,const gchar *b);
 static gboolean is_flipped_pass (pass_t * pass,rot_az_type_t type);
 static inline void set_flipped_pass (GtkRotCtrl* ctrl);
 
-static void next_elem_to_track(GtkRotCtrl* ctrl);
 static void update_tracked_elem(GtkRotCtrl * ctrl);
+static void load_target_lists(GtkRotCtrl * ctrl);
 
 static GtkVBoxClass *parent_class = NULL;
 
@@ -175,17 +166,18 @@ static void
     ctrl->sats = NULL;
 
     ctrl->target = NULL;
+    ctrl->queue_serial = 0;
+    ctrl->target_serial = 0;
 
     ctrl->plot = NULL;
-    ctrl->sock = 0;
+    ctrl->loop = NULL;
+    ctrl->rate = 1.0;
 
     ctrl->tracking = FALSE;
-    g_static_mutex_init(&(ctrl->busy));
     ctrl->engaged = FALSE;
     ctrl->delay = 1000;
     ctrl->timerid = 0;
     ctrl->tolerance = 5.0;
-    ctrl->errcnt = 0;
 }
 
 static void
@@ -205,9 +197,13 @@ static void
         ctrl->conf = NULL;
     }
     
-    /*close the socket if it is still open*/
-    if (ctrl->sock!=0) {
-        close_rotctld_socket(&(ctrl->sock));
+    /* stop the control loop if it is still running */
+    stop_loop (ctrl);
+
+    /* release the priority queue, which the radio controller may still use */
+    if (ctrl->target != NULL) {
+        free_priority_queue (ctrl->target);
+        ctrl->target = NULL;
     }
 
     (* GTK_OBJECT_CLASS (parent_class)->destroy) (object);
@@ -241,13 +237,20 @@ GtkWidget *
 
     /* store current time (don't know if real or simulated) */
     GTK_ROT_CTRL (widget)->t = module->tmgCdnum;
+    g_get_current_time (&GTK_ROT_CTRL (widget)->tstamp);
     
     /* store QTH */
     GTK_ROT_CTRL (widget)->qth = module->qth;
      
-    /* Init structure target */
-    num_sats = g_slist_length (GTK_ROT_CTRL (widget)->sats);
-    GTK_ROT_CTRL (widget)->target = new_priority_queue(num_sats);
+    /* Init structure target; the queue is shared with the radio controller */
+    if (module->rigctrl != NULL) {
+        GTK_ROT_CTRL (widget)->target = ref_priority_queue (GTK_RIG_CTRL (module->rigctrl)->target);
+    }
+    else {
+        num_sats = g_slist_length (GTK_ROT_CTRL (widget)->sats);
+        GTK_ROT_CTRL (widget)->target = new_priority_queue(num_sats);
+        set_sats_priority_queue (GTK_ROT_CTRL (widget)->target, GTK_ROT_CTRL (widget)->sats);
+    }
     
     /* initialise custom colors */
     gdk_rgb_find_color (gtk_widget_get_colormap (widget), &ColBlack);
@@ -316,14 +319,33 @@ void targeting_to_fifo(GtkRotCtrl *ctrl)
  * 
  * This function is called by the parent, i.e. GtkSatModule, indicating that
  * the satellite data has been updated. The function updates the internal state
- * of the controller and the rotator.
+ * of the controller and looks up the target in the schedule; the timer only
+ * publishes the target to the control loop.
  */
 void
         gtk_rot_ctrl_update   (GtkRotCtrl *ctrl, gdouble t)
 {
-    gchar *buff;
+    GTimeVal now;
+    gdouble  wall;
+    gchar   *buff;
     
+    /* measure the rate of the module time, which may be throttled */
+    g_get_current_time (&now);
+    wall = (now.tv_sec - ctrl->tstamp.tv_sec) + 1.0e-6 * (now.tv_usec - ctrl->tstamp.tv_usec);
+    if ((ctrl->t > 0.0) && (wall > 0.0)) {
+        ctrl->rate = (t - ctrl->t) * secday / wall;
+        if (fabs (ctrl->rate) > MAX_TIME_RATE)
+            ctrl->rate = 1.0;
+    }
     ctrl->t = t;
+    ctrl->tstamp = now;
+
+    /* the radio controller may have changed the shared priority queue */
+    if (ctrl->queue_serial != ctrl->target->serial)
+        load_target_lists (ctrl);
+
+    /* the satellite data only changes here */
+    update_tracked_elem (ctrl);
 
     if (ctrl->target->targeting) {
 
@@ -336,76 +358,21 @@ void
         g_free (buff);
         
         update_count_down (ctrl, t);
-
-        /*if the current pass is too far away*/
-        if ((ctrl->target->pass!=NULL)&& (ctrl->qth!=NULL))
-            if (qth_small_dist(ctrl->qth,ctrl->target->pass->qth_comp)>1.0){
-                free_pass (ctrl->target->pass);
-                ctrl->target->pass=NULL;
-                ctrl->target->pass = get_pass (ctrl->target->targeting, ctrl->qth, t, 3.0);
-                if (ctrl->target->pass) {
-                    set_flipped_pass(ctrl);
-                    /* update polar plot */
-                    gtk_polar_plot_set_pass (GTK_POLAR_PLOT (ctrl->plot), ctrl->target->pass);
-                }
-            }
-        
-        /* update next pass if necessary */
-        if (ctrl->target->pass != NULL) {
-            /*if we are not in the current pass*/
-            if ((ctrl->target->pass->aos>t)||(ctrl->target->pass->los<t)){
-                /* the pass may not have met the minimum 
-                   elevation, calculate the pass and plot it*/
-                if (ctrl->target->targeting->el >= 0.0) {
-                    /*inside an unexpected/unpredicted pass*/
-                    free_pass (ctrl->target->pass);
-                    ctrl->target->pass=NULL;
-                    ctrl->target->pass = get_current_pass (ctrl->target->targeting, ctrl->qth, t);
-                    set_flipped_pass(ctrl);
-                    gtk_polar_plot_set_pass (GTK_POLAR_PLOT (ctrl->plot), ctrl->target->pass);
-                } else if ((ctrl->target->targeting->aos-ctrl->target->pass->aos)>(ctrl->delay/secday/1000/4.0)) {
-                    /*the target is expected to appear in a new pass 
-                      sufficiently later after the current pass says*/
-                    
-                    /*converted milliseconds to gpredict time and took a 
-                      fraction of it as a threshold for deciding a new pass*/
-                    
-                    /*if the next pass is not the one for the target*/
-                    free_pass (ctrl->target->pass);
-                    ctrl->target->pass=NULL;
-                    ctrl->target->pass = get_pass (ctrl->target->targeting, ctrl->qth, t, 3.0);
-                    set_flipped_pass(ctrl);
-                    /* update polar plot */
-                    gtk_polar_plot_set_pass (GTK_POLAR_PLOT (ctrl->plot), ctrl->target->pass);
-                }
-            } else {
-                /* inside a pass and target dropped below the 
-                   horizon so look for a new pass */
-                if (ctrl->target->targeting->el < 0.0) {
-                    free_pass (ctrl->target->pass);
-                    ctrl->target->pass=NULL;
-                    ctrl->target->pass = get_pass (ctrl->target->targeting, ctrl->qth, t, 3.0);
-                    set_flipped_pass(ctrl);
-                    /* update polar plot */
-                    gtk_polar_plot_set_pass (GTK_POLAR_PLOT (ctrl->plot), ctrl->target->pass);
-                }
-            }
-        }
-        else {
-            /* we don't have any current pass; store the current one */
-            if (ctrl->target->targeting->el > 0.0) {
-                ctrl->target->pass = get_current_pass (ctrl->target->targeting, ctrl->qth, t);
-            }
-            else {
-                ctrl->target->pass = get_pass (ctrl->target->targeting, ctrl->qth, t, 3.0);
-            }
-            set_flipped_pass(ctrl);
-            /* update polar plot */
-            gtk_polar_plot_set_pass (GTK_POLAR_PLOT (ctrl->plot), ctrl->target->pass);
-        }
     }
 }
 
+/** \brief Get the slew rates of the selected rotator.
+ * \param ctrl Pointer to the GtkRotCtrl.
+ * \param azrate Where the azimuth rate is stored [deg/sec]; 0 if unknown.
+ * \param elrate Where the elevation rate is stored [deg/sec]; 0 if unknown.
+ */
+void
+        gtk_rot_ctrl_get_slew (GtkRotCtrl *ctrl, gdouble *azrate, gdouble *elrate)
+{
+    *azrate = (ctrl->conf != NULL) ? ctrl->conf->azrate : 0.0;
+    *elrate = (ctrl->conf != NULL) ? ctrl->conf->elrate : 0.0;
+}
+
 
 /** \brief Create azimuth control widgets.
  * \param ctrl Pointer to the GtkRotCtrl widget.
@@ -490,7 +457,7 @@ static
 static
         GtkWidget *create_target_widgets (GtkRotCtrl *ctrl)
 {
-    GtkWidget *frame,*table,*satsel, *high_but, *low_but;
+    GtkWidget *frame,*table,*satsel, *high_but, *low_but, *save_but;
     GtkTreeViewColumn *sat_nickname, *checkbox, *minCommunication;
     GtkCellRenderer *rend_sat_nickname, *rend_checkbox, *rend_minCommunication;
     GtkWidget *tree;
@@ -498,7 +465,7 @@ static
     guint i, num_sats;
     sat_t *sat = NULL;
     
-    table = gtk_table_new (6, 5, FALSE);
+    table = gtk_table_new (7, 5, FALSE);
     gtk_container_set_border_width (GTK_CONTAINER (table), 5);
     gtk_table_set_col_spacings (GTK_TABLE (table), 5);
     gtk_table_set_row_spacings (GTK_TABLE (table), 5);
@@ -515,8 +482,6 @@ static
         if (sat) {
             gtk_list_store_append(ctrl->checkSatsList, &iter);
             gtk_list_store_set(ctrl->checkSatsList, &iter, TEXT_COLUMN, sat->nickname, TOGGLE_COLUMN, FALSE, QNT_COLUMN, "0.000000", -1);
-            ctrl->target->sats[i] = NOT_IN_PRIORITY_QUEUE;
-            ctrl->target->minCommunication[i] = 0.0f;
         }
     }
     tree = gtk_tree_view_new_with_model(GTK_TREE_MODEL(ctrl->checkSatsList));
@@ -551,7 +516,7 @@ static
     satsel = gtk_scrolled_window_new(NULL, NULL);
     gtk_scrolled_window_set_policy(GTK_SCROLLED_WINDOW(satsel), GTK_POLICY_AUTOMATIC, GTK_POLICY_AUTOMATIC);
     gtk_container_add(GTK_CONTAINER(satsel), tree);
-    gtk_table_attach_defaults(GTK_TABLE (table), satsel, 0, 3, 0, 6);
+    gtk_table_attach_defaults(GTK_TABLE (table), satsel, 0, 3, 0, 7);
     
     /* Callback functions for the minimun communication and the checkbox */
     g_signal_connect (rend_checkbox, "toggled", G_CALLBACK (sat_selected_cb), ctrl);
@@ -561,6 +526,7 @@ static
      * satellite priority Column
      */
     ctrl->prioritySatsList =  gtk_list_store_new(N_COLUMN_PRIORITY, G_TYPE_STRING);
+    load_target_lists(ctrl);
     ctrl->prioritySats = gtk_tree_view_new_with_model(GTK_TREE_MODEL(ctrl->prioritySatsList));
     gtk_widget_set_usize (ctrl->prioritySats, 150, -1);
      
@@ -601,6 +567,13 @@ static
     gtk_table_attach (GTK_TABLE (table), low_but, 4, 5, 0, 1,
                       GTK_SHRINK, GTK_SHRINK, 0, 0);
 
+    /* Create SAVE Button */
+    save_but = gpredict_hstock_button (GTK_STOCK_SAVE, _("Schedule"),
+                                       _("Save the pass schedule of the priority list to a file."));
+    g_signal_connect (save_but, "clicked", G_CALLBACK (save_schedule_cb), ctrl);
+    gtk_table_attach (GTK_TABLE (table), save_but, 3, 5, 6, 7,
+                      GTK_FILL, GTK_SHRINK, 0, 0);
+
 
     frame = gtk_frame_new (_("Target"));
     gtk_container_add (GTK_CONTAINER (frame), table);
@@ -848,11 +821,13 @@ static void
             gtk_list_store_set(ctrl->prioritySatsList, &iter, TEXT_COLUMN, sat->nickname, -1);
             /* Adds the satellite to the priorityQueue */
             append_elem_priority_queue(ctrl->target, i);
+            ctrl->queue_serial = ctrl->target->serial;
         } 
     }
     else if(!enable && i >= 0){
         index_priority_list = get_elem_index_priority_queue(ctrl->target, i);
         remove_elem_priority_queue(ctrl->target, i);
+        ctrl->queue_serial = ctrl->target->serial;
         /* Gets the new iter for the priority list*/
         gtk_tree_path_free (path);
         path = gtk_tree_path_new_from_indices(index_priority_list ,-1);
@@ -904,6 +879,7 @@ static void
 
         gtk_list_store_swap (ctrl->prioritySatsList, iter1, iter2);
         swap_elem_priority_queue (ctrl->target, i, j);
+        ctrl->queue_serial = ctrl->target->serial;
         update_tracked_elem (ctrl);
     }
 }
@@ -939,10 +915,68 @@ static void
 
         gtk_list_store_swap (ctrl->prioritySatsList, iter1, iter2);
         swap_elem_priority_queue(ctrl->target, i, j);
+        ctrl->queue_serial = ctrl->target->serial;
         update_tracked_elem (ctrl);
     }
 }
 
+/** \brief Save the schedule of the priority list.
+ *  \param button Pointer to the GtkButton that received the signal.
+ *  \param data Pointer to the GtkRotCtrl structure.
+ *
+ * This function is called when the user presses the "Schedule" button. It
+ * asks for a file name and writes the pass schedule of the priority list
+ * to it as a text table.
+ */
+static void
+        save_schedule_cb(GtkButton *button, gpointer data)
+{
+    GtkRotCtrl *ctrl = GTK_ROT_CTRL (data);
+    GtkWidget *toplevel = gtk_widget_get_toplevel (GTK_WIDGET (button));
+    GtkWidget *dialog;
+    GError    *err = NULL;
+    gchar     *filename;
+    gchar     *text;
+
+    /* make sure that the schedule is up to date */
+    update_tracked_elem (ctrl);
+
+    dialog = gtk_file_chooser_dialog_new (_("Save Schedule"),
+                                          GTK_WINDOW (toplevel),
+                                          GTK_FILE_CHOOSER_ACTION_SAVE,
+                                          GTK_STOCK_CANCEL, GTK_RESPONSE_CANCEL,
+                                          GTK_STOCK_SAVE, GTK_RESPONSE_ACCEPT,
+                                          NULL);
+    gtk_file_chooser_set_do_overwrite_confirmation (GTK_FILE_CHOOSER (dialog), TRUE);
+    gtk_file_chooser_set_current_name (GTK_FILE_CHOOSER (dialog), "schedule.txt");
+
+    if (gtk_dialog_run (GTK_DIALOG (dialog)) == GTK_RESPONSE_ACCEPT) {
+        filename = gtk_file_chooser_get_filename (GTK_FILE_CHOOSER (dialog));
+        text = export_priority_queue (ctrl->target);
+
+        if (!g_file_set_contents (filename, text, -1, &err)) {
+            sat_log_log (SAT_LOG_LEVEL_ERROR,
+                         _("%s: Could not save schedule to %s (%s)"),
+                         __FUNCTION__, filename, err->message);
+            gtk_widget_destroy (dialog);
+            dialog = gtk_message_dialog_new (GTK_WINDOW (toplevel),
+                                             GTK_DIALOG_MODAL |
+                                             GTK_DIALOG_DESTROY_WITH_PARENT,
+                                             GTK_MESSAGE_ERROR,
+                                             GTK_BUTTONS_OK,
+                                             _("Could not save schedule to\n%s\n\n%s"),
+                                             filename, err->message);
+            gtk_dialog_run (GTK_DIALOG (dialog));
+            g_clear_error (&err);
+        }
+
+        g_free (text);
+        g_free (filename);
+    }
+
+    gtk_widget_destroy (dialog);
+}
+
 /** \brief Set new minimal time of communication to selected sattelite
  * \param cellrederertext Pointer to the GtkCellRendererText. 
  * \param arg1 String of the i-th changed cell
@@ -984,6 +1018,8 @@ static void
     ctrl->target->minCommunication[i] = num;
 
     /* Resets the next passes if there is a satellite*/
+    invalidate_priority_queue(ctrl->target);
+    ctrl->queue_serial = ctrl->target->serial;
     update_tracked_elem(ctrl);
 }
 
@@ -1019,6 +1055,9 @@ static void
         g_source_remove (ctrl->timerid);
 
     ctrl->timerid = g_timeout_add (ctrl->delay, rot_ctrl_timeout_cb, ctrl);
+
+    if (ctrl->loop != NULL)
+        rotor_loop_set_delay (ctrl->loop, ctrl->delay);
 }
 
 
@@ -1079,6 +1118,9 @@ static void
 
         /*Update flipped when changing rotor if there is a plot*/
         set_flipped_pass(ctrl);
+
+        /* the schedule leaves time to slew between satellites */
+        set_slew_priority_queue (ctrl->target, ctrl->conf->azrate, ctrl->conf->elrate);
     }
     else {
         sat_log_log (SAT_LOG_LEVEL_ERROR,
@@ -1109,7 +1151,7 @@ static void
     if (!gtk_toggle_button_get_active (button)) {
         gtk_widget_set_sensitive (ctrl->DevSel, TRUE);
         ctrl->engaged = FALSE;
-        close_rotctld_socket(&(ctrl->sock));
+        stop_loop (ctrl);
         gtk_label_set_text (GTK_LABEL (ctrl->AzRead), "---");
         gtk_label_set_text (GTK_LABEL (ctrl->ElRead), "---");
     }
@@ -1121,41 +1163,32 @@ static void
                          __FUNCTION__);
             return;
         }
+        ctrl->loop = rotor_loop_new (ctrl->conf, ctrl->qth, ctrl->delay,
+                                     rot_state_cb, ctrl);
+        if (ctrl->loop == NULL)
+            return;
         gtk_widget_set_sensitive (ctrl->DevSel, FALSE);
         ctrl->engaged = TRUE;
-        open_rotctld_socket(ctrl);
-        ctrl->wrops = 0;
-        ctrl->rdops = 0;
     }
 }
 
 /** \brief Rotator controller timeout function
  * \param data Pointer to the GtkRotCtrl widget.
  * \return Always TRUE to let the timer continue.
+ *
+ * The rotator itself is controlled by the loop thread. This function
+ * publishes the target of the last update to the loop, together with the
+ * wall clock time and the rate of that update so the loop can advance it,
+ * and updates the plot.
  */
 static gboolean
         rot_ctrl_timeout_cb (gpointer data)
 {
     GtkRotCtrl *ctrl = GTK_ROT_CTRL (data);
-    gdouble rotaz=0.0, rotel=0.0;
     gdouble setaz=0.0, setel=45.0;
-    gdouble cmdaz=0.0, cmdel=45.0;
-    gchar *text;
-    gboolean error = FALSE;
-    sat_t sat_working, *sat;
-    /*parameters for path predictions*/
-    gdouble time_delta;
-    gdouble step_size;
-    
+    rotor_target_t target;
     
-    if (g_static_mutex_trylock(&(ctrl->busy))==FALSE) {
-        sat_log_log (SAT_LOG_LEVEL_ERROR,_("%s missed the deadline"),__FUNCTION__);
-        return TRUE;
-    }
     
-    /* Update the tracking object */
-    update_tracked_elem(ctrl);
-
     /* If we are tracking and the target satellite is within
        range, set the rotor position controller knob values to
        the target values. If the target satellite is out of range
@@ -1200,153 +1233,22 @@ static gboolean
     }
 
 
-    if ((ctrl->engaged) && (ctrl->conf != NULL)) {
-        
-        /* read back current value from device */
-        if (get_pos (ctrl, &rotaz, &rotel)) {
-
-            /* update display widgets */
-            text = g_strdup_printf ("%.2f\302\260", rotaz);
-            gtk_label_set_text (GTK_LABEL (ctrl->AzRead), text);
-            g_free (text);
-            text = g_strdup_printf ("%.2f\302\260", rotel);
-            gtk_label_set_text (GTK_LABEL (ctrl->ElRead), text);
-            g_free (text);
-            
-            if ((ctrl->conf->aztype == ROT_AZ_TYPE_180) && (rotaz < 0.0)) {
-                gtk_polar_plot_set_rotor_pos (GTK_POLAR_PLOT (ctrl->plot), rotaz+360.0, rotel);
-            }
-            else {
-                gtk_polar_plot_set_rotor_pos (GTK_POLAR_PLOT (ctrl->plot), rotaz, rotel);
-            }
-        }
-        else {
-            gtk_label_set_text (GTK_LABEL (ctrl->AzRead), _("ERROR"));
-            gtk_label_set_text (GTK_LABEL (ctrl->ElRead), _("ERROR"));
-            error = TRUE;
+    if ((ctrl->engaged) && (ctrl->loop != NULL)) {
 
-            gtk_polar_plot_set_rotor_pos (GTK_POLAR_PLOT (ctrl->plot), -10.0, -10.0);
-        }
-        
-        /* if tolerance exceeded */
-        if ((fabs(setaz-rotaz) > ctrl->tolerance) ||
-            (fabs(setel-rotel) > ctrl->tolerance)) {
-            
-            if (ctrl->tracking){
-                /*if we are in a pass try to lead the satellite 
-                  some so we are not always chasing it*/
-                if (ctrl->target->targeting->el>0.0) {
-                    /*starting the rotator moving while we do some computation can lead to errors later*/
-                    /* 
-                       compute a time in the future when the position is 
-                       within tolerance so and send the rotor there.
-                    */         
-                    
-                    /*use a working copy so data does not get corrupted*/
-                    sat=memcpy(&(sat_working),ctrl->target->targeting,sizeof(sat_t));
-                    
-                    /*
-                      compute az/el in the future that is past end of pass 
-                      or exceeds tolerance
-                    */
-                    if (ctrl->target->pass) {
-                        /* the next point is before the end of the pass 
-                           if there is one.*/
-                        time_delta=ctrl->target->pass->los-ctrl->t;
-                    } else {
-                        /* otherwise look 20 minutes into the future*/
-                        time_delta=1.0/72.0;
-                    }
-
-                    /* have a minimum time delta*/
-                    step_size = time_delta / 2.0;
-                    if (step_size<ctrl->delay/1000.0/(secday)){
-                        step_size=ctrl->delay/1000.0/(secday);
-                    }
-                    /*
-                      find a time when satellite is above horizon and at the 
-                      edge of tolerance. the final step size needs to be smaller
-                      than delay. otherwise the az/el could be further away than
-                      tolerance the next time we enter the loop and we end up 
-                      pushing ourselves away from the satellite.
-                    */
-                    while (step_size > (ctrl->delay/1000.0/4.0/(secday))) {
-                        predict_calc (sat,ctrl->qth,ctrl->t+time_delta);
-                        /*update sat->az and sat->el to account for flips and az range*/
-                        if ((ctrl->flipped) && (ctrl->conf->maxel >= 180.0)){
-                            sat->el = 180.0-sat->el;
-                            if (sat->az > 180.0)
-                                sat->az -= 180.0;
-                            else
-                                sat->az += 180.0;
-                        }
-                        if ((ctrl->conf->aztype == ROT_AZ_TYPE_180) && (sat->az > 180.0)) { 
-                            sat->az = sat->az - 360.0;
-                        } 
-                        if ((sat->el < 0.0)||(sat->el > 180.0)||
-                            (fabs(setaz - sat->az) > (ctrl->tolerance)) ||
-                            (fabs(setel - sat->el) > (ctrl->tolerance))) {
-                            time_delta -= step_size;
-                        } else {
-                            time_delta += step_size;
-                        }
-                        step_size /= 2.0;
-                    }
-                    setel = sat->el;
-                    if (setel < 0.0) {
-                        setel = 0.0;
-                    }
-                    if (setel > 180.0) {
-                        setel = 180.0;
-                    }
-                    setaz = sat->az;
-                }
-            }
-        
-			/* If azimuth position is > 180 from current position, send incremental command */
-
-			if(fabs(setaz - rotaz) >= 180.0){
-				if(setaz > rotaz){
-					cmdaz = rotaz + 90;
-				}else{
-					cmdaz = rotaz - 90;
-				}
-			}else{
-				cmdaz = setaz;
-			}
-			cmdel = setel;
-
-            /* send controller values to rotator device */
-            /* this is the newly computed value which should be ahead of the current position */
-            if (!set_pos (ctrl, cmdaz, cmdel)) {
-                error = TRUE;
-            } else {
-                gtk_rot_knob_set_value (GTK_ROT_KNOB (ctrl->AzSet), setaz);
-                gtk_rot_knob_set_value (GTK_ROT_KNOB (ctrl->ElSet), setel);
-            }
-        }
-        
-        /* check error status */
-        if (!error) {
-            /* reset error counter */
-            ctrl->errcnt = 0;
-        }
-        else {
-            if (ctrl->errcnt >= MAX_ERROR_COUNT) {
-                /* disengage device */
-                gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (ctrl->LockBut), FALSE);
-                ctrl->engaged = FALSE;
-                sat_log_log (SAT_LOG_LEVEL_ERROR,
-                             _("%s: MAX_ERROR_COUNT (%d) reached. Disengaging device!"),
-                             __FUNCTION__, MAX_ERROR_COUNT);
-                ctrl->errcnt = 0;
-                //g_print ("ERROR. WROPS: %d   RDOPS: %d\n", ctrl->wrops, ctrl->rdops);
-            }
-            else {
-                /* increment error counter */
-                ctrl->errcnt++;
-            }
-        }
+        /* publish the target to the control loop */
+        target.t = ctrl->t;
+        target.stamp = ctrl->tstamp;
+        target.rate = ctrl->rate;
+        target.az = setaz;
+        target.el = setel;
+        target.tolerance = ctrl->tolerance;
+        target.track = (ctrl->tracking && ctrl->target->targeting != NULL);
+        target.aos = (ctrl->target->pass != NULL) ? ctrl->target->pass->aos : 0.0;
+        target.los = (ctrl->target->pass != NULL) ? ctrl->target->pass->los : 0.0;
+        target.flipped = ctrl->flipped;
+
+        rotor_loop_set_target (ctrl->loop, &target,
+                               target.track ? ctrl->target->targeting : NULL);
     }
     else {
         /* ensure rotor pos is not visible on plot */
@@ -1372,7 +1274,6 @@ static gboolean
                                          gtk_rot_knob_get_value (GTK_ROT_KNOB (ctrl->ElSet)));
         }
     }
-    g_static_mutex_unlock(&(ctrl->busy));
 
     /* Sends new tracked element to FIFO file */
     targeting_to_fifo(ctrl);
@@ -1381,117 +1282,77 @@ static gboolean
 }
 
 
-/** \brief Read rotator position from device.
- * \param ctrl Pointer to the GtkRotCtrl widget.
- * \param az The current Az as read from the device
- * \param el The current El as read from the device
- * \return TRUE if the position was successfully retrieved, FALSE if an
- *         error occurred.
+/** \brief Show the state published by the control loop.
+ * \param state The state of the rotator after the last cycle.
+ * \param data Pointer to the GtkRotCtrl widget.
  */
-static gboolean get_pos (GtkRotCtrl *ctrl, gdouble *az, gdouble *el)
+static void rot_state_cb (const rotor_state_t *state, gpointer data)
 {
-    gchar  *buff,**vbuff;
-    gchar  buffback[128];
-    gboolean retcode;
-    
-    if ((az == NULL) || (el == NULL)) {
-        sat_log_log (SAT_LOG_LEVEL_ERROR,
-                     _("%s:%d: NULL storage."),
-                     __FILE__, __LINE__);
-        return FALSE;
-    }
-    
-    /* send command */
-    buff = g_strdup_printf ("p\x0a");
+    GtkRotCtrl *ctrl = GTK_ROT_CTRL (data);
+    gchar *text;
 
-    retcode=send_rotctld_command(ctrl,buff,buffback,128);
-    
-    /* try to read answer */
-    if (retcode) {
-        if (strncmp(buffback,"RPRT",4)==0){
-            //retcode=FALSE;
-            g_strstrip (buffback);
-            sat_log_log (SAT_LOG_LEVEL_ERROR,
-                         _("%s:%d: rotctld returned error (%s)"),
-                         __FILE__, __LINE__,buffback);
-
-        } else {
-            vbuff = g_strsplit (buffback, "\n", 3);
-            if ((vbuff[0] !=NULL) && (vbuff[1]!=NULL)){
-                *az = g_strtod (vbuff[0], NULL);
-                *el = g_strtod (vbuff[1], NULL);
-            } else {
-                g_strstrip (buffback);
-                sat_log_log (SAT_LOG_LEVEL_ERROR,
-                             _("%s:%d: rotctld returned bad response (%s)"),
-                             __FILE__, __LINE__,buffback);
-                //retcode=FALSE;
-            }
-            
-            g_strfreev (vbuff);
+    if (state->valid) {
+        /* update display widgets */
+        text = g_strdup_printf ("%.2f\302\260", state->az);
+        gtk_label_set_text (GTK_LABEL (ctrl->AzRead), text);
+        g_free (text);
+        text = g_strdup_printf ("%.2f\302\260", state->el);
+        gtk_label_set_text (GTK_LABEL (ctrl->ElRead), text);
+        g_free (text);
+
+        if ((ctrl->conf->aztype == ROT_AZ_TYPE_180) && (state->az < 0.0)) {
+            gtk_polar_plot_set_rotor_pos (GTK_POLAR_PLOT (ctrl->plot), state->az+360.0, state->el);
+        }
+        else {
+            gtk_polar_plot_set_rotor_pos (GTK_POLAR_PLOT (ctrl->plot), state->az, state->el);
         }
     }
+    else {
+        gtk_label_set_text (GTK_LABEL (ctrl->AzRead), _("ERROR"));
+        gtk_label_set_text (GTK_LABEL (ctrl->ElRead), _("ERROR"));
 
-    g_free (buff);
+        gtk_polar_plot_set_rotor_pos (GTK_POLAR_PLOT (ctrl->plot), -10.0, -10.0);
+    }
+
+    /* show where the rotator has been sent to */
+    if (state->moved) {
+        gtk_rot_knob_set_value (GTK_ROT_KNOB (ctrl->AzSet), state->setaz);
+        gtk_rot_knob_set_value (GTK_ROT_KNOB (ctrl->ElSet), state->setel);
+    }
 
-    return retcode;
+    if (state->failed) {
+        /* disengage device */
+        gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (ctrl->LockBut), FALSE);
+        ctrl->engaged = FALSE;
+    }
 }
 
 
-/** \brief Send new position to rotator device
- * \param ctrl Pointer to the GtkRotCtrl widget
- * \param az The new Azimuth
- * \param el The new Elevation
- * \return TRUE if the new position has been sent successfully
- *         FALSE if an error occurred
- * 
- * \note The function does not perform any range check since the GtkRotKnob
- * should always keep its value within range.
+/** \brief Stop the control loop.
+ * \param ctrl Pointer to the GtkRotCtrl widget.
+ *
+ * The statistics of the loop are logged before it is stopped.
  */
-static gboolean set_pos (GtkRotCtrl *ctrl, gdouble az, gdouble el)
+static void stop_loop (GtkRotCtrl *ctrl)
 {
-    gchar  *buff;
-    gchar  buffback[128];
-    gchar  azstr[8],elstr[8];
-    gboolean retcode;
-    gint   retval;
-    
-    /* send command */
-    g_ascii_formatd (azstr, 8, "%7.2f", az);
-    g_ascii_formatd (elstr, 8, "%7.2f", el);
-    buff = g_strdup_printf ("P %s %s\x0a", azstr, elstr);
-    
-    retcode=send_rotctld_command(ctrl,buff,buffback,128);
-    
-    g_free (buff);
-    
-    if (retcode==TRUE){
-        retval=(gint)g_strtod(buffback+4,NULL);
-        /*treat errors as soft errors unless there is good reason*/
-        /*good reasons come from operator experience or documentation*/
-        switch(retval) {
-            
-        case 0:
-            /*no error case*/
-            break;
-        default:
-            /*any other case*/
-            /*not sure what is a hard error or soft error*/
-            /*over time a database of this is needed*/
-            g_strstrip (buffback);
-            sat_log_log (SAT_LOG_LEVEL_ERROR,
-                         _("%s:%d: rotctld returned error %d with az %f el %f(%s)"),
-                         __FILE__, __LINE__, retval, az, el, buffback);
-            
-            //retcode=FALSE;
-            break;
-        }
-    }
-
-    return (retcode);
-}
+    rotor_loop_stats_t stats;
 
+    if (ctrl->loop == NULL)
+        return;
 
+    rotor_loop_get_stats (ctrl->loop, &stats);
+    sat_log_log (SAT_LOG_LEVEL_DEBUG,
+                 _("%s: %d cycles, %d missed, jitter %.1f ms (max %.1f ms)"),
+                 __FUNCTION__, stats.cycles, stats.missed,
+                 1000.0 * stats.jitter_mean, 1000.0 * stats.jitter_max);
+    sat_log_log (SAT_LOG_LEVEL_DEBUG,
+                 _("%s: %d commands, %d errors, round trip %.1f ms (max %.1f ms)"),
+                 __FUNCTION__, stats.commands, stats.errors,
+                 1000.0 * stats.latency, 1000.0 * stats.latency_max);
+
+    rotor_loop_stop (ctrl->loop);
+    ctrl->loop = NULL;
+}
 
 
 /** \brief Update count down label.
@@ -1578,133 +1439,6 @@ static gboolean have_conf ()
     return (i > 0) ? TRUE : FALSE;
 }
 
-/** \brief open the rotcld socket. return true if successful false otherwise.*/
-
-static gboolean open_rotctld_socket (GtkRotCtrl * ctrl) {
-    struct sockaddr_in ServAddr;
-    struct hostent *h;
-    gint status;
-
-    ctrl->sock=socket(PF_INET,SOCK_STREAM,IPPROTO_TCP);
-    if (ctrl->sock < 0) {
-        sat_log_log (SAT_LOG_LEVEL_ERROR,
-                     _("%s: Failed to create socket"),
-                     __FUNCTION__);
-        ctrl->sock = 0;
-        return FALSE;
-    }
-    else {
-        sat_log_log (SAT_LOG_LEVEL_DEBUG,
-                     _("%s: Network socket created successfully"),
-                     __FUNCTION__);
-    }
-
-    memset(&ServAddr, 0, sizeof(ServAddr));     /* Zero out structure */
-    ServAddr.sin_family = AF_INET;             /* Internet address family */
-    h = gethostbyname(ctrl->conf->host);
-    memcpy((char *) &ServAddr.sin_addr.s_addr, h->h_addr_list[0], h->h_length);
-    ServAddr.sin_port = htons(ctrl->conf->port); /* Server port */
-
-    /* establish connection */
-    status = connect(ctrl->sock, (struct sockaddr *) &ServAddr, sizeof(ServAddr));
-    if (status < 0) {
-        sat_log_log (SAT_LOG_LEVEL_ERROR,
-                     _("%s: Failed to connect to %s:%d"),
-                     __FUNCTION__, ctrl->conf->host, ctrl->conf->port);
-        ctrl->sock = 0;
-        return FALSE;
-    }
-    else {
-        sat_log_log (SAT_LOG_LEVEL_DEBUG,
-                     _("%s: Connection opened to %s:%d"),
-                     __FUNCTION__, ctrl->conf->host, ctrl->conf->port);
-    }
-
-    return TRUE;
-}
-
-
-/*close a rotcld socket. First send a q command to cleanly shut down rotctld*/
-static gboolean close_rotctld_socket (gint *sock) {
-  gint written;
-  /*shutdown the rigctld connect*/
-  written = send(*sock, "q\x0a", 2, 0);
-  if (written != 2) {
-      sat_log_log (SAT_LOG_LEVEL_ERROR,
-                   _("%s:%s: Sent 2 bytes but sent %d."),
-                   __FILE__, __FUNCTION__, written);
-  }
-#ifndef WIN32
-  shutdown (*sock, SHUT_RDWR);
-  close (*sock);
-#else
-  shutdown (*sock, SD_BOTH);
-  closesocket (*sock);
-#endif
-  
-  *sock=0;
-  
-  return TRUE;
-}
-
-/** \brief  Send a command to rigctld
- *   Inputs are a controller, a string command, and a buffer and length for returning the output from rigctld.
- */
-
-gboolean send_rotctld_command(GtkRotCtrl *ctrl, gchar *buff, gchar *buffout, gint sizeout)
-{
-    gint    written;
-    gint    size;
-
-    size = strlen(buff);
-    
-    //sat_log_log (SAT_LOG_LEVEL_DEBUG,
-    //             _("%s:%s: Sending %d bytes as %s."),
-    //             __FILE__, __FUNCTION__, size, buff);
-
-
-    /* send command */
-    written = send(ctrl->sock, buff, size, 0);
-    if (written != size) {
-        sat_log_log (SAT_LOG_LEVEL_ERROR,
-                     _("%s: SIZE ERROR %d / %d"),
-                     __FUNCTION__, written, size);
-    }
-    if (written == -1) {
-        sat_log_log (SAT_LOG_LEVEL_ERROR,
-                     _("%s: rotctld Socket Down"),
-                     __FUNCTION__);
-        return FALSE;
-    }
-
-    /* try to read answer */
-    size = recv (ctrl->sock, buffout, sizeout, 0);
-
-    if (size == -1) {
-        sat_log_log (SAT_LOG_LEVEL_ERROR,
-                     _("%s: rotctld Socket Down"),
-                     __FUNCTION__);
-        return FALSE;
-    }  
-
-    buffout[size]='\0';
-    if (size == 0) {
-        sat_log_log (SAT_LOG_LEVEL_ERROR,
-                     _("%s:%s: Got 0 bytes from rotctld"),
-                     __FILE__, __FUNCTION__);
-    }
-    else {
-        //sat_log_log (SAT_LOG_LEVEL_DEBUG,
-        //             _("%s:%s: Read %d bytes as %s from rotctld"),
-        //             __FILE__, __FUNCTION__, size, buffout);
-        
-    }
-
-    ctrl->wrops++;
-    
-    return TRUE;
-}
-
 /** \brief  Compare Satellite Names.
  *simple function to sort the list of satellites in the combo box.
  */
@@ -1729,7 +1463,7 @@ static gboolean is_flipped_pass (pass_t * pass,rot_az_type_t type){
     pass_detail_t      *detail;
     gboolean retval=FALSE;
 
-    num = g_slist_length (pass->details);
+    num = get_pass_num_details (pass);
     if (type==ROT_AZ_TYPE_360) {
         min_az = 0;
         max_az = 360;
@@ -1750,7 +1484,7 @@ static gboolean is_flipped_pass (pass_t * pass,rot_az_type_t type){
     
     if (num>1) {
         for (i = 1; i < num-1; i++) {
-            detail = PASS_DETAIL(g_slist_nth_data (pass->details, i));
+            detail = get_pass_detail (pass, i);
             caz=detail->az;
             while (caz>max_az) {
                 caz-=360;
@@ -1787,124 +1521,67 @@ static inline void set_flipped_pass (GtkRotCtrl* ctrl){
 
 }
 
-/** \brief Chooses the Next Element to be Tracked
+/** \brief Updates the Next Element to be Tracked
  *  \param ctrl Pointer to GtkRotCtrl
  *
- *  This function chooses the next satellite to be tracked according to
- *  the order of the satellites in the priority list. If the LOS - AOS 
- *  of a satellite is smaller than the minimum communication time of that 
- *  satellite, this one is not choosen. 
- *
- *  TODO : Implementation that takes in account minimum elevation
+ *  This function looks up the target in the schedule of the priority
+ *  queue, which updates the fields:
+ *  * ctrl->target->targeting
+ *  * ctrl->target->pass
+ *  The label, the flip and the polar plot are only updated when the target
+ *  or its pass has changed.
  */
 static void
-        next_elem_to_track(GtkRotCtrl* ctrl)
+        update_tracked_elem(GtkRotCtrl * ctrl)
 {
-    int i, num_sats;
-    gdouble aos_old, los_old, aos, los;
-    gboolean trackable_sat = FALSE, passing;
-    sat_t *sat_old, *sat_new;
-    pass_t *pass;
-    guint dt;
-
-    /* set variables */
-    num_sats = ctrl->target->numSatToTrack;
-
-    if(num_sats <= 0)
-        sat_log_log (SAT_LOG_LEVEL_ERROR,
-                _("%s:%d: Error tracking new satellite"),
-                __FILE__, __LINE__);
-
-    /* Gets the first possible satellite of the priority queue */
-    for(i=0; i < num_sats; i++){
-        sat_old = SAT (g_slist_nth_data(ctrl->sats, ctrl->target->priorityQueue[i]));
-        if(sat_old->el > 0.0f && sat_old->aos > 0) {
-            pass = get_current_pass(sat_old, ctrl->qth, ctrl->t);
-            aos_old = pass->aos;
-            los_old = pass->los;
-            free_pass(pass);
-        }
-        else{
-            aos_old = sat_old->aos;
-            los_old = sat_old->los;
-        } 
-
-        /* convert julian date to seconds */
-        dt = (guint) ((los_old - aos_old) * 86400);
-
-        /* if we have the minimal communication time needded */
-        if(dt > ctrl->target->minCommunication[ctrl->target->priorityQueue[i]] || (aos_old < FLT_MIN && sat_old->el > 0.0f)){
-            trackable_sat = TRUE;
-            i++;
-            break;
-        }
-    }
-
-    for(; i < num_sats; i++){
-        /* Gets the next satellite in the priority queue */
-        sat_new = SAT (g_slist_nth_data(ctrl->sats, ctrl->target->priorityQueue[i]));
-        passing = FALSE;
-        if(sat_new->el > 0.0f && sat_new->aos > 0) {
-            passing = TRUE;
-            pass = get_current_pass(sat_new, ctrl->qth, ctrl->t);
-            aos = pass->aos;
-            los = pass->los;
-            free_pass(pass);
-        }
-        else {
-            aos = sat_new->aos;
-            los = sat_new->los;
-        }
-
-        /* convert julian date to seconds */
-        dt = (guint) ((los - aos) * 86400);
+    if(!schedule_priority_queue(ctrl->target, ctrl->qth, ctrl->t, &ctrl->target_serial))
+        return;
 
-        /* if we have the minimal communication time needded */
-        if(dt > ctrl->target->minCommunication[ctrl->target->priorityQueue[i]] || (aos < FLT_MIN && sat_new->el > 0.0f)){
-            /* if the new satellite will set before the rise of the old one */
-            if((aos_old > los && sat_old->el < FLT_MIN) || (passing && aos_old < FLT_MIN)){
-                sat_old = sat_new;
-                aos_old = aos;
-            }
-        }
-    }
-    if(trackable_sat == TRUE){
-        ctrl->target->targeting = sat_old;
-        if(sat_old->el > 0.0f) 
-            ctrl->target->pass = get_current_pass(sat_old, ctrl->qth, ctrl->t);
-        else 
-            ctrl->target->pass = get_pass(sat_old, ctrl->qth, ctrl->t, 3.0f);
+    if(ctrl->target->targeting != NULL){
+        gtk_label_set_text((GtkLabel*)ctrl->track_sat, ctrl->target->targeting->nickname); 
         set_flipped_pass(ctrl);
     }
-    else {
-        ctrl->target->targeting = NULL;
-        ctrl->target->pass = NULL;
+    else{
+        gtk_label_set_text((GtkLabel*)ctrl->track_sat, " --- ");
+    }
+
+    if(ctrl->plot != NULL){
+        /* Plots a new pass only if the target has changed */
+        gtk_polar_plot_set_pass (GTK_POLAR_PLOT (ctrl->plot), ctrl->target->pass);
     }
 }
 
-/** \brief Updates the Next Element to be Tracked
- *  \param ctrl Pointer to GtkRotCtrl
+/** \brief Show the priority queue in the satellite lists.
+ *  \param ctrl Pointer to the GtkRotCtrl widget.
  *
- *  This function updates the fields:
- *  * ctrl->target->targeting
- *  * ctrl->target->pass
- *  setting the new satellite to target
+ * The queue is shared with the radio controller of the module, so the lists
+ * are loaded when they are created and whenever the other controller has
+ * changed the queue.
  */
 static void
-        update_tracked_elem(GtkRotCtrl * ctrl)
+        load_target_lists(GtkRotCtrl * ctrl)
 {
-    if(ctrl->target->numSatToTrack > 0){
-        next_elem_to_track(ctrl);
-    }
-    if(ctrl->target->targeting != NULL){
-        gtk_label_set_text((GtkLabel*)ctrl->track_sat, ctrl->target->targeting->nickname); 
-        
-       if(ctrl->plot != NULL){
-            /* Plots a new pass only if there is a new element added */
-            gtk_polar_plot_set_pass (GTK_POLAR_PLOT (ctrl->plot), ctrl->target->pass);
-        }
+    GtkTreeIter iter;
+    gboolean valid;
+    gchar *buff;
+    gint i;
+
+    valid = gtk_tree_model_get_iter_first(GTK_TREE_MODEL(ctrl->checkSatsList), &iter);
+    for(i = 0; valid; i++){
+        buff = g_strdup_printf("%f", ctrl->target->minCommunication[i]);
+        gtk_list_store_set(ctrl->checkSatsList, &iter,
+                           TOGGLE_COLUMN, ctrl->target->sats[i] != NOT_IN_PRIORITY_QUEUE,
+                           QNT_COLUMN, buff, -1);
+        g_free(buff);
+        valid = gtk_tree_model_iter_next(GTK_TREE_MODEL(ctrl->checkSatsList), &iter);
     }
-    else{
-        gtk_label_set_text((GtkLabel*)ctrl->track_sat, " --- ");
+
+    gtk_list_store_clear(ctrl->prioritySatsList);
+    for(i = 0; i < ctrl->target->numSatToTrack; i++){
+        gtk_list_store_append(ctrl->prioritySatsList, &iter);
+        gtk_list_store_set(ctrl->prioritySatsList, &iter, TEXT_COLUMN,
+                           ctrl->target->satv[ctrl->target->priorityQueue[i]]->nickname, -1);
     }
+
+    ctrl->queue_serial = ctrl->target->serial;
 }
@@ -35,6 +35,7 @@
 #include "sgpsdp/sgp4sdp4.h"
 #include "gtk-sat-module.h"
 #include "rotor-conf.h"
+#include "rotor-loop.h"
 #include "target-sat.h"
 
 #ifdef __cplusplus
@@ -75,6 +76,8 @@ struct _gtk_rot_ctrl
     GtkListStore *prioritySatsList; /*!< The GTK list of priorities */
     GtkListStore *checkSatsList;    /*!< List of sats in current module */
     TargetSat *target;  /*!< Priority list and target satellite */   
+    guint queue_serial;  /*!< Serial of the queue shown in the lists */
+    guint target_serial; /*!< Serial of the target last seen */
     
     /* other widgets */
     GtkWidget *SatCnt;
@@ -85,6 +88,8 @@ struct _gtk_rot_ctrl
                         
     rotor_conf_t *conf;
     gdouble       t;  /*!< Time when sat data last has been updated. */
+    GTimeVal      tstamp; /*!< Wall clock time of the last update. */
+    gdouble       rate;   /*!< Module time per wall clock time (throttle). */
     
     /* satellites */
     GSList *sats;       /*!< List of sats in parent module */
@@ -97,15 +102,9 @@ struct _gtk_rot_ctrl
     gdouble tolerance;  /*!< Error tolerance */
     
     gboolean tracking;  /*!< Flag set when we are tracking a target. */
-    GStaticMutex busy;      /*!< Flag set when control algorithm is busy. */
     gboolean engaged;   /*!< Flag indicating that rotor device is engaged. */
                         
-    gint     errcnt;    /*!< Error counter. */
-    gint     sock;      /*!< socket for connecting to rotctld. */
-    
-    /* debug related */
-    guint    wrops;
-    guint    rdops;
+    rotor_loop_t *loop; /*!< Control loop while the device is engaged. */
 };
 
 struct _GtkRotCtrlClass
@@ -116,6 +115,7 @@ struct _GtkRotCtrlClass
 GType      gtk_rot_ctrl_get_type (void);
 GtkWidget* gtk_rot_ctrl_new      (GtkSatModule *module);
 void       gtk_rot_ctrl_update   (GtkRotCtrl *ctrl, gdouble t);
+void       gtk_rot_ctrl_get_slew (GtkRotCtrl *ctrl, gdouble *azrate, gdouble *elrate);
 
 
 #ifdef __cplusplus
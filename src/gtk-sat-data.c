@@ -26,6 +26,7 @@
   along with this program; if not, visit http://www.fsf.org/
 */
 
+#include <string.h>
 #include <glib.h>
 #include <glib/gi18n.h>
 #include "sgpsdp/sgp4sdp4.h"
@@ -41,6 +42,10 @@
 
 
 
+static gint gtk_sat_data_init_elements (sat_t *sat, const gchar *tlestr1,
+                                        const gchar *tlestr2, const gchar *source);
+
+
 /** \brief Read TLE data for a given satellite into memory.
  *  \param catnum The catalog number of the satellite.
  *  \param sat Pointer to a valid sat_t structure.
@@ -50,21 +55,43 @@
  */
 gint
 gtk_sat_data_read_sat (gint catnum, sat_t *sat)
+{
+    gchar *path;
+    gint   errorcode;
+
+
+    /* ensure that sat != NULL */
+    g_return_val_if_fail (sat != NULL, 1);
+
+    path = sat_file_name_from_catnum (catnum);
+    errorcode = gtk_sat_data_read_sat_file (path, sat);
+    g_free (path);
+
+    return errorcode;
+}
+
+
+/** \brief Read satellite data from a .sat file.
+ *  \param path The full path of the .sat file.
+ *  \param sat Pointer to a valid sat_t structure.
+ *  \return 0 if successfull, 1 if an I/O error occurred,
+ *          2 if the TLE data appears to be bad.
+ *
+ * Like gtk_sat_data_read_sat, but the file does not have to be in the
+ * satellite data directory of the user.
+ */
+gint
+gtk_sat_data_read_sat_file (const gchar *path, sat_t *sat)
 {
     guint    errorcode = 0;
     GError   *error = NULL;
     GKeyFile *data;
-    gchar   *filename = NULL, *path = NULL;
-    gchar   *tlestr1,*tlestr2,*rawtle;
+    gchar   *tlestr1,*tlestr2;
 
 
     /* ensure that sat != NULL */
     g_return_val_if_fail (sat != NULL, 1);
 
-    /* .sat file names */
-    filename = g_strdup_printf ("%d.sat", catnum);
-    path = sat_file_name_from_catnum (catnum);
-
     /* open .sat file */
     data = g_key_file_new ();
     if (!g_key_file_load_from_file (data, path, G_KEY_FILE_KEEP_COMMENTS, &error)) {
@@ -90,8 +117,8 @@ gtk_sat_data_read_sat (gint catnum, sat_t *sat)
         sat->nickname = g_key_file_get_string (data, "Satellite", "NICKNAME", &error);
         if (error != NULL) {
             sat_log_log (SAT_LOG_LEVEL_INFO,
-                         _("%s: Satellite %d has no NICKNAME"),
-                         __FUNCTION__, catnum);
+                         _("%s: Satellite in %s has no NICKNAME"),
+                         __FUNCTION__, path);
             g_clear_error (&error);
             sat->nickname = g_strdup (sat->name);
         }
@@ -114,66 +141,125 @@ gtk_sat_data_read_sat (gint catnum, sat_t *sat)
             g_clear_error (&error);
         }
 
-        rawtle = g_strconcat (tlestr1, tlestr2, NULL);
+        errorcode = gtk_sat_data_init_elements (sat, tlestr1, tlestr2, path);
 
-        if (!Good_Elements (rawtle)) {
-            sat_log_log (SAT_LOG_LEVEL_ERROR,
-                         _("%s: TLE data for %d appears to be bad"),
-                         __FUNCTION__, catnum);
-            errorcode = 2;
-        } else {
-            Convert_Satellite_Data (rawtle, &sat->tle);
-        }
         if (g_key_file_has_key(data, "Satellite", "STATUS",NULL))
             sat->tle.status = g_key_file_get_integer (data, "Satellite", "STATUS", NULL);
 
         g_free (tlestr1);
         g_free (tlestr2);
-        g_free (rawtle);
-
-
-        /* VERY, VERY important! If not done, some sats
-           will not get initialised, the first time SGP4/SDP4
-           is called. Consequently, the resulting data will
-           be NAN, INF or similar nonsense.
-           For some reason, not even using g_new0 seems to
-           be enough.
-        */
-        sat->flags = 0;
-
-        select_ephemeris (sat);
-
-        /* initialise variable fields */
-        sat->jul_utc = 0.0;
-        sat->tsince = 0.0;
-        sat->az = 0.0;
-        sat->el = 0.0;
-        sat->range = 0.0;
-        sat->range_rate = 0.0;
-        sat->ra = 0.0;
-        sat->dec = 0.0;
-        sat->ssplat = 0.0;
-        sat->ssplon = 0.0;
-        sat->alt = 0.0;
-        sat->velo = 0.0;
-        sat->ma = 0.0;
-        sat->footprint = 0.0;
-        sat->phase = 0.0;
-        sat->aos = 0.0;
-        sat->los = 0.0;
-
-        /* calculate satellite data at epoch */
-        gtk_sat_data_init_sat (sat, NULL);
     }
 
-    g_free (filename);
-    g_free (path);
     g_key_file_free (data);
 
     return errorcode;
 }
 
 
+/** \brief Read satellite data from a NASA two-line element set.
+ *  \param name The name of the satellite or NULL to use the catalog number.
+ *  \param tlestr1 The first line of the element set.
+ *  \param tlestr2 The second line of the element set.
+ *  \param sat Pointer to a valid sat_t structure.
+ *  \return 0 if successfull, 2 if the TLE data appears to be bad.
+ *
+ * The lines must not contain the line terminators. The satellite is
+ * initialised the same way as by gtk_sat_data_read_sat.
+ */
+gint
+gtk_sat_data_read_tle (const gchar *name, const gchar *tlestr1,
+                       const gchar *tlestr2, sat_t *sat)
+{
+    gint errorcode;
+
+
+    /* ensure that sat != NULL */
+    g_return_val_if_fail (sat != NULL, 2);
+
+    errorcode = gtk_sat_data_init_elements (sat, tlestr1, tlestr2, name);
+
+    if (name != NULL)
+        sat->name = g_strdup (name);
+    else
+        sat->name = g_strdup_printf ("%d", sat->tle.catnr);
+    sat->nickname = g_strdup (sat->name);
+    sat->website = NULL;
+
+    return errorcode;
+}
+
+
+/** \brief Convert the elements and initialise the satellite.
+ *  \param sat The satellite.
+ *  \param tlestr1 The first line of the element set, may be NULL.
+ *  \param tlestr2 The second line of the element set, may be NULL.
+ *  \param source Where the elements come from; used in the error message.
+ *  \return 0 if successfull, 2 if the TLE data appears to be bad.
+ */
+static gint
+gtk_sat_data_init_elements (sat_t *sat, const gchar *tlestr1,
+                            const gchar *tlestr2, const gchar *source)
+{
+    gchar *rawtle;
+    gint   errorcode = 0;
+
+
+    rawtle = g_strconcat (tlestr1 ? tlestr1 : "", tlestr2 ? tlestr2 : "", NULL);
+
+    /* Good_Elements reads up to the end of the second line */
+    if (strlen (rawtle) < 138 || !Good_Elements (rawtle)) {
+        sat_log_log (SAT_LOG_LEVEL_ERROR,
+                     _("%s: TLE data in %s appears to be bad"),
+                     __FUNCTION__, source);
+        errorcode = 2;
+    } else {
+        Convert_Satellite_Data (rawtle, &sat->tle);
+    }
+
+    g_free (rawtle);
+
+
+    /* VERY, VERY important! If not done, some sats
+       will not get initialised, the first time SGP4/SDP4
+       is called. Consequently, the resulting data will
+       be NAN, INF or similar nonsense.
+       For some reason, not even using g_new0 seems to
+       be enough.
+    */
+    sat->flags = 0;
+
+    select_ephemeris (sat);
+
+    /* initialise variable fields */
+    sat->jul_utc = 0.0;
+    sat->tsince = 0.0;
+    sat->az = 0.0;
+    sat->el = 0.0;
+    sat->range = 0.0;
+    sat->range_rate = 0.0;
+    sat->ra = 0.0;
+    sat->dec = 0.0;
+    sat->ssplat = 0.0;
+    sat->ssplon = 0.0;
+    sat->alt = 0.0;
+    sat->velo = 0.0;
+    sat->ma = 0.0;
+    sat->footprint = 0.0;
+    sat->phase = 0.0;
+    sat->aos = 0.0;
+    sat->los = 0.0;
+
+    /* calculate satellite data at epoch */
+    gtk_sat_data_init_sat (sat, NULL);
+
+    /* callers only free the name strings of bad satellites */
+    if (errorcode)
+        free_ephemeris (sat);
+
+    return errorcode;
+}
+
+
 
 /** \brief Initialise satellite data.
  *  \param sat The satellite to initialise.
@@ -255,47 +341,26 @@ gtk_sat_data_init_sat (sat_t *sat, qth_t *qth)
   * \param qth Pointer to the observer data (needed to initialize sat)
   *
   * This function copies the satellite data from a source sat_t structure into
-  * the destination. The function copies the tle_t data and calls gtk_sat_data_inti_sat()
-  * function for initializing the other fields.
+  * the destination. The destination gets its own strings and propagator model,
+  * so it can be used after the source has been freed and by other threads.
+  * The variable fields are initialised by gtk_sat_data_init_sat().
   *
+  * \note The elements in source have already been processed by
+  *       select_ephemeris(), so the model is rebuilt from them rather than
+  *       calling select_ephemeris() again.
   */
 void gtk_sat_data_copy_sat (const sat_t *source, sat_t *dest, qth_t *qth)
 {
-    guint i;
-
     g_return_if_fail ((source != NULL) && (dest != NULL));
 
-    dest->tle.epoch = source->tle.epoch;
-    dest->tle.epoch_year = source->tle.epoch_year;
-    dest->tle.epoch_day = source->tle.epoch_day;
-    dest->tle.epoch_fod = source->tle.epoch_fod;
-    dest->tle.xndt2o = source->tle.xndt2o;
-    dest->tle.xndd6o = source->tle.xndd6o;
-    dest->tle.bstar = source->tle.bstar;
-    dest->tle.xincl = source->tle.xincl;
-    dest->tle.xnodeo = source->tle.xnodeo;
-    dest->tle.eo = source->tle.eo;
-    dest->tle.omegao = source->tle.omegao;
-    dest->tle.xmo = source->tle.xmo;
-    dest->tle.xno = source->tle.xno;
-    dest->tle.catnr = source->tle.catnr;
-    dest->tle.elset = source->tle.elset;
-    dest->tle.revnum = source->tle.revnum;
+    *dest = *source;
 
     dest->name = g_strdup (source->name);
     dest->nickname = g_strdup (source->nickname);
-    for (i = 0; i < 9; i++)
-        dest->tle.idesg[i] = source->tle.idesg[i];
-
-    dest->tle.status = source->tle.status;
-    dest->tle.xincl1 = source->tle.xincl1;
-    dest->tle.omegao1 = source->tle.omegao1;
-
-    dest->otype = source->otype;
+    dest->website = g_strdup (source->website);
 
     /* very important */
-    dest->flags = 0;
-    select_ephemeris (dest);
+    rebuild_ephemeris (dest);
 
     /* initialise variable fields */
     dest->jul_utc = 0.0;
@@ -342,6 +407,7 @@ void gtk_sat_data_free_sat(sat_t *sat)
                g_free(sat->website);
                sat->website=NULL;
           }
+          free_ephemeris (sat);
         
           g_free(sat);
      }
@@ -196,7 +196,6 @@ static void row_activated_cb(GtkTreeView * tree_view,
                              GtkTreePath * path, GtkTreeViewColumn * column, gpointer list);
 
 static void view_popup_menu(GtkWidget * treeview, GdkEventButton * event, gpointer list);
-static void Calculate_RADec(sat_t * sat, qth_t * qth, obs_astro_t * obs_set);
 
 
 static GtkVBoxClass *parent_class = NULL;
@@ -539,6 +538,7 @@ void gtk_sat_list_update(GtkWidget * widget)
 {
     GtkTreeModel *model;
     GtkSatList *satlist = GTK_SAT_LIST(widget);
+    geodetic_t  obs_geodetic;
 
     /* first, do some sanity checks */
     if ((satlist == NULL) || !IS_GTK_SAT_LIST(satlist))
@@ -555,6 +555,14 @@ void gtk_sat_list_update(GtkWidget * widget)
     {
         satlist->counter = 1;
 
+        /* the observer frame is the same for all rows */
+        obs_geodetic.lon = satlist->qth->lon * de2ra;
+        obs_geodetic.lat = satlist->qth->lat * de2ra;
+        obs_geodetic.alt = satlist->qth->alt / 1000.0;
+        obs_geodetic.theta = 0;
+        Obs_Frame_Init(&satlist->frame, &obs_geodetic);
+        Obs_Frame_Set_Time(&satlist->frame, satlist->tstamp);
+
         /* get and tranverse the model */
         model =
             gtk_tree_model_filter_get_model(GTK_TREE_MODEL_FILTER
@@ -729,13 +737,12 @@ static gboolean sat_list_update_sats(GtkTreeModel * model, GtkTreePath * path,
         {
             obs_astro_t astro;
 
-            Calculate_RADec(sat, satlist->qth, &astro);
-
-            sat->ra = Degrees(astro.ra);
-            sat->dec = Degrees(astro.dec);
+            /* only the list store gets the result; the sat_t belongs to the module */
+            Calculate_RADec_Frame(&satlist->frame, sat->az * de2ra, sat->el * de2ra, &astro);
 
             gtk_list_store_set(GTK_LIST_STORE(model), iter,
-                               SAT_LIST_COL_RA, sat->ra, SAT_LIST_COL_DEC, sat->dec, -1);
+                               SAT_LIST_COL_RA, Degrees(astro.ra),
+                               SAT_LIST_COL_DEC, Degrees(astro.dec), -1);
         }
 
         /* upcoming events */
@@ -800,7 +807,7 @@ static gboolean sat_list_update_sats(GtkTreeModel * model, GtkTreePath * path,
         {
             sat_vis_t vis;
 
-            vis = get_sat_vis(sat, satlist->qth, sat->jul_utc);
+            vis = get_sat_vis_frame(sat, &satlist->frame);
             buff = g_strdup_printf("%c", vis_to_chr(vis));
             gtk_list_store_set(GTK_LIST_STORE(model), iter, SAT_LIST_COL_VISIBILITY, buff, -1);
             g_free(buff);
@@ -1321,54 +1328,6 @@ static void view_popup_menu(GtkWidget * treeview, GdkEventButton * event, gpoint
 }
 
 
-/*** FIXME: formalise with other copies, only need az,el and jul_utc */
-static void Calculate_RADec(sat_t * sat, qth_t * qth, obs_astro_t * obs_set)
-{
-    /* Reference:  Methods of Orbit Determination by  */
-    /*                Pedro Ramon Escobal, pp. 401-402 */
-
-    double phi, theta, sin_theta, cos_theta, sin_phi, cos_phi,
-        az, el, Lxh, Lyh, Lzh, Sx, Ex, Zx, Sy, Ey, Zy, Sz, Ez, Zz,
-        Lx, Ly, Lz, cos_delta, sin_alpha, cos_alpha;
-    geodetic_t geodetic;
-
-    geodetic.lon = qth->lon * de2ra;
-    geodetic.lat = qth->lat * de2ra;
-    geodetic.alt = qth->alt / 1000.0;
-    geodetic.theta = 0;
-
-    az = sat->az * de2ra;
-    el = sat->el * de2ra;
-    phi = geodetic.lat;
-    theta = FMod2p(ThetaG_JD(sat->jul_utc) + geodetic.lon);
-    sin_theta = sin(theta);
-    cos_theta = cos(theta);
-    sin_phi = sin(phi);
-    cos_phi = cos(phi);
-    Lxh = -cos(az) * cos(el);
-    Lyh = sin(az) * cos(el);
-    Lzh = sin(el);
-    Sx = sin_phi * cos_theta;
-    Ex = -sin_theta;
-    Zx = cos_theta * cos_phi;
-    Sy = sin_phi * sin_theta;
-    Ey = cos_theta;
-    Zy = sin_theta * cos_phi;
-    Sz = -cos_phi;
-    Ez = 0;
-    Zz = sin_phi;
-    Lx = Sx * Lxh + Ex * Lyh + Zx * Lzh;
-    Ly = Sy * Lxh + Ey * Lyh + Zy * Lzh;
-    Lz = Sz * Lxh + Ez * Lyh + Zz * Lzh;
-    obs_set->dec = ArcSin(Lz);  /* Declination (radians) */
-    cos_delta = sqrt(1 - Sqr(Lz));
-    sin_alpha = Ly / cos_delta;
-    cos_alpha = Lx / cos_delta;
-    obs_set->ra = AcTan(sin_alpha, cos_alpha);  /* Right Ascension (radians) */
-    obs_set->ra = FMod2p(obs_set->ra);
-}
-
-
 /** \brief Reload reference to satellites (e.g. after TLE update). */
 void gtk_sat_list_reload_sats(GtkWidget * satlist, GHashTable * sats)
 {
@@ -72,6 +72,7 @@ struct _gtk_sat_list
      guint            counter;      /*!< cycle counter */
 
      gdouble          tstamp;       /*!< time stamp of calculations; set by GtkSatModule */
+     obs_frame_t      frame;        /*!< observer frame at tstamp; set up once per update */
     GKeyFile         *cfgdata;
     gint              sort_column;
     GtkSortType       sort_order;
@@ -31,6 +31,7 @@
  *       and gtk-sat-map-popup.c.
  *
  */
+#include <string.h>
 #include <gtk/gtk.h>
 #include <glib/gi18n.h>
 #include "sgpsdp/sgp4sdp4.h"
@@ -50,7 +51,6 @@
 #include "predict-tools.h"
 #include "gtk-sat-map-ground-track.h"
 
-
 static void     create_polylines  (GtkSatMap *satmap, sat_t *sat, qth_t *qth, sat_map_obj_t *obj);
 static gboolean ssp_wrap_detected (GtkSatMap *satmap, gdouble x1, gdouble x2);
 static void     free_ssp          (gpointer ssp, gpointer data);
@@ -58,7 +58,7 @@ static void     free_ssp          (gpointer ssp, gpointer data);
 
 /** \brief Create and show ground track for a satellite.
  *  \param satmap The satellite map widget.
- *  \param sat Pointer to the satellite object.
+ *  \param sat_in Pointer to the satellite object.
  *  \param qth Pointer to the QTH data.
  *  \param obj the satellite object.
  *  
@@ -67,118 +67,37 @@ static void     free_ssp          (gpointer ssp, gpointer data);
  * times, and using one single polyline for the whole ground track would look very
  * silly. To avoid this, the points will be split into several polylines.
  *
+ * The calculations are done on a private copy of the satellite, so the live
+ * satellite data of the module is not changed.
  */
 void
-ground_track_create (GtkSatMap *satmap, sat_t *sat, qth_t *qth, sat_map_obj_t *obj)
+ground_track_create (GtkSatMap *satmap, sat_t *sat_in, qth_t *qth, sat_map_obj_t *obj)
 {
-     long  this_orbit;  /* current orbit number */
-     long  max_orbit;   /* target orbit number, ie. this + num - 1 */
-     double         t0;          /* time when this_orbit starts */
-     double         t;
-     ssp_t         *this_ssp;
+     glong num;    /* number of orbits */
 
 
      sat_log_log (SAT_LOG_LEVEL_DEBUG,
                      _("%s: Creating ground track for %s"),
-                 __FUNCTION__, sat->nickname);
-
-     /* just to be safe... if empty GSList is not NULL => segfault */
-     obj->track_data.latlon = NULL;
+                 __FUNCTION__, sat_in->nickname);
 
      /* get configuration parameters */
-     this_orbit = sat->orbit;
-     max_orbit = sat->orbit -1 + mod_cfg_get_int (satmap->cfgdata,
-                                                             MOD_CFG_MAP_SECTION,
-                                                             MOD_CFG_MAP_TRACK_NUM,
-                                                             SAT_CFG_INT_MAP_TRACK_NUM);
-
-                               
-     sat_log_log (SAT_LOG_LEVEL_DEBUG,
-                     _("%s: Start orbit: %d"),
-                     __FUNCTION__, this_orbit);
-     sat_log_log (SAT_LOG_LEVEL_DEBUG,
-                     _("%s: End orbit %d"),
-                     __FUNCTION__, max_orbit);
-
-
-     /* find the time when the current orbit started */
-
-     /* Iterate backwards in time until we reach sat->orbit < this_orbit.
-        Use predict_calc from predict-tools.c as SGP/SDP driver.
-        As a built-in safety, we stop iteration if the orbit crossing is
-        more than 24 hours back in time.
-     */
-     t0 = satmap->tstamp;//get_current_daynum ();
-     /* use == instead of >= as it is more robust */
-     for (t = t0; (sat->orbit == this_orbit) && ((t + 1.0) > t0); t -= 0.0007) {
-
-          predict_calc (sat, qth, t);
-
-     }
-
-     /* set it so that we are in the same orbit as this_orbit
-        and not a different one */
-     t += 2*0.0007;
-     t0 = t;     
-     predict_calc (sat, qth, t0);
-
-     sat_log_log (SAT_LOG_LEVEL_DEBUG,
-                     _("%s: T0: %f (%d)"),
-                     __FUNCTION__, t0, sat->orbit);
-
+     num = mod_cfg_get_int (satmap->cfgdata,
+                            MOD_CFG_MAP_SECTION,
+                            MOD_CFG_MAP_TRACK_NUM,
+                            SAT_CFG_INT_MAP_TRACK_NUM);
 
      /* calculate (lat,lon) for the required orbits */
-     while ((sat->orbit <= max_orbit) &&
-            (sat->orbit >= this_orbit) &&
-            (!decayed(sat))) {
-
-          /* We use 30 sec time steps. If resolution is too fine, the
-             line drawing routine will filter out unnecessary points
-          */
-          t += 0.00035;
-          predict_calc (sat, qth, t);
-
-          /* store this SSP */
-
-          /* Note: g_slist_append() has to traverse the entire list to find the end, which
-             is inefficient when adding multiple elements. Therefore, we use g_slist_prepend()
-             and reverse the entire list when we are done.
-          */
-          this_ssp = g_try_new (ssp_t, 1);
-
-          if (this_ssp == NULL) {
-               sat_log_log (SAT_LOG_LEVEL_ERROR,
-                               _("%s: MAYDAY: Insufficient memory for ground track!"),
-                               __FUNCTION__);
-               return;
-          }
-          
-          this_ssp->lat = sat->ssplat;
-          this_ssp->lon = sat->ssplon;
-          obj->track_data.latlon = g_slist_prepend (obj->track_data.latlon, this_ssp);
-          
-     }
-     /* log if there is a problem with the orbit calculation */
-     if (sat->orbit != (max_orbit+1)) {
-         sat_log_log (SAT_LOG_LEVEL_ERROR,
-                      _("%s: Problem computing ground track for %s"),
-                      __FUNCTION__, sat->nickname);
-         return;
-     }
-     
-
-     /* Reset satellite structure to eliminate glitches in single sat 
-        view and other places when new ground track is layed out */
-     predict_calc(sat, qth, satmap->tstamp);
+     obj->track_data.latlon = predict_ground_track (sat_in, qth, satmap->tstamp, num);
 
-     /* reverse GSList */
-     obj->track_data.latlon = g_slist_reverse (obj->track_data.latlon);
+     /* the problem has been logged */
+     if (obj->track_data.latlon == NULL)
+          return;
 
      /* split points into polylines */
-     create_polylines (satmap, sat, qth, obj);
+     create_polylines (satmap, sat_in, qth, obj);
 
      /* misc book-keeping */
-     obj->track_orbit = this_orbit;
+     obj->track_orbit = sat_in->orbit;
 
 }
 
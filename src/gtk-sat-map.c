@@ -95,10 +95,7 @@ static gboolean on_button_release  (GooCanvasItem *item,
 static void clear_selection        (gpointer key, gpointer val, gpointer data);
 static void load_map_file          (GtkSatMap *satmap, float clon);
 static GooCanvasItemModel*         create_canvas_model (GtkSatMap *satmap);
-static gdouble arccos              (gdouble, gdouble);
 static gboolean pole_is_covered    (sat_t *sat);
-static gboolean north_pole_is_covered    (sat_t *sat);
-static gboolean south_pole_is_covered    (sat_t *sat);
 static gboolean mirror_lon         (sat_t *sat, gdouble rangelon, gdouble *mlon, gdouble mapbreak);
 static guint calculate_footprint   (GtkSatMap *satmap, sat_t *sat);
 static void  split_points          (GtkSatMap *satmap, sat_t *sat, gdouble sspx);
@@ -1280,26 +1277,6 @@ load_map_file (GtkSatMap *satmap, float clon)
 }
 
 
-/** \brief Arccosine implementation. 
- *
- * Returns a value between zero and two pi.
- * Borrowed from gsat 0.9 by Xavier Crehueras, EB3CZS.
- * Optimized by Alexandru Csete.
- */
-static gdouble
-arccos (gdouble x, gdouble y)
-{
-    if (x && y) {
-        if (y > 0.0)
-            return acos (x/y);
-        else if (y < 0.0)
-            return pi + acos (x/y);
-    }
-
-    return 0.0;
-}
-
-
 /** \brief Check whether the footprint covers the North or South pole. */
 static gboolean
 pole_is_covered   (sat_t *sat)
@@ -1310,44 +1287,6 @@ pole_is_covered   (sat_t *sat)
         return FALSE;
 }
 
-/** \brief Check whether the footprint covers the North pole. */
-static gboolean
-north_pole_is_covered (sat_t *sat) 
-{
-    int ret1;
-    gdouble qrb1, az1;
-
-    ret1 = qrb (sat->ssplon, sat->ssplat, 0.0, 90.0, &qrb1, &az1);
-    if (ret1 != RIG_OK) {
-        sat_log_log (SAT_LOG_LEVEL_ERROR, 
-                     _("%s: Bad data measuring distance to North Pole %f %f."),
-                     __FUNCTION__, sat->ssplon, sat->ssplat);
-    }
-    if (qrb1 <= 0.5*sat->footprint) {
-        return TRUE;
-    }
-    return FALSE;
-}
-
-/** \brief Check whether the footprint covers the South pole. */
-static gboolean
-south_pole_is_covered (sat_t *sat) 
-{
-    int ret1;
-    gdouble qrb1, az1;
-
-    ret1 = qrb (sat->ssplon, sat->ssplat, 0.0, -90.0, &qrb1, &az1);
-    if (ret1 != RIG_OK) {
-        sat_log_log (SAT_LOG_LEVEL_ERROR, 
-                     _("%s: Bad data measuring distance to South Pole %f %f."),
-                     __FUNCTION__, sat->ssplon, sat->ssplat);
-    }
-    if (qrb1 <= 0.5*sat->footprint) {
-        return TRUE;
-    }
-    return FALSE;
-}
-
 
 /** \brief Mirror the footprint longitude. */
 static gboolean
@@ -1426,51 +1365,16 @@ calculate_footprint (GtkSatMap *satmap, sat_t *sat)
 {
     guint azi;
     gfloat sx, sy, msx, msy, ssx, ssy;
-    gdouble ssplat, ssplon, beta, azimuth, num, dem;
     gdouble rangelon, rangelat, mlon;
+    gdouble lat[180], lon[180];
     gboolean warped = FALSE;
     guint numrc = 1;
 
-    /* Range circle calculations.
-     * Borrowed from gsat 0.9.0 by Xavier Crehueras, EB3CZS
-     * who borrowed from John Magliacane, KD2BD.
-     * Optimized by Alexandru Csete and William J Beksi.
-     */
-    ssplat = sat->ssplat * de2ra;
-    ssplon = sat->ssplon * de2ra;
-    beta = (0.5 * sat->footprint) / xkmper;
+    footprint_points (sat, lat, lon);
 
     for (azi = 0; azi < 180; azi++)    {
-        azimuth = de2ra * (double)azi;
-        rangelat = asin (sin (ssplat) * cos (beta) + cos (azimuth) *
-                         sin (beta) * cos (ssplat));
-        num = cos (beta) - (sin (ssplat) * sin (rangelat));
-        dem = cos (ssplat) * cos (rangelat);
-            
-        if (azi == 0 && north_pole_is_covered(sat))
-            rangelon = ssplon + pi;
-            
-        else if (azi == 180 && south_pole_is_covered(sat))
-            rangelon = ssplon + pi;
-                
-        else if (fabs (num / dem) > 1.0)
-            rangelon = ssplon;
-                
-        else {
-            if ((180.0 - azi) >= 0)
-                rangelon = ssplon - arccos (num, dem);
-            else
-                rangelon = ssplon + arccos (num, dem);
-        }
-                
-        while (rangelon < -pi)
-            rangelon += twopi;
-        
-        while (rangelon > (pi))
-            rangelon -= twopi;
-                
-        rangelat = rangelat / de2ra;
-        rangelon = rangelon / de2ra;
+        rangelat = lat[azi];
+        rangelon = lon[azi];
 
         /* mirror longitude */
         if (mirror_lon (sat, rangelon, &mlon, satmap->left_side_lon))
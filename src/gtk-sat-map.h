@@ -35,6 +35,7 @@
 #include <gdk/gdk.h>
 #include <gtk/gtk.h>
 #include "gtk-sat-data.h"
+#include "predict-tools.h"
 #include <goocanvas.h>
 
 
@@ -57,13 +58,6 @@ extern "C" {
 typedef struct _GtkSatMapClass   GtkSatMapClass;
 
 
-/** \brief Structure that define a sub-satellite point. */
-typedef struct {
-    double lat;   /*!< Latitude in decimal degrees North. */
-    double lon;   /*!< Longitude in decimal degrees West. */
-} ssp_t;
-
-
 /** \brief Data storage for ground tracks */
 typedef struct {
     GSList    *latlon;   /*!< List of ssp_t */
@@ -853,6 +853,7 @@ static void sky_at_glance_cb (GtkWidget *menuitem, gpointer data)
 
     /* store time at which GtkSkyGlance has been created */
     module->lastSkgUpd = module->tmgCdnum;
+    module->skg_stale = FALSE;
 
     gtk_container_set_border_width (GTK_CONTAINER (module->skgwin), 10);
     gtk_container_add (GTK_CONTAINER (module->skgwin), module->skg);
@@ -0,0 +1,406 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2012  Alexandru Csete, OZ9AEC.
+
+    Authors: Alexandru Csete <oz9aec@gmail.com>
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+/** \brief Parallel module tick.
+ *
+ * The satellites of a module are propagated on a thread pool outside the
+ * GTK main loop. Each module tick keeps a private copy of every satellite
+ * (the snapshot) and only the worker threads write to it. When all workers
+ * are done, the main loop copies the snapshot into the live sat_t
+ * structures that the views use and calls the done-function of the
+ * module, so the live data is only ever touched from the main loop.
+ *
+ * The satellites are split into small chunks and all chunks are queued in
+ * one thread pool shared by all modules. Idle threads pick the next chunk
+ * from the queue, which keeps the threads busy even when some chunks
+ * contain expensive deep-space satellites.
+ */
+
+#include <string.h>
+#include <glib.h>
+#include <glib/gi18n.h>
+#include "sgpsdp/sgp4sdp4.h"
+#ifdef HAVE_CONFIG_H
+#  include <build-config.h>
+#endif
+#include "sat-log.h"
+#include "predict-tools.h"
+#include "sat-event-cache.h"
+#include "sat-ephem-cache.h"
+#include "gtk-sat-module-tick.h"
+
+
+/** \brief Number of satellites per work unit. */
+#define TICK_CHUNK_SIZE  32
+
+/** \brief Number of worker threads if GLib can not tell the number of CPUs. */
+#define TICK_THREADS     4
+
+
+/** \brief Work unit: a range of satellites in the snapshot. */
+typedef struct {
+    mod_tick_t    *tick;        /*!< The tick that the chunk belongs to */
+    guint          first;       /*!< Index of the first satellite */
+    guint          n;           /*!< Number of satellites */
+} tick_chunk_t;
+
+
+struct mod_tick_s {
+    guint               nsats;    /*!< Number of satellites */
+    sat_t             **live;     /*!< The satellites of the module */
+    sat_t              *snap;     /*!< Private copies propagated by the workers */
+    sat_event_cache_t **events;   /*!< AOS/LOS event cache of each satellite */
+    sat_ephem_cache_t **ephem;    /*!< Ephemeris cache of each satellite, or NULL */
+    guint               nchunks;  /*!< Number of work units */
+    tick_chunk_t       *chunks;   /*!< The work units */
+
+    qth_t               qth;      /*!< Copy of the module QTH for the running tick */
+    gdouble             t;        /*!< Time of the running tick */
+    obs_frame_t         frame;    /*!< Observer frame at t, shared by the workers */
+    gdouble             maxdt;    /*!< AOS/LOS look-ahead time */
+
+    mod_tick_done_t     done;     /*!< Function called after publishing */
+    gpointer            data;     /*!< User data for done */
+
+    gboolean            running;  /*!< A tick has been started but not published */
+    GMutex             *lock;     /*!< Protects pending and idle_id */
+    GCond              *cond;     /*!< Signalled when pending reaches 0 */
+    guint               pending;  /*!< Number of unfinished work units */
+    guint               idle_id;  /*!< Source ID of the scheduled publish */
+    GTimer             *timer;    /*!< Measures the duration of a tick */
+    mod_tick_stats_t    stats;    /*!< Tick statistics */
+};
+
+
+static GThreadPool *pool = NULL;
+static guint        pool_users = 0;
+
+
+static void     tick_worker      (gpointer data, gpointer user_data);
+static gboolean tick_publish_cb  (gpointer data);
+static void     tick_collect_sat (gpointer key, gpointer val, gpointer data);
+
+
+/** \brief Create a new tick for a set of satellites.
+ *  \param sats The satellites of the module (catnum -> sat_t).
+ *  \param events The AOS/LOS event caches of the module (catnum -> sat_event_cache_t).
+ *  \param ephem The ephemeris caches of the module (catnum -> sat_ephem_cache_t),
+ *               or NULL to propagate the satellites directly.
+ *  \param done Function to call in the main loop after each tick.
+ *  \param data User data passed to \a done.
+ *  \return A newly allocated tick which should be freed with mod_tick_free.
+ *
+ * The snapshot is initialised from the current contents of \a sats and any
+ * missing event or ephemeris cache is added to \a events or \a ephem. The tick must be re-created
+ * every time the satellites have been (re)loaded.
+ */
+mod_tick_t *
+mod_tick_new   (GHashTable *sats, GHashTable *events, GHashTable *ephem,
+                mod_tick_done_t done, gpointer data)
+{
+    mod_tick_t            *tick;
+    tick_chunk_t          *chunk;
+    GPtrArray             *live;
+    GError                *err = NULL;
+    guint                  i;
+
+
+    tick = g_new0 (mod_tick_t, 1);
+    tick->done = done;
+    tick->data = data;
+    tick->lock = g_mutex_new ();
+    tick->cond = g_cond_new ();
+    tick->timer = g_timer_new ();
+
+    live = g_ptr_array_new ();
+    if (sats != NULL)
+        g_hash_table_foreach (sats, tick_collect_sat, live);
+
+    tick->nsats = live->len;
+    tick->live = (sat_t **) g_ptr_array_free (live, FALSE);
+    tick->snap = g_new (sat_t, tick->nsats);
+    tick->events = g_new (sat_event_cache_t *, tick->nsats);
+    if (ephem != NULL)
+        tick->ephem = g_new (sat_ephem_cache_t *, tick->nsats);
+
+    for (i = 0; i < tick->nsats; i++) {
+        tick->snap[i] = *(tick->live[i]);
+
+        tick->events[i] = g_hash_table_lookup (events, GINT_TO_POINTER (tick->snap[i].tle.catnr));
+        if (tick->events[i] == NULL) {
+            tick->events[i] = sat_event_cache_new ();
+            g_hash_table_insert (events, GINT_TO_POINTER (tick->snap[i].tle.catnr),
+                                 tick->events[i]);
+        }
+
+        if (ephem == NULL)
+            continue;
+
+        tick->ephem[i] = g_hash_table_lookup (ephem, GINT_TO_POINTER (tick->snap[i].tle.catnr));
+        if (tick->ephem[i] == NULL) {
+            tick->ephem[i] = sat_ephem_cache_new ();
+            g_hash_table_insert (ephem, GINT_TO_POINTER (tick->snap[i].tle.catnr),
+                                 tick->ephem[i]);
+        }
+    }
+
+    /* split the satellites into work units */
+    tick->nchunks = (tick->nsats + TICK_CHUNK_SIZE - 1) / TICK_CHUNK_SIZE;
+    tick->chunks = g_new0 (tick_chunk_t, tick->nchunks);
+
+    for (i = 0; i < tick->nchunks; i++) {
+        chunk = &tick->chunks[i];
+        chunk->tick = tick;
+        chunk->first = i * TICK_CHUNK_SIZE;
+        chunk->n = MIN (TICK_CHUNK_SIZE, tick->nsats - chunk->first);
+    }
+
+    /* the thread pool is shared by all modules */
+    if (pool == NULL) {
+#if GLIB_CHECK_VERSION(2,36,0)
+        pool = g_thread_pool_new (tick_worker, NULL, g_get_num_processors (), FALSE, &err);
+#else
+        pool = g_thread_pool_new (tick_worker, NULL, TICK_THREADS, FALSE, &err);
+#endif
+        if (pool == NULL) {
+            sat_log_log (SAT_LOG_LEVEL_ERROR,
+                         _("%s: Could not create thread pool (%s)"),
+                         __FUNCTION__, err ? err->message : "unknown error");
+            g_clear_error (&err);
+        }
+    }
+    pool_users++;
+
+    return tick;
+}
+
+
+/** \brief Free a tick.
+ *
+ * Waits for the workers to finish and drops the unpublished results, if any.
+ */
+void
+mod_tick_free  (mod_tick_t *tick)
+{
+    if (tick == NULL)
+        return;
+
+    mod_tick_wait (tick);
+
+    g_free (tick->chunks);
+    g_free (tick->live);
+    g_free (tick->snap);
+    g_free (tick->events);
+    g_free (tick->ephem);
+    g_mutex_free (tick->lock);
+    g_cond_free (tick->cond);
+    g_timer_destroy (tick->timer);
+    g_free (tick);
+
+    pool_users--;
+    if (pool_users == 0 && pool != NULL) {
+        g_thread_pool_free (pool, FALSE, TRUE);
+        pool = NULL;
+    }
+}
+
+
+/** \brief Start a new tick.
+ *  \param tick The tick.
+ *  \param qth The QTH; it is copied so the caller may change it while the tick runs.
+ *  \param t The time to propagate the satellites to.
+ *  \param maxdt The look-ahead time for the AOS/LOS search [days].
+ *  \return TRUE if the tick was started, FALSE if the previous tick has not
+ *          been published yet. The latter counts as a missed deadline.
+ *
+ * This function returns immediately. The satellites are published and the
+ * done-function is called from the main loop when the workers are finished.
+ * Must be called from the main loop.
+ */
+gboolean
+mod_tick_start (mod_tick_t *tick, qth_t *qth, gdouble t, gdouble maxdt)
+{
+    guint i;
+
+    if (tick->running) {
+        tick->stats.missed++;
+        return FALSE;
+    }
+
+    tick->running = TRUE;
+    tick->qth = *qth;
+    tick->t = t;
+    tick->maxdt = maxdt;
+    predict_init_frame (&tick->frame, &tick->qth, t);
+    g_timer_start (tick->timer);
+
+    g_mutex_lock (tick->lock);
+    tick->pending = tick->nchunks;
+    if (tick->pending == 0)
+        tick->idle_id = g_idle_add (tick_publish_cb, tick);
+    g_mutex_unlock (tick->lock);
+
+    /* without a thread pool the work units are done right here */
+    for (i = 0; i < tick->nchunks; i++) {
+        if (pool != NULL)
+            g_thread_pool_push (pool, &tick->chunks[i], NULL);
+        else
+            tick_worker (&tick->chunks[i], NULL);
+    }
+
+    return TRUE;
+}
+
+
+/** \brief Check whether a tick is in progress. */
+gboolean
+mod_tick_running   (mod_tick_t *tick)
+{
+    return tick->running;
+}
+
+
+/** \brief Wait for the running tick to finish and cancel its publishing.
+ *
+ * Used before the satellites of the module are freed or reloaded. Must be
+ * called from the main loop.
+ */
+void
+mod_tick_wait  (mod_tick_t *tick)
+{
+    g_mutex_lock (tick->lock);
+
+    while (tick->pending > 0)
+        g_cond_wait (tick->cond, tick->lock);
+
+    if (tick->idle_id > 0) {
+        g_source_remove (tick->idle_id);
+        tick->idle_id = 0;
+    }
+
+    g_mutex_unlock (tick->lock);
+
+    tick->running = FALSE;
+}
+
+
+/** \brief Copy the snapshot into the live satellites.
+ *
+ * Must be called from the main loop and not while a tick is running.
+ */
+void
+mod_tick_publish   (mod_tick_t *tick)
+{
+    guint i;
+
+    for (i = 0; i < tick->nsats; i++)
+        memcpy (tick->live[i], &tick->snap[i], sizeof (sat_t));
+}
+
+
+/** \brief Get the tick statistics. */
+void
+mod_tick_get_stats (mod_tick_t *tick, mod_tick_stats_t *stats)
+{
+    *stats = tick->stats;
+}
+
+
+/** \brief Add a satellite to the list of live satellites. */
+static void
+tick_collect_sat (gpointer key, gpointer val, gpointer data)
+{
+    (void) key; /* prevent unused parameter compiler warning */
+
+    g_ptr_array_add ((GPtrArray *) data, val);
+}
+
+
+/** \brief Thread pool function; updates one work unit.
+ *  \param data The work unit (tick_chunk_t).
+ *  \param user_data Not used.
+ *
+ * Only the snapshot of the satellites in the unit and their event and
+ * ephemeris caches are written to, so the units can run concurrently.
+ */
+static void
+tick_worker    (gpointer data, gpointer user_data)
+{
+    tick_chunk_t *chunk = (tick_chunk_t *) data;
+    mod_tick_t   *tick = chunk->tick;
+    sat_t        *sat;
+    guint         i;
+
+    (void) user_data; /* prevent unused parameter compiler warning */
+
+    for (i = chunk->first; i < chunk->first + chunk->n; i++) {
+        sat = &tick->snap[i];
+
+        sat_event_cache_get (tick->events[i], sat, &tick->qth,
+                             tick->t, tick->maxdt, &sat->aos, &sat->los);
+
+        if (tick->ephem != NULL)
+            predict_calc_cached (sat, tick->ephem[i], &tick->frame);
+        else
+            predict_calc_frame (sat, &tick->frame);
+    }
+
+    /* the last unit schedules the publishing in the main loop */
+    g_mutex_lock (tick->lock);
+    tick->pending--;
+    if (tick->pending == 0) {
+        tick->idle_id = g_idle_add (tick_publish_cb, tick);
+        g_cond_broadcast (tick->cond);
+    }
+    g_mutex_unlock (tick->lock);
+}
+
+
+/** \brief Publish the finished tick; called from the main loop. */
+static gboolean
+tick_publish_cb    (gpointer data)
+{
+    mod_tick_t *tick = (mod_tick_t *) data;
+
+    g_mutex_lock (tick->lock);
+    tick->idle_id = 0;
+    g_mutex_unlock (tick->lock);
+
+    mod_tick_publish (tick);
+
+    tick->stats.count++;
+    tick->stats.last = 1000.0 * g_timer_elapsed (tick->timer, NULL);
+    if (tick->stats.last > tick->stats.max)
+        tick->stats.max = tick->stats.last;
+
+    tick->running = FALSE;
+
+    if (tick->done != NULL)
+        tick->done (tick->data, tick->t);
+
+    return FALSE;
+}
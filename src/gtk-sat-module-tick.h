@@ -0,0 +1,87 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2012  Alexandru Csete, OZ9AEC.
+
+    Authors: Alexandru Csete <oz9aec@gmail.com>
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+
+/****
+
+     NOTE: This file is an internal part of gtk-sat-module and should not
+     be used by other files than gtk-sat-module.c and gtk-sat-module-popup.c
+
+*****/
+
+#ifndef __GTK_SAT_MODULE_TICK_H__
+#define __GTK_SAT_MODULE_TICK_H__ 1
+
+#include <glib.h>
+#include "qth-data.h"
+
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+
+/** \brief Parallel module tick (opaque). */
+typedef struct mod_tick_s mod_tick_t;
+
+
+/** \brief Tick statistics. */
+typedef struct {
+    guint    count;    /*!< Number of finished ticks */
+    guint    missed;   /*!< Number of ticks skipped because the previous one was still running */
+    gdouble  last;     /*!< Duration of the last tick [msec] */
+    gdouble  max;      /*!< Longest tick so far [msec] */
+} mod_tick_stats_t;
+
+
+/** \brief Function called in the main loop when a tick has been published.
+ *  \param data The user data given to mod_tick_new.
+ *  \param t The time of the published satellite data.
+ */
+typedef void (*mod_tick_done_t) (gpointer data, gdouble t);
+
+
+mod_tick_t *mod_tick_new       (GHashTable *sats,
+                                GHashTable *events,
+                                GHashTable *ephem,
+                                mod_tick_done_t done,
+                                gpointer data);
+void        mod_tick_free      (mod_tick_t *tick);
+gboolean    mod_tick_start     (mod_tick_t *tick, qth_t *qth,
+                                gdouble t, gdouble maxdt);
+gboolean    mod_tick_running   (mod_tick_t *tick);
+void        mod_tick_wait      (mod_tick_t *tick);
+void        mod_tick_publish   (mod_tick_t *tick);
+void        mod_tick_get_stats (mod_tick_t *tick, mod_tick_stats_t *stats);
+
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* __GTK_SAT_MODULE_TICK_H__ */
@@ -57,9 +57,12 @@
 #include "time-tools.h"
 #include "orbit-tools.h"
 #include "predict-tools.h"
+#include "sat-event-cache.h"
+#include "sat-ephem-cache.h"
 #include "gtk-sat-module.h"
 #include "gtk-sat-module-popup.h"
 #include "gtk-sat-module-tmg.h"
+#include "gtk-sat-module-tick.h"
 #include "gtk-sat-list.h"
 #include "gtk-sat-map.h"
 #include "gtk-polar-view.h"
@@ -76,6 +79,10 @@
 //#  include "libc_interface.h"
 //#endif
 
+
+/** \brief Log every this many missed ticks. */
+#define MISSED_TICKS_LOG 100
+
 static void     gtk_sat_module_class_init     (GtkSatModuleClass   *class);
 static void     gtk_sat_module_init           (GtkSatModule        *module);
 static void     gtk_sat_module_destroy        (GtkObject           *object);
@@ -85,9 +92,7 @@ static void     gtk_sat_module_read_cfg_data  (GtkSatModule *module,
 static void     gtk_sat_module_load_sats      (GtkSatModule *module);
 static void     gtk_sat_module_free_sat       (gpointer sat);
 static gboolean gtk_sat_module_timeout_cb     (gpointer module);
-static void     gtk_sat_module_update_sat     (gpointer key,
-                                               gpointer val,
-                                               gpointer data);
+static void     gtk_sat_module_tick_done      (gpointer module, gdouble t);
 static void     gtk_sat_module_popup_cb       (GtkWidget *button,
                                                gpointer data);
 
@@ -100,6 +105,8 @@ static GtkWidget *create_view                 (GtkSatModule *module, guint num);
 static void     reload_sats_in_child (GtkWidget *widget, GtkSatModule *module);
 
 static void     update_skg                    (GtkSatModule *module);
+static void     gtk_sat_module_cfg_changed    (const sat_cfg_snapshot_t *cfg,
+                                               gpointer data);
 
 
 static GtkVBoxClass *parent_class = NULL;
@@ -169,6 +176,14 @@ gtk_sat_module_init (GtkSatModule *module)
                                                 g_int_equal,
                                                 g_free,
                                                 gtk_sat_module_free_sat);
+    module->events = g_hash_table_new_full (g_direct_hash,
+                                            g_direct_equal,
+                                            NULL,
+                                            (GDestroyNotify) sat_event_cache_free);
+    module->ephem = g_hash_table_new_full (g_direct_hash,
+                                           g_direct_equal,
+                                           NULL,
+                                           (GDestroyNotify) sat_ephem_cache_free);
     
     module->rotctrlwin = NULL;
     module->rotctrl    = NULL;
@@ -177,9 +192,14 @@ gtk_sat_module_init (GtkSatModule *module)
     module->skgwin     = NULL;
     module->skg        = NULL;
     module->lastSkgUpd = 0.0;
+    module->skg_stale  = FALSE;
 
     module->state = GTK_SAT_MOD_STATE_DOCKED;
     module->busy = g_mutex_new();
+    module->tick = NULL;
+
+    /* cached predictions must follow the prediction settings */
+    module->cfg_notify = sat_cfg_add_notify (gtk_sat_module_cfg_changed, module);
 
     /* open the gpsd device */
     module->gps_data = NULL;
@@ -214,6 +234,11 @@ gtk_sat_module_destroy (GtkObject *object)
     if (module->timerid > 0)
         g_source_remove (module->timerid);
 
+    if (module->cfg_notify > 0) {
+        sat_cfg_remove_notify (module->cfg_notify);
+        module->cfg_notify = 0;
+    }
+
     /* destroy time controller */
     if (module->tmgActive) {
         gtk_widget_destroy (module->tmgWin);
@@ -239,11 +264,21 @@ gtk_sat_module_destroy (GtkObject *object)
         module->qth = NULL;
     }
 
-    /* clean up satellites */
+    /* clean up satellites; wait for a running tick first */
+    mod_tick_free (module->tick);
+    module->tick = NULL;
     if (module->satellites) {
         g_hash_table_destroy (module->satellites);
         module->satellites = NULL;
     }
+    if (module->events) {
+        g_hash_table_destroy (module->events);
+        module->events = NULL;
+    }
+    if (module->ephem) {
+        g_hash_table_destroy (module->ephem);
+        module->ephem = NULL;
+    }
 
     if (module->grid) {
         g_free (module->grid);
@@ -326,6 +361,12 @@ gtk_sat_module_new (const gchar *cfgfile)
 
     /* load satellites */
     gtk_sat_module_load_sats (GTK_SAT_MODULE (widget));
+    GTK_SAT_MODULE (widget)->tick = mod_tick_new (GTK_SAT_MODULE (widget)->satellites,
+                                                  GTK_SAT_MODULE (widget)->events,
+                                                  GTK_SAT_MODULE (widget)->ephem_cache ?
+                                                  GTK_SAT_MODULE (widget)->ephem : NULL,
+                                                  gtk_sat_module_tick_done,
+                                                  widget);
     
     /* create buttons */
     GTK_SAT_MODULE (widget)->popup_button =
@@ -349,15 +390,6 @@ gtk_sat_module_new (const gchar *cfgfile)
         (GTK_SAT_MODULE(widget)->timeout > 1000 ? 1 : 
          (guint) floor (1000/GTK_SAT_MODULE(widget)->timeout));
 
-    /* Event timeout
-       Update every minute FIXME: user configurable
-    */
-    GTK_SAT_MODULE (widget)->event_timeout = 
-        (GTK_SAT_MODULE(widget)->timeout > 60000 ? 1 : 
-         (guint) floor (60000/GTK_SAT_MODULE(widget)->timeout));
-    /* force update the first time */
-    GTK_SAT_MODULE (widget)->event_count = GTK_SAT_MODULE (widget)->event_timeout;
-
 
     butbox = gtk_hbox_new (FALSE, 0);
     gtk_box_pack_start (GTK_BOX (butbox),
@@ -589,6 +621,12 @@ gtk_sat_module_read_cfg_data (GtkSatModule *module, const gchar *cfgfile)
                                        MOD_CFG_TIMEOUT_KEY,
                                        SAT_CFG_INT_MODULE_TIMEOUT);
 
+    /* use ephemeris cache? */
+    module->ephem_cache = mod_cfg_get_bool (module->cfgdata,
+                                            MOD_CFG_GLOBAL_SECTION,
+                                            MOD_CFG_EPHEM_CACHE_KEY,
+                                            SAT_CFG_BOOL_EPHEM_CACHE);
+
     /* get grid layout configuration (introduced in 1.2) */
     buffer = mod_cfg_get_str (module->cfgdata,
                               MOD_CFG_GLOBAL_SECTION,
@@ -721,7 +759,7 @@ gtk_sat_module_load_sats      (GtkSatModule *module)
                              __FUNCTION__, sats[i]);
 
                 /* it is not needed in this case */
-                g_free (sat);
+                gtk_sat_data_free_sat (sat);
             }
 
         }
@@ -755,11 +793,11 @@ static gboolean
 gtk_sat_module_timeout_cb     (gpointer module)
 {
     GtkSatModule   *mod = GTK_SAT_MODULE (module);
-    GtkWidget      *child;
     gboolean        needupdate = FALSE;
     GdkWindowState  state;
     gdouble         delta;
-    guint           i;
+    gdouble         maxdt;
+    mod_tick_stats_t stats;
     /*update the qth position*/
     qth_data_update(mod->qth,mod->tmgCdnum);
 
@@ -810,92 +848,111 @@ gtk_sat_module_timeout_cb     (gpointer module)
            mod->tmgCdnum every time
         */
 
-        /* time to update header? */
-        mod->head_count++;
-        if (mod->head_count >= mod->head_timeout) {
+        /* start updating the satellite data in the worker threads; the
+           views are updated in gtk_sat_module_tick_done once the data
+           has been published. If the previous tick is still running,
+           this one is skipped and counted as missed.
+        */
+        maxdt = (gdouble) sat_cfg_get_snapshot ()->pred_look_ahead;
 
-            /* reset counter */
-            mod->head_count = 0;
-            
-            update_header (mod);
-        }
+        if (mod_tick_start (mod->tick, mod->qth, mod->tmgCdnum, maxdt)) {
 
-        /* time to update events? */
-        if (mod->event_count == mod->event_timeout) {
+            /* store time keeping variables */
+            mod->rtPrev = mod->rtNow;
+            mod->tmgPdnum = mod->tmgCdnum;
 
-            /* reset counter, this will make gtk_sat_module_update_sat
-               recalculate events
-            */
-            mod->event_count = 0;
         }
-        /*only trigger an update if adequate movement has occurred*/
-        /*FIXME position threshhold should be configurable*/
-        if (qth_small_dist(mod->qth,mod->qth_event)>1.0) {
-            /* reset counter, this will make gtk_sat_module_update_sat
-               recalculate events
-            */
-            mod->event_count = 0;
-        }
-        
-        /*if the events are going to be recalculated store the position*/
-        if (mod->event_count == 0){
-            qth_small_save(mod->qth,&(mod->qth_event));
-        }
-        /* update satellite data */
-        if (mod->satellites != NULL)
-            g_hash_table_foreach (mod->satellites,
-                                  gtk_sat_module_update_sat,
-                                  module);
-
-        /* update children */
-        for (i = 0; i < mod->nviews; i++) {
-            child = GTK_WIDGET (g_slist_nth_data (mod->views, i));
-            update_child (child, mod->tmgCdnum);
+        else {
+            mod_tick_get_stats (mod->tick, &stats);
+
+            if (stats.missed % MISSED_TICKS_LOG == 1) {
+                sat_log_log (SAT_LOG_LEVEL_WARN,
+                             _("%s: Previous cycle of %s missed its deadline "\
+                               "(%d times so far)."),
+                             __FUNCTION__, mod->name, stats.missed);
+            }
         }
 
+        g_mutex_unlock(mod->busy);
 
-        /* update satellite data (it may have got out of sync during child updates) */
-        if (mod->satellites != NULL) 
-            g_hash_table_foreach (mod->satellites,
-                                  gtk_sat_module_update_sat,
-                                  module);
+    }
+    return TRUE;
+}
 
-        /* send notice to radio and rotator controller */
-        if (mod->rigctrl)
-            gtk_rig_ctrl_update (GTK_RIG_CTRL (mod->rigctrl), mod->tmgCdnum);
-        if (mod->rotctrl)
-            gtk_rot_ctrl_update (GTK_ROT_CTRL (mod->rotctrl), mod->tmgCdnum);
-            
-        /* check and update Sky at glance */
-        /* FIXME: We should have some timeout counter to ensure that we don't
-         * update GtkSkyGlance too often when running with high throttle values;
-         * however, the update does not seem to add any significant load even
-         * when running at max throttle
-         */
-        if (mod->skg)
-            update_skg (mod);
 
+/** \brief Update the module after a tick.
+ *  \param module Pointer to the GtkSatModule widget.
+ *  \param t The time of the satellite data.
+ *
+ * This function is called in the main loop when the satellite data of a
+ * tick started by gtk_sat_module_timeout_cb has been published. It updates
+ * the header, the views, the radio and rotator controllers, and the sky at
+ * a glance.
+ */
+static void
+gtk_sat_module_tick_done      (gpointer module, gdouble t)
+{
+    GtkSatModule   *mod = GTK_SAT_MODULE (module);
+    GtkWidget      *child;
+    gdouble         azrate, elrate;
+    guint           i;
 
-        mod->event_count++;
+    if (g_mutex_trylock(mod->busy)==FALSE)
+        return;
 
-        /* store time keeping variables */
-        mod->rtPrev = mod->rtNow;
-        mod->tmgPdnum = mod->tmgCdnum;
+    /* time to update header? */
+    mod->head_count++;
+    if (mod->head_count >= mod->head_timeout) {
 
-        if (mod->tmgActive) {
+        /* reset counter */
+        mod->head_count = 0;
+        
+        update_header (mod);
+    }
 
-            /* update time control spin buttons when we are
-               in RT or SRT mode */
-            if (mod->throttle) {
-                tmg_update_widgets (mod);
-            }
+    /* update children; the views treat the satellite data as read-only
+       and do their own calculations on private copies (see test-007) */
+    for (i = 0; i < mod->nviews; i++) {
+        child = GTK_WIDGET (g_slist_nth_data (mod->views, i));
+        update_child (child, t);
+    }
 
-        }
+    /* the radio and the rotator share one schedule, which leaves time to
+       slew the rotator, if any */
+    if (mod->rigctrl) {
+        azrate = 0.0;
+        elrate = 0.0;
+        if (mod->rotctrl)
+            gtk_rot_ctrl_get_slew (GTK_ROT_CTRL (mod->rotctrl), &azrate, &elrate);
+        gtk_rig_ctrl_set_slew (GTK_RIG_CTRL (mod->rigctrl), azrate, elrate);
+    }
 
-          g_mutex_unlock(mod->busy);
+    /* send notice to radio and rotator controller */
+    if (mod->rigctrl)
+        gtk_rig_ctrl_update (GTK_RIG_CTRL (mod->rigctrl), t);
+    if (mod->rotctrl)
+        gtk_rot_ctrl_update (GTK_ROT_CTRL (mod->rotctrl), t);
+        
+    /* check and update Sky at glance */
+    /* FIXME: We should have some timeout counter to ensure that we don't
+     * update GtkSkyGlance too often when running with high throttle values;
+     * however, the update does not seem to add any significant load even
+     * when running at max throttle
+     */
+    if (mod->skg)
+        update_skg (mod);
+
+    if (mod->tmgActive) {
+
+        /* update time control spin buttons when we are
+           in RT or SRT mode */
+        if (mod->throttle) {
+            tmg_update_widgets (mod);
+        }
 
     }
-    return TRUE;
+
+    g_mutex_unlock(mod->busy);
 }
 
 
@@ -942,107 +999,6 @@ update_child (GtkWidget *child, gdouble tstamp)
 }
 
 
-/** \brief Update a given satellite.
- *  \param key The hash table key (catnum)
- *  \param val The hash table value (sat_t structure)
- *  \param data User data (the GtkSatModule widget).
- *
- * This function updates the tracking data for a given satelite. It is called by
- * the timeout handler for each element in the hash table.
- */
-static void
-gtk_sat_module_update_sat    (gpointer key, gpointer val, gpointer data)
-{
-    sat_t        *sat;
-    GtkSatModule *module;
-    gdouble       daynum;
-    gdouble       maxdt;
-
-    (void) key; /* prevent unused parameter compiler warning */
-
-    g_return_if_fail ((val != NULL) && (data != NULL));
-
-    sat = SAT(val);
-    module = GTK_SAT_MODULE (data);
-    
-
-
-    /* get current time (real or simulated */
-    daynum = module->tmgCdnum;
-
-    /* update events if the event counter has been reset
-       and the other requirements are fulfilled
-    */
-    if ((GTK_SAT_MODULE (module)->event_count == 0) &&
-        has_aos (sat, module->qth))    {
-
-        /* Note that has_aos may return TRUE for geostationary sats
-           whose orbit deviate from a true-geostat orbit, however,
-           find_aos and find_los will not go beyond the time limit
-           we specify (in those cases they return 0.0 for AOS/LOS times.
-           We use SAT_CFG_INT_PRED_LOOK_AHEAD for upper time limit
-        */
-        maxdt = (gdouble) sat_cfg_get_int (SAT_CFG_INT_PRED_LOOK_AHEAD);
-        //sat->aos = find_aos (sat, module->qth, daynum, maxdt, 0.0f);
-        sat->aos = find_aos (sat, module->qth, daynum, maxdt);
-        //sat->los = find_los (sat, module->qth, daynum, maxdt, 0.0f);
-        sat->los = find_los (sat, module->qth, daynum, maxdt);
-
-    } 
-    /*
-      Update AOS and LOS for this satellite if it was known and is before 
-      the current time. 
-      
-      daynum is the current time in the module. 
-      
-      The conditional aos < daynum is merely saying that aos occured 
-      in the past. Therefore it cannot be the next event or aos/los 
-      for that satellite.
-
-      The conditional aos > 0.0 is a short hand for saying that the 
-      aos was successfully computed before. find_aos returns 0.0 when it 
-      cannot find an AOS. 
-      
-      This code should not execute find_aos(los) if the conditional before 
-      is triggered as the newly computed aos(los) should either be in 
-      the future (aos > daynum) or (aos == 0 ).
-
-      Single sat/list/event/map views all use these values and they 
-      should be up to date.
-
-      The above code is still required for dealing with circumstances 
-      where the qth moves from someplace where the qth can have an AOS and 
-      where qth does not and for satellites in parking orbits where the 
-      AOS may be further than maxdt out results in aos==0.0 until the 
-      next aos is closer than maxdt. It also prevents the aos from 
-      being computed every pass through the module for the parking orbits.
-
-      To be completely correct, when time can move forward and backwards 
-      as it can with the time controller, the time the aos/los was 
-      computed should be stored and associated with aos/los. That way 
-      if daynum <time_computed, the aos can be recomputed as there is 
-      no assurance that the current stored aos is the next aos. As a 
-      practical matter the above code handles time reversing acceptably 
-      for most circumstances. 
-
-    */
-    if (sat->aos > 0 && sat->aos < daynum) {
-        maxdt = (gdouble) sat_cfg_get_int (SAT_CFG_INT_PRED_LOOK_AHEAD);
-        sat->aos = find_aos (sat, module->qth, daynum, maxdt);
-   //     sat->aos = find_aos (sat, module->qth, daynum, maxdt, 0.0f);
-    } 
-    if (sat->los > 0 && sat->los < daynum) {
-        maxdt = (gdouble) sat_cfg_get_int (SAT_CFG_INT_PRED_LOOK_AHEAD);
-        sat->los = find_los (sat, module->qth, daynum, maxdt);
-   //     sat->los = find_los (sat, module->qth, daynum, maxdt, 0.0f);
-    }
-
-    predict_calc( sat, module->qth, daynum);
-
-}
-
-
-
 /** \brief Module options
  *
  * Invoke module-wide popup menu
@@ -1357,6 +1313,7 @@ update_header (GtkSatModule *module)
     gchar *fmtstr;
     gchar buff[TIME_FORMAT_MAX_LENGTH+1];
     gchar *buff2;
+    mod_tick_stats_t stats;
 
 
     fmtstr = sat_cfg_get_str (SAT_CFG_STR_TIME_FORMAT);
@@ -1371,6 +1328,13 @@ update_header (GtkSatModule *module)
     else
         gtk_label_set_text (GTK_LABEL (module->header), buff);
  
+    /* tick statistics */
+    mod_tick_get_stats (module->tick, &stats);
+    buff2 = g_strdup_printf (_("Updates: %d\nMissed: %d\n"\
+                               "Last update: %.1f msec\nSlowest update: %.1f msec"),
+                             stats.count, stats.missed, stats.last, stats.max);
+    gtk_widget_set_tooltip_text (module->header, buff2);
+    g_free (buff2);
 
 
     g_free (fmtstr);
@@ -1419,14 +1383,20 @@ gtk_sat_module_reload_sats    (GtkSatModule *module)
                  _("%s: Reloading satellites for module %s"),
                  __FUNCTION__, module->name);
 
-    /* remove each element from the hash table, but keep the hash table */
+    /* remove each element from the hash table, but keep the hash table;
+       a running tick still uses the satellites so wait for it first */
+    mod_tick_free (module->tick);
     g_hash_table_foreach_remove (module->satellites, empty, NULL);
 
-    /* reset event counter so that next AOS/LOS gets re-calculated */
-    module->event_count = 0;       
+    /* the TLE data may have changed, recalculate AOS/LOS and ephemerides */
+    g_hash_table_remove_all (module->events);
+    g_hash_table_remove_all (module->ephem);
 
     /* load satellites */
     gtk_sat_module_load_sats (module);
+    module->tick = mod_tick_new (module->satellites, module->events,
+                                 module->ephem_cache ? module->ephem : NULL,
+                                 gtk_sat_module_tick_done, module);
 
     /* update children */
     for (i = 0; i < module->nviews; i++) {
@@ -1556,10 +1526,11 @@ static void get_grid_size (GtkSatModule *module, guint *rows, guint *cols)
  * widget was last updated and triggers an update if necessary. The current 
  * distance is set to 1km.
  * 
- * This is a cheap/lazy implementation of automatic update. Instead of
- * performing a real update by "moving" the objects on the GtkSkyGlance canvas,
- * we simply replace the current GtkSkyGlance object with a new one.
- * Ugly but safe.
+ * When only the time has moved, the timeline of the existing GtkSkyGlance
+ * object is shifted so that only the newly exposed time slice has to be
+ * predicted. The widget is replaced with a new one when the qth has moved
+ * or the prediction settings have changed, since all passes change in that
+ * case.
  * 
  * To ensure smooth performance while running in simulated real time with high
  * throttle value or manual time mode, the caller is responsible for only calling
@@ -1568,6 +1539,7 @@ static void get_grid_size (GtkSatModule *module, guint *rows, guint *cols)
 static void update_skg (GtkSatModule *module)
 {
     gboolean update_needed=FALSE;
+    gboolean rebuild=FALSE;
     /* threshold is ~60 seconds */
     if (G_UNLIKELY(fabs(module->tmgCdnum - module->lastSkgUpd) > 7.0e-4)) {
         update_needed=TRUE;
@@ -1575,21 +1547,72 @@ static void update_skg (GtkSatModule *module)
     /* threshold is 1km */
     if (G_UNLIKELY(qth_small_dist(module->qth, module->lastSkgUpdqth) >1.0)) {
         update_needed=TRUE;
+        rebuild=TRUE;
+    }
+    /* the passes were predicted with the old settings */
+    if (G_UNLIKELY(module->skg_stale)) {
+        update_needed=TRUE;
+        rebuild=TRUE;
     }
 
 
     if (G_UNLIKELY(update_needed==TRUE)) {
         
-        sat_log_log (SAT_LOG_LEVEL_INFO,
-                     _("%s: Updating GtkSkyGlance for %s"),
-                     __FUNCTION__, module->name);
-        
-        gtk_container_remove (GTK_CONTAINER (module->skgwin), module->skg);
-        module->skg = gtk_sky_glance_new (module->satellites, module->qth, module->tmgCdnum);
-        gtk_container_add (GTK_CONTAINER (module->skgwin), module->skg);
-        gtk_widget_show_all (module->skg);
+        if (rebuild || !IS_GTK_SKY_GLANCE (module->skg)) {
+            sat_log_log (SAT_LOG_LEVEL_INFO,
+                         _("%s: Updating GtkSkyGlance for %s"),
+                         __FUNCTION__, module->name);
+
+            gtk_container_remove (GTK_CONTAINER (module->skgwin), module->skg);
+            module->skg = gtk_sky_glance_new (module->satellites, module->qth, module->tmgCdnum);
+            gtk_container_add (GTK_CONTAINER (module->skgwin), module->skg);
+            gtk_widget_show_all (module->skg);
+            module->skg_stale = FALSE;
+        }
+        else if (!gtk_sky_glance_set_time (module->skg, module->tmgCdnum)) {
+            /* previous slice is still being predicted; try again next cycle */
+            return;
+        }
         
         module->lastSkgUpd = module->tmgCdnum;
         qth_small_save(module->qth,&(module->lastSkgUpdqth));
     }
 }
+
+
+/** \brief Invalidate one AOS/LOS event cache; used with g_hash_table_foreach. */
+static void invalidate_events (gpointer key, gpointer val, gpointer data)
+{
+    (void) key;  /* prevent unused parameter compiler warning */
+    (void) data; /* prevent unused parameter compiler warning */
+
+    sat_event_cache_invalidate ((sat_event_cache_t *) val);
+}
+
+
+/** \brief Drop the predictions made with the old prediction settings.
+ *  \param cfg The new configuration snapshot.
+ *  \param data Pointer to the GtkSatModule.
+ *
+ * This function is called by sat-cfg in the main loop when the preferences
+ * have been saved and one of the prediction settings has changed. The AOS/LOS
+ * event caches are recomputed at the next tick. The GtkSkyGlance widget is
+ * rebuilt at the next update, which also cancels its running job on the pass
+ * prediction service; passes it has already predicted used the old minimum
+ * elevation, resolution and time span.
+ */
+static void gtk_sat_module_cfg_changed (const sat_cfg_snapshot_t *cfg, gpointer data)
+{
+    GtkSatModule *module = GTK_SAT_MODULE (data);
+
+    (void) cfg; /* prevent unused parameter compiler warning */
+
+    /* a running tick uses the event caches */
+    if (module->tick != NULL)
+        mod_tick_wait (module->tick);
+
+    g_hash_table_foreach (module->events, invalidate_events, NULL);
+
+    if (module->skg != NULL)
+        module->skg_stale = TRUE;
+}
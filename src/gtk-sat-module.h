@@ -105,12 +105,11 @@ struct _gtk_sat_module
     GtkWidget     *skg;         /*!< Sky at glance widget */
     gdouble        lastSkgUpd;  /*!< Daynum of last GtkSkyGlance update */
     qth_small_t    lastSkgUpdqth;     /*!< QTH information for last GtkSkyGlance update. */
+    gboolean       skg_stale;   /*!< The prediction settings changed since the GtkSkyGlance was created */
 
     GtkWidget     *header;
     guint          head_count;
     guint          head_timeout;
-    guint          event_count;
-    guint          event_timeout;
 
     /* layout and children */
     guint         *grid;         /*!< The grid layout array [(type,left,right,top,bottom),...] */
@@ -118,11 +117,15 @@ struct _gtk_sat_module
     GSList       *views;        /*!< Pointers to the views */
 
     GKeyFile      *cfgdata;      /*!< Configuration data. */
+    guint          cfg_notify;   /*!< ID of the sat_cfg change notification */
     qth_t         *qth;          /*!< QTH information. */
-    qth_small_t   qth_event;     /*!< QTH information for last AOS/LOS update. */
     GHashTable    *satellites;   /*!< Satellites. */
+    GHashTable    *events;       /*!< AOS/LOS event caches (sat_event_cache_t), key is catnum */
+    GHashTable    *ephem;        /*!< Ephemeris caches (sat_ephem_cache_t), key is catnum */
+    struct mod_tick_s *tick;     /*!< Parallel satellite update, see gtk-sat-module-tick.c */
 
     guint32        timeout;      /*!< Timeout value [msec] */
+    gboolean       ephem_cache;  /*!< Use the ephemeris caches, see sat-ephem-cache.c */
 
     gtk_sat_mod_state_t  state;   /*!< The state of the module. */
 
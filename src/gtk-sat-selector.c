@@ -457,6 +457,7 @@ static void create_and_fill_models (GtkSatSelector *selector)
 
                 g_free (sat.name);
                 g_free (sat.nickname);
+                free_ephemeris (&sat);
                 num++;
             }
 
@@ -572,6 +573,7 @@ static void load_cat_file (GtkSatSelector *selector, const gchar *fname)
                                         -1);
                     g_free (sat.name);
                     g_free (sat.nickname);
+                    free_ephemeris (&sat);
                     num++;
                 }
 
@@ -114,7 +114,6 @@ static void gtk_single_sat_destroy    (GtkObject       *object);
 
 static void store_sats              (gpointer key, gpointer value, gpointer user_data);
 static void update_field            (GtkSingleSat *ssat, guint i);
-static void Calculate_RADec         (sat_t *sat, qth_t *qth, obs_astro_t *obs_set);
 static void gtk_single_sat_popup_cb (GtkWidget *button, gpointer data);
 static void select_satellite        (GtkWidget *menuitem, gpointer data);
 static gint sat_name_compare (sat_t *a,sat_t *b);
@@ -230,6 +229,8 @@ gtk_single_sat_new (GKeyFile *cfgdata, GHashTable *sats, qth_t *qth, guint32 fie
 
     g_hash_table_foreach (sats, store_sats, widget);
     GTK_SINGLE_SAT (widget)->selected = 0;
+    GTK_SINGLE_SAT (widget)->ra = 0.0;
+    GTK_SINGLE_SAT (widget)->dec = 0.0;
     GTK_SINGLE_SAT (widget)->qth = qth;
     GTK_SINGLE_SAT (widget)->cfgdata = cfgdata;
     
@@ -399,19 +400,22 @@ gtk_single_sat_update          (GtkWidget *widget)
         ssat->counter++;
     }
     else {
-        
+        sat_t *sat = SAT (g_slist_nth_data (ssat->sats, ssat->selected));
+
+        /* shared by RA/Dec and visibility */
+        predict_init_frame (&ssat->frame, ssat->qth, ssat->tstamp);
 
         /* we calculate here to avoid double calc */
         if ((ssat->flags & SINGLE_SAT_FLAG_RA) ||
             (ssat->flags & SINGLE_SAT_FLAG_DEC)) {
 
-            sat_t      *sat = SAT (g_slist_nth_data (ssat->sats, ssat->selected));
             obs_astro_t astro;
 
 
-            Calculate_RADec (sat, ssat->qth, &astro);
-            sat->ra = Degrees(astro.ra);
-            sat->dec = Degrees(astro.dec);
+            /* keep the result in the view; the sat_t belongs to the module */
+            Calculate_RADec_Frame (&ssat->frame, sat->az * de2ra, sat->el * de2ra, &astro);
+            ssat->ra = Degrees(astro.ra);
+            ssat->dec = Degrees(astro.dec);
         }
 
         /* update visible fields one by one */
@@ -499,12 +503,12 @@ update_field            (GtkSingleSat *ssat, guint i)
 
 
     case SINGLE_SAT_FIELD_RA:
-        buff = g_strdup_printf ("%6.2f\302\260", sat->ra);
+        buff = g_strdup_printf ("%6.2f\302\260", ssat->ra);
         break;
 
 
     case SINGLE_SAT_FIELD_DEC:
-        buff = g_strdup_printf ("%6.2f\302\260", sat->dec);
+        buff = g_strdup_printf ("%6.2f\302\260", ssat->dec);
         break;
 
 
@@ -703,7 +707,7 @@ update_field            (GtkSingleSat *ssat, guint i)
 
 
     case SINGLE_SAT_FIELD_VISIBILITY:
-        vis = get_sat_vis (sat, ssat->qth, sat->jul_utc);
+        vis = get_sat_vis_frame (sat, &ssat->frame);
         buff = vis_to_str (vis);
         break;
 
@@ -743,59 +747,6 @@ store_sats (gpointer key, gpointer value, gpointer user_data)
 
 
 
-
-static void
-Calculate_RADec (sat_t *sat, qth_t *qth, obs_astro_t *obs_set)
-{
-    /* Reference:  Methods of Orbit Determination by  */
-    /*                Pedro Ramon Escobal, pp. 401-402 */
-
-    double phi,theta,sin_theta,cos_theta,sin_phi,cos_phi,
-        az,el,Lxh,Lyh,Lzh,Sx,Ex,Zx,Sy,Ey,Zy,Sz,Ez,Zz,
-        Lx,Ly,Lz,cos_delta,sin_alpha,cos_alpha;
-    geodetic_t geodetic;
-
-
-    geodetic.lon = qth->lon * de2ra;
-    geodetic.lat = qth->lat * de2ra;
-    geodetic.alt = qth->alt / 1000.0;
-    geodetic.theta = 0;
-
-
-
-    az = sat->az * de2ra;
-    el = sat->el * de2ra;
-    phi   = geodetic.lat;
-    theta = FMod2p(ThetaG_JD(sat->jul_utc) + geodetic.lon);
-    sin_theta = sin(theta);
-    cos_theta = cos(theta);
-    sin_phi = sin(phi);
-    cos_phi = cos(phi);
-    Lxh = -cos(az) * cos(el);
-    Lyh =  sin(az) * cos(el);
-    Lzh =  sin(el);
-    Sx = sin_phi * cos_theta;
-    Ex = -sin_theta;
-    Zx = cos_theta * cos_phi;
-    Sy = sin_phi * sin_theta;
-    Ey = cos_theta;
-    Zy = sin_theta*cos_phi;
-    Sz = -cos_phi;
-    Ez = 0;
-    Zz = sin_phi;
-    Lx = Sx*Lxh + Ex * Lyh + Zx*Lzh;
-    Ly = Sy*Lxh + Ey * Lyh + Zy*Lzh;
-    Lz = Sz*Lxh + Ez * Lyh + Zz*Lzh;
-    obs_set->dec = ArcSin(Lz);  /* Declination (radians)*/
-    cos_delta = sqrt(1 - Sqr(Lz));
-    sin_alpha = Ly / cos_delta;
-    cos_alpha = Lx / cos_delta;
-    obs_set->ra = AcTan(sin_alpha,cos_alpha); /* Right Ascension (radians)*/
-    obs_set->ra = FMod2p(obs_set->ra);
-
-}
-
-
 /** \brief Songle sat options
  *
  * Invoke single sat popup menu
@@ -139,6 +139,9 @@ struct _gtk_single_sat
      guint         refresh;      /*!< Refresh rate. */
      guint         counter;      /*!< cycle counter. */
      guint          selected;     /*!< index of selected sat. */
+     gdouble       ra;           /*!< Right Ascension of selected sat [deg]. */
+     gdouble       dec;          /*!< Declination of selected sat [deg]. */
+     obs_frame_t   frame;        /*!< Observer frame of the last update. */
 
      gdouble       tstamp;       /*!< time stamp of calculations; update by GtkSatModule */
      
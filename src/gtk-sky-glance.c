@@ -37,6 +37,11 @@
  * When we get additional space due to resizing, the space will be allocated
  * to make the rectangles taller.
  *
+ * When time moves on, gtk_sky_glance_set_time shifts the timeline: passes
+ * that are still within the window are kept and only moved on the canvas,
+ * passes that fell off the left edge are dropped, and only the newly
+ * exposed slice on the right is predicted on the pass prediction service.
+ *
  */
 #include <gtk/gtk.h>
 #include <glib/gi18n.h>
@@ -49,6 +54,7 @@
 #include "gtk-sat-data.h"
 #include "gpredict-utils.h"
 #include "predict-tools.h"
+#include "pass-service.h"
 #include "sat-pass-dialogs.h"
 #include "time-tools.h"
 //#include "gtk-sky-glance-popup.h"
@@ -65,6 +71,7 @@
 #define SKG_PIX_PER_SAT 10
 #define SKG_MARGIN 15
 #define SKG_FOOTER 50
+#define SKG_MAX_PASSES 10   /* max number of passes per satellite and prediction */
 
 
 static void     gtk_sky_glance_class_init(GtkSkyGlanceClass * class);
@@ -101,6 +108,11 @@ static GooCanvasItemModel *create_canvas_model(GtkSkyGlance * skg);
 
 
 static void     create_sat(gpointer key, gpointer value, gpointer data);
+static void     add_passes(GtkSkyGlance * skg, sky_row_t * row, GSList * passes);
+static void     free_row(sky_row_t * row);
+static void     update_layout(GtkSkyGlance * skg);
+static void     start_prediction(GtkSkyGlance * skg, gdouble from);
+static void     apply_slice_cb(pass_job_t * job, gpointer data);
 
 static gdouble  t2x(GtkSkyGlance * skg, gdouble t);
 static gdouble  x2t(GtkSkyGlance * skg, gdouble x);
@@ -160,8 +172,8 @@ static void gtk_sky_glance_init(GtkSkyGlance * skg)
 {
     skg->sats = NULL;
     skg->qth = NULL;
-    skg->passes = NULL;
-    skg->satlab = NULL;
+    skg->rows = NULL;
+    skg->job = NULL;
     skg->x0 = 0;
     skg->y0 = 0;
     skg->w = 0;
@@ -184,37 +196,24 @@ static void gtk_sky_glance_init(GtkSkyGlance * skg)
  */
 static void gtk_sky_glance_destroy(GtkObject * object)
 {
-    sky_pass_t     *skypass;
-    guint           i, n;
+    GtkSkyGlance   *skg = GTK_SKY_GLANCE(object);
 
 
-    /* free passes */
-    /* FIXME: TBC whether this is enough */
-    if (GTK_SKY_GLANCE(object)->passes != NULL)
-    {
+    /* cancel a running prediction */
+    pass_job_free(skg->job);
+    skg->job = NULL;
 
-        n = g_slist_length(GTK_SKY_GLANCE(object)->passes);
-        for (i = 0; i < n; i++)
-        {
-            skypass =
-                (sky_pass_t *) g_slist_nth_data(GTK_SKY_GLANCE(object)->passes,
-                                                i);
-            free_pass(skypass->pass);
-            g_free(skypass);
-        }
-
-        g_slist_free(GTK_SKY_GLANCE(object)->passes);
-        GTK_SKY_GLANCE(object)->passes = NULL;
+    /* free rows and passes */
+    if (skg->rows != NULL)
+    {
+        g_slist_foreach(skg->rows, (GFunc) free_row, NULL);
+        g_slist_free(skg->rows);
+        skg->rows = NULL;
     }
 
     /* for the rest we only need to free the GSList because the
        canvas items will be freed when removed from canvas.
      */
-    if (GTK_SKY_GLANCE(object)->satlab != NULL)
-    {
-        g_slist_free(GTK_SKY_GLANCE(object)->satlab);
-        GTK_SKY_GLANCE(object)->satlab = NULL;
-    }
     if (GTK_SKY_GLANCE(object)->majors != NULL)
     {
         g_slist_free(GTK_SKY_GLANCE(object)->majors);
@@ -320,8 +319,9 @@ GtkWidget      *gtk_sky_glance_new(GHashTable * sats, qth_t * qth, gdouble ts)
 
     g_object_unref(root);
 
-    /* add satellite passes */
+    /* add satellite rows and predict the passes in the background */
     g_hash_table_foreach(GTK_SKY_GLANCE(skg)->sats, create_sat, skg);
+    start_prediction(GTK_SKY_GLANCE(skg), GTK_SKY_GLANCE(skg)->ts);
 
     gtk_container_add(GTK_CONTAINER(skg), GTK_SKY_GLANCE(skg)->canvas);
 
@@ -453,14 +453,6 @@ static void
 size_allocate_cb(GtkWidget * widget, GtkAllocation * allocation, gpointer data)
 {
     GtkSkyGlance   *skg;
-    GooCanvasPoints *pts;
-    GooCanvasItem  *obj;
-    gint            i, j, n;
-    guint           curcat;
-    gdouble         th, tm;
-    gdouble         xh, xm;
-    sky_pass_t     *skp;
-    gdouble         x, y, w, h;
 
 
     if (gtk_widget_get_realized(widget))
@@ -479,123 +471,154 @@ size_allocate_cb(GtkWidget * widget, GtkAllocation * allocation, gpointer data)
         goo_canvas_set_bounds(GOO_CANVAS(GTK_SKY_GLANCE(skg)->canvas), 0, 0,
                               allocation->width, allocation->height);
 
+        update_layout(skg);
+    }
+}
 
-        /* update cursor tracking line */
-        pts = goo_canvas_points_new(2);
-        pts->coords[0] = skg->x0;
-        pts->coords[1] = skg->y0;
-        pts->coords[2] = skg->x0;
-        pts->coords[3] = skg->h;
-        g_object_set(skg->cursor, "points", pts, NULL);
-        goo_canvas_points_unref(pts);
 
-        /* time label */
-        g_object_set(skg->timel, "x", (gdouble) skg->x0 + 5, NULL);
+/** \brief Update the position of the canvas items.
+ *  \param skg The GtkSkyGlance widget.
+ *
+ * This function places the canvas items according to the graph dimensions
+ * and the time window. It is used when the canvas has been re-sized and when
+ * the timeline has moved.
+ */
+static void update_layout(GtkSkyGlance * skg)
+{
+    GooCanvasPoints *pts;
+    GooCanvasItemModel *obj;
+    gint            i, j, n;
+    gdouble         th, tm;
+    gdouble         xh, xm;
+    gchar           buff[3];
+    GSList         *rnode, *pnode;
+    sky_row_t      *row;
+    sky_pass_t     *skp;
+    gdouble         x, y, w, h;
 
 
-        /* update footer */
-        g_object_set(skg->footer,
-                     "x", (gdouble) skg->x0,
-                     "y", (gdouble) skg->h,
-                     "width", (gdouble) skg->w,
-                     "height", (gdouble) SKG_FOOTER, NULL);
+    /* update cursor tracking line */
+    pts = goo_canvas_points_new(2);
+    pts->coords[0] = skg->x0;
+    pts->coords[1] = skg->y0;
+    pts->coords[2] = skg->x0;
+    pts->coords[3] = skg->h;
+    g_object_set(skg->cursor, "points", pts, NULL);
+    goo_canvas_points_unref(pts);
 
-        g_object_set(skg->axisl,
-                     "x", (gdouble) (skg->w / 2),
-                     "y", (gdouble) (skg->h + SKG_FOOTER - 5), NULL);
+    /* time label */
+    g_object_set(skg->timel, "x", (gdouble) skg->x0 + 5, NULL);
 
-        /* get the first hour and first 30 min slot */
-        th = ceil(skg->ts * 24.0) / 24.0;
 
-        /* workaround for bug 1839140 (first hour incorrexct) */
-        th += 0.00069;
+    /* update footer */
+    g_object_set(skg->footer,
+                 "x", (gdouble) skg->x0,
+                 "y", (gdouble) skg->h,
+                 "width", (gdouble) skg->w,
+                 "height", (gdouble) SKG_FOOTER, NULL);
 
-        if ((th - skg->ts) > 0.0208333)
-        {
-            tm = th - 0.0208333;
-        }
-        else
-        {
-            tm = th + 0.0208333;
-        }
+    g_object_set(skg->axisl,
+                 "x", (gdouble) (skg->w / 2),
+                 "y", (gdouble) (skg->h + SKG_FOOTER - 5), NULL);
 
-        /* the number of steps equals the number of hours */
-        n = sat_cfg_get_int(SAT_CFG_INT_SKYATGL_TIME);
-        for (i = 0; i < n; i++)
-        {
-            xh = t2x(skg, th);
+    /* get the first hour and first 30 min slot */
+    th = ceil(skg->ts * 24.0) / 24.0;
 
-            pts = goo_canvas_points_new(2);
-            pts->coords[0] = xh;
-            pts->coords[1] = skg->h;
-            pts->coords[2] = xh;
-            pts->coords[3] = skg->h + 10;
+    /* workaround for bug 1839140 (first hour incorrexct) */
+    th += 0.00069;
 
-            obj = g_slist_nth_data(skg->majors, i);
-            g_object_set(obj, "points", pts, NULL);
+    if ((th - skg->ts) > 0.0208333)
+    {
+        tm = th - 0.0208333;
+    }
+    else
+    {
+        tm = th + 0.0208333;
+    }
 
-            goo_canvas_points_unref(pts);
+    /* the number of steps equals the number of hours */
+    n = g_slist_length(skg->majors);
+    for (i = 0; i < n; i++)
+    {
+        xh = t2x(skg, th);
 
-            obj = g_slist_nth_data(skg->labels, i);
-            g_object_set(obj,
-                         "x", (gdouble) xh,
-                         "y", (gdouble) (skg->h + 12), NULL);
+        pts = goo_canvas_points_new(2);
+        pts->coords[0] = xh;
+        pts->coords[1] = skg->h;
+        pts->coords[2] = xh;
+        pts->coords[3] = skg->h + 10;
 
-            /* 30 min tick */
-            xm = t2x(skg, tm);
+        obj = g_slist_nth_data(skg->majors, i);
+        g_object_set(obj, "points", pts, NULL);
 
-            pts = goo_canvas_points_new(2);
-            pts->coords[0] = xm;
-            pts->coords[1] = skg->h;
-            pts->coords[2] = xm;
-            pts->coords[3] = skg->h + 5;
+        goo_canvas_points_unref(pts);
 
-            obj = g_slist_nth_data(skg->minors, i);
-            g_object_set(obj, "points", pts, NULL);
+        /* the hours change when the timeline moves */
+        daynum_to_str(buff, 3, "%H", th);
 
-            goo_canvas_points_unref(pts);
+        obj = g_slist_nth_data(skg->labels, i);
+        g_object_set(obj,
+                     "text", buff,
+                     "x", (gdouble) xh,
+                     "y", (gdouble) (skg->h + 12), NULL);
 
-            th += 0.04167;
-            tm += 0.04167;
-        }
+        /* 30 min tick */
+        xm = t2x(skg, tm);
 
-        /* update pass items */
-        n = g_slist_length(skg->passes);
-        j = -1;
-        curcat = 0;
-        y = 10.0;
-        h = 10.0;
-        for (i = 0; i < n; i++)
+        pts = goo_canvas_points_new(2);
+        pts->coords[0] = xm;
+        pts->coords[1] = skg->h;
+        pts->coords[2] = xm;
+        pts->coords[3] = skg->h + 5;
+
+        obj = g_slist_nth_data(skg->minors, i);
+        g_object_set(obj, "points", pts, NULL);
+
+        goo_canvas_points_unref(pts);
+
+        th += 0.04167;
+        tm += 0.04167;
+    }
+
+    /* update pass items; satellites without passes get no row */
+    j = -1;
+    for (rnode = skg->rows; rnode != NULL; rnode = rnode->next)
+    {
+        row = SKY_ROW_T(rnode->data);
+
+        if (row->passes == NULL)
         {
+            g_object_set(row->label, "visibility", GOO_CANVAS_ITEM_INVISIBLE, NULL);
+            continue;
+        }
 
-            /* get pass */
-            skp = (sky_pass_t *) g_slist_nth_data(skg->passes, i);
+        j++;
+        y = j * (skg->pps + SKG_MARGIN) + SKG_MARGIN;
+        h = skg->pps;
+
+        for (pnode = row->passes; pnode != NULL; pnode = pnode->next)
+        {
+            skp = SKY_PASS_T(pnode->data);
 
             x = t2x(skg, skp->pass->aos);
             w = t2x(skg, skp->pass->los) - x;
 
-            /* new satellite? */
-            if (skp->catnum != curcat)
+            /* update label next to the first pass */
+            if (pnode == row->passes)
             {
-                j++;
-                curcat = skp->catnum;
-                y = j * (skg->pps + SKG_MARGIN) + SKG_MARGIN;
-                h = skg->pps;
-
-                /* update label */
-                obj = g_slist_nth_data(skg->satlab, j);
                 if (x > (skg->x0 + 100))
-                    g_object_set(obj, "x", x - 5, "y", y + h / 2.0,
-                                 "anchor", GTK_ANCHOR_E, NULL);
+                    g_object_set(row->label, "x", x - 5, "y", y + h / 2.0,
+                                 "anchor", GTK_ANCHOR_E,
+                                 "visibility", GOO_CANVAS_ITEM_VISIBLE, NULL);
                 else
-                    g_object_set(obj, "x", x + w + 5, "y", y + h / 2.0,
-                                 "anchor", GTK_ANCHOR_W, NULL);
+                    g_object_set(row->label, "x", x + w + 5, "y", y + h / 2.0,
+                                 "anchor", GTK_ANCHOR_W,
+                                 "visibility", GOO_CANVAS_ITEM_VISIBLE, NULL);
             }
 
             g_object_set(skp->box,
                          "x", x, "y", y, "width", w, "height", h, NULL);
         }
-
     }
 }
 
@@ -988,24 +1011,65 @@ static void get_colours(guint i, guint * bcol, guint * fcol)
  *  \param data Pointer to the GtkSkyGlance object.
  *
  * This function is called by g_hash_table_foreach with each satellite in the
- * satellite hash table. It gets the passes for the current satellite and creates
- * the corresponding canvas items.
+ * satellite hash table. It creates the empty row of the satellite; the
+ * passes are predicted in the background, see start_prediction.
  */
 static void create_sat(gpointer key, gpointer value, gpointer data)
 {
     sat_t          *sat = SAT(value);
     GtkSkyGlance   *skg = GTK_SKY_GLANCE(data);
-    GSList         *passes = NULL;
-    gdouble         maxdt;
-    guint           i, n;
-    pass_t         *tmppass = NULL;
-    sky_pass_t     *skypass;
-    guint           bcol, fcol; /* colours */
+    sky_row_t      *row;
     GooCanvasItemModel *root;
-    GooCanvasItemModel *lab;
 
     (void)key;                  /* avoid unused parameter compiler warning */
 
+
+    /* FIXME: 
+       Include current pass if sat is up now
+     */
+
+    /* get canvas root */
+    root = goo_canvas_get_root_item_model(GOO_CANVAS(skg->canvas));
+
+    row = g_new0(sky_row_t, 1);
+    row->catnum = sat->tle.catnr;
+    get_colours(skg->satcnt++, &row->bcol, &row->fcol);
+
+    /* satellite label; hidden until the satellite has a pass */
+    row->label = goo_canvas_text_model_new(root, sat->nickname,
+                                           5, 0, -1, GTK_ANCHOR_W,
+                                           "font", "Sans 8",
+                                           "fill-color-rgba", row->bcol,
+                                           "visibility",
+                                           GOO_CANVAS_ITEM_INVISIBLE, NULL);
+
+    /* nothing has been predicted yet */
+    row->end = skg->ts;
+
+    skg->rows = g_slist_append(skg->rows, row);
+}
+
+
+/** \brief Add passes to a satellite row.
+ *  \param skg Pointer to the GtkSkyGlance widget.
+ *  \param row The row of the satellite.
+ *  \param passes List of pass_t structures; the list and the passes are
+ *               taken over by this function.
+ *
+ * This function creates the canvas items for the passes and appends them to
+ * the row. Passes that start before the last pass already in the row are
+ * duplicates from overlapping predictions and are discarded.
+ */
+static void add_passes(GtkSkyGlance * skg, sky_row_t * row, GSList * passes)
+{
+    GooCanvasItemModel *root;
+    GSList         *node;
+    GSList         *last;
+    pass_t         *pass;
+    sky_pass_t     *skypass;
+    gdouble         lastaos = 0.0;
+    gchar          *fmt;
+
     /* tooltips vars */
     gchar          *tooltip;    /* the complete tooltips string */
     gchar           aosstr[100];        /* AOS time string */
@@ -1013,106 +1077,239 @@ static void create_sat(gpointer key, gpointer value, gpointer data)
     gchar           tcastr[100];        /* TCA time string */
 
 
-    /* FIXME: 
-       Include current pass if sat is up now
-     */
+    if (passes == NULL)
+        return;
 
-    /* check that we didn't exceed 10 sats */
-    /*      if (++skg->satcnt > 10) { */
-    /*           return; */
-    /*      } */
-
-    /* get canvas root */
     root = goo_canvas_get_root_item_model(GOO_CANVAS(skg->canvas));
+    fmt = sat_cfg_get_str(SAT_CFG_STR_TIME_FORMAT);
 
-    get_colours(skg->satcnt++, &bcol, &fcol);
+    last = g_slist_last(row->passes);
+    if (last != NULL)
+        lastaos = SKY_PASS_T(last->data)->pass->aos;
 
-    maxdt = skg->te - skg->ts;
+    for (node = passes; node != NULL; node = node->next)
+    {
+        pass = (pass_t *) node->data;
 
-    /* get passes for satellite */
-    passes = get_passes(sat, skg->qth, skg->ts, maxdt, 10);
-    n = g_slist_length(passes);
-    sat_log_log(SAT_LOG_LEVEL_DEBUG,
-                _("%s:%d: %s has %d passes within %.4f days\n"),
-                __FILE__, __LINE__, sat->nickname, n, maxdt);
+        if (last != NULL && pass->aos <= lastaos)
+        {
+            free_pass(pass);
+            continue;
+        }
 
-    /* add sky_pass_t items to skg->passes */
-    if (passes != NULL)
-    {
+        skypass = g_try_new(sky_pass_t, 1);
 
-        /* add pass items */
-        for (i = 0; i < n; i++)
+        if (skypass == NULL)
         {
+            sat_log_log(SAT_LOG_LEVEL_ERROR,
+                        _("%s:%d: Could not allocate memory for pass object"),
+                        __FILE__, __LINE__);
+            free_pass(pass);
+            continue;
+        }
 
-            skypass = g_try_new(sky_pass_t, 1);
+        /* create pass structure items */
+        skypass->catnum = row->catnum;
+        skypass->pass = pass;
+
+        daynum_to_str(aosstr, TIME_FORMAT_MAX_LENGTH, fmt, pass->aos);
+        daynum_to_str(losstr, TIME_FORMAT_MAX_LENGTH, fmt, pass->los);
+        daynum_to_str(tcastr, TIME_FORMAT_MAX_LENGTH, fmt, pass->tca);
+
+        /* box tooltip will contain pass summary */
+        tooltip = g_strdup_printf("<b>%s</b>\n"
+                                  "AOS: %s  Az:%.0f\302\260\n"
+                                  "TCA: %s  Az:%.0f\302\260  El:%.1f\302\260\n"
+                                  "LOS: %s  Az:%.0f\302\260\n"
+                                  "<i>Click for details</i>",
+                                  pass->satname,
+                                  aosstr, pass->aos_az,
+                                  tcastr, pass->maxel_az,
+                                  pass->max_el, losstr, pass->los_az);
+
+        skypass->box = goo_canvas_rect_model_new(root, 10, 10, 20, 20,  /* dummy coordinates */
+                                                 "stroke-color-rgba",
+                                                 row->bcol,
+                                                 "fill-color-rgba",
+                                                 row->fcol, "line-width",
+                                                 1.0, "antialias",
+                                                 CAIRO_ANTIALIAS_NONE,
+                                                 "tooltip", tooltip, NULL);
+        g_free(tooltip);
+
+        /* store a pointer to the pass data in the GooCanvasItem so that we
+           can access it later during various events, e.g mouse click */
+        g_object_set_data(G_OBJECT(skypass->box), "pass", skypass->pass);
+
+        /* store this pass in the row */
+        row->passes = g_slist_append(row->passes, skypass);
+        lastaos = pass->aos;
+        last = row->passes;
+    }
 
-            if (skypass != NULL)
-            {
+    g_free(fmt);
+    g_slist_free(passes);
+}
 
-                /* create pass structure items */
-                skypass->catnum = sat->tle.catnr;
-                tmppass = (pass_t *) g_slist_nth_data(passes, i);
-                skypass->pass = copy_pass(tmppass);
-
-                daynum_to_str(aosstr, TIME_FORMAT_MAX_LENGTH,
-                              sat_cfg_get_str(SAT_CFG_STR_TIME_FORMAT),
-                              skypass->pass->aos);
-                daynum_to_str(losstr, TIME_FORMAT_MAX_LENGTH,
-                              sat_cfg_get_str(SAT_CFG_STR_TIME_FORMAT),
-                              skypass->pass->los);
-                daynum_to_str(tcastr, TIME_FORMAT_MAX_LENGTH,
-                              sat_cfg_get_str(SAT_CFG_STR_TIME_FORMAT),
-                              skypass->pass->tca);
-
-                /* box tooltip will contain pass summary */
-                tooltip = g_strdup_printf("<b>%s</b>\n"
-                                          "AOS: %s  Az:%.0f\302\260\n"
-                                          "TCA: %s  Az:%.0f\302\260  El:%.1f\302\260\n"
-                                          "LOS: %s  Az:%.0f\302\260\n"
-                                          "<i>Click for details</i>",
-                                          skypass->pass->satname,
-                                          aosstr, skypass->pass->aos_az,
-                                          tcastr, skypass->pass->maxel_az,
-                                          skypass->pass->max_el, losstr,
-                                          skypass->pass->los_az);
-
-                skypass->box = goo_canvas_rect_model_new(root, 10, 10, 20, 20,  /* dummy coordinates */
-                                                         "stroke-color-rgba",
-                                                         bcol,
-                                                         "fill-color-rgba",
-                                                         fcol, "line-width",
-                                                         1.0, "antialias",
-                                                         CAIRO_ANTIALIAS_NONE,
-                                                         "tooltip", tooltip,
-                                                         NULL);
-                g_free(tooltip);
-
-                /* store this pass in list */
-                skg->passes = g_slist_append(skg->passes, skypass);
-
-                /* store a pointer to the pass data in the GooCanvasItem so that we
-                   can access it later during various events, e.g mouse click */
-                g_object_set_data(G_OBJECT(skypass->box), "pass",
-                                  skypass->pass);
 
-            }
-            else
+/** \brief Free a pass item and remove it from the canvas. */
+static void free_sky_pass(sky_pass_t * skypass)
+{
+    goo_canvas_item_model_remove(skypass->box);
+    free_pass(skypass->pass);
+    g_free(skypass);
+}
+
+
+/** \brief Free a satellite row and remove its items from the canvas. */
+static void free_row(sky_row_t * row)
+{
+    g_slist_foreach(row->passes, (GFunc) free_sky_pass, NULL);
+    g_slist_free(row->passes);
+    goo_canvas_item_model_remove(row->label);
+    g_free(row);
+}
+
+
+/** \brief Move the timeline to a new start time.
+ *  \param widget The GtkSkyGlance widget.
+ *  \param ts The new start time.
+ *  \return TRUE if the timeline has been moved, FALSE if the previous
+ *          prediction is still running.
+ *
+ * The length of the timeline is kept. Passes that are still within the new
+ * time window are kept and only moved on the canvas, passes that ended
+ * before the new start time are removed. If the new window overlaps the old
+ * one, only the newly exposed slice at the end is predicted; otherwise all
+ * passes are predicted again, see start_prediction.
+ */
+gboolean gtk_sky_glance_set_time(GtkWidget * widget, gdouble ts)
+{
+    GtkSkyGlance   *skg = GTK_SKY_GLANCE(widget);
+    GSList         *rnode;
+    sky_row_t      *row;
+    sky_pass_t     *skypass;
+    gdouble         from;
+    gdouble         len;
+
+
+    if (skg->job != NULL)
+        return FALSE;
+
+    len = skg->te - skg->ts;
+
+    if (ts < skg->ts || ts >= skg->te)
+    {
+        /* no overlap; start from scratch */
+        from = ts;
+        for (rnode = skg->rows; rnode != NULL; rnode = rnode->next)
+        {
+            row = SKY_ROW_T(rnode->data);
+            g_slist_foreach(row->passes, (GFunc) free_sky_pass, NULL);
+            g_slist_free(row->passes);
+            row->passes = NULL;
+            row->end = ts;
+        }
+    }
+    else
+    {
+        /* drop the passes that fell off the left edge */
+        from = skg->te;
+        for (rnode = skg->rows; rnode != NULL; rnode = rnode->next)
+        {
+            row = SKY_ROW_T(rnode->data);
+            while (row->passes != NULL &&
+                   SKY_PASS_T(row->passes->data)->pass->los < ts)
             {
-                sat_log_log(SAT_LOG_LEVEL_ERROR,
-                            _
-                            ("%s:%d: Could not allocate memory for pass object"),
-                            __FILE__, __LINE__);
+                skypass = SKY_PASS_T(row->passes->data);
+                row->passes = g_slist_delete_link(row->passes, row->passes);
+                free_sky_pass(skypass);
             }
-
         }
+    }
 
-        free_passes(passes);
+    skg->ts = ts;
+    skg->te = ts + len;
 
-        /* add satellite label */
-        lab = goo_canvas_text_model_new(root, sat->nickname,
-                                        5, 0, -1, GTK_ANCHOR_W,
-                                        "font", "Sans 8",
-                                        "fill-color-rgba", bcol, NULL);
-        skg->satlab = g_slist_append(skg->satlab, lab);
+    start_prediction(skg, from);
+
+    if (gtk_widget_get_realized(skg->canvas))
+        update_layout(skg);
+
+    return TRUE;
+}
+
+
+/** \brief Predict the passes up to the end of the timeline.
+ *  \param skg The GtkSkyGlance widget.
+ *  \param from Earliest start of the prediction.
+ *
+ * Each row is predicted from the end of what it already has, but not before
+ * from. The prediction runs on the pass prediction service using private
+ * copies of the satellites, and apply_slice_cb adds the new passes to the
+ * graph when it has finished.
+ */
+static void start_prediction(GtkSkyGlance * skg, gdouble from)
+{
+    pass_filter_t   filter;
+    GSList         *rnode;
+    GSList         *last;
+    sky_row_t      *row;
+    sat_t          *sat;
+    gdouble         start;
+
+
+    filter.num = SKG_MAX_PASSES;
+    filter.min_el = sat_cfg_get_int(SAT_CFG_INT_PRED_MIN_EL);
+    filter.visible = FALSE;
+    filter.summary = TRUE;
+
+    skg->job = pass_job_new(skg->qth, &filter, NULL, apply_slice_cb, skg);
+
+    /* one satellite per row, in row order */
+    for (rnode = skg->rows; rnode != NULL; rnode = rnode->next)
+    {
+        row = SKY_ROW_T(rnode->data);
+
+        /* continue after the last pass we already have */
+        start = MAX(from, row->end);
+        last = g_slist_last(row->passes);
+        if (last != NULL)
+            start = MAX(start, SKY_PASS_T(last->data)->pass->los);
+
+        sat = g_hash_table_lookup(skg->sats, &row->catnum);
+        pass_job_add(skg->job, sat, start, skg->te);
     }
+
+    pass_job_start(skg->job);
+}
+
+
+/** \brief Add the passes of a finished prediction to the graph.
+ *  \param job The finished prediction.
+ *  \param data Pointer to the GtkSkyGlance widget.
+ *
+ * This function is called in the main loop by the pass prediction service.
+ * A prediction that is running when the widget is destroyed is cancelled.
+ */
+static void apply_slice_cb(pass_job_t * job, gpointer data)
+{
+    GtkSkyGlance   *skg = GTK_SKY_GLANCE(data);
+    GSList         *rnode;
+    sky_row_t      *row;
+    guint           i;
+
+
+    for (i = 0, rnode = skg->rows; rnode != NULL; i++, rnode = rnode->next)
+    {
+        row = SKY_ROW_T(rnode->data);
+        add_passes(skg, row, pass_job_steal_passes(job, i));
+        row->end = skg->te;
+    }
+
+    pass_job_free(job);
+    skg->job = NULL;
+
+    if (gtk_widget_get_realized(skg->canvas))
+        update_layout(skg);
 }
@@ -34,6 +34,7 @@
 #include <gtk/gtk.h>
 #include "gtk-sat-data.h"
 #include "predict-tools.h"
+#include "pass-service.h"
 #include <goocanvas.h>
 
 
@@ -65,6 +66,20 @@ typedef struct {
 #define SKY_PASS_T(obj) ((sky_pass_t *)obj)
 
 
+/** \brief Satellite row on graph. */
+typedef struct {
+    guint           catnum;     /*!< Catalogue number of satellite */
+    GSList         *passes;     /*!< The sky_pass_t items of the satellite, sorted by AOS */
+    gdouble         end;        /*!< Passes have been predicted up to this time */
+    guint           bcol;       /*!< Border colour of the pass boxes */
+    guint           fcol;       /*!< Fill colour of the pass boxes */
+    GooCanvasItemModel *label;  /*!< Canvas item showing the satellite name */
+} sky_row_t;
+
+
+#define SKY_ROW_T(obj) ((sky_row_t *)obj)
+
+
 /** \brief GtkSkyGlance widget */
 struct _GtkSkyGlance {
     GtkVBox         vbox;
@@ -74,10 +89,12 @@ struct _GtkSkyGlance {
     GHashTable     *sats;       /*!< Copy of satellites. */
     qth_t          *qth;        /*!< Pointer to current location. */
 
-    GSList         *passes;     /*!< Canvas items representing each pass.
-                                   Each element in the list is of type sky_pass_t.
+    GSList         *rows;       /*!< One row per satellite.
+                                   Each element in the list is of type sky_row_t.
+                                 */
+    pass_job_t     *job;        /*!< Prediction of the newly exposed time slice
+                                   running in the background, or NULL.
                                  */
-    GSList         *satlab;     /*!< Canvas items showing satellite names. */
 
 
     guint           x0;         /*!< X0 */
@@ -114,6 +131,7 @@ struct _GtkSkyGlanceClass {
 
 GType           gtk_sky_glance_get_type(void);
 GtkWidget      *gtk_sky_glance_new(GHashTable * sats, qth_t * qth, gdouble ts);
+gboolean        gtk_sky_glance_set_time(GtkWidget * skg, gdouble ts);
 
 /*
 void           gtk_sky_glance_reconf     (GtkWidget *skg);
@@ -0,0 +1,976 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2012  Alexandru Csete, OZ9AEC.
+
+    Authors: Alexandru Csete <oz9aec@gmail.com>
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+/** \brief Asynchronous I/O with the hamlib rigctld and rotctld daemons.
+ *
+ * All connections are served by one I/O thread running its own main loop,
+ * so a slow or hanging daemon never blocks the GTK main loop. The sockets
+ * are non-blocking and stay open while the connection exists; after an
+ * error the next batch reconnects.
+ *
+ * The commands of a batch are written in one go and the daemon answers
+ * them in order, so a set command followed by a get command reads back the
+ * value after it has been set without any delay in between. Commands of
+ * several batches on one connection are pipelined the same way. When all
+ * commands of a batch have been answered, or the connection has failed,
+ * the done-function is called in the GTK main loop. Worker threads that
+ * have no main loop of their own can send a batch with hamlib_io_send_wait
+ * instead, which blocks the calling thread until the batch is finished.
+ *
+ * The round trip of every command is measured from the time it is queued
+ * for writing to the time its answer is complete.
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <glib.h>
+#include <glib/gi18n.h>
+#ifdef HAVE_CONFIG_H
+#  include <build-config.h>
+#endif
+#ifndef WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/socket.h>     /* socket(), connect(), send() */
+#include <netinet/in.h>     /* struct sockaddr_in */
+#include <arpa/inet.h>      /* htons() */
+#include <netdb.h>          /* gethostbyname() */
+#else
+#include <winsock2.h>
+#endif
+#include "sat-log.h"
+#include "hamlib-io.h"
+
+
+/** \brief Time to wait for an answer before the connection is dropped [s]. */
+#define HAMLIB_IO_TIMEOUT   5.0
+
+/** \brief Interval of the timeout check [msec]. */
+#define HAMLIB_IO_TICK      500
+
+/** \brief Size of the receive buffer. */
+#define HAMLIB_IO_READ      256
+
+
+/** \brief A command and its answer. */
+typedef struct {
+    gchar     *cmd;      /*!< Command including the newline */
+    guint      lines;    /*!< Number of lines of a successful answer */
+    GString   *reply;    /*!< Answer without the last newline; NULL on error */
+    GTimeVal   sent;     /*!< Time when the command was queued for writing */
+    gdouble    latency;  /*!< Round trip [s] */
+} hamlib_cmd_t;
+
+
+struct hamlib_batch_s {
+    GArray        *cmds;      /*!< The commands (hamlib_cmd_t) */
+    guint          answered;  /*!< Number of commands answered or failed */
+    guint          lines;     /*!< Lines of the current answer received so far */
+    hamlib_io_t   *io;        /*!< The connection while the batch is sent */
+    hamlib_done_t  done;      /*!< Function to call in the main loop */
+    gpointer       data;      /*!< User data for done */
+    GDestroyNotify notify;    /*!< Function to free data, or NULL */
+    GAsyncQueue   *queue;     /*!< Queue of hamlib_io_send_wait, or NULL */
+};
+
+
+struct hamlib_io_s {
+    gint          ref_count;  /*!< Owner plus batches in flight plus the I/O thread */
+    gchar        *host;       /*!< Host name of the daemon */
+    gint          port;       /*!< Port of the daemon */
+
+    /* the fields below are only used in the I/O thread */
+    gint          sock;       /*!< The socket or -1 */
+    gboolean      connecting; /*!< The connection is being established */
+    GIOChannel   *chan;       /*!< Channel of the socket */
+    GSource      *in_watch;   /*!< Watch for incoming data and errors */
+    GSource      *out_watch;  /*!< Watch for writing, only while needed */
+    GSource      *timer;      /*!< Timeout check, only while answers are due */
+    GString      *wbuf;       /*!< Data not written yet */
+    GString      *rbuf;       /*!< Incomplete line received */
+    GQueue       *wait;       /*!< Batch of every unanswered command, in order */
+    gboolean      closing;    /*!< Close as soon as all commands are answered */
+
+    /* owner only */
+    gboolean      cancelled;  /*!< Closed by the owner; no more done-calls */
+
+    GStaticMutex  lock;       /*!< Protects stats */
+    hamlib_io_stats_t stats;  /*!< Round trip statistics */
+};
+
+
+/** \brief Operation posted to the I/O thread. */
+typedef struct {
+    hamlib_io_t    *io;
+    hamlib_batch_t *batch;    /*!< Batch to send or NULL to close */
+} hamlib_op_t;
+
+
+static GMainContext *io_context = NULL;
+static GStaticMutex  io_context_lock = G_STATIC_MUTEX_INIT;
+
+
+static gboolean io_thread_start (void);
+static gpointer io_thread_run   (gpointer data);
+static void     io_invoke       (GSourceFunc func, gpointer data);
+static gboolean io_op_cb        (gpointer data);
+static void     io_connect      (hamlib_io_t *io);
+static void     io_disconnect   (hamlib_io_t *io);
+static void     io_fail         (hamlib_io_t *io);
+static void     io_flush        (hamlib_io_t *io);
+static void     io_watch_out    (hamlib_io_t *io);
+static void     io_answer       (hamlib_io_t *io, const gchar *line);
+static void     io_finish_cmd   (hamlib_io_t *io, hamlib_batch_t *batch, gboolean ok);
+static void     io_finish_batch (hamlib_batch_t *batch);
+static void     io_check_close  (hamlib_io_t *io);
+static gboolean io_in_cb        (GIOChannel *chan, GIOCondition cond, gpointer data);
+static gboolean io_out_cb       (GIOChannel *chan, GIOCondition cond, gpointer data);
+static gboolean io_timer_cb     (gpointer data);
+static gboolean io_done_cb      (gpointer data);
+static gboolean io_would_block  (void);
+static void     hamlib_io_unref (hamlib_io_t *io);
+
+
+/** \brief Create a connection to a daemon.
+ *  \param host The host name of rigctld or rotctld.
+ *  \param port The port of the daemon.
+ *  \return The connection, which must be closed with hamlib_io_close.
+ *
+ * The connection is established in the I/O thread, so this function
+ * returns immediately. Commands can be sent right away; they are written
+ * when the connection is up. The thread that creates the connection owns
+ * it; hamlib_io_send and hamlib_io_close must be called from the same
+ * thread. Connections with done-functions must be owned by the main loop.
+ */
+hamlib_io_t *
+hamlib_io_new (const gchar *host, gint port)
+{
+    hamlib_io_t *io;
+
+
+    /* if this fails, hamlib_io_send tries again */
+    io_thread_start ();
+
+    io = g_new0 (hamlib_io_t, 1);
+    io->ref_count = 1;
+    io->host = g_strdup (host);
+    io->port = port;
+    io->sock = -1;
+    io->wbuf = g_string_new (NULL);
+    io->rbuf = g_string_new (NULL);
+    io->wait = g_queue_new ();
+    g_static_mutex_init (&io->lock);
+
+    return io;
+}
+
+
+/** \brief Send a batch of commands.
+ *  \param io The connection.
+ *  \param batch The commands; the batch is owned by the connection now.
+ *  \param done Function to call in the main loop when all commands are
+ *              answered, or NULL.
+ *  \param data User data passed to \a done.
+ *  \param notify Function to free \a data in the main loop, or NULL. It is
+ *                also called when the connection has been closed before
+ *                \a done could be called.
+ *
+ * The commands of a batch are answered in order and after the commands of
+ * the batches sent before on the same connection. If the connection fails,
+ * the remaining commands get a NULL reply.
+ */
+void
+hamlib_io_send (hamlib_io_t *io, hamlib_batch_t *batch,
+                hamlib_done_t done, gpointer data, GDestroyNotify notify)
+{
+    hamlib_op_t *op;
+
+
+    g_atomic_int_inc (&io->ref_count);
+    batch->io = io;
+    batch->done = done;
+    batch->data = data;
+    batch->notify = notify;
+
+    if (!io_thread_start ()) {
+        /* nobody can answer; all commands fail */
+        g_static_mutex_lock (&io->lock);
+        io->stats.errors += batch->cmds->len;
+        g_static_mutex_unlock (&io->lock);
+        io_finish_batch (batch);
+        return;
+    }
+
+    op = g_new (hamlib_op_t, 1);
+    op->io = io;
+    op->batch = batch;
+    io_invoke (io_op_cb, op);
+}
+
+
+/** \brief Send a batch of commands and wait for the answers.
+ *  \param io The connection.
+ *  \param batch The commands; the batch stays owned by the caller.
+ *  \return TRUE if all commands have been answered, FALSE if any of them
+ *          failed.
+ *
+ * This blocks the calling thread until all commands of the batch have been
+ * answered or have failed, i.e. at most HAMLIB_IO_TIMEOUT seconds after the
+ * last answer from the daemon. It is meant for worker threads and must not
+ * be used in the main loop.
+ */
+gboolean
+hamlib_io_send_wait (hamlib_io_t *io, hamlib_batch_t *batch)
+{
+    hamlib_cmd_t *cmd;
+    gboolean      ok = TRUE;
+    guint         i;
+
+
+    batch->queue = g_async_queue_new ();
+    hamlib_io_send (io, batch, NULL, NULL, NULL);
+    g_async_queue_pop (batch->queue);
+
+    g_async_queue_unref (batch->queue);
+    batch->queue = NULL;
+    batch->io = NULL;
+    hamlib_io_unref (io);
+
+    for (i = 0; i < batch->cmds->len; i++) {
+        cmd = &g_array_index (batch->cmds, hamlib_cmd_t, i);
+        if (cmd->reply == NULL)
+            ok = FALSE;
+    }
+
+    return ok;
+}
+
+
+/** \brief Get the round trip statistics of a connection. */
+void
+hamlib_io_get_stats (hamlib_io_t *io, hamlib_io_stats_t *stats)
+{
+    g_static_mutex_lock (&io->lock);
+    *stats = io->stats;
+    g_static_mutex_unlock (&io->lock);
+}
+
+
+/** \brief Close a connection.
+ *  \param io The connection, which must not be used any more.
+ *
+ * The commands that have been sent are still written, but their
+ * done-functions are not called any more. The socket is closed when they
+ * have been answered. Must be called from the thread that owns the
+ * connection.
+ */
+void
+hamlib_io_close (hamlib_io_t *io)
+{
+    hamlib_op_t *op;
+
+
+    io->cancelled = TRUE;
+
+    if (!io_thread_start ()) {
+        /* nothing has been sent, so this is the last reference */
+        hamlib_io_unref (io);
+        return;
+    }
+
+    /* the reference of the owner goes to the I/O thread */
+    op = g_new (hamlib_op_t, 1);
+    op->io = io;
+    op->batch = NULL;
+    io_invoke (io_op_cb, op);
+}
+
+
+/** \brief Create an empty batch. */
+hamlib_batch_t *
+hamlib_batch_new (void)
+{
+    hamlib_batch_t *batch;
+
+    batch = g_new0 (hamlib_batch_t, 1);
+    batch->cmds = g_array_new (FALSE, TRUE, sizeof (hamlib_cmd_t));
+
+    return batch;
+}
+
+
+/** \brief Add a command to a batch.
+ *  \param batch The batch.
+ *  \param lines The number of lines of the answer, e.g. 1 for a set command
+ *               ("RPRT 0") or for most get commands. An "RPRT" line always
+ *               ends the answer, so errors of get commands are recognised.
+ *  \param fmt printf-like format of the command without the newline.
+ *  \return The index of the command in the batch.
+ */
+guint
+hamlib_batch_add (hamlib_batch_t *batch, guint lines, const gchar *fmt, ...)
+{
+    hamlib_cmd_t cmd;
+    va_list      args;
+    gchar       *str;
+
+
+    va_start (args, fmt);
+    str = g_strdup_vprintf (fmt, args);
+    va_end (args);
+
+    memset (&cmd, 0, sizeof (cmd));
+    cmd.cmd = g_strconcat (str, "\x0a", NULL);
+    cmd.lines = MAX (lines, 1);
+    g_free (str);
+
+    g_array_append_val (batch->cmds, cmd);
+
+    return batch->cmds->len - 1;
+}
+
+
+/** \brief Get the number of commands in a batch. */
+guint
+hamlib_batch_size (hamlib_batch_t *batch)
+{
+    return batch->cmds->len;
+}
+
+
+/** \brief Get the answer of a command.
+ *  \param batch The batch.
+ *  \param i The index returned by hamlib_batch_add.
+ *  \return The answer without the last newline, or NULL if the command
+ *          failed because of a connection error or a timeout. The string is
+ *          owned by the batch.
+ */
+const gchar *
+hamlib_batch_reply (hamlib_batch_t *batch, guint i)
+{
+    hamlib_cmd_t *cmd;
+
+    if (i >= batch->cmds->len)
+        return NULL;
+
+    cmd = &g_array_index (batch->cmds, hamlib_cmd_t, i);
+
+    return (cmd->reply != NULL) ? cmd->reply->str : NULL;
+}
+
+
+/** \brief Get the round trip of a command in seconds. */
+gdouble
+hamlib_batch_latency (hamlib_batch_t *batch, guint i)
+{
+    if (i >= batch->cmds->len)
+        return 0.0;
+
+    return g_array_index (batch->cmds, hamlib_cmd_t, i).latency;
+}
+
+
+/** \brief Free a batch.
+ *
+ * Only needed for batches that have not been sent; sent batches are freed
+ * after their done-function has returned.
+ */
+void
+hamlib_batch_free (hamlib_batch_t *batch)
+{
+    hamlib_cmd_t *cmd;
+    guint         i;
+
+    for (i = 0; i < batch->cmds->len; i++) {
+        cmd = &g_array_index (batch->cmds, hamlib_cmd_t, i);
+        g_free (cmd->cmd);
+        if (cmd->reply != NULL)
+            g_string_free (cmd->reply, TRUE);
+    }
+
+    g_array_free (batch->cmds, TRUE);
+    g_free (batch);
+}
+
+
+/** \brief Remove a reference and free the connection if it was the last. */
+static void
+hamlib_io_unref (hamlib_io_t *io)
+{
+    if (!g_atomic_int_dec_and_test (&io->ref_count))
+        return;
+
+    g_free (io->host);
+    g_string_free (io->wbuf, TRUE);
+    g_string_free (io->rbuf, TRUE);
+    g_queue_free (io->wait);
+    g_static_mutex_free (&io->lock);
+    g_free (io);
+}
+
+
+/** \brief Start the I/O thread unless it is running.
+ *  \return TRUE if the thread is running.
+ *
+ * The thread is shared by all connections and kept running. If it can not
+ * be created, the next call tries again.
+ */
+static gboolean
+io_thread_start (void)
+{
+    GError   *err = NULL;
+    gboolean  ok = TRUE;
+
+
+    g_static_mutex_lock (&io_context_lock);
+    if (io_context == NULL) {
+        io_context = g_main_context_new ();
+        if (!g_thread_create (io_thread_run, io_context, FALSE, &err)) {
+            sat_log_log (SAT_LOG_LEVEL_ERROR,
+                         _("%s: Could not create I/O thread (%s)"),
+                         __FUNCTION__, err ? err->message : "unknown error");
+            g_clear_error (&err);
+            g_main_context_unref (io_context);
+            io_context = NULL;
+            ok = FALSE;
+        }
+    }
+    g_static_mutex_unlock (&io_context_lock);
+
+    return ok;
+}
+
+
+/** \brief Main function of the I/O thread. */
+static gpointer
+io_thread_run (gpointer data)
+{
+    GMainLoop *loop;
+
+    loop = g_main_loop_new ((GMainContext *) data, FALSE);
+    g_main_loop_run (loop);
+
+    return NULL;
+}
+
+
+/** \brief Call a function in the I/O thread. */
+static void
+io_invoke (GSourceFunc func, gpointer data)
+{
+    GSource *source;
+
+    source = g_idle_source_new ();
+    g_source_set_callback (source, func, data, NULL);
+    g_source_attach (source, io_context);
+    g_source_unref (source);
+}
+
+
+/** \brief Execute an operation in the I/O thread. */
+static gboolean
+io_op_cb (gpointer data)
+{
+    hamlib_op_t    *op = (hamlib_op_t *) data;
+    hamlib_io_t    *io = op->io;
+    hamlib_batch_t *batch = op->batch;
+    hamlib_cmd_t   *cmd;
+    guint           i;
+
+
+    g_free (op);
+
+    if (batch == NULL) {
+        io->closing = TRUE;
+        io_check_close (io);
+        return FALSE;
+    }
+
+    if (batch->cmds->len == 0) {
+        io_finish_batch (batch);
+        return FALSE;
+    }
+
+    if (io->sock < 0)
+        io_connect (io);
+
+    for (i = 0; i < batch->cmds->len; i++) {
+        cmd = &g_array_index (batch->cmds, hamlib_cmd_t, i);
+        g_get_current_time (&cmd->sent);
+        g_string_append (io->wbuf, cmd->cmd);
+        g_queue_push_tail (io->wait, batch);
+    }
+
+    if (io->sock < 0) {
+        io_fail (io);
+        return FALSE;
+    }
+
+    if (io->timer == NULL) {
+        io->timer = g_timeout_source_new (HAMLIB_IO_TICK);
+        g_source_set_callback (io->timer, io_timer_cb, io, NULL);
+        g_source_attach (io->timer, io_context);
+    }
+
+    io_flush (io);
+
+    return FALSE;
+}
+
+
+/** \brief Start connecting to the daemon. */
+static void
+io_connect (hamlib_io_t *io)
+{
+    struct sockaddr_in addr;
+    struct hostent    *h;
+#ifdef WIN32
+    u_long             mode = 1;
+#endif
+
+
+    h = gethostbyname (io->host);
+    if (h == NULL) {
+        sat_log_log (SAT_LOG_LEVEL_ERROR,
+                     _("%s: Could not resolve %s"),
+                     __FUNCTION__, io->host);
+        return;
+    }
+
+    io->sock = socket (PF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (io->sock < 0) {
+        sat_log_log (SAT_LOG_LEVEL_ERROR,
+                     _("%s: Failed to create socket"),
+                     __FUNCTION__);
+        io->sock = -1;
+        return;
+    }
+
+#ifndef WIN32
+    fcntl (io->sock, F_SETFL, fcntl (io->sock, F_GETFL, 0) | O_NONBLOCK);
+#else
+    ioctlsocket (io->sock, FIONBIO, &mode);
+#endif
+
+    memset (&addr, 0, sizeof (addr));
+    addr.sin_family = AF_INET;
+    memcpy ((char *) &addr.sin_addr.s_addr, h->h_addr_list[0], h->h_length);
+    addr.sin_port = htons (io->port);
+
+    if (connect (io->sock, (struct sockaddr *) &addr, sizeof (addr)) < 0) {
+        if (!io_would_block ()) {
+            sat_log_log (SAT_LOG_LEVEL_ERROR,
+                         _("%s: Failed to connect to %s:%d"),
+                         __FUNCTION__, io->host, io->port);
+            io_disconnect (io);
+            return;
+        }
+        io->connecting = TRUE;
+    }
+
+#ifndef WIN32
+    io->chan = g_io_channel_unix_new (io->sock);
+#else
+    io->chan = g_io_channel_win32_new_socket (io->sock);
+#endif
+    io->in_watch = g_io_create_watch (io->chan, G_IO_IN | G_IO_ERR | G_IO_HUP);
+    g_source_set_callback (io->in_watch, (GSourceFunc) io_in_cb, io, NULL);
+    g_source_attach (io->in_watch, io_context);
+
+    if (io->connecting)
+        io_watch_out (io);
+    else
+        sat_log_log (SAT_LOG_LEVEL_DEBUG,
+                     _("%s: Connection opened to %s:%d"),
+                     __FUNCTION__, io->host, io->port);
+}
+
+
+/** \brief Close the socket and remove the watches. */
+static void
+io_disconnect (hamlib_io_t *io)
+{
+    if (io->in_watch != NULL) {
+        g_source_destroy (io->in_watch);
+        g_source_unref (io->in_watch);
+        io->in_watch = NULL;
+    }
+    if (io->out_watch != NULL) {
+        g_source_destroy (io->out_watch);
+        g_source_unref (io->out_watch);
+        io->out_watch = NULL;
+    }
+    if (io->timer != NULL) {
+        g_source_destroy (io->timer);
+        g_source_unref (io->timer);
+        io->timer = NULL;
+    }
+    if (io->chan != NULL) {
+        g_io_channel_unref (io->chan);
+        io->chan = NULL;
+    }
+
+    if (io->sock >= 0) {
+#ifndef WIN32
+        shutdown (io->sock, SHUT_RDWR);
+        close (io->sock);
+#else
+        shutdown (io->sock, SD_BOTH);
+        closesocket (io->sock);
+#endif
+    }
+
+    io->sock = -1;
+    io->connecting = FALSE;
+    g_string_truncate (io->wbuf, 0);
+    g_string_truncate (io->rbuf, 0);
+}
+
+
+/** \brief Drop the connection and fail all unanswered commands. */
+static void
+io_fail (hamlib_io_t *io)
+{
+    hamlib_batch_t *batch;
+
+    io_disconnect (io);
+
+    while ((batch = g_queue_peek_head (io->wait)) != NULL)
+        io_finish_cmd (io, batch, FALSE);
+
+    io_check_close (io);
+}
+
+
+/** \brief Write as much of the pending data as the socket takes. */
+static void
+io_flush (hamlib_io_t *io)
+{
+    gint written;
+
+    if (io->sock < 0 || io->connecting)
+        return;
+
+    while (io->wbuf->len > 0) {
+        written = send (io->sock, io->wbuf->str, io->wbuf->len, 0);
+        if (written < 0) {
+            if (io_would_block ()) {
+                io_watch_out (io);
+                return;
+            }
+            sat_log_log (SAT_LOG_LEVEL_ERROR,
+                         _("%s: Connection to %s:%d closed"),
+                         __FUNCTION__, io->host, io->port);
+            io_fail (io);
+            return;
+        }
+        g_string_erase (io->wbuf, 0, written);
+    }
+}
+
+
+/** \brief Watch the socket for writing. */
+static void
+io_watch_out (hamlib_io_t *io)
+{
+    if (io->out_watch != NULL)
+        return;
+
+    io->out_watch = g_io_create_watch (io->chan, G_IO_OUT);
+    g_source_set_callback (io->out_watch, (GSourceFunc) io_out_cb, io, NULL);
+    g_source_attach (io->out_watch, io_context);
+}
+
+
+/** \brief Store a line of an answer. */
+static void
+io_answer (hamlib_io_t *io, const gchar *line)
+{
+    hamlib_batch_t *batch;
+    hamlib_cmd_t   *cmd;
+
+
+    batch = g_queue_peek_head (io->wait);
+    if (batch == NULL) {
+        sat_log_log (SAT_LOG_LEVEL_DEBUG,
+                     _("%s: Unexpected data from %s:%d (%s)"),
+                     __FUNCTION__, io->host, io->port, line);
+        return;
+    }
+
+    cmd = &g_array_index (batch->cmds, hamlib_cmd_t, batch->answered);
+    if (cmd->reply == NULL)
+        cmd->reply = g_string_new (line);
+    else
+        g_string_append_printf (cmd->reply, "\n%s", line);
+    batch->lines++;
+
+    if (batch->lines >= cmd->lines || !strncmp (line, "RPRT", 4))
+        io_finish_cmd (io, batch, TRUE);
+}
+
+
+/** \brief Finish the oldest unanswered command.
+ *  \param io The connection.
+ *  \param batch The batch of the command, which is the head of io->wait.
+ *  \param ok Whether the command has been answered.
+ */
+static void
+io_finish_cmd (hamlib_io_t *io, hamlib_batch_t *batch, gboolean ok)
+{
+    hamlib_cmd_t *cmd;
+    GTimeVal      now;
+
+
+    g_queue_pop_head (io->wait);
+
+    cmd = &g_array_index (batch->cmds, hamlib_cmd_t, batch->answered);
+    g_get_current_time (&now);
+    cmd->latency = (now.tv_sec - cmd->sent.tv_sec) +
+        1.0e-6 * (now.tv_usec - cmd->sent.tv_usec);
+
+    g_static_mutex_lock (&io->lock);
+    if (ok) {
+        io->stats.num++;
+        io->stats.last = cmd->latency;
+        io->stats.mean += (cmd->latency - io->stats.mean) / io->stats.num;
+        if (cmd->latency > io->stats.max)
+            io->stats.max = cmd->latency;
+    }
+    else {
+        io->stats.errors++;
+        if (cmd->reply != NULL) {
+            g_string_free (cmd->reply, TRUE);
+            cmd->reply = NULL;
+        }
+    }
+    g_static_mutex_unlock (&io->lock);
+
+    if (ok)
+        sat_log_log (SAT_LOG_LEVEL_DEBUG,
+                     _("%s: %s:%d answered %.*s in %.1f ms"),
+                     __FUNCTION__, io->host, io->port,
+                     (gint) strlen (cmd->cmd) - 1, cmd->cmd, 1000.0 * cmd->latency);
+
+    batch->lines = 0;
+    batch->answered++;
+    if (batch->answered < batch->cmds->len)
+        return;
+
+    io_finish_batch (batch);
+}
+
+
+/** \brief Hand a batch whose commands are all finished back to its sender.
+ *
+ * A waiting sender is woken up and keeps the batch; otherwise the
+ * done-function is called in the main loop, which frees the batch.
+ */
+static void
+io_finish_batch (hamlib_batch_t *batch)
+{
+    if (batch->queue != NULL)
+        g_async_queue_push (batch->queue, batch);
+    else
+        g_idle_add (io_done_cb, batch);
+}
+
+
+/** \brief Close the connection if the owner has closed it and nothing is due. */
+static void
+io_check_close (hamlib_io_t *io)
+{
+    if (!io->closing || !g_queue_is_empty (io->wait))
+        return;
+
+    if (io->sock >= 0 && !io->connecting) {
+        /* tell the daemon that we are leaving */
+        if (send (io->sock, "q\x0a", 2, 0) != 2)
+            sat_log_log (SAT_LOG_LEVEL_DEBUG,
+                         _("%s: Could not send quit to %s:%d"),
+                         __FUNCTION__, io->host, io->port);
+    }
+
+    io_disconnect (io);
+    hamlib_io_unref (io);
+}
+
+
+/** \brief Read the answers of the daemon. */
+static gboolean
+io_in_cb (GIOChannel *chan, GIOCondition cond, gpointer data)
+{
+    hamlib_io_t *io = (hamlib_io_t *) data;
+    gchar        buff[HAMLIB_IO_READ];
+    gchar       *nl;
+    gint         size;
+
+
+    (void) chan;
+
+    if (io->connecting)
+        return TRUE;
+
+    size = recv (io->sock, buff, sizeof (buff), 0);
+    if (size < 0 && io_would_block ())
+        return TRUE;
+
+    if (size <= 0) {
+        sat_log_log (SAT_LOG_LEVEL_ERROR,
+                     _("%s: Connection to %s:%d closed (%d)"),
+                     __FUNCTION__, io->host, io->port, cond);
+        /* the watch is destroyed by io_fail */
+        io_fail (io);
+        return TRUE;
+    }
+
+    g_string_append_len (io->rbuf, buff, size);
+
+    while ((nl = memchr (io->rbuf->str, '\n', io->rbuf->len)) != NULL) {
+        *nl = '\0';
+        if (nl > io->rbuf->str && nl[-1] == '\r')
+            nl[-1] = '\0';
+        io_answer (io, io->rbuf->str);
+
+        /* io_answer may have closed the connection */
+        if (io->sock < 0)
+            return TRUE;
+        g_string_erase (io->rbuf, 0, nl - io->rbuf->str + 1);
+    }
+
+    if (io->closing)
+        io_check_close (io);
+
+    return TRUE;
+}
+
+
+/** \brief Finish connecting or continue writing. */
+static gboolean
+io_out_cb (GIOChannel *chan, GIOCondition cond, gpointer data)
+{
+    hamlib_io_t *io = (hamlib_io_t *) data;
+    gint         error = 0;
+#ifndef WIN32
+    socklen_t    len = sizeof (error);
+#else
+    int          len = sizeof (error);
+#endif
+
+
+    (void) chan;
+    (void) cond;
+
+    g_source_unref (io->out_watch);
+    io->out_watch = NULL;
+
+    if (io->connecting) {
+        io->connecting = FALSE;
+        if (getsockopt (io->sock, SOL_SOCKET, SO_ERROR, (gpointer) &error, &len) < 0 ||
+            error != 0) {
+            sat_log_log (SAT_LOG_LEVEL_ERROR,
+                         _("%s: Failed to connect to %s:%d"),
+                         __FUNCTION__, io->host, io->port);
+            io_fail (io);
+            return FALSE;
+        }
+        sat_log_log (SAT_LOG_LEVEL_DEBUG,
+                     _("%s: Connection opened to %s:%d"),
+                     __FUNCTION__, io->host, io->port);
+    }
+
+    io_flush (io);
+
+    /* io_flush adds a new watch if it could not write everything */
+    return FALSE;
+}
+
+
+/** \brief Drop the connection if an answer is overdue. */
+static gboolean
+io_timer_cb (gpointer data)
+{
+    hamlib_io_t    *io = (hamlib_io_t *) data;
+    hamlib_batch_t *batch;
+    hamlib_cmd_t   *cmd;
+    GTimeVal        now;
+    gdouble         age;
+
+
+    batch = g_queue_peek_head (io->wait);
+    if (batch == NULL) {
+        g_source_unref (io->timer);
+        io->timer = NULL;
+        return FALSE;
+    }
+
+    cmd = &g_array_index (batch->cmds, hamlib_cmd_t, batch->answered);
+    g_get_current_time (&now);
+    age = (now.tv_sec - cmd->sent.tv_sec) + 1.0e-6 * (now.tv_usec - cmd->sent.tv_usec);
+
+    if (age > HAMLIB_IO_TIMEOUT) {
+        sat_log_log (SAT_LOG_LEVEL_ERROR,
+                     _("%s: No answer from %s:%d within %.0f s"),
+                     __FUNCTION__, io->host, io->port, HAMLIB_IO_TIMEOUT);
+        /* the timer is destroyed by io_fail */
+        io_fail (io);
+    }
+
+    return TRUE;
+}
+
+
+/** \brief Report a finished batch in the main loop. */
+static gboolean
+io_done_cb (gpointer data)
+{
+    hamlib_batch_t *batch = (hamlib_batch_t *) data;
+    hamlib_io_t    *io = batch->io;
+
+    if (!io->cancelled && batch->done != NULL)
+        batch->done (batch, batch->data);
+    if (batch->notify != NULL)
+        batch->notify (batch->data);
+
+    hamlib_batch_free (batch);
+    hamlib_io_unref (io);
+
+    return FALSE;
+}
+
+
+/** \brief Check whether the last socket call would have blocked. */
+static gboolean
+io_would_block (void)
+{
+#ifndef WIN32
+    return (errno == EINPROGRESS || errno == EAGAIN || errno == EWOULDBLOCK);
+#else
+    return (WSAGetLastError () == WSAEWOULDBLOCK);
+#endif
+}
@@ -0,0 +1,75 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2012  Alexandru Csete, OZ9AEC.
+
+    Authors: Alexandru Csete <oz9aec@gmail.com>
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+#ifndef HAMLIB_IO_H
+#define HAMLIB_IO_H 1
+
+#include <glib.h>
+
+
+/** \brief Connection to a rigctld or rotctld daemon (opaque). */
+typedef struct hamlib_io_s hamlib_io_t;
+
+/** \brief Commands sent together on one connection (opaque). */
+typedef struct hamlib_batch_s hamlib_batch_t;
+
+
+/** \brief Round trip statistics of a connection. */
+typedef struct {
+    guint    num;     /*!< Number of answered commands */
+    guint    errors;  /*!< Number of commands that got no answer */
+    gdouble  last;    /*!< Round trip of the last answered command [s] */
+    gdouble  mean;    /*!< Mean round trip [s] */
+    gdouble  max;     /*!< Longest round trip [s] */
+} hamlib_io_stats_t;
+
+
+/** \brief Function called in the main loop when all commands of a batch are answered.
+ *  \param batch The batch with the replies; it is freed after the call.
+ *  \param data The user data given to hamlib_io_send.
+ */
+typedef void (*hamlib_done_t) (hamlib_batch_t *batch, gpointer data);
+
+
+hamlib_io_t    *hamlib_io_new        (const gchar *host, gint port);
+void            hamlib_io_send       (hamlib_io_t *io, hamlib_batch_t *batch,
+                                      hamlib_done_t done, gpointer data,
+                                      GDestroyNotify notify);
+gboolean        hamlib_io_send_wait  (hamlib_io_t *io, hamlib_batch_t *batch);
+void            hamlib_io_get_stats  (hamlib_io_t *io, hamlib_io_stats_t *stats);
+void            hamlib_io_close      (hamlib_io_t *io);
+
+hamlib_batch_t *hamlib_batch_new     (void);
+guint           hamlib_batch_add     (hamlib_batch_t *batch, guint lines,
+                                      const gchar *fmt, ...) G_GNUC_PRINTF (3, 4);
+guint           hamlib_batch_size    (hamlib_batch_t *batch);
+const gchar    *hamlib_batch_reply   (hamlib_batch_t *batch, guint i);
+gdouble         hamlib_batch_latency (hamlib_batch_t *batch, guint i);
+void            hamlib_batch_free    (hamlib_batch_t *batch);
+
+
+#endif
@@ -699,6 +699,7 @@ static void add_selected_sat (GtkListStore *store, gint catnum)
                             -1);
         g_free (sat.name);
         g_free (sat.nickname);
+        free_ephemeris (&sat);
     }
 }
 
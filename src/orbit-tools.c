@@ -34,9 +34,14 @@
 #ifdef HAVE_CONFIG_H
 #  include <build-config.h>
 #endif
+#include "sat-log.h"
+#include "locator.h"
 #include "orbit-tools.h"
 
 
+static gdouble arccos (gdouble x, gdouble y);
+
+
 
 orbit_type_t
 get_orbit_type (sat_t *sat)
@@ -169,3 +174,115 @@ has_aos        (sat_t *sat, qth_t *qth)
      }
      return retcode;
 }
+
+
+/** \brief Check whether the footprint covers the North pole. */
+gboolean
+north_pole_is_covered (sat_t *sat)
+{
+     int ret1;
+     gdouble qrb1, az1;
+
+     ret1 = qrb (sat->ssplon, sat->ssplat, 0.0, 90.0, &qrb1, &az1);
+     if (ret1 != RIG_OK) {
+          sat_log_log (SAT_LOG_LEVEL_ERROR,
+                       _("%s: Bad data measuring distance to North Pole %f %f."),
+                       __FUNCTION__, sat->ssplon, sat->ssplat);
+     }
+     if (qrb1 <= 0.5*sat->footprint) {
+          return TRUE;
+     }
+     return FALSE;
+}
+
+
+/** \brief Check whether the footprint covers the South pole. */
+gboolean
+south_pole_is_covered (sat_t *sat)
+{
+     int ret1;
+     gdouble qrb1, az1;
+
+     ret1 = qrb (sat->ssplon, sat->ssplat, 0.0, -90.0, &qrb1, &az1);
+     if (ret1 != RIG_OK) {
+          sat_log_log (SAT_LOG_LEVEL_ERROR,
+                       _("%s: Bad data measuring distance to South Pole %f %f."),
+                       __FUNCTION__, sat->ssplon, sat->ssplat);
+     }
+     if (qrb1 <= 0.5*sat->footprint) {
+          return TRUE;
+     }
+     return FALSE;
+}
+
+
+/** \brief Calculate the left half of the range circle of a satellite.
+ *  \param sat Pointer to satellite data after predict_calc.
+ *  \param lat Array of 180 elements receiving the latitudes in degrees.
+ *  \param lon Array of 180 elements receiving the longitudes in degrees [-180;180].
+ *
+ * Point i is at azimuth i degrees seen from the sub-satellite point. The
+ * right half of the range circle is the mirror image in longitude.
+ *
+ * Range circle calculations.
+ * Borrowed from gsat 0.9.0 by Xavier Crehueras, EB3CZS
+ * who borrowed from John Magliacane, KD2BD.
+ * Optimized by Alexandru Csete and William J Beksi.
+ */
+void
+footprint_points (sat_t *sat, gdouble *lat, gdouble *lon)
+{
+     guint azi;
+     gdouble ssplat, ssplon, beta, azimuth, num, dem;
+     gdouble rangelon, rangelat;
+
+     ssplat = sat->ssplat * de2ra;
+     ssplon = sat->ssplon * de2ra;
+     beta = (0.5 * sat->footprint) / xkmper;
+
+     for (azi = 0; azi < 180; azi++) {
+          azimuth = de2ra * (double)azi;
+          rangelat = asin (sin (ssplat) * cos (beta) + cos (azimuth) *
+                           sin (beta) * cos (ssplat));
+          num = cos (beta) - (sin (ssplat) * sin (rangelat));
+          dem = cos (ssplat) * cos (rangelat);
+
+          if (azi == 0 && north_pole_is_covered (sat))
+               rangelon = ssplon + pi;
+
+          else if (fabs (num / dem) > 1.0)
+               rangelon = ssplon;
+
+          else
+               rangelon = ssplon - arccos (num, dem);
+
+          while (rangelon < -pi)
+               rangelon += twopi;
+
+          while (rangelon > (pi))
+               rangelon -= twopi;
+
+          lat[azi] = rangelat / de2ra;
+          lon[azi] = rangelon / de2ra;
+     }
+}
+
+
+/** \brief Arccosine implementation.
+ *
+ * Returns a value between zero and two pi.
+ * Borrowed from gsat 0.9 by Xavier Crehueras, EB3CZS.
+ * Optimized by Alexandru Csete.
+ */
+static gdouble
+arccos (gdouble x, gdouble y)
+{
+     if (x && y) {
+          if (y > 0.0)
+               return acos (x/y);
+          else if (y < 0.0)
+               return pi + acos (x/y);
+     }
+
+     return 0.0;
+}
@@ -37,5 +37,9 @@ gboolean     geostationary  (sat_t *sat);
 gboolean     decayed        (sat_t *sat);
 gboolean     has_aos        (sat_t *sat, qth_t *qth);
 
+gboolean     north_pole_is_covered (sat_t *sat);
+gboolean     south_pole_is_covered (sat_t *sat);
+void         footprint_points      (sat_t *sat, gdouble *lat, gdouble *lon);
+
 
 #endif
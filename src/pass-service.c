@@ -0,0 +1,415 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2012  Alexandru Csete, OZ9AEC.
+
+    Authors: Alexandru Csete <oz9aec@gmail.com>
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+/** \brief Parallel pass prediction service.
+ *
+ * A pass job predicts the passes of many satellites outside the GTK main
+ * loop. Each satellite is a work unit with a private copy of the satellite
+ * and its own ephemeris, so the units can run concurrently on a thread pool
+ * shared by all jobs. The live satellites are only read in pass_job_add,
+ * which is called from the main loop.
+ *
+ * Progress and completion are reported in the main loop. A job that is
+ * freed while it is running is cancelled: the work units that have not
+ * started yet are skipped and the job is freed by the last running unit.
+ */
+
+#include <string.h>
+#include <glib.h>
+#include <glib/gi18n.h>
+#include "sgpsdp/sgp4sdp4.h"
+#ifdef HAVE_CONFIG_H
+#  include <build-config.h>
+#endif
+#include "sat-log.h"
+#include "predict-tools.h"
+#include "pass-service.h"
+
+
+/** \brief Number of worker threads if GLib can not tell the number of CPUs. */
+#define PASS_THREADS     4
+
+
+/** \brief Work unit: the prediction of one satellite. */
+typedef struct {
+    pass_job_t  *job;     /*!< The job that the unit belongs to */
+    sat_t        sat;     /*!< Private copy of the satellite */
+    gboolean     valid;   /*!< FALSE if there is nothing to predict */
+    gdouble      start;   /*!< Start of the time window */
+    gdouble      end;     /*!< End of the time window */
+    GSList      *passes;  /*!< The predicted passes */
+} pass_unit_t;
+
+
+struct pass_job_s {
+    qth_t                qth;       /*!< Copy of the QTH */
+    pass_filter_t        filter;    /*!< Copy of the filters */
+    GPtrArray           *units;     /*!< The work units (pass_unit_t) */
+
+    pass_job_progress_t  progress;  /*!< Function called to report progress */
+    pass_job_done_t      done;      /*!< Function called when the job is done */
+    gpointer             data;      /*!< User data for progress and done */
+
+    GMutex              *lock;      /*!< Protects the fields below */
+    guint                pending;   /*!< Number of unfinished work units */
+    guint                finished;  /*!< Number of finished work units */
+    gboolean             cancelled; /*!< The job has been freed while running */
+    guint                progress_id; /*!< Source ID of the scheduled progress report */
+    guint                done_id;   /*!< Source ID of the scheduled completion */
+};
+
+
+static GThreadPool *pool = NULL;
+static gint         max_threads = 0;   /* 0 means one thread per CPU */
+
+
+static gint     pass_num_threads (void);
+static void     pass_worker      (gpointer data, gpointer user_data);
+static gboolean pass_progress_cb (gpointer data);
+static gboolean pass_done_cb     (gpointer data);
+static void     pass_job_destroy (pass_job_t *job);
+
+
+/** \brief Create a new pass prediction job.
+ *  \param qth The QTH; it is copied.
+ *  \param filter The filters applied to the passes; they are copied.
+ *  \param progress Function to call in the main loop to report progress, or NULL.
+ *  \param done Function to call in the main loop when the job is done, or NULL.
+ *  \param data User data passed to \a progress and \a done.
+ *  \return A newly allocated job which should be freed with pass_job_free.
+ *
+ * Add the satellites with pass_job_add, then start the job with
+ * pass_job_start.
+ */
+pass_job_t *
+pass_job_new   (qth_t *qth, const pass_filter_t *filter,
+                pass_job_progress_t progress, pass_job_done_t done, gpointer data)
+{
+    pass_job_t *job;
+    GError     *err = NULL;
+
+
+    job = g_new0 (pass_job_t, 1);
+    job->qth = *qth;
+    job->filter = *filter;
+    job->units = g_ptr_array_new ();
+    job->progress = progress;
+    job->done = done;
+    job->data = data;
+    job->lock = g_mutex_new ();
+
+    /* the thread pool is shared by all jobs and kept for later jobs */
+    if (pool == NULL) {
+        pool = g_thread_pool_new (pass_worker, NULL, pass_num_threads (), FALSE, &err);
+        if (pool == NULL) {
+            sat_log_log (SAT_LOG_LEVEL_ERROR,
+                         _("%s: Could not create thread pool (%s)"),
+                         __FUNCTION__, err ? err->message : "unknown error");
+            g_clear_error (&err);
+        }
+    }
+
+    return job;
+}
+
+
+/** \brief Set the number of worker threads.
+ *  \param num The number of threads, or 0 for one thread per CPU.
+ *
+ * Applies to the jobs that are running and to later jobs.
+ */
+void
+pass_service_set_threads (guint num)
+{
+    max_threads = num;
+
+    if (pool != NULL)
+        g_thread_pool_set_max_threads (pool, pass_num_threads (), NULL);
+}
+
+
+/** \brief Get the number of worker threads to use. */
+static gint
+pass_num_threads (void)
+{
+    if (max_threads > 0)
+        return max_threads;
+
+#if GLIB_CHECK_VERSION(2,36,0)
+    return g_get_num_processors ();
+#else
+    return PASS_THREADS;
+#endif
+}
+
+
+/** \brief Add a satellite to a job.
+ *  \param job The job, which must not have been started.
+ *  \param sat The satellite, or NULL for a placeholder without passes.
+ *  \param start Start of the time window.
+ *  \param end End of the time window; passes must have their AOS before it.
+ *  \return The index of the satellite for pass_job_steal_passes.
+ *
+ * The satellite is copied, so the live satellites of a module may be used.
+ */
+guint
+pass_job_add   (pass_job_t *job, sat_t *sat, gdouble start, gdouble end)
+{
+    pass_unit_t *unit;
+
+
+    unit = g_new0 (pass_unit_t, 1);
+    unit->job = job;
+    unit->start = start;
+    unit->end = end;
+
+    if (sat != NULL && start < end) {
+        /* the ephemeris is rebuilt by the worker from the elements */
+        unit->sat = *sat;
+        unit->sat.name = NULL;
+        unit->sat.nickname = g_strdup (sat->nickname);
+        unit->sat.website = NULL;
+        unit->sat.model = NULL;
+        unit->valid = TRUE;
+    }
+
+    g_ptr_array_add (job->units, unit);
+
+    return job->units->len - 1;
+}
+
+
+/** \brief Start a job.
+ *
+ * This function returns immediately. The done-function is called from the
+ * main loop when all satellites have been predicted. Must be called from
+ * the main loop.
+ */
+void
+pass_job_start (pass_job_t *job)
+{
+    guint i;
+
+    g_mutex_lock (job->lock);
+    job->pending = job->units->len;
+    if (job->pending == 0)
+        job->done_id = g_idle_add (pass_done_cb, job);
+    g_mutex_unlock (job->lock);
+
+    /* without a thread pool the work units are done right here */
+    for (i = 0; i < job->units->len; i++) {
+        if (pool != NULL)
+            g_thread_pool_push (pool, g_ptr_array_index (job->units, i), NULL);
+        else
+            pass_worker (g_ptr_array_index (job->units, i), NULL);
+    }
+}
+
+
+/** \brief Take the passes of a satellite.
+ *  \param job The job, which must be done.
+ *  \param i The index returned by pass_job_add.
+ *  \return The passes of the satellite, which are now owned by the caller.
+ */
+GSList *
+pass_job_steal_passes (pass_job_t *job, guint i)
+{
+    pass_unit_t *unit;
+    GSList      *passes;
+
+    g_return_val_if_fail (i < job->units->len, NULL);
+
+    unit = g_ptr_array_index (job->units, i);
+    passes = unit->passes;
+    unit->passes = NULL;
+
+    return passes;
+}
+
+
+/** \brief Free a job.
+ *
+ * If the job is still running it is cancelled; neither the progress nor
+ * the done-function is called after this. Must be called from the main loop.
+ */
+void
+pass_job_free  (pass_job_t *job)
+{
+    gboolean running;
+
+    if (job == NULL)
+        return;
+
+    g_mutex_lock (job->lock);
+
+    if (job->progress_id > 0) {
+        g_source_remove (job->progress_id);
+        job->progress_id = 0;
+    }
+    if (job->done_id > 0) {
+        g_source_remove (job->done_id);
+        job->done_id = 0;
+    }
+
+    job->cancelled = TRUE;
+    running = (job->pending > 0);
+
+    g_mutex_unlock (job->lock);
+
+    /* otherwise the last running work unit frees the job */
+    if (!running)
+        pass_job_destroy (job);
+}
+
+
+/** \brief Free the memory of a job. */
+static void
+pass_job_destroy (pass_job_t *job)
+{
+    pass_unit_t *unit;
+    guint        i;
+
+    for (i = 0; i < job->units->len; i++) {
+        unit = g_ptr_array_index (job->units, i);
+        free_passes (unit->passes);
+        g_free (unit->sat.nickname);
+        g_free (unit);
+    }
+
+    g_ptr_array_free (job->units, TRUE);
+    g_mutex_free (job->lock);
+    g_free (job);
+}
+
+
+/** \brief Thread pool function; predicts the passes of one satellite.
+ *  \param data The work unit (pass_unit_t).
+ *  \param user_data Not used.
+ *
+ * Only the private copy of the satellite and the passes of the unit are
+ * written to, so the units can run concurrently.
+ */
+static void
+pass_worker    (gpointer data, gpointer user_data)
+{
+    pass_unit_t *unit = (pass_unit_t *) data;
+    pass_job_t  *job = unit->job;
+    GSList      *node, *next;
+    pass_t      *pass;
+    gboolean     cancelled;
+    gboolean     last;
+
+    (void) user_data; /* prevent unused parameter compiler warning */
+
+    g_mutex_lock (job->lock);
+    cancelled = job->cancelled;
+    g_mutex_unlock (job->lock);
+
+    if (unit->valid && !cancelled) {
+        rebuild_ephemeris (&unit->sat);
+
+        unit->passes = get_passes_min_el (&unit->sat, &job->qth, unit->start,
+                                          unit->end - unit->start, job->filter.num,
+                                          job->filter.min_el, job->filter.summary);
+
+        /* the visibility is known once the details have been calculated,
+           which must happen before the passes are handed over */
+        if (job->filter.visible) {
+            for (node = unit->passes; node != NULL; node = next) {
+                next = node->next;
+                pass = PASS (node->data);
+                get_pass_num_details (pass);
+                if (pass->vis[0] != 'V') {
+                    free_pass (pass);
+                    unit->passes = g_slist_delete_link (unit->passes, node);
+                }
+            }
+        }
+
+        free_ephemeris (&unit->sat);
+    }
+
+    /* the last unit schedules the completion in the main loop */
+    g_mutex_lock (job->lock);
+    job->pending--;
+    job->finished++;
+    cancelled = job->cancelled;
+    last = (job->pending == 0);
+    if (!cancelled) {
+        if (last)
+            job->done_id = g_idle_add (pass_done_cb, job);
+        else if (job->progress != NULL && job->progress_id == 0)
+            job->progress_id = g_idle_add (pass_progress_cb, job);
+    }
+    g_mutex_unlock (job->lock);
+
+    if (cancelled && last)
+        pass_job_destroy (job);
+}
+
+
+/** \brief Report the progress of a job; called from the main loop. */
+static gboolean
+pass_progress_cb   (gpointer data)
+{
+    pass_job_t *job = (pass_job_t *) data;
+    guint       finished;
+
+    g_mutex_lock (job->lock);
+    job->progress_id = 0;
+    finished = job->finished;
+    g_mutex_unlock (job->lock);
+
+    job->progress (job, finished, job->units->len, job->data);
+
+    return FALSE;
+}
+
+
+/** \brief Report the completion of a job; called from the main loop. */
+static gboolean
+pass_done_cb   (gpointer data)
+{
+    pass_job_t *job = (pass_job_t *) data;
+
+    g_mutex_lock (job->lock);
+    job->done_id = 0;
+    if (job->progress_id > 0) {
+        g_source_remove (job->progress_id);
+        job->progress_id = 0;
+    }
+    g_mutex_unlock (job->lock);
+
+    if (job->progress != NULL)
+        job->progress (job, job->units->len, job->units->len, job->data);
+
+    /* may free the job */
+    if (job->done != NULL)
+        job->done (job, job->data);
+
+    return FALSE;
+}
@@ -0,0 +1,80 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2012  Alexandru Csete, OZ9AEC.
+
+    Authors: Alexandru Csete <oz9aec@gmail.com>
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+#ifndef PASS_SERVICE_H
+#define PASS_SERVICE_H 1
+
+#include <glib.h>
+#include "gtk-sat-data.h"
+#include "qth-data.h"
+#include "predict-tools.h"
+
+
+/** \brief Pass prediction job for a set of satellites (opaque). */
+typedef struct pass_job_s pass_job_t;
+
+
+/** \brief Filters applied to the passes of a job. */
+typedef struct {
+    guint     num;      /*!< Maximum number of passes per satellite, 0 for no limit */
+    gdouble   min_el;   /*!< Minimum elevation a pass must reach [deg] */
+    gboolean  visible;  /*!< Only keep passes during which the satellite is visible */
+    gboolean  summary;  /*!< Only calculate the summaries, see get_passes_summary */
+} pass_filter_t;
+
+
+/** \brief Function called in the main loop while a job is running.
+ *  \param job The job.
+ *  \param done The number of satellites that have been predicted.
+ *  \param total The number of satellites in the job.
+ *  \param data The user data given to pass_job_new.
+ *
+ * Calls are coalesced, so not every satellite is reported.
+ */
+typedef void (*pass_job_progress_t) (pass_job_t *job, guint done, guint total, gpointer data);
+
+/** \brief Function called in the main loop when all satellites of a job are done.
+ *  \param job The job; may be freed by this function.
+ *  \param data The user data given to pass_job_new.
+ */
+typedef void (*pass_job_done_t) (pass_job_t *job, gpointer data);
+
+
+pass_job_t *pass_job_new          (qth_t *qth, const pass_filter_t *filter,
+                                   pass_job_progress_t progress,
+                                   pass_job_done_t done,
+                                   gpointer data);
+guint       pass_job_add          (pass_job_t *job, sat_t *sat,
+                                   gdouble start, gdouble end);
+void        pass_job_start        (pass_job_t *job);
+GSList     *pass_job_steal_passes (pass_job_t *job, guint i);
+void        pass_job_free         (pass_job_t *job);
+
+void        pass_service_set_threads (guint num);
+
+
+#endif
@@ -247,11 +247,11 @@ pass_to_txt_tblcontents (pass_t *pass, qth_t *qth, gint fields)
 {
     gchar    *fmtstr;
     gchar     tbuff[TIME_FORMAT_MAX_LENGTH];
-    guint     i,num;
     gchar    *line;
     gchar    *data = NULL;
     gchar    *buff;
     pass_detail_t *detail;
+    pass_detail_iter_t iter;
     obs_astro_t    astro;
     gdouble        ra,dec,numf;
     gchar         *ssp;
@@ -261,13 +261,10 @@ pass_to_txt_tblcontents (pass_t *pass, qth_t *qth, gint fields)
     fmtstr = sat_cfg_get_str (SAT_CFG_STR_TIME_FORMAT);
     daynum_to_str (tbuff, TIME_FORMAT_MAX_LENGTH, fmtstr, pass->aos);
 
-    /* get number of rows */
-    num = g_slist_length (pass->details);
+    /* one row per detail */
+    pass_detail_iter_init (&iter, pass);
 
-    for (i = 0; i < num; i++) {
-
-        /* get detail */
-        detail = PASS_DETAIL (g_slist_nth_data (pass->details, i));
+    while ((detail = pass_detail_iter_next (&iter)) != NULL) {
 
         /* time */
         daynum_to_str (tbuff, TIME_FORMAT_MAX_LENGTH, fmtstr, detail->time);
@@ -430,7 +427,7 @@ pass_to_txt_tblcontents (pass_t *pass, qth_t *qth, gint fields)
         }
 
         /* append line to return string */
-        if (i == 0) {
+        if (data == NULL) {
             data = g_strdup_printf ("%s\n", line);
             g_free (line);
         }
@@ -43,44 +43,62 @@
 #include "sat-log.h"
 
 
-static pass_t * get_pass_engine   (sat_t *sat_in, qth_t *qth, gdouble start, gdouble maxdt, gdouble min_el);
-
-/** \brief SGP4SDP4 driver for doing AOS/LOS calculations.
- *  \param sat Pointer to the satellite data.
- *  \param qth Pointer to the QTH data.
- *  \param t The time for calculation (Julian Date)
+/** \brief How far back find_prev_aos looks for the start of a pass (days). */
+#define PREV_AOS_MAXDT 10.0
+
+/** \brief Default search window of find_eclipse_entry and find_eclipse_exit (days). */
+#define ECLIPSE_MAXDT 10.0
+
+/** \brief Maximum number of eclipses stored for one pass. */
+#define PASS_MAX_ECLIPSES 16
+
+/** \brief Alignment of the allocations from a pass arena. */
+#define ARENA_ALIGN 16
+#define ARENA_ROUND(x) (((x) + ARENA_ALIGN - 1) & ~((gsize) ARENA_ALIGN - 1))
+
+/** \brief Minimum chunk size of a pass arena in bytes. */
+#define ARENA_MIN_CHUNK 1024
+
+static pass_t * get_pass_engine   (sat_t *sat_in, qth_t *qth, gdouble start, gdouble maxdt, gdouble min_el,
+                                   gboolean summary, pass_arena_t *arena);
+static GSList * get_passes_engine (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt, guint num,
+                                   gdouble min_el, gboolean summary);
+static pass_t * get_current_pass_engine (sat_t *sat_in, qth_t *qth, gdouble start,
+                                         gboolean summary);
+static void     calc_pass_details (pass_t *pass, sat_t *sat, qth_t *qth, gboolean summary);
+static void     calc_pass_tca     (pass_t *pass, sat_t *sat, qth_t *qth);
+static void     calc_pass_eclipses (pass_t *pass, sat_t *sat, qth_t *qth);
+static glong    predict_orbit     (sat_t *sat, gdouble t);
+static void     qth_to_geodetic   (qth_t *qth, geodetic_t *obs_geodetic);
+
+static pass_arena_t *pass_arena_new     (gsize size);
+static gpointer      pass_arena_alloc   (pass_arena_t *arena, gsize size);
+static void          pass_arena_release (pass_arena_t *arena, gpointer mem);
+static gchar        *pass_arena_strdup  (pass_arena_t *arena, const gchar *str);
+static void          pass_arena_ref     (pass_arena_t *arena);
+static void          pass_arena_unref   (pass_arena_t *arena);
+static gsize         pass_arena_size    (sat_t *sat, gboolean summary);
+
+/** \brief Calculate the derived satellite data.
+ *  \param sat Pointer to the satellite data with pos, vel and phase set.
+ *  \param frame The observer frame at the time of sat.
  *
+ * This function calculates the look angles, sub-satellite point and the
+ * other derived values from the converted position and velocity of the
+ * satellite. It is shared by predict_calc_frame and predict_calc_cached.
  */
-void
-predict_calc (sat_t *sat, qth_t *qth, gdouble t)
+static void
+predict_calc_derived (sat_t *sat, const obs_frame_t *frame)
 {
     obs_set_t     obs_set;
     geodetic_t    sat_geodetic;
-    geodetic_t    obs_geodetic;
-    double        age;
-
-
-    obs_geodetic.lon = qth->lon * de2ra;
-    obs_geodetic.lat = qth->lat * de2ra;
-    obs_geodetic.alt = qth->alt / 1000.0;
-    obs_geodetic.theta = 0;
-
-    sat->jul_utc = t;
-    sat->tsince = (sat->jul_utc - sat->jul_epoch) * xmnpda;
-
-    /* call the norad routines according to the deep-space flag */
-    if (sat->flags & DEEP_SPACE_EPHEM_FLAG)
-        SDP4 (sat, sat->tsince);
-    else
-        SGP4 (sat, sat->tsince);
 
-    Convert_Sat_State (&sat->pos, &sat->vel);
 
     /* get the velocity of the satellite */
     Magnitude (&sat->vel);
     sat->velo = sat->vel.w;
-    Calculate_Obs (sat->jul_utc, &sat->pos, &sat->vel, &obs_geodetic, &obs_set);
-    Calculate_LatLonAlt (sat->jul_utc, &sat->pos, &sat_geodetic);
+    Calculate_Obs_Frame (frame, &sat->pos, &sat->vel, &obs_set);
+    Calculate_LatLonAlt_ThetaG (frame->thetag, &sat->pos, &sat_geodetic);
 
     while (sat_geodetic.lon < -pi)
         sat_geodetic.lon += twopi;
@@ -102,148 +120,276 @@ predict_calc (sat_t *sat, qth_t *qth, gdouble t)
     /* same formulas, but the one from predict is nicer */
     //sat->footprint = 2.0 * xkmper * acos (xkmper/sat->pos.w);
     sat->footprint = 12756.33 * acos (xkmper / (xkmper+sat->alt));
-    age = sat->jul_utc - sat->jul_epoch;
-    sat->orbit = (long) floor((sat->tle.xno * xmnpda/twopi +
-                    age * sat->tle.bstar * ae) * age +
-                    sat->tle.xmo/twopi) + sat->tle.revnum - 1;
+    sat->orbit = predict_orbit (sat, sat->jul_utc);
 }
 
 
-/** \brief Find the AOS time of the next pass.
- *  \author Alexandru Csete, OZ9AEC
- *  \author John A. Magliacane, KD2BD
+/** \brief Prepare the observer frame for a QTH and a time.
+ *  \param frame The frame to initialise.
+ *  \param qth Pointer to the QTH data.
+ *  \param t The time for calculation (Julian Date)
+ *
+ * The frame holds everything about the observer that does not depend on
+ * the satellite: the geodetic position, the sidereal time and the ECI
+ * position and velocity of the observer. It is read-only for
+ * predict_calc_frame and can be shared by any number of satellites and
+ * threads as long as they are calculated at time \a t.
+ */
+void
+predict_init_frame (obs_frame_t *frame, qth_t *qth, gdouble t)
+{
+    geodetic_t obs_geodetic;
+
+    qth_to_geodetic (qth, &obs_geodetic);
+    Obs_Frame_Init (frame, &obs_geodetic);
+    Obs_Frame_Set_Time (frame, t);
+}
+
+
+/** \brief SGP4SDP4 driver for doing AOS/LOS calculations.
  *  \param sat Pointer to the satellite data.
  *  \param qth Pointer to the QTH data.
- *  \param start The time where calculation should start.
- *  \param maxdt The upper time limit in days (0.0 = no limit)
- *  \param min_el The minimal elevation necessary for AOS
- *  \return The time of the next AOS or 0.0 if the satellite has no AOS.
+ *  \param t The time for calculation (Julian Date)
  *
- * This function finds the time of AOS for the first coming pass taking place
- * no earlier that start.
- * If the satellite is currently within range, the function first calls
- * find_los to get the next LOS time. Then the calculations are done using
- * the new start time.
+ */
+void
+predict_calc (sat_t *sat, qth_t *qth, gdouble t)
+{
+    obs_frame_t frame;
+
+    predict_init_frame (&frame, qth, t);
+    predict_calc_frame (sat, &frame);
+}
+
+
+/** \brief SGP4SDP4 driver using a prepared observer frame.
+ *  \param sat Pointer to the satellite data.
+ *  \param frame The observer frame from predict_init_frame.
  *
+ * Same as predict_calc at the time of the frame. Use this when many
+ * satellites are calculated for the same QTH and time.
  */
-gdouble
-//find_aos (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt, gdouble min_el)
-find_aos (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt)
+void
+predict_calc_frame (sat_t *sat, const obs_frame_t *frame)
 {
-    gdouble t = start;
-    gdouble aostime = 0.0;
+    gdouble t = frame->jul_utc;
 
-    /* make sure current sat values are
-        in sync with the time
-    */
-    predict_calc (sat, qth, start);
+    sat->jul_utc = t;
+    sat->tsince = (sat->jul_utc - sat->jul_epoch) * xmnpda;
 
-    /* check whether satellite has aos */
-    if (!has_aos (sat, qth)) {
+    /* call the norad routines according to the deep-space flag */
+    if (sat->flags & DEEP_SPACE_EPHEM_FLAG)
+        SDP4 (sat, sat->tsince);
+    else
+        SGP4 (sat, sat->tsince);
 
-        return 0.0;
+    Convert_Sat_State (&sat->pos, &sat->vel);
 
+    predict_calc_derived (sat, frame);
+}
+
+
+/** \brief SGP4SDP4 driver using an ephemeris cache.
+ *  \param sat Pointer to the satellite data.
+ *  \param cache The ephemeris cache of the satellite or NULL.
+ *  \param frame The observer frame from predict_init_frame.
+ *
+ * Same as predict_calc_frame, but the position and velocity are evaluated
+ * from the ephemeris cache whenever it can provide them (see
+ * sat-ephem-cache.c). Without a cache the satellite is propagated directly.
+ */
+void
+predict_calc_cached (sat_t *sat, sat_ephem_cache_t *cache, const obs_frame_t *frame)
+{
+    if (cache == NULL || !sat_ephem_cache_get (cache, sat, frame->jul_utc)) {
+        predict_calc_frame (sat, frame);
+        return;
     }
 
+    predict_calc_derived (sat, frame);
+}
 
-    //if (sat->el > min_el)
-    if (sat->el > 0.0f)
-        //t = find_los (sat, qth, start, maxdt, min_el) + 0.014; // +20 min
-        t = find_los (sat, qth, start, maxdt) + 0.014; // +20 min
 
-    /* invalid time (potentially returned by find_los) */
-    if (t < 0.1)
-        return 0.0;
+/** \brief Calculate the orbit number of a satellite.
+ *  \param sat Pointer to the satellite data.
+ *  \param t The time (Julian Date)
+ *
+ * The orbit number only depends on the TLE and the time, so it can be
+ * calculated without propagating the satellite.
+ */
+static glong
+predict_orbit (sat_t *sat, gdouble t)
+{
+    double age = t - sat->jul_epoch;
 
-    /* update satellite data */
-    predict_calc (sat, qth, t);
+    return (glong) floor((sat->tle.xno * xmnpda/twopi +
+                          age * sat->tle.bstar * ae) * age +
+                         sat->tle.xmo/twopi) + sat->tle.revnum - 1;
+}
 
-    /* use upper time limit */
-    if (maxdt > 0.0) {
 
-        /* coarse time steps */
-        //while ((sat->el < (-1.0 + min_el)) && (t <= (start + maxdt))) {
-        while ((sat->el < (-1.0)) && (t <= (start + maxdt))) {
-            //t -= 0.00035 * ((sat->el-min_el) * ((sat->alt / 8400.0) + 0.46) - 2.0);
-            t -= 0.00035 * ((sat->el) * ((sat->alt / 8400.0) + 0.46) - 2.0);
-            predict_calc (sat, qth, t);
-        }
+/** \brief Calculate the ground track of whole orbits.
+ *  \param sat_in The satellite; it is not modified.
+ *  \param qth The QTH.
+ *  \param t A time in the current orbit of the satellite.
+ *  \param num The number of orbits, starting with the current one.
+ *  \return A newly allocated list of sub-satellite points (ssp_t) in 30 second
+ *          steps from the start of the current orbit to the end of the last
+ *          one, or NULL if the orbits could not be calculated. Free the list
+ *          and its elements with g_free.
+ *
+ * The current orbit is the sat_in->orbit; it is searched for at most one day
+ * back in time from t.
+ */
+GSList *
+predict_ground_track (sat_t *sat_in, qth_t *qth, gdouble t, glong num)
+{
+    sat_t         *sat, sat_working;
+    long           this_orbit;  /* current orbit number */
+    long           max_orbit;   /* target orbit number, ie. this + num - 1 */
+    double         t0;          /* time when this_orbit starts */
+    GSList        *latlon = NULL;
+    ssp_t         *this_ssp;
+    obs_frame_t    frame;
 
-        /* fine steps */
-        while ((aostime == 0.0) && (t <= (start + maxdt))) {
 
-            //if (fabs (sat->el) < (0.005 + min_el)) {
-            if (fabs (sat->el) < (0.005)) {
-                aostime = t;
-            }
-            else {
-                t -= sat->el * sqrt (sat->alt) / 530000.0;
-                predict_calc (sat, qth, t);
-            }
+    /* copy sat_in to a working structure */
+    sat = memcpy (&sat_working, sat_in, sizeof (sat_t));
+
+    this_orbit = sat->orbit;
+    max_orbit = sat->orbit - 1 + num;
+
+    sat_log_log (SAT_LOG_LEVEL_DEBUG,
+                 _("%s: Start orbit: %d"),
+                 __FUNCTION__, this_orbit);
+    sat_log_log (SAT_LOG_LEVEL_DEBUG,
+                 _("%s: End orbit %d"),
+                 __FUNCTION__, max_orbit);
 
+
+    /* find the time when the current orbit started */
+
+    /* Iterate backwards in time until we reach sat->orbit < this_orbit.
+       The orbit number does not depend on the propagation, so the
+       satellite is not propagated while searching. As a built-in safety,
+       we stop iteration if the orbit crossing is more than 24 hours back
+       in time.
+    */
+    t0 = t;
+    while ((t + 1.0) > t0) {
+
+        /* use == instead of >= as it is more robust */
+        if (predict_orbit (sat, t) != this_orbit) {
+            t -= 0.0007;
+            break;
         }
 
+        t -= 0.0007;
     }
-    /* don't use upper time limit */
-    else {
 
-        /* coarse time steps */
-        //while (sat->el < (-1.0 + min_el)) {
-        while (sat->el < (-1.0)) {
+    /* set it so that we are in the same orbit as this_orbit
+       and not a different one */
+    t += 2*0.0007;
+    t0 = t;
+    predict_calc (sat, qth, t0);
 
-            //t -= 0.00035 * ((sat->el-min_el) * ((sat->alt / 8400.0) + 0.46) - 2.0);
-            t -= 0.00035 * ((sat->el) * ((sat->alt / 8400.0) + 0.46) - 2.0);
-            predict_calc (sat, qth, t);
-        }
+    sat_log_log (SAT_LOG_LEVEL_DEBUG,
+                 _("%s: T0: %f (%d)"),
+                 __FUNCTION__, t0, sat->orbit);
 
-        /* fine steps */
-        while (aostime == 0.0) {
 
-            //if (fabs (sat->el) < (0.005 + min_el)) {
-            if (fabs (sat->el) < (0.005 )) {
-                aostime = t;
-            }
-            else {
-                t -= sat->el * sqrt (sat->alt) / 530000.0;
-                predict_calc (sat, qth, t);
-            }
+    /* calculate (lat,lon) for the required orbits; the observer set-up
+       is done once */
+    predict_init_frame (&frame, qth, t0);
+
+    while ((sat->orbit <= max_orbit) &&
+           (sat->orbit >= this_orbit) &&
+           (!decayed (sat))) {
+
+        /* We use 30 sec time steps. If resolution is too fine, the
+           line drawing routine will filter out unnecessary points
+        */
+        t += 0.00035;
+        Obs_Frame_Set_Time (&frame, t);
+        predict_calc_frame (sat, &frame);
 
+        /* store this SSP */
+
+        /* Note: g_slist_append() has to traverse the entire list to find the end, which
+           is inefficient when adding multiple elements. Therefore, we use g_slist_prepend()
+           and reverse the entire list when we are done.
+        */
+        this_ssp = g_try_new (ssp_t, 1);
+
+        if (this_ssp == NULL) {
+            sat_log_log (SAT_LOG_LEVEL_ERROR,
+                         _("%s: MAYDAY: Insufficient memory for ground track!"),
+                         __FUNCTION__);
+            g_slist_foreach (latlon, (GFunc) g_free, NULL);
+            g_slist_free (latlon);
+            return NULL;
         }
+
+        this_ssp->lat = sat->ssplat;
+        this_ssp->lon = sat->ssplon;
+        latlon = g_slist_prepend (latlon, this_ssp);
     }
 
+    /* log if there is a problem with the orbit calculation */
+    if (sat->orbit != (max_orbit+1)) {
+        sat_log_log (SAT_LOG_LEVEL_ERROR,
+                     _("%s: Problem computing ground track for %s"),
+                     __FUNCTION__, sat->nickname);
+        g_slist_foreach (latlon, (GFunc) g_free, NULL);
+        g_slist_free (latlon);
+        return NULL;
+    }
 
-    return aostime;
+    /* reverse GSList */
+    return g_slist_reverse (latlon);
 }
 
 
-/** \brief Find the LOS time of the next pass.
+/** \brief Convert the QTH location to the observer geodetic used by SGP4SDP4.
+ *  \param qth Pointer to the QTH data.
+ *  \param obs_geodetic Pointer to the geodetic structure to fill.
+ */
+static void
+qth_to_geodetic (qth_t *qth, geodetic_t *obs_geodetic)
+{
+    obs_geodetic->lon = qth->lon * de2ra;
+    obs_geodetic->lat = qth->lat * de2ra;
+    obs_geodetic->alt = qth->alt / 1000.0;
+    obs_geodetic->theta = 0;
+}
+
+
+/** \brief Find the AOS time of the next pass.
  *  \author Alexandru Csete, OZ9AEC
  *  \author John A. Magliacane, KD2BD
  *  \param sat Pointer to the satellite data.
  *  \param qth Pointer to the QTH data.
  *  \param start The time where calculation should start.
- *  \param maxdt The upper time limit in days (0.0 = no limit)
- *  \param min_el The minimum elevation for the LOS
- *  \return The time of the next LOS or 0.0 if the satellite has no LOS.
+ *  \param maxdt The upper time limit in days (0.0 or negative = no limit)
+ *  \param min_el The minimal elevation necessary for AOS
+ *  \return The time of the next AOS or 0.0 if the satellite has no AOS.
  *
- * This function finds the time of LOS for the first coming pass taking place
+ * This function finds the time of AOS for the first coming pass taking place
  * no earlier that start.
- * If the satellite is currently out of range, the function first calls
- * find_aos to get the next AOS time. Then the calculations are done using
- * the new start time.
- * The function has a built-in watchdog to ensure that we don't end up in
- * lengthy loops.
+ * If the satellite is currently within range, the AOS of the following pass
+ * is returned.
  *
+ * The horizon crossing is bracketed and refined by Find_Crossing, see
+ * sgpsdp/sgp_event.c. The satellite data is not in sync with any particular
+ * time when the function returns.
  */
 gdouble
-//find_los (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt, gdouble min_el)
-find_los (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt)
+find_aos (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt, gdouble min_el)
 {
-    gdouble t = start;
-    gdouble lostime = 0.0;
-    gdouble eltemp;
+    geodetic_t obs_geodetic;
 
-    predict_calc (sat, qth, start);
+    /* has_aos needs an up to date jul_utc to check for decay */
+    sat->jul_utc = start;
 
     /* check whether satellite has aos */
     if (!has_aos (sat, qth)) {
@@ -252,84 +398,56 @@ find_los (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt)
 
     }
 
+    qth_to_geodetic (qth, &obs_geodetic);
 
-    //if (sat->el < min_el)
-    if (sat->el < 0.0f)
-        //t = find_aos (sat, qth, start, maxdt, min_el) + 0.001; // +1.5 min
-        t = find_aos (sat, qth, start, maxdt) + 0.001; // +1.5 min
-
-    /* invalid time (potentially returned by find_aos) */
-    if (t < 0.01)
-        return 0.0;
-
-    /* update satellite data */
-    predict_calc (sat, qth, t);
+    /* like before, a negative limit means no limit */
+    if (maxdt < 0.0)
+        maxdt = 0.0;
 
+    return Find_Crossing (sat, &obs_geodetic, start, maxdt, min_el, TRUE);
+}
 
-    /* use upper time limit */
-    if (maxdt > 0.0) {
 
-        /* coarse steps */
-        while ((sat->el >= 1.0) && (t <= (start + maxdt))) {
-            t += cos((sat->el - 1.0) * de2ra) * sqrt(sat->alt) / 25000.0;
-            predict_calc (sat, qth, t);
-        }
+/** \brief Find the LOS time of the next pass.
+ *  \author Alexandru Csete, OZ9AEC
+ *  \author John A. Magliacane, KD2BD
+ *  \param sat Pointer to the satellite data.
+ *  \param qth Pointer to the QTH data.
+ *  \param start The time where calculation should start.
+ *  \param maxdt The upper time limit in days (0.0 or negative = no limit)
+ *  \param min_el The minimum elevation for the LOS
+ *  \return The time of the next LOS or 0.0 if the satellite has no LOS.
+ *
+ * This function finds the time of LOS for the first coming pass taking place
+ * no earlier that start.
+ * If the satellite is currently out of range, the LOS of the next pass is
+ * returned.
+ *
+ * The horizon crossing is bracketed and refined by Find_Crossing, which has
+ * a built-in watchdog to ensure that we don't end up in lengthy loops.
+ */
+gdouble
+find_los (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt, gdouble min_el)
+{
+    geodetic_t obs_geodetic;
 
-        /* fine steps */
-        while ((lostime == 0.0) && (t <= (start + maxdt)))  {
-            
-            t += sat->el * sqrt(sat->alt)/502500.0;
-            predict_calc (sat, qth, t);
-            
-            if (fabs (sat->el) < 0.005) {
-                /* two things are true at LOS time
-                   The elevation is a zero and descending.
-                   This checks that those two are true.
-                */
-                eltemp = sat->el;
-
-                /*check elevation 1 second earlier*/
-                predict_calc (sat, qth, t-1.0/86400.0);
-
-                if (sat->el > eltemp)
-                    lostime = t;
-            }
-        }
-    }
+    /* has_aos needs an up to date jul_utc to check for decay */
+    sat->jul_utc = start;
 
-    /* don't use upper limit */
-    else {
+    /* check whether satellite has aos */
+    if (!has_aos (sat, qth)) {
 
-        /* coarse steps */
-        while (sat->el >= 1.0) {
-            t += cos((sat->el - 1.0) * de2ra) * sqrt(sat->alt) / 25000.0;
-            predict_calc (sat, qth, t);
-        }
+        return 0.0;
 
-        /* fine steps */
-        while (lostime == 0.0) {
-            
-            t += sat->el * sqrt(sat->alt)/502500.0;
-            predict_calc (sat, qth, t);
-            
-            if (fabs(sat->el) < 0.005){
-                /* two things are true at LOS time
-                   The elevation is a zero and descending.
-                   This checks that those two are true.
-                */
-                eltemp = sat->el;
-
-                /*check elevation 1 second earlier*/
-                predict_calc (sat,qth,t-1.0/86400.0);
-
-                if (sat->el > eltemp)
-                    lostime = t;
-            }
-        }
     }
 
+    qth_to_geodetic (qth, &obs_geodetic);
+
+    /* like before, a negative limit means no limit */
+    if (maxdt < 0.0)
+        maxdt = 0.0;
 
-    return lostime;
+    return Find_Crossing (sat, &obs_geodetic, start, maxdt, min_el, FALSE);
 }
 
 
@@ -341,13 +459,14 @@ find_los (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt)
  *  \return The time of the previous AOS or 0.0 if the satellite has no AOS.
  *
  * This function can be used to find the AOS time in the past of the
- * current pass.
+ * current pass. If the satellite is not within range at start, start
+ * is returned. Passes that started more than PREV_AOS_MAXDT days ago are
+ * considered to have no AOS.
  */
 gdouble
-//find_prev_aos (sat_t *sat, qth_t *qth, gdouble start, gdouble min_el)
-find_prev_aos (sat_t *sat, qth_t *qth, gdouble start)
+find_prev_aos (sat_t *sat, qth_t *qth, gdouble start, gdouble min_el)
 {
-    gdouble aostime = start;
+    geodetic_t obs_geodetic;
 
 
     /* make sure current sat values are
@@ -362,13 +481,62 @@ find_prev_aos (sat_t *sat, qth_t *qth, gdouble start)
 
     }
 
-    //while (sat->el >= min_el) {
-    while (sat->el >= 0.0f) {
-        aostime -= 0.0005; // 0.75 min
-        predict_calc (sat, qth, aostime);
-    }
+    if (sat->el < min_el)
+        return start;
 
-    return aostime;
+    qth_to_geodetic (qth, &obs_geodetic);
+
+    return Find_Crossing (sat, &obs_geodetic, start, -PREV_AOS_MAXDT, min_el, TRUE);
+}
+
+
+/** \brief Find the time when the satellite enters the umbra of the earth.
+ *  \param sat Pointer to the satellite data.
+ *  \param start The time where calculation should start.
+ *  \param maxdt The upper time limit in days (0.0 or negative = ECLIPSE_MAXDT)
+ *  \return The time of the next umbra entry or 0.0 if there is none.
+ *
+ * If the satellite is in the umbra at start, the entry after the following
+ * exit is returned. The entry is found like the AOS by Find_Eclipse, see
+ * sgpsdp/sgp_event.c, on the eclipse depth used by get_sat_vis. The satellite
+ * data is not in sync with any particular time when the function returns.
+ */
+gdouble
+find_eclipse_entry (sat_t *sat, gdouble start, gdouble maxdt)
+{
+    /* decayed needs an up to date jul_utc */
+    sat->jul_utc = start;
+    if (decayed (sat))
+        return 0.0;
+
+    if (maxdt <= 0.0)
+        maxdt = ECLIPSE_MAXDT;
+
+    return Find_Eclipse (sat, start, maxdt, TRUE);
+}
+
+
+/** \brief Find the time when the satellite leaves the umbra of the earth.
+ *  \param sat Pointer to the satellite data.
+ *  \param start The time where calculation should start.
+ *  \param maxdt The upper time limit in days (0.0 or negative = ECLIPSE_MAXDT)
+ *  \return The time of the next umbra exit or 0.0 if there is none.
+ *
+ * If the satellite is in sunlight at start, the exit of the next eclipse is
+ * returned. See find_eclipse_entry.
+ */
+gdouble
+find_eclipse_exit (sat_t *sat, gdouble start, gdouble maxdt)
+{
+    /* decayed needs an up to date jul_utc */
+    sat->jul_utc = start;
+    if (decayed (sat))
+        return 0.0;
+
+    if (maxdt <= 0.0)
+        maxdt = ECLIPSE_MAXDT;
+
+    return Find_Eclipse (sat, start, maxdt, FALSE);
 }
 
 /** \brief Predict the next pass.
@@ -382,9 +550,8 @@ find_prev_aos (sat_t *sat, qth_t *qth, gdouble start)
  * This function simply wraps the get_pass function using the current time
  * as parameter.
  *
- * \note the data in sat will be corrupt (future) and must be refreshed
- *       by the caller, if the caller will need it later on (eg. if the caller
- *       is GtkSatList).
+ * \note The data in sat is not changed since the calculations are done
+ *       on a private copy, so the live satellites of a module may be used.
  *
  */
 pass_t *
@@ -413,9 +580,8 @@ get_next_pass   (sat_t *sat, qth_t *qth, gdouble maxdt)
  * This function simply wraps the get_passes function using the
  * current time as parameter.
  *
- * \note the data in sat will be corrupt (future) and must be refreshed
- *       by the caller, if the caller will need it later on (eg. if the caller
- *       is GtkSatList).
+ * \note The data in sat is not changed since the calculations are done
+ *       on a private copy, so the live satellites of a module may be used.
  */
 GSList *
 get_next_passes (sat_t *sat, qth_t *qth, gdouble maxdt, guint num)
@@ -444,7 +610,7 @@ get_next_passes (sat_t *sat, qth_t *qth, gdouble maxdt, guint num)
 
 pass_t *
 get_pass   (sat_t *sat_in, qth_t *qth, gdouble start, gdouble maxdt) {
-    return get_pass_engine (sat_in, qth, start, maxdt, 1.0*sat_cfg_get_int (SAT_CFG_INT_PRED_MIN_EL));
+    return get_pass_engine (sat_in, qth, start, maxdt, 1.0*sat_cfg_get_snapshot ()->pred_min_el, FALSE, NULL);
 }
 
 /** \brief Predict first pass after a certain time ignoring the min elevation.
@@ -459,7 +625,208 @@ get_pass   (sat_t *sat_in, qth_t *qth, gdouble start, gdouble maxdt) {
  */
 pass_t *
 get_pass_no_min_el   (sat_t *sat_in, qth_t *qth, gdouble start, gdouble maxdt) {
-    return get_pass_engine (sat_in, qth, start, maxdt, 0.0);
+    return get_pass_engine (sat_in, qth, start, maxdt, 0.0, FALSE, NULL);
+}
+
+
+/** \brief Predict the summary of the first pass after a certain time.
+ *  \param sat Pointer to the satellite data.
+ *  \param qth Pointer to the location data.
+ *  \param start Starting time.
+ *  \param maxdt The maximum number of days to look ahead (0 for no limit).
+ *  \return Pointer to a newly allocated pass_t structure or NULL if
+ *          there was an error.
+ *
+ * This function is like get_pass but it only calculates AOS, TCA, LOS, the
+ * maximum elevation, the azimuths and the eclipses, which is much cheaper. TCA and the
+ * maximum elevation are found the same way as by get_pass, by a search for
+ * the maximum. The pass details and the visibility string are calculated
+ * when they are first accessed.
+ */
+pass_t *
+get_pass_summary (sat_t *sat_in, qth_t *qth, gdouble start, gdouble maxdt)
+{
+    return get_pass_engine (sat_in, qth, start, maxdt, 1.0*sat_cfg_get_snapshot ()->pred_min_el, TRUE, NULL);
+}
+
+
+/** \brief Calculate the details of a pass.
+ *  \param pass The pass with AOS and LOS set.
+ *  \param sat Working copy of the satellite; will be modified.
+ *  \param qth Pointer to the location data.
+ *  \param summary Whether to also set AOS azimuth and orbit from the first
+ *                 sample.
+ *
+ * The pass is sampled from AOS to LOS with the configured number of entries
+ * and time resolution, and the visibility string is set. The details are
+ * stored in a single array allocated from the arena of the pass.
+ */
+static void
+calc_pass_details (pass_t *pass, sat_t *sat, qth_t *qth, gboolean summary)
+{
+    const sat_cfg_snapshot_t *cfg = sat_cfg_get_snapshot ();
+    pass_detail_t *detail = NULL;
+    obs_frame_t    frame;
+    gdouble        tres;          /* required time resolution */
+    gdouble        step;          /* time step */
+    gdouble        t;
+    guint          i, n;
+
+
+    /* get time resolution; sat-cfg stores it in seconds */
+    tres = cfg->pred_resolution / 86400.0;
+
+    /* get time step, which will give us the max number of entries */
+    step = (pass->los - pass->aos) / cfg->pred_num_entries;
+
+    /* but if this is smaller than the required resolution
+        we go with the resolution
+    */
+    if (step < tres)
+        step = tres;
+
+    /* time samples aos, aos+step, ... not later than los */
+    n = 0;
+    for (t = pass->aos; t <= pass->los; t += step)
+        n++;
+
+    pass->details = pass_arena_alloc (pass->arena, n * sizeof (pass_detail_t));
+    pass->num_details = n;
+
+    /* calculate satellite data for all time steps; the observer set-up
+       is done once */
+    predict_init_frame (&frame, qth, pass->aos);
+
+    for (i = 0, t = pass->aos; i < n; i++, t += step) {
+
+        Obs_Frame_Set_Time (&frame, t);
+        predict_calc_frame (sat, &frame);
+
+        /* in the first iter we want to store
+            pass->aos_az
+        */
+        if (summary && i == 0) {
+            pass->aos_az = sat->az;
+            pass->orbit = sat->orbit;
+        }
+
+        detail = &pass->details[i];
+        detail->time = t;
+        detail->pos = sat->pos;
+        detail->vel = sat->vel;
+        detail->velo = sat->velo;
+        detail->az = sat->az;
+        detail->el = sat->el;
+        detail->range = sat->range;
+        detail->range_rate = sat->range_rate;
+        detail->lat = sat->ssplat;
+        detail->lon = sat->ssplon;
+        detail->alt = sat->alt;
+        detail->ma = sat->ma;
+        detail->phase = sat->phase;
+        detail->footprint = sat->footprint;
+        detail->orbit = sat->orbit;
+        detail->vis = get_sat_vis (sat, qth, t);
+
+        /* also store visibility "bit" */
+        switch (detail->vis) {
+        case SAT_VIS_VISIBLE:
+            pass->vis[0] = 'V';
+            break;
+        case SAT_VIS_DAYLIGHT:
+            pass->vis[1] = 'D';
+            break;
+        case SAT_VIS_ECLIPSED:
+            pass->vis[2] = 'E';
+            break;
+        default:
+            break;
+        }
+    }
+
+    pass->has_details = TRUE;
+}
+
+
+/** \brief Find the time of closest approach of a pass.
+ *  \param pass The pass with AOS and LOS set.
+ *  \param sat Working copy of the satellite; will be modified.
+ *  \param qth Pointer to the location data.
+ *
+ * TCA, the maximum elevation and its azimuth are found with
+ * Find_Max_Elevation instead of from the detail samples, so passes with
+ * and without details have the same values and the maximum is not missed
+ * between two samples.
+ */
+static void
+calc_pass_tca (pass_t *pass, sat_t *sat, qth_t *qth)
+{
+    geodetic_t  obs_geodetic;
+    gdouble     max_el;
+
+
+    qth_to_geodetic (qth, &obs_geodetic);
+    pass->tca = Find_Max_Elevation (sat, &obs_geodetic,
+                                    pass->aos, pass->los, &max_el);
+    predict_calc (sat, qth, pass->tca);
+    pass->max_el = sat->el;
+    pass->maxel_az = sat->az;
+}
+
+
+/** \brief Calculate the eclipses of a pass.
+ *  \param pass The pass with AOS and LOS set.
+ *  \param sat Working copy of the satellite; will be modified.
+ *  \param qth Pointer to the location data.
+ *
+ * The umbra entries and exits between AOS and LOS are found with
+ * Find_Eclipse instead of sampling the pass, so short eclipses and the
+ * exact transitions are not missed. The intervals are allocated from the
+ * arena of the pass and the 'E' of the visibility string is set if there
+ * are any.
+ */
+static void
+calc_pass_eclipses (pass_t *pass, sat_t *sat, qth_t *qth)
+{
+    pass_eclipse_t  ecl[PASS_MAX_ECLIPSES];
+    vector_t        sun;
+    gdouble         depth;
+    gdouble         t = pass->aos;
+    gboolean        eclipsed;
+    guint           n = 0;
+
+
+    if (pass->los <= pass->aos)
+        return;
+
+    /* are we in the umbra at AOS? */
+    predict_calc (sat, qth, t);
+    get_sun_position (t, &sun);
+    eclipsed = Sat_Eclipsed (&sat->pos, &sun, &depth);
+
+    while (n < PASS_MAX_ECLIPSES && t < pass->los) {
+        if (eclipsed) {
+            ecl[n].entry = t;
+            t = Find_Eclipse (sat, t, pass->los - t, FALSE);
+            if (t == 0.0)
+                t = pass->los;
+            ecl[n++].exit = t;
+        }
+        else {
+            t = Find_Eclipse (sat, t, pass->los - t, TRUE);
+            if (t == 0.0)
+                break;
+        }
+        eclipsed = !eclipsed;
+    }
+
+    if (n == 0)
+        return;
+
+    pass->eclipses = pass_arena_alloc (pass->arena, n * sizeof (pass_eclipse_t));
+    memcpy (pass->eclipses, ecl, n * sizeof (pass_eclipse_t));
+    pass->num_eclipses = n;
+    pass->vis[2] = 'E';
 }
 
 
@@ -468,6 +835,10 @@ get_pass_no_min_el   (sat_t *sat_in, qth_t *qth, gdouble start, gdouble maxdt) {
  *  \param qth Pointer to the location data.
  *  \param start Starting time.
  *  \param maxdt The maximum number of days to look ahead (0 for no limit).
+ *  \param min_el The minimum elevation the pass must reach.
+ *  \param summary Whether to calculate the summary only.
+ *  \param arena The arena to allocate the pass from or NULL to use a new
+ *               arena for this pass only.
  *  \return Pointer to a newly allocated pass_t structure or NULL if
  *          there was an error.
  *
@@ -476,39 +847,29 @@ get_pass_no_min_el   (sat_t *sat_in, qth_t *qth, gdouble start, gdouble maxdt) {
  *
  * \note For no time limit use maxdt = 0.0
  *
- * \note the data in sat will be corrupt (future) and must be refreshed
- *       by the caller, if the caller will need it later on (eg. if the caller
- *       is GtkSatList).
- *
- * \note Prepending to a singly linked list is much faster than appending.
- *       Therefore, the elements are prepended whereafter the GSList is
- *       reversed
+ * \note The data in sat is not changed since the calculations are done
+ *       on a private copy, so the live satellites of a module may be used.
  */
 
 static pass_t *
-get_pass_engine   (sat_t *sat_in, qth_t *qth, gdouble start, gdouble maxdt, gdouble min_el)
+get_pass_engine   (sat_t *sat_in, qth_t *qth, gdouble start, gdouble maxdt, gdouble min_el,
+                   gboolean summary, pass_arena_t *arena)
 {
     gdouble        aos = 0.0;    /* time of AOS */
-    gdouble        tca = 0.0;    /* time of TCA */
     gdouble        los = 0.0;    /* time of LOS */
-    gdouble        dt = 0.0;     /* time diff */
-    gdouble        step = 0.0;   /* time step */
     gdouble        t0 = start;
-    gdouble        t;            /* current time counter */
-    gdouble        tres = 0.0; /* required time resolution */
-    gdouble        max_el = 0.0; /* maximum elevation */
     pass_t        *pass = NULL;
-    pass_detail_t *detail = NULL;
     gboolean       done = FALSE;
     guint          iter = 0;      /* number of iterations */
     sat_t         *sat,sat_working;
+    gboolean       own_arena = (arena == NULL);
     /* FIXME: watchdog */
 
     /*copy sat_in to a working structure*/
     sat = memcpy(&sat_working,sat_in,sizeof(sat_t));
 
-    /* get time resolution; sat-cfg stores it in seconds */
-    tres = sat_cfg_get_int (SAT_CFG_INT_PRED_RESOLUTION) / 86400.0;
+    if (own_arena)
+        arena = pass_arena_new (pass_arena_size (sat, summary));
 
     /* loop until we find a pass with elevation > SAT_CFG_INT_PRED_MIN_EL
         or we run out of time
@@ -516,22 +877,18 @@ get_pass_engine   (sat_t *sat_in, qth_t *qth, gdouble start, gdouble maxdt, gdou
     */
     while (!done) {
 
-        /* Find los of next pass or of current pass */
-        //los = find_los (sat, qth, t0, maxdt, 0.0f); // See if a pass is ongoing
-        los = find_los (sat, qth, t0, maxdt); // See if a pass is ongoing
-        //aos = find_aos (sat, qth, t0, start + maxdt - t0, 0.0f);
-        aos = find_aos (sat, qth, t0, start + maxdt - t0);
-        /* sat_log_log(SAT_LOG_LEVEL_INFO, "%s:%s:%d: found aos %f and los %f for t0=%f", */
-        /*          __FILE__,  */
-        /*          __FUNCTION__, */
-        /*          __LINE__, */
-        /*          aos, */
-        /*          los,  */
-        /*          t0); */
-        if (aos > los) {
-            // los is from an currently happening pass, find previous aos
- //           aos = find_prev_aos(sat, qth, t0, 0.0f);
-            aos = find_prev_aos(sat, qth, t0);
+        /* Find aos and los of the current pass or of the next one;
+           the los is searched from the aos so that the time until the
+           next pass is only scanned once */
+        predict_calc (sat, qth, t0);
+        if (sat->el > 0.0) {
+            /* a pass is ongoing */
+            los = find_los (sat, qth, t0, 0.0, 0.0);
+            aos = find_prev_aos (sat, qth, t0, 0.0);
+        }
+        else {
+            aos = find_aos (sat, qth, t0, start + maxdt - t0, 0.0);
+            los = (aos > 0.0) ? find_los (sat, qth, aos, 0.0, 0.0) : 0.0;
         }
 
         /* aos = 0.0 means no aos */
@@ -546,133 +903,180 @@ get_pass_engine   (sat_t *sat_in, qth_t *qth, gdouble start, gdouble maxdt, gdou
             done = TRUE;
         }
         else {
-            //los = find_los (sat, qth, aos + 0.001, maxdt); // +1.5 min later
-            dt = los - aos;
+            /* create a pass_t entry */
+            pass = pass_arena_alloc (arena, sizeof (pass_t));
+            pass->arena = arena;
 
-            /* get time step, which will give us the max number of entries */
-            step = dt / sat_cfg_get_int (SAT_CFG_INT_PRED_NUM_ENTRIES);
-
-            /* but if this is smaller than the required resolution
-                we go with the resolution
-            */
-            if (step < tres)
-                step = tres;
-
-            /* create a pass_t entry; FIXME: g_try_new in 2.8 */
-            pass = g_new (pass_t, 1);
-            
             pass->aos = aos;
             pass->los = los;
+            pass->tca = 0.0;
             pass->max_el = 0.0;
             pass->aos_az = 0.0;
             pass->los_az = 0.0;
+            pass->orbit = 0;
             pass->maxel_az = 0.0;
             pass->vis[0] = '-';
             pass->vis[1] = '-';
             pass->vis[2] = '-';
             pass->vis[3] = 0;
-            pass->satname = g_strdup (sat->nickname);
+            pass->satname = pass_arena_strdup (arena, sat->nickname);
             pass->details = NULL;
+            pass->num_details = 0;
+            pass->eclipses = NULL;
+            pass->num_eclipses = 0;
+            pass->has_details = FALSE;
+            pass->tle = sat->tle;
+            pass->flags = sat->flags;
             /*copy qth data into the pass for later comparisons*/
             qth_small_save(qth,&(pass->qth_comp));
 
-            /* iterate over each time step */
-            for (t = pass->aos; t <= pass->los; t += step) {
-            
-                /* calculate satellite data */
-                predict_calc (sat, qth, t);
-
-                /* in the first iter we want to store
-                    pass->aos_az
-                */
-                if (t == pass->aos) {
-                    pass->aos_az = sat->az;
-                    pass->orbit = sat->orbit;
-                }
-
-                /* append details to sat->details */
-                detail = g_new (pass_detail_t, 1);
-                detail->time = t;
-                detail->pos.x = sat->pos.x;
-                detail->pos.y = sat->pos.y;
-                detail->pos.z = sat->pos.z;
-                detail->pos.w = sat->pos.w;
-                detail->vel.x = sat->vel.x;
-                detail->vel.y = sat->vel.y;
-                detail->vel.z = sat->vel.z;
-                detail->vel.w = sat->vel.w;
-                detail->velo = sat->velo;
-                detail->az = sat->az;
-                detail->el = sat->el;
-                detail->range = sat->range;
-                detail->range_rate = sat->range_rate;
-                detail->lat = sat->ssplat;
-                detail->lon = sat->ssplon;
-                detail->alt = sat->alt;
-                detail->ma = sat->ma;
-                detail->phase = sat->phase;
-                detail->footprint = sat->footprint;
-                detail->orbit = sat->orbit;
-                detail->vis = get_sat_vis (sat, qth, t);
-
-                /* also store visibility "bit" */
-                switch (detail->vis) {
-                case SAT_VIS_VISIBLE:
-                    pass->vis[0] = 'V';
-                    break;
-                case SAT_VIS_DAYLIGHT:
-                    pass->vis[1] = 'D';
-                    break;
-                case SAT_VIS_ECLIPSED:
-                    pass->vis[2] = 'E';
-                    break;
-                default:
-                    break;
-                }
-
-                pass->details = g_slist_prepend (pass->details, detail);
-
-                /* store elevation if greater than the
-                    previously stored one
-                */
-                if (sat->el > max_el) {
-                    max_el = sat->el;
-                    tca = t;
-                    pass->maxel_az = sat->az;
-                }
-
-                /*     g_print ("TIME: %f\tAZ: %f\tEL: %f (MAX: %f)\n", */
-                /*           t, sat->az, sat->el, max_el); */
+            if (summary) {
+                /* AOS azimuth and orbit */
+                predict_calc (sat, qth, pass->aos);
+                pass->aos_az = sat->az;
+                pass->orbit = sat->orbit;
+            }
+            else {
+                calc_pass_details (pass, sat, qth, TRUE);
             }
 
-            pass->details = g_slist_reverse (pass->details);
+            /* same TCA and max elevation with and without details */
+            calc_pass_tca (pass, sat, qth);
 
             /* calculate satellite data */
             predict_calc (sat, qth, pass->los);
-            /* store los_az, max_el and tca */
+            /* store los_az */
             pass->los_az = sat->az;
-            pass->max_el = max_el;
-            pass->tca    = tca;
 
             /* check whether this pass is good */
-            if (max_el >= min_el) {
+            if (pass->max_el >= min_el) {
                 done = TRUE;
+                calc_pass_eclipses (pass, sat, qth);
+                pass_arena_ref (arena);
             }
             else {
                 done = FALSE;
                 t0 = los + 0.014; // +20 min
-                free_pass (pass);
+                /* give back the pass and its details */
+                pass_arena_release (arena, pass);
                 pass = NULL;
             }
 
             iter++;
         }
     }
+
+    if (own_arena)
+        pass_arena_unref (arena);
      
     return pass;
 }
 
 
+/** \brief Make sure that the details of a pass have been calculated.
+ *  \param pass The pass.
+ *
+ * Passes predicted with the summary functions have no details until they
+ * are accessed the first time; the details and the visibility string are
+ * then calculated from the elements and the location stored in the pass.
+ *
+ * \note The first access modifies the pass, so a pass shared between
+ *       threads must have its details calculated before it is shared.
+ */
+static void
+ensure_pass_details (pass_t *pass)
+{
+    sat_t  sat;
+    qth_t  qth;
+
+
+    if (pass->has_details)
+        return;
+
+    /* private satellite from the stored elements */
+    memset (&sat, 0, sizeof (sat_t));
+    sat.tle = pass->tle;
+    sat.flags = pass->flags;
+    sat.nickname = pass->satname;
+    rebuild_ephemeris (&sat);
+    sat.jul_epoch = Julian_Date_of_Epoch (sat.tle.epoch);
+
+    /* location at the time of the prediction */
+    memset (&qth, 0, sizeof (qth_t));
+    qth.lat = pass->qth_comp.lat;
+    qth.lon = pass->qth_comp.lon;
+    qth.alt = pass->qth_comp.alt;
+
+    calc_pass_details (pass, &sat, &qth, FALSE);
+
+    free_ephemeris (&sat);
+}
+
+
+/** \brief Get the number of details of a pass.
+ *  \param pass The pass.
+ *  \return The number of pass_detail_t entries of the pass.
+ *
+ * The details are calculated if necessary, see ensure_pass_details.
+ */
+guint
+get_pass_num_details (pass_t *pass)
+{
+    if (pass == NULL)
+        return 0;
+
+    ensure_pass_details (pass);
+
+    return pass->num_details;
+}
+
+
+/** \brief Get a detail of a pass.
+ *  \param pass The pass.
+ *  \param i The index of the detail, 0 being the AOS.
+ *  \return The detail owned by the pass or NULL if i is out of range.
+ *
+ * The details are calculated if necessary, see ensure_pass_details.
+ */
+pass_detail_t *
+get_pass_detail (pass_t *pass, guint i)
+{
+    if (i >= get_pass_num_details (pass))
+        return NULL;
+
+    return &pass->details[i];
+}
+
+
+/** \brief Initialise an iterator over the details of a pass.
+ *  \param iter The iterator.
+ *  \param pass The pass.
+ */
+void
+pass_detail_iter_init (pass_detail_iter_t *iter, pass_t *pass)
+{
+    iter->pass = pass;
+    iter->index = 0;
+}
+
+
+/** \brief Get the next detail of a pass.
+ *  \param iter The iterator.
+ *  \return The next detail or NULL when all details have been visited.
+ */
+pass_detail_t *
+pass_detail_iter_next (pass_detail_iter_t *iter)
+{
+    pass_detail_t *detail;
+
+    detail = get_pass_detail (iter->pass, iter->index);
+    if (detail != NULL)
+        iter->index++;
+
+    return detail;
+}
+
+
 
 
 /** \brief Predict passes after a certain time.
@@ -686,9 +1090,8 @@ get_pass_engine   (sat_t *sat_in, qth_t *qth, gdouble start, gdouble maxdt, gdou
  *
  * \note For no time limit use maxdt = 0.0
  *
- * \note the data in sat will be corrupt (future) and must be refreshed
- *       by the caller, if the caller will need it later on (eg. if the caller
- *       is GtkSatList).
+ * \note The data in sat is not changed since the calculations are done
+ *       on a private copy, so the live satellites of a module may be used.
  *
  * \note Prepending to a singly linked list is much faster than appending.
  *       Therefore, the elements are prepended whereafter the GSList is
@@ -697,10 +1100,53 @@ get_pass_engine   (sat_t *sat_in, qth_t *qth, gdouble start, gdouble maxdt, gdou
 GSList *
 get_passes (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt, guint num)
 {
-    GSList *passes = NULL;
-    pass_t *pass = NULL;
-    guint   i;
-    gdouble t;
+    return get_passes_engine (sat, qth, start, maxdt, num,
+                              1.0 * sat_cfg_get_snapshot ()->pred_min_el, FALSE);
+}
+
+
+/** \brief Predict the summaries of passes after a certain time.
+ *
+ * This function is like get_passes but uses get_pass_summary, i.e. the
+ * pass details are calculated when they are first accessed.
+ * It is meant for consumers that only need AOS, TCA, LOS, maximum elevation
+ * and the azimuths, like the sky at a glance timeline.
+ */
+GSList *
+get_passes_summary (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt, guint num)
+{
+    return get_passes_engine (sat, qth, start, maxdt, num,
+                              1.0 * sat_cfg_get_snapshot ()->pred_min_el, TRUE);
+}
+
+
+/** \brief Predict passes reaching a given elevation.
+ *  \param min_el The minimum elevation the passes must reach.
+ *  \param summary Whether to calculate the summaries only, see
+ *                 get_passes_summary.
+ *
+ * This function is like get_passes but uses min_el instead of the
+ * configured minimum elevation. The configuration is not read, except for
+ * the number of entries and the resolution of the details.
+ */
+GSList *
+get_passes_min_el (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt, guint num,
+                   gdouble min_el, gboolean summary)
+{
+    return get_passes_engine (sat, qth, start, maxdt, num, min_el, summary);
+}
+
+
+/** \brief Common part of get_passes, get_passes_summary and get_passes_min_el. */
+static GSList *
+get_passes_engine (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt, guint num,
+                   gdouble min_el, gboolean summary)
+{
+    GSList       *passes = NULL;
+    pass_t       *pass = NULL;
+    pass_arena_t *arena;
+    guint         i;
+    gdouble       t;
 
     /* if no number has been specified
         set it to something big */
@@ -709,8 +1155,11 @@ get_passes (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt, guint num)
 
     t = start;
 
+    /* all passes share one arena; it grows if the guess is too small */
+    arena = pass_arena_new (MIN (num, 10) * pass_arena_size (sat, summary));
+
     for (i = 0; i < num; i++) {
-        pass = get_pass (sat, qth, t, maxdt);
+        pass = get_pass_engine (sat, qth, t, maxdt, min_el, summary, arena);
 
         if (pass != NULL) {
             passes = g_slist_prepend (passes, pass);
@@ -730,6 +1179,8 @@ get_passes (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt, guint num)
 
     }
 
+    pass_arena_unref (arena);
+
     if (passes != NULL)
         passes = g_slist_reverse (passes);
 
@@ -742,53 +1193,45 @@ get_passes (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt, guint num)
 
 
 
+/** \brief Copy a pass.
+ *  \param pass The pass to copy.
+ *  \return A newly allocated copy of the pass including its details, if
+ *          they have been calculated.
+ *
+ * The copy has its own arena, so it can be freed independently of the
+ * original.
+ */
 pass_t *
 copy_pass         (pass_t *pass)
 {
-    pass_t *new;
-
-    new = g_try_new (pass_t, 1);
-
-    if (new != NULL) {
-        new->aos = pass->aos;
-        new->los = pass->los;
-        new->tca = pass->tca;
-        new->max_el = pass->max_el;
-        new->aos_az = pass->aos_az;
-        new->los_az = pass->los_az;
-        new->orbit = pass->orbit;
-        new->maxel_az = pass->maxel_az;
-        new->vis[0] = pass->vis[0];
-        new->vis[1] = pass->vis[1];
-        new->vis[2] = pass->vis[2];
-        new->vis[3] = pass->vis[3];
-        new->details = copy_pass_details (pass->details);
-        
-        if (pass->satname != NULL)
-            new->satname = g_strdup (pass->satname);
-        else
-            new->satname = NULL;
+    pass_arena_t *arena;
+    pass_t       *new;
+    gsize         size;
+
+    size = ARENA_ROUND (sizeof (pass_t)) +
+        ARENA_ROUND (pass->num_details * sizeof (pass_detail_t)) +
+        ARENA_ROUND (pass->num_eclipses * sizeof (pass_eclipse_t));
+    if (pass->satname != NULL)
+        size += ARENA_ROUND (strlen (pass->satname) + 1);
+
+    arena = pass_arena_new (size);
+
+    new = pass_arena_alloc (arena, sizeof (pass_t));
+    *new = *pass;
+    new->arena = arena;
+    new->satname = pass_arena_strdup (arena, pass->satname);
+
+    if (pass->num_details > 0) {
+        new->details = pass_arena_alloc (arena, pass->num_details * sizeof (pass_detail_t));
+        memcpy (new->details, pass->details, pass->num_details * sizeof (pass_detail_t));
     }
 
-    return new;
-}
-
-
-GSList *
-copy_pass_details (GSList *details)
-{
-    GSList *new = NULL;
-    guint   i,n;
-
-
-    n = g_slist_length (details);
-    for (i = 0; i < n; i++) {
-        new = g_slist_prepend (new, 
-                        copy_pass_detail (PASS_DETAIL (g_slist_nth_data (details, i))));
+    if (pass->num_eclipses > 0) {
+        new->eclipses = pass_arena_alloc (arena, pass->num_eclipses * sizeof (pass_eclipse_t));
+        memcpy (new->eclipses, pass->eclipses, pass->num_eclipses * sizeof (pass_eclipse_t));
     }
 
-    new = g_slist_reverse (new);
-
+    /* the arena is now owned by the new pass */
     return new;
 }
 
@@ -801,48 +1244,23 @@ copy_pass_detail  (pass_detail_t *detail)
     /* create a pass_t entry; FIXME: g_try_new in 2.8 */
     new = g_new (pass_detail_t, 1);
 
-    new->time = detail->time;
-    new->pos.x = detail->pos.x;
-    new->pos.y = detail->pos.y;
-    new->pos.z = detail->pos.z;
-    new->pos.w = detail->pos.w;
-    new->vel.x = detail->vel.x;
-    new->vel.y = detail->vel.y;
-    new->vel.z = detail->vel.z;
-    new->vel.w = detail->vel.w;
-    new->velo = detail->velo;
-    new->az = detail->az;
-    new->el = detail->el;
-    new->range = detail->range;
-    new->range_rate = detail->range_rate;
-    new->lat = detail->lat;
-    new->lon = detail->lon;
-    new->alt = detail->alt;
-    new->ma = detail->ma;
-    new->phase = detail->phase;
-    new->footprint = detail->footprint;
-    new->orbit = detail->orbit;
-    new->vis = detail->vis;
+    *new = *detail;
 
     return new;
 }
 
 
 
-/** \brief Free a pass_t structure. */
+/** \brief Free a pass_t structure.
+ *
+ * The memory of the pass is returned when the last pass of its arena
+ * has been freed.
+ */
 void
 free_pass   (pass_t *pass)
 {
      if (pass!=NULL){
-     free_pass_details (pass->details);
-     
-     if (pass->satname != NULL) {
-          g_free (pass->satname);
-          pass->satname = NULL;
-     }
-     
-     g_free (pass);
-     pass = NULL;
+          pass_arena_unref (pass->arena);
      } else {
           /*FIXME: log an error?*/
      }
@@ -853,17 +1271,12 @@ free_pass   (pass_t *pass)
 void
 free_passes (GSList *passes)
 {
-    guint n,i;
-    gpointer pass;
-
-    n = g_slist_length (passes);
-
-    for (i = 0; i < n; i++) {
+    GSList *node;
 
-        pass = g_slist_nth_data (passes, i);
+    for (node = passes; node != NULL; node = node->next) {
 
         /* free element data */
-        free_pass (PASS (pass));
+        free_pass (PASS (node->data));
 
     }
 
@@ -875,8 +1288,8 @@ free_passes (GSList *passes)
 
 /** \brief Free a pass detail structure.
  *
- * This function is not rarely useful except for the
- * free_pass function.
+ * This function is only useful for details created with copy_pass_detail;
+ * the details of a pass are owned by the pass.
  *
  */
 void
@@ -888,30 +1301,181 @@ free_pass_detail (pass_detail_t *detail)
 
 
 
-/** \brief Free the whole list of details.
+/* The passes of a prediction and their details are allocated from an arena,
+   which is a list of memory chunks with a bump pointer. A batch of passes
+   therefore needs only a few allocations and the memory is returned when
+   the last pass using the arena is freed.
+*/
+
+/** \brief Memory chunk of a pass arena; the memory follows the header. */
+typedef struct pass_chunk_s {
+    struct pass_chunk_s *next;  /*!< Previous chunk */
+    gsize                size;  /*!< Usable size of the chunk */
+} pass_chunk_t;
+
+struct pass_arena_s {
+    gint          ref_count;  /*!< Creator plus number of passes */
+    GStaticMutex  lock;       /*!< Lazily calculated details can be allocated from any thread */
+    pass_chunk_t *chunks;     /*!< Newest chunk first */
+    gsize         used;       /*!< Bytes used in the newest chunk */
+};
+
+#define CHUNK_DATA(c) ((gchar *) (c) + ARENA_ROUND (sizeof (pass_chunk_t)))
+
+
+/** \brief Create a new arena.
+ *  \param size The expected size of the allocations.
+ *  \return The new arena with a reference count of 1.
+ */
+static pass_arena_t *
+pass_arena_new (gsize size)
+{
+    pass_arena_t *arena;
+
+    if (size < ARENA_MIN_CHUNK)
+        size = ARENA_MIN_CHUNK;
+
+    arena = g_new (pass_arena_t, 1);
+    arena->ref_count = 1;
+    g_static_mutex_init (&arena->lock);
+    arena->chunks = g_malloc (ARENA_ROUND (sizeof (pass_chunk_t)) + size);
+    arena->chunks->next = NULL;
+    arena->chunks->size = size;
+    arena->used = 0;
+
+    return arena;
+}
+
+
+/** \brief Allocate memory from an arena.
+ *  \param arena The arena.
+ *  \param size The number of bytes.
+ *  \return Memory that stays valid until the arena is freed.
  *
+ * If the newest chunk is full, a new chunk of at least twice its size
+ * is added.
  */
-void
-free_pass_details (GSList *details)
+static gpointer
+pass_arena_alloc (pass_arena_t *arena, gsize size)
 {
-    guint n,i;
-    gpointer detail;
+    pass_chunk_t *chunk;
+    gpointer      mem;
+    gsize         csize;
 
-    n = g_slist_length (details);
+    size = ARENA_ROUND (size);
 
-    for (i = 0; i < n; i++) {
+    g_static_mutex_lock (&arena->lock);
 
-        detail = g_slist_nth_data (details, i);
+    if (arena->used + size > arena->chunks->size) {
+        csize = MAX (2 * arena->chunks->size, size);
+        chunk = g_malloc (ARENA_ROUND (sizeof (pass_chunk_t)) + csize);
+        chunk->next = arena->chunks;
+        chunk->size = csize;
+        arena->chunks = chunk;
+        arena->used = 0;
+    }
 
-        /* free element data */
-        free_pass_detail (PASS_DETAIL (detail));
+    mem = CHUNK_DATA (arena->chunks) + arena->used;
+    arena->used += size;
+
+    g_static_mutex_unlock (&arena->lock);
+
+    return mem;
+}
+
+
+/** \brief Give back memory to an arena.
+ *  \param arena The arena.
+ *  \param mem Memory allocated with pass_arena_alloc.
+ *
+ * This releases mem and everything allocated after it, provided that it
+ * is in the newest chunk; otherwise the memory is kept until the arena is
+ * freed.
+ */
+static void
+pass_arena_release (pass_arena_t *arena, gpointer mem)
+{
+    gchar *data;
+
+    g_static_mutex_lock (&arena->lock);
+
+    data = CHUNK_DATA (arena->chunks);
+    if ((gchar *) mem >= data && (gchar *) mem < data + arena->used)
+        arena->used = (gchar *) mem - data;
+
+    g_static_mutex_unlock (&arena->lock);
+}
+
+
+/** \brief Duplicate a string into an arena. */
+static gchar *
+pass_arena_strdup (pass_arena_t *arena, const gchar *str)
+{
+    gchar *new;
+    gsize  len;
+
+    if (str == NULL)
+        return NULL;
+
+    len = strlen (str) + 1;
+    new = pass_arena_alloc (arena, len);
+    memcpy (new, str, len);
+
+    return new;
+}
+
+
+/** \brief Add a reference to an arena. */
+static void
+pass_arena_ref (pass_arena_t *arena)
+{
+    g_atomic_int_inc (&arena->ref_count);
+}
+
+
+/** \brief Remove a reference from an arena and free it if it was the last. */
+static void
+pass_arena_unref (pass_arena_t *arena)
+{
+    pass_chunk_t *chunk;
+
+    if (!g_atomic_int_dec_and_test (&arena->ref_count))
+        return;
+
+    while (arena->chunks != NULL) {
+        chunk = arena->chunks;
+        arena->chunks = chunk->next;
+        g_free (chunk);
     }
 
-    /* free list elements */
-    g_slist_free (details);
-    details = NULL;
+    g_static_mutex_free (&arena->lock);
+    g_free (arena);
 }
 
+
+/** \brief Estimate the arena size needed for one pass.
+ *  \param sat The satellite.
+ *  \param summary Whether the details are calculated later.
+ *
+ * A pass has at most one more detail than the configured number of
+ * entries, see calc_pass_details. Room for one eclipse is included.
+ */
+static gsize
+pass_arena_size (sat_t *sat, gboolean summary)
+{
+    gsize size;
+
+    size = ARENA_ROUND (sizeof (pass_t)) + ARENA_ROUND (sizeof (pass_eclipse_t));
+    if (sat->nickname != NULL)
+        size += ARENA_ROUND (strlen (sat->nickname) + 1);
+    if (!summary)
+        size += ARENA_ROUND ((sat_cfg_get_snapshot ()->pred_num_entries + 2) *
+                             sizeof (pass_detail_t));
+
+    return size;
+}
+
+
 /** \brief Get current pass.
  *  \param sat Pointer to the satellite data.
  *  \param qth Pointer to the QTH data.
@@ -931,6 +1495,31 @@ free_pass_details (GSList *details)
  */
 pass_t *
 get_current_pass (sat_t *sat_in, qth_t *qth, gdouble start)
+{
+    return get_current_pass_engine (sat_in, qth, start, FALSE);
+}
+
+
+/** \brief Get the summary of the current pass.
+ *  \param sat Pointer to the satellite data.
+ *  \param qth Pointer to the QTH data.
+ *  \param start Time to start calculations; use 0.0 for now.
+ *  \return Pointer to a newly allocated pass_t structure or NULL if
+ *          there was an error.
+ *
+ * Like get_current_pass but the details are calculated when they are
+ * first accessed, see get_pass_summary.
+ */
+pass_t *
+get_current_pass_summary (sat_t *sat_in, qth_t *qth, gdouble start)
+{
+    return get_current_pass_engine (sat_in, qth, start, TRUE);
+}
+
+
+/** \brief Common part of get_current_pass and get_current_pass_summary. */
+static pass_t *
+get_current_pass_engine (sat_t *sat_in, qth_t *qth, gdouble start, gboolean summary)
 {
     gdouble t,t0;
     gdouble el0;
@@ -963,7 +1552,7 @@ get_current_pass (sat_t *sat_in, qth_t *qth, gdouble start)
         t -= 0.007; // +10 min
     }
 
-    pass = get_pass_no_min_el (sat, qth, t, 0.0);
+    pass = get_pass_engine (sat, qth, t, 0.0, 0.0, summary, NULL);
     if (el0 > 0.0) {
         /* this function is only specified if the elevation 
            is greater than zero at the time it is called*/
@@ -33,9 +33,20 @@
 #include "sgpsdp/sgp4sdp4.h"
 #include "gtk-sat-data.h"
 #include "sat-vis.h"
+#include "sat-ephem-cache.h"
 
 
 
+/** \brief Arena holding the passes of a prediction and their details. */
+typedef struct pass_arena_s pass_arena_t;
+
+
+/** \brief Time interval of a pass in which the satellite is in the umbra. */
+typedef struct {
+    gdouble     entry;    /*!< Umbra entry in "jul_utc", AOS if eclipsed at AOS */
+    gdouble     exit;     /*!< Umbra exit in "jul_utc", LOS if eclipsed at LOS */
+} pass_eclipse_t;
+
 
 /** \brief Brief satellite pass info. */
 typedef struct {
@@ -49,11 +60,25 @@ typedef struct {
     gint        orbit;    /*!< Orbit number */
     gdouble     maxel_az; /*!< Azimuth at maximum elevation */
     gchar       vis[4];   /*!< Visibility string, e.g. VSE, -S-, V-- */
-    GSList     *details;  /*!< List of pass_detail_t entries */
+    struct pass_detail_s *details; /*!< Array of pass details; use get_pass_detail */
+    guint       num_details; /*!< Number of entries in details */
+    pass_eclipse_t *eclipses; /*!< Eclipsed intervals of the pass in time order */
+    guint       num_eclipses; /*!< Number of entries in eclipses */
+    gboolean    has_details; /*!< FALSE until the details have been calculated */
+    tle_t       tle;      /*!< Processed elements used for the calculation of the details */
+    gint        flags;    /*!< Ephemeris flags belonging to tle */
     qth_small_t qth_comp; /*!< Short version of qth at time computed */
+    pass_arena_t *arena;  /*!< Arena owning the pass and its details */
 } pass_t;
 
 
+/** \brief Structure that define a sub-satellite point. */
+typedef struct {
+    double lat;   /*!< Latitude in decimal degrees North. */
+    double lon;   /*!< Longitude in decimal degrees West. */
+} ssp_t;
+
+
 /** \brief Pass detail entry.
  *
  * In order to ensure maximum flexibility at a minimal effort, only the
@@ -62,7 +87,7 @@ typedef struct {
  * This way we can use the same prediction engine for various consumers
  * without having too much overhead and complexity in the low level code.
  */
-typedef struct {
+typedef struct pass_detail_s {
     gdouble   time;   /*!< time in "jul_utc" */
     vector_t  pos;    /*!< Raw unprocessed position at time */
     vector_t  vel;    /*!< Raw unprocessed velocity at time */
@@ -82,6 +107,17 @@ typedef struct {
 } pass_detail_t;
 
 
+/** \brief Iterator over the details of a pass.
+ *
+ * Initialise with pass_detail_iter_init and call pass_detail_iter_next
+ * until it returns NULL.
+ */
+typedef struct {
+    pass_t *pass;   /*!< The pass */
+    guint   index;  /*!< Index of the next detail */
+} pass_detail_iter_t;
+
+
 /* type casting macros */
 #define PASS(x) ((pass_t *) x)
 #define PASS_DETAIL(x) ((pass_detail_t *) x)
@@ -89,14 +125,19 @@ typedef struct {
 
 /* SGP4/SDP4 driver */
 void predict_calc (sat_t *sat, qth_t *qth, gdouble t);
+void predict_init_frame (obs_frame_t *frame, qth_t *qth, gdouble t);
+void predict_calc_frame (sat_t *sat, const obs_frame_t *frame);
+void predict_calc_cached (sat_t *sat, sat_ephem_cache_t *cache, const obs_frame_t *frame);
+GSList *predict_ground_track (sat_t *sat, qth_t *qth, gdouble t, glong num);
 
 /* AOS/LOS time calculators */
-//gdouble find_aos           (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt, gdouble min_el);
-gdouble find_aos           (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt);
-//gdouble find_los           (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt, gdouble min_el);
-gdouble find_los           (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt);
-//gdouble find_prev_aos      (sat_t *sat, qth_t *qth, gdouble start, gdouble minEl);
-gdouble find_prev_aos      (sat_t *sat, qth_t *qth, gdouble start);
+gdouble find_aos           (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt, gdouble min_el);
+gdouble find_los           (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt, gdouble min_el);
+gdouble find_prev_aos      (sat_t *sat, qth_t *qth, gdouble start, gdouble min_el);
+
+/* umbra entry/exit time calculators */
+gdouble find_eclipse_entry (sat_t *sat, gdouble start, gdouble maxdt);
+gdouble find_eclipse_exit  (sat_t *sat, gdouble start, gdouble maxdt);
 
 /* next events */
 pass_t *get_next_pass      (sat_t *sat, qth_t *qth, gdouble maxdt);
@@ -108,16 +149,27 @@ GSList *get_passes         (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt
 pass_t *get_current_pass   (sat_t *sat, qth_t *qth, gdouble start);
 pass_t *get_pass_no_min_el (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt);
 
+/* pass summaries; details are calculated on first access */
+pass_t *get_pass_summary         (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt);
+GSList *get_passes_summary       (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt, guint num);
+pass_t *get_current_pass_summary (sat_t *sat, qth_t *qth, gdouble start);
+GSList *get_passes_min_el        (sat_t *sat, qth_t *qth, gdouble start, gdouble maxdt, guint num,
+                                  gdouble min_el, gboolean summary);
+
+/* pass details */
+guint          get_pass_num_details  (pass_t *pass);
+pass_detail_t *get_pass_detail       (pass_t *pass, guint i);
+void           pass_detail_iter_init (pass_detail_iter_t *iter, pass_t *pass);
+pass_detail_t *pass_detail_iter_next (pass_detail_iter_t *iter);
+
 /* copying */
 pass_t        *copy_pass         (pass_t *pass);
-GSList        *copy_pass_details (GSList *details);
 pass_detail_t *copy_pass_detail  (pass_detail_t *detail);
 
 /* memory cleaning */
 void free_pass         (pass_t *pass);
 void free_passes       (GSList *passes);
 void free_pass_detail  (pass_detail_t *detail);
-void free_pass_details (GSList *details);
 
 
 #endif
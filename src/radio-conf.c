@@ -44,6 +44,7 @@
 #define KEY_PTT         "PTT"
 #define KEY_VFO_DOWN    "VFO_DOWN"
 #define KEY_VFO_UP      "VFO_UP"
+#define KEY_FSTEP       "FreqStep"
 
 
 /** \brief Read radio configuration.
@@ -144,6 +145,22 @@ gboolean radio_conf_read (radio_conf_t *conf)
         conf->loup = 0.0;
     }
 
+    /* KEY_FSTEP is optional */
+    if (g_key_file_has_key (cfg, GROUP, KEY_FSTEP, NULL)) {
+        conf->fstep = g_key_file_get_double (cfg, GROUP, KEY_FSTEP, &error);
+        if (error != NULL) {
+            sat_log_log (SAT_LOG_LEVEL_ERROR,
+                        _("%s: Error reading radio conf from %s (%s)."),
+                        __FUNCTION__, conf->name, error->message);
+            g_clear_error (&error);
+            g_key_file_free (cfg);
+            return FALSE;
+        }
+    }
+    else {
+        conf->fstep = 1.0;
+    }
+
     /* Radio type */
     conf->type = g_key_file_get_integer (cfg, GROUP, KEY_TYPE, &error);
     if (error != NULL) {
@@ -232,6 +249,7 @@ void radio_conf_save (radio_conf_t *conf)
     g_key_file_set_integer (cfg, GROUP, KEY_PORT, conf->port);
     g_key_file_set_double (cfg, GROUP, KEY_LO, conf->lo);
     g_key_file_set_double (cfg, GROUP, KEY_LOUP, conf->loup);
+    g_key_file_set_double (cfg, GROUP, KEY_FSTEP, conf->fstep);
     g_key_file_set_integer (cfg, GROUP, KEY_TYPE, conf->type);
     g_key_file_set_integer (cfg, GROUP, KEY_PTT, conf->ptt);
     
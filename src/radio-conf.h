@@ -69,6 +69,7 @@ typedef struct {
     ptt_type_t   ptt;       /*!< PTT type (needed for RX, TX, and TRX) */
     vfo_t        vfoDown;   /*!< Downlink VFO for full-duplex radios */
     vfo_t        vfoUp;     /*!< Uplink VFO for full-duplex radios */
+    gdouble      fstep;     /*!< Smallest frequency change sent to the radio [Hz] */
 } radio_conf_t;
 
 
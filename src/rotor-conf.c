@@ -43,6 +43,9 @@
 #define KEY_MAXAZ       "MaxAz"
 #define KEY_MINEL       "MinEl"
 #define KEY_MAXEL       "MaxEl"
+#define KEY_AZRATE      "AzRate"
+#define KEY_ELRATE      "ElRate"
+#define KEY_LATENCY     "Latency"
 
 
 /** \brief Read rotator configuration.
@@ -155,6 +158,25 @@ gboolean rotor_conf_read (rotor_conf_t *conf)
         conf->maxel = 90.0;
     }
     
+    /* the optional motion parameters are only used by the trajectory planner */
+    conf->azrate = g_key_file_get_double (cfg, GROUP, KEY_AZRATE, &error);
+    if (error != NULL) {
+        g_clear_error (&error);
+        conf->azrate = 0.0;
+    }
+    
+    conf->elrate = g_key_file_get_double (cfg, GROUP, KEY_ELRATE, &error);
+    if (error != NULL) {
+        g_clear_error (&error);
+        conf->elrate = 0.0;
+    }
+    
+    conf->latency = g_key_file_get_double (cfg, GROUP, KEY_LATENCY, &error);
+    if (error != NULL) {
+        g_clear_error (&error);
+        conf->latency = 0.0;
+    }
+    
     g_key_file_free (cfg);
     
     return TRUE;
@@ -187,6 +209,9 @@ void rotor_conf_save (rotor_conf_t *conf)
     g_key_file_set_double  (cfg, GROUP, KEY_MAXAZ, conf->maxaz);
     g_key_file_set_double  (cfg, GROUP, KEY_MINEL, conf->minel);
     g_key_file_set_double  (cfg, GROUP, KEY_MAXEL, conf->maxel);
+    g_key_file_set_double  (cfg, GROUP, KEY_AZRATE, conf->azrate);
+    g_key_file_set_double  (cfg, GROUP, KEY_ELRATE, conf->elrate);
+    g_key_file_set_double  (cfg, GROUP, KEY_LATENCY, conf->latency);
     
     /* build filename */
     confdir = get_hwconf_dir();
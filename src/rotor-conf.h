@@ -48,6 +48,9 @@ typedef struct {
     gdouble      maxaz;     /*!< Upper azimuth limit */
     gdouble      minel;     /*!< Lower elevation limit */
     gdouble      maxel;     /*!< Upper elevation limit */
+    gdouble      azrate;    /*!< Azimuth slew rate [deg/sec], 0 if unknown */
+    gdouble      elrate;    /*!< Elevation slew rate [deg/sec], 0 if unknown */
+    gdouble      latency;   /*!< Delay between command and motion [sec] */
 } rotor_conf_t;
 
 
@@ -0,0 +1,637 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2012  Alexandru Csete, OZ9AEC.
+
+    Authors: Alexandru Csete <oz9aec@gmail.com>
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+/** \brief Rotator control loop.
+ *
+ * The loop reads the position of the rotator from rotctld and sends it to
+ * a new position when it is out of tolerance. It runs in its own thread on
+ * a fixed-rate schedule: the cycles are due at a fixed period from the
+ * start of the loop, so the time spent in a cycle does not add up, and a
+ * cycle that is still running when the next one is due makes the loop skip
+ * the cycles it has missed instead of running them late. The rotctld
+ * commands go through the non-blocking connections of hamlib-io.
+ *
+ * The widget publishes a target snapshot with rotor_loop_set_target, and
+ * the loop publishes a state snapshot to the main loop after every cycle.
+ * The loop keeps a private copy of the target satellite with its own
+ * ephemeris, so it never touches the data of the module. From this copy it
+ * builds the trajectory plan of the pass (see rotor-plan.c) once, and each
+ * cycle looks up the position for the current time plus the latency of
+ * the rotator. The current time is the time of the target advanced by the
+ * wall clock time since it was published, at the rate of the module time.
+ */
+
+#include <string.h>
+#include <math.h>
+#include <glib.h>
+#include <glib/gi18n.h>
+#ifdef HAVE_CONFIG_H
+#  include <build-config.h>
+#endif
+#include "sat-log.h"
+#include "predict-tools.h"
+#include "hamlib-io.h"
+#include "rotor-plan.h"
+#include "rotor-loop.h"
+
+
+/** \brief Number of consecutive failed cycles before the loop gives up. */
+#define MAX_ERROR_COUNT 5
+
+/** \brief Time covered by a plan when there is no pass, e.g. for a
+ *         satellite that never sets [days]. */
+#define ROTOR_LOOP_SPAN (1.0/72.0)
+
+/* commands posted to the loop thread */
+#define LOOP_STOP   GINT_TO_POINTER (1)
+#define LOOP_DELAY  GINT_TO_POINTER (2)
+
+
+struct rotor_loop_s {
+    gint              ref_count;  /*!< Owner, loop thread and published states */
+    rotor_conf_t      conf;       /*!< Copy of the rotator configuration */
+    qth_t             qth;        /*!< Copy of the QTH */
+    rotor_loop_func_t func;       /*!< Function called after every cycle */
+    gpointer          data;       /*!< User data for func */
+    GAsyncQueue      *queue;      /*!< Commands to the loop thread */
+
+    GStaticMutex      lock;       /*!< Protects the fields below */
+    guint             delay;      /*!< Period of the loop [msec] */
+    rotor_target_t    target;     /*!< Latest target snapshot */
+    gboolean          have_target;/*!< A target has been published */
+    sat_t             sat;        /*!< Latest target satellite, without ephemeris */
+    guint             sat_serial; /*!< Incremented when sat changes */
+    rotor_loop_stats_t stats;     /*!< Loop statistics */
+
+    /* main loop only */
+    gboolean          stopped;    /*!< Stopped by the owner; no more calls of func */
+};
+
+
+/** \brief Data owned by the loop thread. */
+typedef struct {
+    hamlib_io_t      *io;         /*!< Connection to rotctld */
+    sat_t             sat;        /*!< Private copy of the target satellite */
+    guint             sat_serial; /*!< Serial of the copy, 0 if there is none */
+    rotor_plan_t     *plan;       /*!< Plan of the current pass or NULL */
+    guint             plan_serial;/*!< Serial of the satellite of the plan */
+    gdouble           plan_aos;   /*!< AOS of the plan */
+    gdouble           plan_los;   /*!< LOS of the plan */
+    gboolean          plan_flip;  /*!< Flip of the plan */
+    gint              errcnt;     /*!< Number of consecutive failed cycles */
+} rotor_work_t;
+
+
+/** \brief State published to the main loop. */
+typedef struct {
+    rotor_loop_t     *loop;
+    rotor_state_t     state;
+} rotor_msg_t;
+
+
+static gpointer loop_thread_run (gpointer data);
+static void     loop_cycle      (rotor_loop_t *loop, rotor_work_t *work,
+                                 rotor_state_t *state);
+static void     loop_plan       (rotor_loop_t *loop, rotor_work_t *work,
+                                 const rotor_target_t *target);
+static gboolean loop_get_pos    (rotor_work_t *work, gdouble *az, gdouble *el);
+static gboolean loop_set_pos    (rotor_work_t *work, gdouble az, gdouble el);
+static gboolean loop_publish_cb (gpointer data);
+static gdouble  loop_time_diff  (const GTimeVal *a, const GTimeVal *b);
+static void     loop_unref      (rotor_loop_t *loop);
+
+
+/** \brief Start a rotator control loop.
+ *  \param conf The rotator configuration; it is copied.
+ *  \param qth The QTH; it is copied.
+ *  \param delay The period of the loop [msec].
+ *  \param func Function called in the main loop after every cycle.
+ *  \param data User data passed to \a func.
+ *  \return The loop, which must be stopped with rotor_loop_stop, or NULL if
+ *          the thread could not be created.
+ *
+ * The first cycle runs right away. Until a target has been published with
+ * rotor_loop_set_target the loop only reads the position of the rotator.
+ * Must be called from the main loop.
+ */
+rotor_loop_t *
+rotor_loop_new (const rotor_conf_t *conf, qth_t *qth, guint delay,
+                rotor_loop_func_t func, gpointer data)
+{
+    rotor_loop_t *loop;
+    GError       *err = NULL;
+
+
+    loop = g_new0 (rotor_loop_t, 1);
+    loop->ref_count = 2;
+    loop->conf = *conf;
+    loop->conf.name = NULL;
+    loop->conf.host = g_strdup (conf->host);
+    loop->qth = *qth;
+    loop->func = func;
+    loop->data = data;
+    loop->queue = g_async_queue_new ();
+    g_static_mutex_init (&loop->lock);
+    loop->delay = MAX (delay, 1);
+
+    if (!g_thread_create (loop_thread_run, loop, FALSE, &err)) {
+        sat_log_log (SAT_LOG_LEVEL_ERROR,
+                     _("%s: Could not create rotator thread (%s)"),
+                     __FUNCTION__, err ? err->message : "unknown error");
+        g_clear_error (&err);
+        loop->ref_count = 1;
+        loop_unref (loop);
+        return NULL;
+    }
+
+    return loop;
+}
+
+
+/** \brief Publish a new target.
+ *  \param loop The loop.
+ *  \param target The target; it is copied.
+ *  \param sat The target satellite, or NULL if \a target->track is FALSE. It is
+ *             copied; the ephemeris is rebuilt by the loop thread when the
+ *             satellite or its elements change.
+ *
+ * The target is used from the next cycle on.
+ */
+void
+rotor_loop_set_target (rotor_loop_t *loop, const rotor_target_t *target,
+                       const sat_t *sat)
+{
+    g_static_mutex_lock (&loop->lock);
+
+    loop->target = *target;
+    loop->have_target = TRUE;
+
+    if (sat != NULL) {
+        if (loop->sat_serial == 0 ||
+            loop->sat.tle.catnr != sat->tle.catnr ||
+            loop->sat.tle.epoch != sat->tle.epoch)
+            loop->sat_serial++;
+
+        loop->sat = *sat;
+        loop->sat.name = NULL;
+        loop->sat.nickname = NULL;
+        loop->sat.website = NULL;
+        loop->sat.model = NULL;
+    }
+    else {
+        loop->target.track = FALSE;
+    }
+
+    g_static_mutex_unlock (&loop->lock);
+}
+
+
+/** \brief Change the period of the loop.
+ *  \param loop The loop.
+ *  \param delay The new period [msec].
+ *
+ * The schedule restarts with the new period from the time of the change.
+ */
+void
+rotor_loop_set_delay (rotor_loop_t *loop, guint delay)
+{
+    g_static_mutex_lock (&loop->lock);
+    loop->delay = MAX (delay, 1);
+    g_static_mutex_unlock (&loop->lock);
+
+    g_async_queue_push (loop->queue, LOOP_DELAY);
+}
+
+
+/** \brief Get the statistics of the loop. */
+void
+rotor_loop_get_stats (rotor_loop_t *loop, rotor_loop_stats_t *stats)
+{
+    g_static_mutex_lock (&loop->lock);
+    *stats = loop->stats;
+    g_static_mutex_unlock (&loop->lock);
+}
+
+
+/** \brief Stop a loop.
+ *  \param loop The loop, which must not be used any more.
+ *
+ * The function returns immediately; a cycle that is running is finished
+ * by the loop thread, but its state is not reported any more. Must be
+ * called from the main loop.
+ */
+void
+rotor_loop_stop (rotor_loop_t *loop)
+{
+    loop->stopped = TRUE;
+    g_async_queue_push (loop->queue, LOOP_STOP);
+    loop_unref (loop);
+}
+
+
+/** \brief Main function of the loop thread. */
+static gpointer
+loop_thread_run (gpointer data)
+{
+    rotor_loop_t  *loop = (rotor_loop_t *) data;
+    rotor_work_t   work;
+    rotor_msg_t   *msg;
+    GTimeVal       deadline, now;
+    gpointer       cmd;
+    gdouble        jitter, late;
+    guint          delay, missed;
+
+
+    memset (&work, 0, sizeof (work));
+    work.io = hamlib_io_new (loop->conf.host, loop->conf.port);
+
+    g_static_mutex_lock (&loop->lock);
+    delay = loop->delay;
+    g_static_mutex_unlock (&loop->lock);
+
+    g_get_current_time (&deadline);
+
+    while (TRUE) {
+        cmd = g_async_queue_timed_pop (loop->queue, &deadline);
+
+        if (cmd == LOOP_STOP)
+            break;
+
+        if (cmd == LOOP_DELAY) {
+            g_static_mutex_lock (&loop->lock);
+            delay = loop->delay;
+            g_static_mutex_unlock (&loop->lock);
+
+            g_get_current_time (&deadline);
+            g_time_val_add (&deadline, 1000L * delay);
+            continue;
+        }
+
+        /* the cycle is due */
+        g_get_current_time (&now);
+        jitter = MAX (loop_time_diff (&now, &deadline), 0.0);
+
+        msg = g_new0 (rotor_msg_t, 1);
+        loop_cycle (loop, &work, &msg->state);
+
+        g_atomic_int_inc (&loop->ref_count);
+        msg->loop = loop;
+        g_idle_add (loop_publish_cb, msg);
+
+        /* next deadline; skip the cycles that are already over */
+        g_time_val_add (&deadline, 1000L * delay);
+        g_get_current_time (&now);
+        late = loop_time_diff (&now, &deadline);
+        missed = 0;
+        if (late >= 0.0) {
+            missed = (guint) floor (late * 1000.0 / delay) + 1;
+            g_time_val_add (&deadline, 1000L * delay * missed);
+            sat_log_log (SAT_LOG_LEVEL_ERROR,
+                         _("%s missed the deadline (%u cycles skipped)"),
+                         __FUNCTION__, missed);
+        }
+        else if (-late > 0.001 * delay) {
+            /* the clock has been set back */
+            deadline = now;
+            g_time_val_add (&deadline, 1000L * delay);
+        }
+
+        g_static_mutex_lock (&loop->lock);
+        loop->stats.cycles++;
+        loop->stats.missed += missed;
+        loop->stats.jitter = jitter;
+        loop->stats.jitter_mean += (jitter - loop->stats.jitter_mean) / loop->stats.cycles;
+        if (jitter > loop->stats.jitter_max)
+            loop->stats.jitter_max = jitter;
+        g_static_mutex_unlock (&loop->lock);
+    }
+
+    hamlib_io_close (work.io);
+    rotor_plan_free (work.plan);
+    if (work.sat_serial != 0)
+        free_ephemeris (&work.sat);
+    loop_unref (loop);
+
+    return NULL;
+}
+
+
+/** \brief Run one cycle of the loop.
+ *  \param loop The loop.
+ *  \param work The data of the loop thread.
+ *  \param state Where the state of the rotator is stored.
+ */
+static void
+loop_cycle (rotor_loop_t *loop, rotor_work_t *work, rotor_state_t *state)
+{
+    rotor_target_t     target;
+    hamlib_io_stats_t  iostats;
+    gboolean           have_target, rebuild = FALSE;
+    gboolean           error = FALSE;
+    GTimeVal           now;
+    gdouble            rotaz = 0.0, rotel = 0.0;
+    gdouble            setaz, setel, leadaz, leadel, cmdaz;
+
+
+    /* take the latest target */
+    g_static_mutex_lock (&loop->lock);
+    target = loop->target;
+    have_target = loop->have_target;
+    if (target.track && loop->sat_serial != work->sat_serial) {
+        if (work->sat_serial != 0)
+            free_ephemeris (&work->sat);
+        work->sat = loop->sat;
+        work->sat_serial = loop->sat_serial;
+        rebuild = TRUE;
+    }
+    g_static_mutex_unlock (&loop->lock);
+
+    if (rebuild)
+        rebuild_ephemeris (&work->sat);
+
+    /* the target may be several cycles old */
+    if (have_target) {
+        g_get_current_time (&now);
+        target.t += loop_time_diff (&now, &target.stamp) * target.rate / secday;
+    }
+
+    /* position that the rotator should have when the command takes effect */
+    setaz = target.az;
+    setel = target.el;
+    leadaz = setaz;
+    leadel = setel;
+    if (have_target && target.track) {
+        loop_plan (loop, work, &target);
+        if (work->plan != NULL)
+            rotor_plan_get (work->plan, target.t + loop->conf.latency / secday,
+                            &setaz, &setel, &leadaz, &leadel);
+    }
+
+    /* read back current value from device */
+    state->valid = loop_get_pos (work, &rotaz, &rotel);
+    state->az = rotaz;
+    state->el = rotel;
+    if (!state->valid)
+        error = TRUE;
+
+    /* if tolerance exceeded send the rotator to the lead point, the last
+       point of the plan that is within tolerance, so that it does not
+       have to move on every cycle */
+    if (have_target &&
+        ((fabs (setaz - rotaz) > target.tolerance) ||
+         (fabs (setel - rotel) > target.tolerance))) {
+
+        /* If azimuth position is > 180 from current position, send
+           incremental command */
+        if (fabs (leadaz - rotaz) >= 180.0) {
+            if (leadaz > rotaz)
+                cmdaz = rotaz + 90;
+            else
+                cmdaz = rotaz - 90;
+        }
+        else {
+            cmdaz = leadaz;
+        }
+
+        /* this is the newly computed value which should be ahead of the
+           current position */
+        if (!loop_set_pos (work, cmdaz, leadel)) {
+            error = TRUE;
+        }
+        else {
+            state->moved = TRUE;
+            state->setaz = leadaz;
+            state->setel = leadel;
+        }
+    }
+
+    /* check error status */
+    if (!error) {
+        work->errcnt = 0;
+    }
+    else if (work->errcnt >= MAX_ERROR_COUNT) {
+        sat_log_log (SAT_LOG_LEVEL_ERROR,
+                     _("%s: MAX_ERROR_COUNT (%d) reached. Disengaging device!"),
+                     __FUNCTION__, MAX_ERROR_COUNT);
+        state->failed = TRUE;
+        work->errcnt = 0;
+    }
+    else {
+        work->errcnt++;
+    }
+
+    /* command latency */
+    hamlib_io_get_stats (work->io, &iostats);
+    g_static_mutex_lock (&loop->lock);
+    loop->stats.commands = iostats.num;
+    loop->stats.errors = iostats.errors;
+    loop->stats.latency = iostats.mean;
+    loop->stats.latency_max = iostats.max;
+    g_static_mutex_unlock (&loop->lock);
+}
+
+
+/** \brief Make sure that the plan matches the target.
+ *  \param loop The loop.
+ *  \param work The data of the loop thread with the target satellite.
+ *  \param target The target.
+ *
+ * A new plan is built when the satellite, the pass or the flip changes.
+ * Without a pass the plan covers ROTOR_LOOP_SPAN from now and is renewed
+ * when half of it has passed. A new tolerance only updates the lead points.
+ */
+static void
+loop_plan (rotor_loop_t *loop, rotor_work_t *work, const rotor_target_t *target)
+{
+    rotor_plan_t *plan = work->plan;
+    gdouble       start, end, aos;
+
+
+    if (work->sat_serial == 0)
+        return;
+
+    if ((plan != NULL) &&
+        (work->plan_serial == work->sat_serial) &&
+        (work->plan_aos == target->aos) &&
+        (work->plan_los == target->los) &&
+        (work->plan_flip == target->flipped) &&
+        ((target->los > 0.0) || (target->t < 0.5 * (plan->start + plan->end)))) {
+
+        if (plan->tolerance != target->tolerance)
+            rotor_plan_set_tolerance (plan, target->tolerance);
+        return;
+    }
+
+    rotor_plan_free (plan);
+    work->plan = NULL;
+
+    if (target->los > 0.0) {
+        /* from a while before AOS, but not from the past, until LOS */
+        aos = target->aos;
+        start = MAX (aos - rotor_plan_prepos (&loop->conf), target->t);
+        end = target->los;
+    }
+    else {
+        aos = 0.0;
+        start = target->t;
+        end = start + ROTOR_LOOP_SPAN;
+    }
+
+    work->plan = rotor_plan_new (&work->sat, &loop->qth, &loop->conf,
+                                 start, aos, end,
+                                 target->flipped, target->tolerance);
+    work->plan_serial = work->sat_serial;
+    work->plan_aos = target->aos;
+    work->plan_los = target->los;
+    work->plan_flip = target->flipped;
+
+    if (work->plan != NULL)
+        sat_log_log (SAT_LOG_LEVEL_DEBUG,
+                     _("%s: Planned %d points from %.5f to %.5f"),
+                     __FUNCTION__, work->plan->num, work->plan->start, work->plan->end);
+}
+
+
+/** \brief Read rotator position from device.
+ *  \return TRUE if rotctld has answered, FALSE if an error occurred.
+ */
+static gboolean
+loop_get_pos (rotor_work_t *work, gdouble *az, gdouble *el)
+{
+    hamlib_batch_t *batch;
+    const gchar    *reply;
+    gchar         **vbuff;
+    gboolean        retcode;
+
+
+    batch = hamlib_batch_new ();
+    hamlib_batch_add (batch, 2, "p");
+    retcode = hamlib_io_send_wait (work->io, batch);
+
+    reply = hamlib_batch_reply (batch, 0);
+    if (reply != NULL) {
+        if (strncmp (reply, "RPRT", 4) == 0) {
+            sat_log_log (SAT_LOG_LEVEL_ERROR,
+                         _("%s:%d: rotctld returned error (%s)"),
+                         __FILE__, __LINE__, reply);
+        }
+        else {
+            vbuff = g_strsplit (reply, "\n", 3);
+            if ((vbuff[0] != NULL) && (vbuff[1] != NULL)) {
+                *az = g_strtod (vbuff[0], NULL);
+                *el = g_strtod (vbuff[1], NULL);
+            }
+            else {
+                sat_log_log (SAT_LOG_LEVEL_ERROR,
+                             _("%s:%d: rotctld returned bad response (%s)"),
+                             __FILE__, __LINE__, reply);
+            }
+            g_strfreev (vbuff);
+        }
+    }
+
+    hamlib_batch_free (batch);
+
+    return retcode;
+}
+
+
+/** \brief Send new position to rotator device.
+ *  \return TRUE if the new position has been sent successfully, FALSE if an
+ *          error occurred.
+ *
+ * Errors reported by rotctld are treated as soft errors.
+ */
+static gboolean
+loop_set_pos (rotor_work_t *work, gdouble az, gdouble el)
+{
+    hamlib_batch_t *batch;
+    const gchar    *reply;
+    gchar           azstr[8], elstr[8];
+    gboolean        retcode;
+    gint            retval;
+
+
+    g_ascii_formatd (azstr, 8, "%7.2f", az);
+    g_ascii_formatd (elstr, 8, "%7.2f", el);
+
+    batch = hamlib_batch_new ();
+    hamlib_batch_add (batch, 1, "P %s %s", azstr, elstr);
+    retcode = hamlib_io_send_wait (work->io, batch);
+
+    reply = hamlib_batch_reply (batch, 0);
+    if (reply != NULL && strlen (reply) > 4) {
+        retval = (gint) g_strtod (reply + 4, NULL);
+        if (retval != 0) {
+            sat_log_log (SAT_LOG_LEVEL_ERROR,
+                         _("%s:%d: rotctld returned error %d with az %f el %f(%s)"),
+                         __FILE__, __LINE__, retval, az, el, reply);
+        }
+    }
+
+    hamlib_batch_free (batch);
+
+    return retcode;
+}
+
+
+/** \brief Report the state of a cycle in the main loop. */
+static gboolean
+loop_publish_cb (gpointer data)
+{
+    rotor_msg_t *msg = (rotor_msg_t *) data;
+
+    if (!msg->loop->stopped)
+        msg->loop->func (&msg->state, msg->loop->data);
+
+    loop_unref (msg->loop);
+    g_free (msg);
+
+    return FALSE;
+}
+
+
+/** \brief Difference a - b between two times [s]. */
+static gdouble
+loop_time_diff (const GTimeVal *a, const GTimeVal *b)
+{
+    return (a->tv_sec - b->tv_sec) + 1.0e-6 * (a->tv_usec - b->tv_usec);
+}
+
+
+/** \brief Remove a reference and free the loop if it was the last. */
+static void
+loop_unref (rotor_loop_t *loop)
+{
+    if (!g_atomic_int_dec_and_test (&loop->ref_count))
+        return;
+
+    g_async_queue_unref (loop->queue);
+    g_static_mutex_free (&loop->lock);
+    g_free (loop->conf.host);
+    g_free (loop);
+}
@@ -0,0 +1,99 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2012  Alexandru Csete, OZ9AEC.
+
+    Authors: Alexandru Csete <oz9aec@gmail.com>
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+#ifndef ROTOR_LOOP_H
+#define ROTOR_LOOP_H 1
+
+#include <glib.h>
+#include "sgpsdp/sgp4sdp4.h"
+#include "qth-data.h"
+#include "rotor-conf.h"
+
+
+/** \brief Rotator control loop running in its own thread (opaque). */
+typedef struct rotor_loop_s rotor_loop_t;
+
+
+/** \brief Target snapshot published by the widget. */
+typedef struct {
+    gdouble   t;          /*!< Time of the target data */
+    GTimeVal  stamp;      /*!< Wall clock time at which t was current */
+    gdouble   rate;       /*!< Time t per wall clock time (throttle) */
+    gdouble   az;         /*!< Azimuth to go to [deg] */
+    gdouble   el;         /*!< Elevation to go to [deg] */
+    gdouble   tolerance;  /*!< Tolerance [deg] */
+    gboolean  track;      /*!< A satellite is tracked */
+    gdouble   aos;        /*!< AOS of the current or next pass, or 0 if there is none */
+    gdouble   los;        /*!< LOS of the current or next pass, or 0 if there is none */
+    gboolean  flipped;    /*!< The pass is a flip pass */
+} rotor_target_t;
+
+
+/** \brief State snapshot published by the loop after every cycle. */
+typedef struct {
+    gboolean  valid;      /*!< The position has been read */
+    gdouble   az;         /*!< Azimuth of the rotator [deg] */
+    gdouble   el;         /*!< Elevation of the rotator [deg] */
+    gboolean  moved;      /*!< A new position has been commanded */
+    gdouble   setaz;      /*!< Azimuth that the rotator has been sent to [deg] */
+    gdouble   setel;      /*!< Elevation that the rotator has been sent to [deg] */
+    gboolean  failed;     /*!< Too many errors; the loop should be stopped */
+} rotor_state_t;
+
+
+/** \brief Statistics of the loop. */
+typedef struct {
+    guint     cycles;     /*!< Number of cycles run */
+    guint     missed;     /*!< Number of cycles skipped because the previous one was late */
+    gdouble   jitter;     /*!< Wake-up delay of the last cycle [s] */
+    gdouble   jitter_mean;/*!< Mean wake-up delay [s] */
+    gdouble   jitter_max; /*!< Largest wake-up delay [s] */
+    guint     commands;   /*!< Number of answered rotctld commands */
+    guint     errors;     /*!< Number of rotctld commands without answer */
+    gdouble   latency;    /*!< Mean round trip of the rotctld commands [s] */
+    gdouble   latency_max;/*!< Longest round trip of the rotctld commands [s] */
+} rotor_loop_stats_t;
+
+
+/** \brief Function called in the main loop after every cycle.
+ *  \param state The state of the rotator.
+ *  \param data The user data given to rotor_loop_new.
+ */
+typedef void (*rotor_loop_func_t) (const rotor_state_t *state, gpointer data);
+
+
+rotor_loop_t *rotor_loop_new        (const rotor_conf_t *conf, qth_t *qth,
+                                     guint delay, rotor_loop_func_t func,
+                                     gpointer data);
+void          rotor_loop_set_target (rotor_loop_t *loop, const rotor_target_t *target,
+                                     const sat_t *sat);
+void          rotor_loop_set_delay  (rotor_loop_t *loop, guint delay);
+void          rotor_loop_get_stats  (rotor_loop_t *loop, rotor_loop_stats_t *stats);
+void          rotor_loop_stop       (rotor_loop_t *loop);
+
+
+#endif
@@ -0,0 +1,310 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2012  Alexandru Csete, OZ9AEC.
+
+    Authors: Alexandru Csete <oz9aec@gmail.com>
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+/** \brief Rotator trajectory planner.
+ *
+ * The planner computes the az/el command profile of a pass once, so that
+ * the control loop only has to look up the position for the current time.
+ * The profile starts some time before AOS at the AOS position, so the
+ * rotator is in place when the satellite comes up, and ends at LOS.
+ *
+ * The satellite positions are converted to rotator coordinates (flip pass
+ * and az type) and then limited to the slew rates of the rotator. Where
+ * the satellite moves faster than the rotator can follow, e.g. near the
+ * zenith or when the azimuth has to go all the way round, the profile is
+ * the mean of a lagging and a leading rate-limited profile. Such a profile
+ * can be followed and spreads the unavoidable error evenly before and
+ * after the fast part instead of only lagging behind.
+ *
+ * For each point the planner also stores the last point ahead that is
+ * still within tolerance. The control loop sends the rotator there, so it
+ * does not move on every cycle.
+ */
+
+#include <math.h>
+#include <glib.h>
+#ifdef HAVE_CONFIG_H
+#  include <build-config.h>
+#endif
+#include "predict-tools.h"
+#include "rotor-plan.h"
+
+
+/** \brief Time between two points of a plan [sec]. */
+#define ROTOR_PLAN_STEP     1.0
+
+/** \brief Maximum number of points of a plan; longer plans get a larger step. */
+#define ROTOR_PLAN_MAX      8192
+
+/** \brief Minimum time to be in place before AOS [sec]. */
+#define ROTOR_PLAN_PREPOS   30.0
+
+/** \brief How far ahead the lead point is searched [sec]. */
+#define ROTOR_PLAN_HORIZON  1200.0
+
+
+static void plan_limit_rate (gdouble *v, guint n, gdouble dmax);
+
+
+/** \brief Build the command profile of a pass.
+ *  \param sat The satellite; a private copy that is propagated by the planner.
+ *  \param qth The QTH.
+ *  \param conf The rotator configuration.
+ *  \param start Time of the first point (Julian date).
+ *  \param aos AOS; points before AOS hold the AOS position. Use 0 if the
+ *             satellite is already up.
+ *  \param end Time of the last point, usually LOS (Julian date).
+ *  \param flipped Whether the pass is a flip pass.
+ *  \param tolerance The tolerance of the controller [deg].
+ *  \return The plan, which must be freed with rotor_plan_free, or NULL if
+ *          the time window is empty.
+ */
+rotor_plan_t *
+rotor_plan_new (sat_t *sat, qth_t *qth, const rotor_conf_t *conf,
+                gdouble start, gdouble aos, gdouble end,
+                gboolean flipped, gdouble tolerance)
+{
+    rotor_plan_t *plan;
+    gdouble       t, az, el;
+    gdouble       aosaz = 0.0, aosel = 0.0;
+    guint         i;
+
+
+    if (end <= start)
+        return NULL;
+
+    plan = g_new0 (rotor_plan_t, 1);
+    plan->start = start;
+    plan->step = ROTOR_PLAN_STEP / secday;
+    plan->num = (guint) ceil ((end - start) / plan->step) + 1;
+    if (plan->num > ROTOR_PLAN_MAX) {
+        plan->num = ROTOR_PLAN_MAX;
+        plan->step = (end - start) / (ROTOR_PLAN_MAX - 1);
+    }
+    plan->end = start + (plan->num - 1) * plan->step;
+    plan->az = g_new (gdouble, plan->num);
+    plan->el = g_new (gdouble, plan->num);
+    plan->lead = g_new (guint, plan->num);
+
+    if (aos > start) {
+        predict_calc (sat, qth, aos);
+        aosaz = sat->az;
+        aosel = sat->el;
+    }
+
+    for (i = 0; i < plan->num; i++) {
+        t = start + i * plan->step;
+
+        if (t < aos) {
+            az = aosaz;
+            el = aosel;
+        }
+        else {
+            predict_calc (sat, qth, t);
+            az = sat->az;
+            el = sat->el;
+        }
+
+        /* the rotator can not go below the horizon */
+        if (el < 0.0)
+            el = 0.0;
+
+        /* flip pass if the rotor supports it */
+        if (flipped && (conf->maxel >= 180.0)) {
+            el = 180.0 - el;
+            if (az > 180.0)
+                az -= 180.0;
+            else
+                az += 180.0;
+        }
+        if ((conf->aztype == ROT_AZ_TYPE_180) && (az > 180.0))
+            az -= 360.0;
+
+        plan->az[i] = az;
+        plan->el[i] = el;
+    }
+
+    /* slew rates */
+    if (conf->azrate > 0.0)
+        plan_limit_rate (plan->az, plan->num, conf->azrate * plan->step * secday);
+    if (conf->elrate > 0.0)
+        plan_limit_rate (plan->el, plan->num, conf->elrate * plan->step * secday);
+
+    rotor_plan_set_tolerance (plan, tolerance);
+
+    return plan;
+}
+
+
+/** \brief Update the lead points for a new tolerance.
+ *  \param plan The plan.
+ *  \param tolerance The new tolerance [deg].
+ */
+void
+rotor_plan_set_tolerance (rotor_plan_t *plan, gdouble tolerance)
+{
+    guint i, j, horizon;
+
+    horizon = (guint) (ROTOR_PLAN_HORIZON / (plan->step * secday));
+    plan->tolerance = tolerance;
+
+    for (i = 0; i < plan->num; i++) {
+        j = i;
+        while ((j + 1 < plan->num) && (j + 1 - i <= horizon) &&
+               (fabs (plan->az[j+1] - plan->az[i]) <= tolerance) &&
+               (fabs (plan->el[j+1] - plan->el[i]) <= tolerance))
+            j++;
+        plan->lead[i] = j;
+    }
+}
+
+
+/** \brief Look up the command position at a given time.
+ *  \param plan The plan.
+ *  \param t The time (Julian date).
+ *  \param az Where the azimuth at \a t is stored.
+ *  \param el Where the elevation at \a t is stored.
+ *  \param leadaz Where the azimuth of the lead point is stored.
+ *  \param leadel Where the elevation of the lead point is stored.
+ *  \return TRUE if \a t is within the plan, FALSE otherwise.
+ */
+gboolean
+rotor_plan_get (rotor_plan_t *plan, gdouble t,
+                gdouble *az, gdouble *el, gdouble *leadaz, gdouble *leadel)
+{
+    gdouble x, frac;
+    guint   i;
+
+    if ((t < plan->start) || (t > plan->end))
+        return FALSE;
+
+    x = (t - plan->start) / plan->step;
+    i = (guint) x;
+    if (i >= plan->num - 1) {
+        i = plan->num - 1;
+        frac = 0.0;
+    }
+    else {
+        frac = x - i;
+    }
+
+    if (frac == 0.0) {
+        *az = plan->az[i];
+        *el = plan->el[i];
+    }
+    else {
+        /* don't interpolate across an azimuth wrap */
+        if (fabs (plan->az[i+1] - plan->az[i]) > 180.0)
+            *az = (frac < 0.5) ? plan->az[i] : plan->az[i+1];
+        else
+            *az = plan->az[i] + frac * (plan->az[i+1] - plan->az[i]);
+        *el = plan->el[i] + frac * (plan->el[i+1] - plan->el[i]);
+    }
+
+    if (plan->lead[i] > i) {
+        *leadaz = plan->az[plan->lead[i]];
+        *leadel = plan->el[plan->lead[i]];
+    }
+    else {
+        *leadaz = *az;
+        *leadel = *el;
+    }
+
+    return TRUE;
+}
+
+
+/** \brief Time that a plan should start before AOS [days].
+ *  \param conf The rotator configuration.
+ *
+ * This is the time that the rotator needs to go over its full range, or
+ * ROTOR_PLAN_PREPOS seconds if that is longer or the slew rates are not
+ * known.
+ */
+gdouble
+rotor_plan_prepos (const rotor_conf_t *conf)
+{
+    gdouble t = ROTOR_PLAN_PREPOS;
+
+    if (conf->azrate > 0.0)
+        t = MAX (t, (conf->maxaz - conf->minaz) / conf->azrate);
+    if (conf->elrate > 0.0)
+        t = MAX (t, (conf->maxel - conf->minel) / conf->elrate);
+
+    return t / secday;
+}
+
+
+/** \brief Free a plan. */
+void
+rotor_plan_free (rotor_plan_t *plan)
+{
+    if (plan == NULL)
+        return;
+
+    g_free (plan->az);
+    g_free (plan->el);
+    g_free (plan->lead);
+    g_free (plan);
+}
+
+
+/** \brief Limit the change between two points.
+ *  \param v The values.
+ *  \param n The number of values.
+ *  \param dmax The largest change between two points.
+ *
+ * The result is the mean of the forward limited values, which lag behind,
+ * and the backward limited values, which lead. Both change at most by dmax
+ * per point, and so does their mean.
+ */
+static void
+plan_limit_rate (gdouble *v, guint n, gdouble dmax)
+{
+    gdouble *fwd, *bwd;
+    guint    i;
+
+    if (n < 2)
+        return;
+
+    fwd = g_new (gdouble, n);
+    bwd = g_new (gdouble, n);
+
+    fwd[0] = v[0];
+    for (i = 1; i < n; i++)
+        fwd[i] = CLAMP (v[i], fwd[i-1] - dmax, fwd[i-1] + dmax);
+
+    bwd[n-1] = v[n-1];
+    for (i = n - 1; i > 0; i--)
+        bwd[i-1] = CLAMP (v[i-1], bwd[i] - dmax, bwd[i] + dmax);
+
+    for (i = 0; i < n; i++)
+        v[i] = 0.5 * (fwd[i] + bwd[i]);
+
+    g_free (fwd);
+    g_free (bwd);
+}
@@ -0,0 +1,68 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2012  Alexandru Csete, OZ9AEC.
+
+    Authors: Alexandru Csete <oz9aec@gmail.com>
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+#ifndef ROTOR_PLAN_H
+#define ROTOR_PLAN_H 1
+
+#include <glib.h>
+#include "sgpsdp/sgp4sdp4.h"
+#include "qth-data.h"
+#include "rotor-conf.h"
+
+
+/** \brief Az/el command profile of the rotator for one pass.
+ *
+ * The points are equally spaced in time, so the position at any time is
+ * found by indexing. The positions are in rotator coordinates, i.e. after
+ * the flip and the az type have been applied, and the rotator can follow
+ * them at its slew rates.
+ */
+typedef struct {
+    gdouble   start;      /*!< Time of the first point (Julian date) */
+    gdouble   end;        /*!< Time of the last point (Julian date) */
+    gdouble   step;       /*!< Time between two points [days] */
+    guint     num;        /*!< Number of points */
+    gdouble  *az;         /*!< Azimuth of each point [deg] */
+    gdouble  *el;         /*!< Elevation of each point [deg] */
+    guint    *lead;       /*!< Last point that is within tolerance of each point */
+    gdouble   tolerance;  /*!< Tolerance used for lead [deg] */
+} rotor_plan_t;
+
+
+rotor_plan_t *rotor_plan_new           (sat_t *sat, qth_t *qth,
+                                        const rotor_conf_t *conf,
+                                        gdouble start, gdouble aos, gdouble end,
+                                        gboolean flipped, gdouble tolerance);
+void          rotor_plan_set_tolerance (rotor_plan_t *plan, gdouble tolerance);
+gboolean      rotor_plan_get           (rotor_plan_t *plan, gdouble t,
+                                        gdouble *az, gdouble *el,
+                                        gdouble *leadaz, gdouble *leadel);
+gdouble       rotor_plan_prepos        (const rotor_conf_t *conf);
+void          rotor_plan_free          (rotor_plan_t *plan);
+
+
+#endif
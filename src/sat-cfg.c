@@ -135,7 +135,8 @@ sat_cfg_bool_t sat_cfg_bool[SAT_CFG_BOOL_NUM] = {
     { "TLE",     "PROXY_AUTH",         FALSE},
     { "TLE",     "ADD_NEW_SATS",       TRUE},
     { "LOG",     "KEEP_LOG_FILES",     FALSE},
-    { "PREDICT", "USE_REAL_T0",        FALSE}
+    { "PREDICT", "USE_REAL_T0",        FALSE},
+    { "MODULES", "EPHEM_CACHE",        FALSE}
 };
 
 
@@ -242,6 +243,25 @@ sat_cfg_str_t sat_cfg_str[SAT_CFG_STR_NUM] = {
 /* The configuration data buffer */
 static GKeyFile *config = NULL;
 
+/** \brief A registered change notification. */
+typedef struct {
+    guint             id;     /*!< ID returned by sat_cfg_add_notify */
+    sat_cfg_notify_t  func;   /*!< The function to call */
+    gpointer          data;   /*!< User data for func */
+} sat_cfg_hook_t;
+
+/* Snapshot of the hot path values and its change notifications. A
+   published snapshot is never modified or freed, because worker threads
+   may still read it; a refresh publishes a new one and keeps the old one
+   in the retired list. */
+static sat_cfg_snapshot_t *snapshot = NULL;
+static GSList             *retired = NULL;
+static GSList             *hooks = NULL;
+static guint               hook_id = 0;
+
+
+static void sat_cfg_refresh_snapshot (gboolean notify);
+
 
 
 /** \brief Load configuration data.
@@ -283,6 +303,8 @@ guint sat_cfg_load        ()
 
         g_clear_error (&error);
 
+        sat_cfg_refresh_snapshot (TRUE);
+
         return 1;
     }
     else {
@@ -299,6 +321,7 @@ guint sat_cfg_load        ()
         sat_cfg_set_int (SAT_CFG_INT_VERSION_MINOR, 1);
     }
 
+    sat_cfg_refresh_snapshot (TRUE);
 
     return 0;
 }
@@ -308,7 +331,8 @@ guint sat_cfg_load        ()
  *  \return 0 on success, 1 if an error occured.
  *
  * This function saves the configuration data currently stored in
- * memory to the gpredict.cfg file.
+ * memory to the gpredict.cfg file. The configuration snapshot is refreshed
+ * and the change notifications are called if any of its values changed.
  */
 guint sat_cfg_save        ()
 {
@@ -323,6 +347,8 @@ guint sat_cfg_save        ()
 
     g_free (confdir);
 
+    sat_cfg_refresh_snapshot (TRUE);
+
     return err;
 }
 
@@ -697,3 +723,132 @@ void sat_cfg_reset_int    (sat_cfg_int_e param)
 }
 
 
+/** \brief Read the hot path values into a new snapshot and publish it.
+ *  \param notify Whether to call the change notifications if a value changed.
+ *
+ * Called from the main loop only. The new snapshot replaces the current
+ * one with an atomic pointer swap, so a worker thread sees either the old
+ * or the new values, never a mix of both.
+ */
+static void
+sat_cfg_refresh_snapshot (gboolean notify)
+{
+    sat_cfg_snapshot_t *old;
+    sat_cfg_snapshot_t *cfg;
+    sat_cfg_hook_t     *hook;
+    GSList             *node;
+
+    cfg = g_new (sat_cfg_snapshot_t, 1);
+    cfg->pred_min_el = sat_cfg_get_int (SAT_CFG_INT_PRED_MIN_EL);
+    cfg->pred_num_pass = sat_cfg_get_int (SAT_CFG_INT_PRED_NUM_PASS);
+    cfg->pred_look_ahead = sat_cfg_get_int (SAT_CFG_INT_PRED_LOOK_AHEAD);
+    cfg->pred_resolution = sat_cfg_get_int (SAT_CFG_INT_PRED_RESOLUTION);
+    cfg->pred_num_entries = sat_cfg_get_int (SAT_CFG_INT_PRED_NUM_ENTRIES);
+    cfg->pred_twilight_thld = sat_cfg_get_int (SAT_CFG_INT_PRED_TWILIGHT_THLD);
+    cfg->skyatgl_time = sat_cfg_get_int (SAT_CFG_INT_SKYATGL_TIME);
+    cfg->pred_use_real_t0 = sat_cfg_get_bool (SAT_CFG_BOOL_PRED_USE_REAL_T0);
+
+    old = (sat_cfg_snapshot_t *) g_atomic_pointer_get ((gpointer *) &snapshot);
+
+    if (old != NULL && !memcmp (old, cfg, sizeof (sat_cfg_snapshot_t))) {
+        g_free (cfg);
+        return;
+    }
+
+    g_atomic_pointer_set ((gpointer *) &snapshot, cfg);
+
+    if (old == NULL)
+        return;
+
+    retired = g_slist_prepend (retired, old);
+
+    if (!notify)
+        return;
+
+    for (node = hooks; node != NULL; node = node->next) {
+        hook = (sat_cfg_hook_t *) node->data;
+        hook->func (cfg, hook->data);
+    }
+}
+
+
+/** \brief Get the snapshot of the configuration values used on hot paths.
+ *  \return Pointer to the snapshot. It is owned by the configuration module
+ *          and stays valid until the program exits.
+ *
+ * This can be called from any thread. The snapshot never changes; when
+ * the configuration is loaded or saved a new one is published, which the
+ * next call returns. A thread that needs several values that belong
+ * together should call this once and read them all from the same pointer.
+ * Before sat_cfg_load the snapshot holds the default values.
+ */
+const sat_cfg_snapshot_t *
+sat_cfg_get_snapshot (void)
+{
+    sat_cfg_snapshot_t *cfg;
+
+    cfg = (sat_cfg_snapshot_t *) g_atomic_pointer_get ((gpointer *) &snapshot);
+    if (G_LIKELY (cfg != NULL))
+        return cfg;
+
+    /* sat_cfg_get_int is not safe here, but the defaults are constant */
+    cfg = g_new (sat_cfg_snapshot_t, 1);
+    cfg->pred_min_el = sat_cfg_get_int_def (SAT_CFG_INT_PRED_MIN_EL);
+    cfg->pred_num_pass = sat_cfg_get_int_def (SAT_CFG_INT_PRED_NUM_PASS);
+    cfg->pred_look_ahead = sat_cfg_get_int_def (SAT_CFG_INT_PRED_LOOK_AHEAD);
+    cfg->pred_resolution = sat_cfg_get_int_def (SAT_CFG_INT_PRED_RESOLUTION);
+    cfg->pred_num_entries = sat_cfg_get_int_def (SAT_CFG_INT_PRED_NUM_ENTRIES);
+    cfg->pred_twilight_thld = sat_cfg_get_int_def (SAT_CFG_INT_PRED_TWILIGHT_THLD);
+    cfg->skyatgl_time = sat_cfg_get_int_def (SAT_CFG_INT_SKYATGL_TIME);
+    cfg->pred_use_real_t0 = sat_cfg_get_bool_def (SAT_CFG_BOOL_PRED_USE_REAL_T0);
+
+    /* another thread may have got here first */
+    if (!g_atomic_pointer_compare_and_exchange ((gpointer *) &snapshot, NULL, cfg)) {
+        g_free (cfg);
+        cfg = (sat_cfg_snapshot_t *) g_atomic_pointer_get ((gpointer *) &snapshot);
+    }
+
+    return cfg;
+}
+
+
+/** \brief Register a function to be called when the snapshot changes.
+ *  \param func The function to call.
+ *  \param data User data passed to func.
+ *  \return An ID that can be passed to sat_cfg_remove_notify.
+ *
+ * The function is called from the main loop after the configuration has
+ * been loaded or saved, and only if a value in the snapshot has changed.
+ */
+guint
+sat_cfg_add_notify (sat_cfg_notify_t func, gpointer data)
+{
+    sat_cfg_hook_t *hook;
+
+    hook = g_new (sat_cfg_hook_t, 1);
+    hook->id = ++hook_id;
+    hook->func = func;
+    hook->data = data;
+
+    hooks = g_slist_append (hooks, hook);
+
+    return hook->id;
+}
+
+
+/** \brief Remove a change notification.
+ *  \param id The ID returned by sat_cfg_add_notify.
+ */
+void
+sat_cfg_remove_notify (guint id)
+{
+    GSList *node;
+
+    for (node = hooks; node != NULL; node = node->next) {
+        if (((sat_cfg_hook_t *) node->data)->id == id) {
+            g_free (node->data);
+            hooks = g_slist_delete_link (hooks, node);
+            return;
+        }
+    }
+}
@@ -57,6 +57,7 @@ typedef enum {
     SAT_CFG_BOOL_TLE_ADD_NEW,         /*!< Add new satellites to database. */
     SAT_CFG_BOOL_KEEP_LOG_FILES,      /*!< Whether to keep old log files */
     SAT_CFG_BOOL_PRED_USE_REAL_T0,    /*!< Whether to use current time as T0 fro predictions */
+    SAT_CFG_BOOL_EPHEM_CACHE,         /*!< Whether modules use the ephemeris cache */
     SAT_CFG_BOOL_NUM                  /*!< Number of boolean parameters */
 } sat_cfg_bool_e;
 
@@ -155,6 +156,34 @@ typedef enum {
 } sat_cfg_str_e;
 
 
+/** \brief Typed snapshot of the configuration values used on hot paths.
+ *
+ * The fields are plain copies of the corresponding configuration values.
+ * A snapshot is never modified. When the configuration is loaded or saved
+ * a new one is published, so values changed with sat_cfg_set_xxx become
+ * visible to sat_cfg_get_snapshot when the preferences are saved.
+ * Reading a field is just a memory access, unlike sat_cfg_get_xxx which
+ * looks the value up in the key file and is not safe to call from worker
+ * threads.
+ */
+typedef struct {
+    gint      pred_min_el;        /*!< SAT_CFG_INT_PRED_MIN_EL */
+    gint      pred_num_pass;      /*!< SAT_CFG_INT_PRED_NUM_PASS */
+    gint      pred_look_ahead;    /*!< SAT_CFG_INT_PRED_LOOK_AHEAD */
+    gint      pred_resolution;    /*!< SAT_CFG_INT_PRED_RESOLUTION */
+    gint      pred_num_entries;   /*!< SAT_CFG_INT_PRED_NUM_ENTRIES */
+    gint      pred_twilight_thld; /*!< SAT_CFG_INT_PRED_TWILIGHT_THLD */
+    gint      skyatgl_time;       /*!< SAT_CFG_INT_SKYATGL_TIME */
+    gboolean  pred_use_real_t0;   /*!< SAT_CFG_BOOL_PRED_USE_REAL_T0 */
+} sat_cfg_snapshot_t;
+
+
+/** \brief Function called when the configuration snapshot has changed.
+ *  \param cfg The new snapshot.
+ *  \param data The user data given to sat_cfg_add_notify.
+ */
+typedef void (*sat_cfg_notify_t) (const sat_cfg_snapshot_t *cfg, gpointer data);
+
 
 guint     sat_cfg_load         (void);
 guint     sat_cfg_save         (void);
@@ -172,5 +201,9 @@ gint      sat_cfg_get_int_def  (sat_cfg_int_e param);
 void      sat_cfg_set_int      (sat_cfg_int_e param, gint value);
 void      sat_cfg_reset_int    (sat_cfg_int_e param);
 
+const sat_cfg_snapshot_t *sat_cfg_get_snapshot (void);
+guint     sat_cfg_add_notify    (sat_cfg_notify_t func, gpointer data);
+void      sat_cfg_remove_notify (guint id);
+
 
 #endif
@@ -0,0 +1,363 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2012  Alexandru Csete, OZ9AEC.
+
+    Authors: Alexandru Csete <oz9aec@gmail.com>
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+ 
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+  
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+  
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+/** \brief Chebyshev ephemeris cache.
+ *
+ * The orbit of a satellite is a smooth function of time, yet the module
+ * runs the full SGP4/SDP4 propagator for every satellite at every tick.
+ * This cache fits Chebyshev polynomials to the position, velocity and
+ * phase of a satellite over a short span of its orbit and evaluates the
+ * polynomials instead, which takes the same small, constant time for
+ * near-earth and deep-space satellites.
+ *
+ * The length of a span is a fixed fraction of the orbital period, i.e.
+ * minutes for low earth orbits and hours for geostationary orbits. The
+ * spans are aligned to a grid counted from the TLE epoch, so the results
+ * do not depend on the order of the queries. Each fit is compared with the
+ * propagator at a few points between the nodes. If the error is larger
+ * than the tolerance, the span is halved and fitted again; if that does
+ * not help either, the satellite is propagated directly within the span.
+ *
+ * The tolerances are far below the accuracy of SGP4/SDP4 but above the
+ * numerical noise of the propagator itself: the Kepler solver of SGP4
+ * jitters by a few meters and SDP4 reuses its lunar-solar terms for up to
+ * 30 minutes. The samples of a fit always evaluate those terms at the
+ * sample time, so the polynomials follow the smooth solution.
+ *
+ * A fit costs about 17 propagations, so the cache only pays off when a
+ * satellite is evaluated several times per span, as in the module update
+ * at normal speed. It is therefore optional and enabled per module.
+ */
+
+#include <math.h>
+#include <glib.h>
+#include "sgpsdp/sgp4sdp4.h"
+#ifdef HAVE_CONFIG_H
+#  include <build-config.h>
+#endif
+#include "sat-ephem-cache.h"
+
+
+/** \brief Length of a span as a fraction of the orbital period. */
+#define EPHEM_CACHE_SPAN_FRAC   0.125
+
+/** \brief Shortest span before halving (days). */
+#define EPHEM_CACHE_SPAN_MIN    (1.0/1440.0)
+
+/** \brief Longest span (days). */
+#define EPHEM_CACHE_SPAN_MAX    0.25
+
+/** \brief How many times a span may be halved. */
+#define EPHEM_CACHE_MAX_SPLIT   4
+
+/** \brief Number of points where a fit is checked. */
+#define EPHEM_CACHE_NCHECK      5
+
+/** \brief Largest accepted position error (km). */
+#define EPHEM_CACHE_POS_TOL     5.0E-2
+
+/** \brief Largest accepted velocity error (km/s). */
+#define EPHEM_CACHE_VEL_TOL     5.0E-5
+
+/** \brief Largest accepted phase error (rad). */
+#define EPHEM_CACHE_PHASE_TOL   1.0E-5
+
+
+static void     sat_ephem_cache_update (sat_ephem_cache_t *cache,
+                                        sat_t *sat, gdouble t);
+static gboolean sat_ephem_cache_fit    (sat_ephem_cache_t *cache,
+                                        sat_t *sat, gdouble start, gdouble end);
+static void     ephem_propagate        (sat_t *sat, sgpsdp_state_t *state,
+                                        gdouble t, gdouble *y);
+static void     ephem_eval             (const sat_ephem_cache_t *cache,
+                                        gdouble t, gdouble *y);
+
+
+/** \brief Create a new, empty ephemeris cache.
+ *  \return A newly allocated cache that should be freed with
+ *          sat_ephem_cache_free.
+ */
+sat_ephem_cache_t *
+sat_ephem_cache_new (void)
+{
+    sat_ephem_cache_t *cache;
+
+    cache = g_new0 (sat_ephem_cache_t, 1);
+    cache->valid = FALSE;
+
+    return cache;
+}
+
+
+/** \brief Free an ephemeris cache.
+ *  \param cache The cache to free.
+ */
+void
+sat_ephem_cache_free (sat_ephem_cache_t *cache)
+{
+    g_free (cache);
+}
+
+
+/** \brief Mark an ephemeris cache as invalid.
+ *  \param cache The cache.
+ *
+ * The span will be fitted again at the next call to sat_ephem_cache_get.
+ */
+void
+sat_ephem_cache_invalidate (sat_ephem_cache_t *cache)
+{
+    cache->valid = FALSE;
+}
+
+
+/** \brief Get the state of a satellite from the ephemeris cache.
+ *  \param cache The ephemeris cache of the satellite.
+ *  \param sat Pointer to the satellite data.
+ *  \param t The time (Julian date).
+ *  \return TRUE if the state has been evaluated from the cache, FALSE if
+ *          the satellite must be propagated directly.
+ *
+ * On success jul_utc, tsince, pos, vel and phase of the satellite are set
+ * as SGP4/SDP4 and Convert_Sat_State would set them, to within the
+ * tolerances above. The rest of the satellite data is not changed. A new
+ * span is fitted if t is outside the current one or if the TLE of the
+ * satellite has changed.
+ */
+gboolean
+sat_ephem_cache_get (sat_ephem_cache_t *cache, sat_t *sat, gdouble t)
+{
+    gdouble y[EPHEM_CACHE_NCOMP];
+
+    if (!cache->valid ||
+        (t < cache->start) ||
+        (t > cache->end) ||
+        (sat->tle.epoch != cache->epoch)) {
+
+        sat_ephem_cache_update (cache, sat, t);
+    }
+
+    if (cache->direct)
+        return FALSE;
+
+    ephem_eval (cache, t, y);
+
+    sat->jul_utc = t;
+    sat->tsince = (t - sat->jul_epoch) * xmnpda;
+    sat->pos.x = y[0];
+    sat->pos.y = y[1];
+    sat->pos.z = y[2];
+    sat->vel.x = y[3];
+    sat->vel.y = y[4];
+    sat->vel.z = y[5];
+    Magnitude (&sat->pos);
+    Magnitude (&sat->vel);
+    sat->phase = FMod2p (y[6]);
+
+    return TRUE;
+}
+
+
+/** \brief Fit the span containing a given time.
+ *  \param cache The ephemeris cache of the satellite.
+ *  \param sat Pointer to the satellite data.
+ *  \param t The time that must be inside the span.
+ */
+static void
+sat_ephem_cache_update (sat_ephem_cache_t *cache, sat_t *sat, gdouble t)
+{
+    gdouble len;
+    gdouble start;
+    gint    i;
+
+
+    if (sat->meanmo > 0.0)
+        len = CLAMP (EPHEM_CACHE_SPAN_FRAC / sat->meanmo,
+                     EPHEM_CACHE_SPAN_MIN, EPHEM_CACHE_SPAN_MAX);
+    else
+        len = EPHEM_CACHE_SPAN_MAX;
+
+    cache->direct = FALSE;
+
+    for (i = 0; ; i++) {
+        start = sat->jul_epoch + floor ((t - sat->jul_epoch) / len) * len;
+
+        if (sat_ephem_cache_fit (cache, sat, start, start + len))
+            break;
+
+        if (i == EPHEM_CACHE_MAX_SPLIT) {
+            cache->direct = TRUE;
+            break;
+        }
+
+        len /= 2.0;
+    }
+
+    cache->epoch = sat->tle.epoch;
+    cache->valid = TRUE;
+}
+
+
+/** \brief Fit the polynomials of one span.
+ *  \param cache The ephemeris cache of the satellite.
+ *  \param sat Pointer to the satellite data.
+ *  \param start Start of the span.
+ *  \param end End of the span.
+ *  \return TRUE if the fit is within the tolerances.
+ *
+ * The components are sampled at the Chebyshev nodes of the span, which
+ * gives a near minimax polynomial without solving any equations, and the
+ * fit is then compared with the propagator at EPHEM_CACHE_NCHECK evenly
+ * spaced points including both ends of the span. The state of the
+ * satellite is not changed.
+ */
+static gboolean
+sat_ephem_cache_fit (sat_ephem_cache_t *cache, sat_t *sat,
+                     gdouble start, gdouble end)
+{
+    sgpsdp_state_t state = sat->state;
+    gdouble        f[EPHEM_CACHE_NCOEF][EPHEM_CACHE_NCOMP];
+    gdouble        cosines[EPHEM_CACHE_NCOEF][EPHEM_CACHE_NCOEF];
+    gdouble        y[EPHEM_CACHE_NCOMP];
+    gdouble        fit[EPHEM_CACHE_NCOMP];
+    gdouble        mid = 0.5 * (start + end);
+    gdouble        half = 0.5 * (end - start);
+    gdouble        t, sum, dpos, dvel, dphase;
+    gint           i, j, k;
+
+
+    for (j = 0; j < EPHEM_CACHE_NCOEF; j++)
+        for (k = 0; k < EPHEM_CACHE_NCOEF; k++)
+            cosines[j][k] = cos (pi * j * (k + 0.5) / EPHEM_CACHE_NCOEF);
+
+    /* sample in increasing time, which keeps the SDP4 resonance
+       integrator going in one direction; the phase is unwrapped */
+    for (k = EPHEM_CACHE_NCOEF - 1; k >= 0; k--) {
+        ephem_propagate (sat, &state, mid + half * cosines[1][k], f[k]);
+
+        if (k < EPHEM_CACHE_NCOEF - 1) {
+            while (f[k][6] < f[k+1][6] - pi)
+                f[k][6] += twopi;
+            while (f[k][6] > f[k+1][6] + pi)
+                f[k][6] -= twopi;
+        }
+    }
+
+    for (i = 0; i < EPHEM_CACHE_NCOMP; i++) {
+        for (j = 0; j < EPHEM_CACHE_NCOEF; j++) {
+            sum = 0.0;
+            for (k = 0; k < EPHEM_CACHE_NCOEF; k++)
+                sum += f[k][i] * cosines[j][k];
+            cache->coef[i][j] = 2.0 * sum / EPHEM_CACHE_NCOEF;
+        }
+    }
+
+    cache->start = start;
+    cache->end = end;
+
+    /* the comparisons are written so that NaN, e.g. from a decayed
+       satellite, counts as a failed fit */
+    for (k = 0; k < EPHEM_CACHE_NCHECK; k++) {
+        t = start + (end - start) * k / (EPHEM_CACHE_NCHECK - 1);
+        ephem_propagate (sat, &state, t, y);
+        ephem_eval (cache, t, fit);
+
+        dpos = sqrt (Sqr (fit[0] - y[0]) + Sqr (fit[1] - y[1]) + Sqr (fit[2] - y[2]));
+        dvel = sqrt (Sqr (fit[3] - y[3]) + Sqr (fit[4] - y[4]) + Sqr (fit[5] - y[5]));
+        dphase = fabs (FMod2p (fit[6] - y[6] + pi) - pi);
+
+        if (!(dpos <= EPHEM_CACHE_POS_TOL) ||
+            !(dvel <= EPHEM_CACHE_VEL_TOL) ||
+            !(dphase <= EPHEM_CACHE_PHASE_TOL))
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+
+/** \brief Propagate a satellite without changing its data.
+ *  \param sat Pointer to the satellite data.
+ *  \param state The propagator state to use.
+ *  \param t The time (Julian date).
+ *  \param y Location where position, velocity and phase are stored.
+ */
+static void
+ephem_propagate (sat_t *sat, sgpsdp_state_t *state, gdouble t, gdouble *y)
+{
+    vector_t pos, vel;
+    gdouble  tsince = (t - sat->jul_epoch) * xmnpda;
+
+    /* evaluate the lunar-solar periodics at t instead of reusing them
+       for up to 30 minutes, so the samples are a smooth function of t */
+    state->savtsn = 1E20;
+
+    if (sat->flags & DEEP_SPACE_EPHEM_FLAG)
+        SDP4_Model (sat->model, state, tsince);
+    else
+        SGP4_Model (sat->model, state, tsince);
+
+    pos = state->pos;
+    vel = state->vel;
+    Convert_Sat_State (&pos, &vel);
+
+    y[0] = pos.x;
+    y[1] = pos.y;
+    y[2] = pos.z;
+    y[3] = vel.x;
+    y[4] = vel.y;
+    y[5] = vel.z;
+    y[6] = state->phase;
+}
+
+
+/** \brief Evaluate the polynomials of the span.
+ *  \param cache The ephemeris cache of the satellite.
+ *  \param t The time (Julian date); should be inside the span.
+ *  \param y Location where the components are stored.
+ *
+ * Uses the Clenshaw recurrence.
+ */
+static void
+ephem_eval (const sat_ephem_cache_t *cache, gdouble t, gdouble *y)
+{
+    gdouble x, b0, b1, b2;
+    gint    i, j;
+
+    x = (2.0 * t - cache->start - cache->end) / (cache->end - cache->start);
+
+    for (i = 0; i < EPHEM_CACHE_NCOMP; i++) {
+        b1 = 0.0;
+        b2 = 0.0;
+        for (j = EPHEM_CACHE_NCOEF - 1; j > 0; j--) {
+            b0 = 2.0 * x * b1 - b2 + cache->coef[i][j];
+            b2 = b1;
+            b1 = b0;
+        }
+        y[i] = x * b1 - b2 + 0.5 * cache->coef[i][0];
+    }
+}
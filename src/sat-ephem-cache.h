@@ -0,0 +1,66 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2012  Alexandru Csete, OZ9AEC.
+
+    Authors: Alexandru Csete <oz9aec@gmail.com>
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+ 
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+  
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+  
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+#ifndef SAT_EPHEM_CACHE_H
+#define SAT_EPHEM_CACHE_H 1
+
+#include <glib.h>
+#include "sgpsdp/sgp4sdp4.h"
+
+
+/** \brief Number of Chebyshev coefficients per component. */
+#define EPHEM_CACHE_NCOEF   12
+
+/** \brief Number of fitted components: position, velocity and phase. */
+#define EPHEM_CACHE_NCOMP   7
+
+
+/** \brief Ephemeris cache of one satellite.
+ *
+ * The cache holds Chebyshev polynomials fitted to the ECI position and
+ * velocity and to the orbit phase of the satellite over the time span
+ * [start;end]. Within the span the state of the satellite is evaluated from
+ * the polynomials instead of running SGP4/SDP4.
+ */
+typedef struct {
+    gdouble   start;    /*!< Start of the span in "jul_utc" */
+    gdouble   end;      /*!< End of the span */
+    gdouble   epoch;    /*!< Epoch of the TLE the span was fitted for */
+    gboolean  valid;    /*!< FALSE if the cache must be refitted */
+    gboolean  direct;   /*!< The fit failed; propagate directly within the span */
+    gdouble   coef[EPHEM_CACHE_NCOMP][EPHEM_CACHE_NCOEF]; /*!< Chebyshev coefficients */
+} sat_ephem_cache_t;
+
+
+sat_ephem_cache_t *sat_ephem_cache_new        (void);
+void               sat_ephem_cache_free       (sat_ephem_cache_t *cache);
+void               sat_ephem_cache_invalidate (sat_ephem_cache_t *cache);
+gboolean           sat_ephem_cache_get        (sat_ephem_cache_t *cache,
+                                               sat_t *sat, gdouble t);
+
+
+#endif
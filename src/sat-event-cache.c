@@ -0,0 +1,221 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2012  Alexandru Csete, OZ9AEC.
+
+    Authors: Alexandru Csete <oz9aec@gmail.com>
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+ 
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+  
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+  
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+/** \brief AOS/LOS event cache.
+ *
+ * The module used to recalculate the next AOS and LOS of every satellite
+ * once a minute and whenever the stored event was in the past. This cache
+ * instead calculates all events in a window around the current time once
+ * and answers the "next AOS/LOS after t" queries from the stored times
+ * until the time leaves the window, the TLE changes or the QTH moves.
+ */
+
+#include <glib.h>
+#include <glib/gi18n.h>
+#include "sgpsdp/sgp4sdp4.h"
+#ifdef HAVE_CONFIG_H
+#  include <build-config.h>
+#endif
+#include "predict-tools.h"
+#include "sat-event-cache.h"
+
+
+/** \brief How far back the window reaches (days). */
+#define EVENT_CACHE_BACK     0.5
+
+/** \brief How far the window reaches beyond the look-ahead time (days). */
+#define EVENT_CACHE_AHEAD    1.0
+
+/** \brief QTH movement that invalidates the cache (km). */
+#define EVENT_CACHE_QTH_DIST 1.0
+
+/** \brief Time after an event where the search for the next one starts (days). */
+#define EVENT_CACHE_EPS      1.0E-4
+
+
+static void    sat_event_cache_fill (sat_event_cache_t *cache,
+                                     sat_t *sat, qth_t *qth,
+                                     gdouble start, gdouble end);
+static gdouble next_event           (GArray *events, gdouble t);
+
+
+/** \brief Create a new, empty event cache.
+ *  \return A newly allocated cache that should be freed with
+ *          sat_event_cache_free.
+ */
+sat_event_cache_t *
+sat_event_cache_new (void)
+{
+    sat_event_cache_t *cache;
+
+    cache = g_new0 (sat_event_cache_t, 1);
+    cache->aos = g_array_new (FALSE, FALSE, sizeof (gdouble));
+    cache->los = g_array_new (FALSE, FALSE, sizeof (gdouble));
+    cache->valid = FALSE;
+
+    return cache;
+}
+
+
+/** \brief Free an event cache.
+ *  \param cache The cache to free.
+ */
+void
+sat_event_cache_free (sat_event_cache_t *cache)
+{
+    if (cache == NULL)
+        return;
+
+    g_array_free (cache->aos, TRUE);
+    g_array_free (cache->los, TRUE);
+    g_free (cache);
+}
+
+
+/** \brief Mark an event cache as invalid.
+ *  \param cache The cache.
+ *
+ * The events will be recomputed at the next call to sat_event_cache_get.
+ */
+void
+sat_event_cache_invalidate (sat_event_cache_t *cache)
+{
+    cache->valid = FALSE;
+}
+
+
+/** \brief Get the next AOS and LOS of a satellite.
+ *  \param cache The event cache of the satellite.
+ *  \param sat Pointer to the satellite data.
+ *  \param qth Pointer to the QTH data.
+ *  \param t The time (Julian date).
+ *  \param maxdt The look-ahead time in days.
+ *  \param aos Location where the next AOS after t is stored.
+ *  \param los Location where the next LOS after t is stored.
+ *
+ * The results are the same as those of find_aos and find_los with the same
+ * time and look-ahead, i.e. 0.0 if there is no AOS or LOS within maxdt.
+ * The events are recomputed only if t + maxdt is outside the cached window,
+ * if the TLE of the satellite has changed or if the QTH has moved more than
+ * EVENT_CACHE_QTH_DIST km. When that happens the satellite data is not in
+ * sync with t any more.
+ */
+void
+sat_event_cache_get (sat_event_cache_t *cache, sat_t *sat, qth_t *qth,
+                     gdouble t, gdouble maxdt, gdouble *aos, gdouble *los)
+{
+    if (!cache->valid ||
+        (t < cache->start) ||
+        (t + maxdt > cache->end) ||
+        (sat->tle.epoch != cache->epoch) ||
+        (qth_small_dist (qth, cache->qth) > EVENT_CACHE_QTH_DIST)) {
+
+        sat_event_cache_fill (cache, sat, qth,
+                              t - EVENT_CACHE_BACK,
+                              t + maxdt + EVENT_CACHE_AHEAD);
+    }
+
+    *aos = next_event (cache->aos, t);
+    *los = next_event (cache->los, t);
+
+    /* same limit as find_aos and find_los */
+    if (*aos > t + maxdt)
+        *aos = 0.0;
+    if (*los > t + maxdt)
+        *los = 0.0;
+}
+
+
+/** \brief Compute the events of the cache.
+ *  \param cache The event cache of the satellite.
+ *  \param sat Pointer to the satellite data.
+ *  \param qth Pointer to the QTH data.
+ *  \param start Start of the window.
+ *  \param end End of the window.
+ *
+ * Each AOS and LOS in the window is found once with find_aos or find_los,
+ * starting just after the previous event of the same kind.
+ */
+static void
+sat_event_cache_fill (sat_event_cache_t *cache, sat_t *sat, qth_t *qth,
+                      gdouble start, gdouble end)
+{
+    gdouble aos, los;
+
+
+    g_array_set_size (cache->aos, 0);
+    g_array_set_size (cache->los, 0);
+
+    aos = find_aos (sat, qth, start, end - start, 0.0);
+    los = find_los (sat, qth, start, end - start, 0.0);
+
+    while (aos > 0.0 || los > 0.0) {
+
+        if (aos > 0.0 && (los == 0.0 || aos < los)) {
+            g_array_append_val (cache->aos, aos);
+            aos += EVENT_CACHE_EPS;
+            aos = (aos < end) ? find_aos (sat, qth, aos, end - aos, 0.0) : 0.0;
+        }
+        else {
+            g_array_append_val (cache->los, los);
+            los += EVENT_CACHE_EPS;
+            los = (los < end) ? find_los (sat, qth, los, end - los, 0.0) : 0.0;
+        }
+    }
+
+    cache->start = start;
+    cache->end = end;
+    cache->epoch = sat->tle.epoch;
+    qth_small_save (qth, &cache->qth);
+    cache->valid = TRUE;
+}
+
+
+/** \brief Find the first event after t.
+ *  \param events Sorted array of event times.
+ *  \param t The time.
+ *  \return The first time in events that is later than t or 0.0 if
+ *          there is none.
+ */
+static gdouble
+next_event (GArray *events, gdouble t)
+{
+    guint lo = 0;
+    guint hi = events->len;
+    guint mid;
+
+    /* binary search for the first element > t */
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (g_array_index (events, gdouble, mid) > t)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+
+    return (lo < events->len) ? g_array_index (events, gdouble, lo) : 0.0;
+}
@@ -0,0 +1,64 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2012  Alexandru Csete, OZ9AEC.
+
+    Authors: Alexandru Csete <oz9aec@gmail.com>
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+ 
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+  
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+  
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+#ifndef SAT_EVENT_CACHE_H
+#define SAT_EVENT_CACHE_H 1
+
+#include <glib.h>
+#include "sgpsdp/sgp4sdp4.h"
+#include "gtk-sat-data.h"
+#include "qth-data.h"
+
+
+/** \brief AOS/LOS event cache of one satellite.
+ *
+ * The cache holds every AOS and every LOS of the satellite in the time
+ * window [start;end] as seen from the QTH in qth. The times are sorted, so
+ * the next AOS or LOS after any time in the window is found with a binary
+ * search, no matter whether time runs forward or backward.
+ */
+typedef struct {
+    GArray      *aos;     /*!< AOS times in "jul_utc", sorted */
+    GArray      *los;     /*!< LOS times in "jul_utc", sorted */
+    gdouble      start;   /*!< Start of the window */
+    gdouble      end;     /*!< End of the window */
+    gdouble      epoch;   /*!< Epoch of the TLE the events were computed with */
+    qth_small_t  qth;     /*!< QTH the events were computed for */
+    gboolean     valid;   /*!< FALSE if the cache must be recomputed */
+} sat_event_cache_t;
+
+
+sat_event_cache_t *sat_event_cache_new        (void);
+void               sat_event_cache_free       (sat_event_cache_t *cache);
+void               sat_event_cache_invalidate (sat_event_cache_t *cache);
+void               sat_event_cache_get        (sat_event_cache_t *cache,
+                                               sat_t *sat, qth_t *qth,
+                                               gdouble t, gdouble maxdt,
+                                               gdouble *aos, gdouble *los);
+
+
+#endif
@@ -56,6 +56,7 @@ static gboolean initialised = FALSE;
 static GIOChannel *logfile = NULL;
 static sat_log_level_t loglevel = SAT_LOG_LEVEL_DEBUG;
 static gboolean debug_to_stderr = TRUE;  // whether to also send debug msg to stderr
+static GStaticMutex log_lock = G_STATIC_MUTEX_INIT;  // messages may come from worker threads
 
 /*! \brief String representation of debug levels. */
 const gchar *debug_level_str[] = {
@@ -190,10 +191,12 @@ void sat_log_log(sat_log_level_t level, const gchar * fmt, ...)
        which will print the debug message and save it to
        a logfile
      */
+    g_static_mutex_lock(&log_lock);
     for (i = 0; i < numlines; i++)
     {
         manage_debug_message(level, msgv[i]);
     }
+    g_static_mutex_unlock(&log_lock);
 
     va_end(ap);
 
@@ -348,12 +348,12 @@ void show_pass (const gchar *satname, qth_t *qth, pass_t *pass, GtkWidget *tople
                                     G_TYPE_STRING);  // visibility
 
     /* add rows to list store */
-    num = g_slist_length (pass->details);
+    num = get_pass_num_details (pass);
 
     
     for (i = 0; i < num; i++) {
 
-        detail = PASS_DETAIL(g_slist_nth_data (pass->details, i));
+        detail = get_pass_detail (pass, i);
 
         gtk_list_store_append (liststore, &item);
         gtk_list_store_set (liststore, &item,
@@ -41,12 +41,14 @@ static GtkWidget *listspin;   /* spin button for list view */
 static GtkWidget *mapspin;    /* spin button for map view */
 static GtkWidget *polarspin;  /* spin button for polar view */
 static GtkWidget *singlespin; /* spin button for single-sat view */
+static GtkWidget *ephemcheck; /* check button for the ephemeris cache */
 
 static gboolean dirty = FALSE;  /* used to check whether any changes have occurred */
 static gboolean reset = FALSE;
 
 
 static void spin_changed_cb     (GtkWidget *spinner, gpointer data);
+static void check_toggled_cb    (GtkWidget *button, gpointer data);
 static void create_reset_button (GKeyFile *cfg, GtkBox *vbox);
 static void reset_cb            (GtkWidget *button, gpointer cfg);
 
@@ -276,6 +278,29 @@ GtkWidget *sat_pref_refresh_create (GKeyFile *cfg)
      gtk_container_set_border_width (GTK_CONTAINER (vbox), 20);
      gtk_box_pack_start (GTK_BOX (vbox), table, TRUE, TRUE, 0);
 
+     /* ephemeris cache */
+     ephemcheck = gtk_check_button_new_with_label (_("Use ephemeris cache"));
+     gtk_widget_set_tooltip_text (ephemcheck,
+                                  _("Calculate the satellite positions from "\
+                                    "polynomials fitted to short spans of the "\
+                                    "orbit instead of running SGP4/SDP4 at every "\
+                                    "update. This reduces the CPU load of modules "\
+                                    "with many satellites."));
+     if (cfg != NULL) {
+          gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (ephemcheck),
+                                        mod_cfg_get_bool (cfg,
+                                                          MOD_CFG_GLOBAL_SECTION,
+                                                          MOD_CFG_EPHEM_CACHE_KEY,
+                                                          SAT_CFG_BOOL_EPHEM_CACHE));
+     }
+     else {
+          gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (ephemcheck),
+                                        sat_cfg_get_bool (SAT_CFG_BOOL_EPHEM_CACHE));
+     }
+     g_signal_connect (G_OBJECT (ephemcheck), "toggled",
+                       G_CALLBACK (check_toggled_cb), NULL);
+     gtk_box_pack_start (GTK_BOX (vbox), ephemcheck, FALSE, FALSE, 10);
+
      /* create RESET button */
      create_reset_button (cfg, GTK_BOX (vbox));
      
@@ -331,6 +356,11 @@ sat_pref_refresh_ok     (GKeyFile *cfg)
                               MOD_CFG_SINGLE_SAT_REFRESH,
                               gtk_spin_button_get_value_as_int (GTK_SPIN_BUTTON (singlespin)));
 
+               g_key_file_set_boolean (cfg,
+                              MOD_CFG_GLOBAL_SECTION,
+                              MOD_CFG_EPHEM_CACHE_KEY,
+                              gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (ephemcheck)));
+
           }
           else {
 
@@ -349,6 +379,9 @@ sat_pref_refresh_ok     (GKeyFile *cfg)
                sat_cfg_set_int (SAT_CFG_INT_SINGLE_SAT_REFRESH,
                           gtk_spin_button_get_value_as_int (GTK_SPIN_BUTTON (singlespin)));
 
+               sat_cfg_set_bool (SAT_CFG_BOOL_EPHEM_CACHE,
+                           gtk_toggle_button_get_active (GTK_TOGGLE_BUTTON (ephemcheck)));
+
           }
 
      }
@@ -361,6 +394,7 @@ sat_pref_refresh_ok     (GKeyFile *cfg)
                sat_cfg_reset_int (SAT_CFG_INT_MAP_REFRESH);
                sat_cfg_reset_int (SAT_CFG_INT_POLAR_REFRESH);
                sat_cfg_reset_int (SAT_CFG_INT_SINGLE_SAT_REFRESH);
+               sat_cfg_reset_bool (SAT_CFG_BOOL_EPHEM_CACHE);
           }
           else {
                /* remove keys */
@@ -384,6 +418,10 @@ sat_pref_refresh_ok     (GKeyFile *cfg)
                                 MOD_CFG_SINGLE_SAT_SECTION,
                                 MOD_CFG_SINGLE_SAT_REFRESH,
                                 NULL);
+               g_key_file_remove_key ((GKeyFile *)(cfg),
+                                MOD_CFG_GLOBAL_SECTION,
+                                MOD_CFG_EPHEM_CACHE_KEY,
+                                NULL);
           }
      }
 
@@ -403,6 +441,16 @@ spin_changed_cb (GtkWidget *spinner, gpointer data)
 }
 
 
+static void
+check_toggled_cb (GtkWidget *button, gpointer data)
+{
+    (void) button; /* avoid unused parameter compiler warning */
+    (void) data; /* avoid unused parameter compiler warning */
+
+     dirty = TRUE;
+}
+
+
 
 
 
@@ -469,6 +517,8 @@ reset_cb               (GtkWidget *button, gpointer cfg)
           gtk_spin_button_set_value (GTK_SPIN_BUTTON (polarspin), val);
           val = sat_cfg_get_int_def (SAT_CFG_INT_SINGLE_SAT_REFRESH);
           gtk_spin_button_set_value (GTK_SPIN_BUTTON (singlespin), val);
+          gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (ephemcheck),
+                                        sat_cfg_get_bool_def (SAT_CFG_BOOL_EPHEM_CACHE));
      }
      else {
           /* local mode, get global value */
@@ -482,6 +532,8 @@ reset_cb               (GtkWidget *button, gpointer cfg)
           gtk_spin_button_set_value (GTK_SPIN_BUTTON (polarspin), val);
           val = sat_cfg_get_int (SAT_CFG_INT_SINGLE_SAT_REFRESH);
           gtk_spin_button_set_value (GTK_SPIN_BUTTON (singlespin), val);
+          gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON (ephemcheck),
+                                        sat_cfg_get_bool (SAT_CFG_BOOL_EPHEM_CACHE));
      }
 
 
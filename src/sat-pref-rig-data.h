@@ -39,6 +39,7 @@ typedef enum {
     RIG_LIST_COL_VFODOWN,   /*!< VFO down */
     RIG_LIST_COL_LO,        /*!< Local oscillator freq (downlink) */
     RIG_LIST_COL_LOUP,      /*!< Local oscillato freq (uplink) */
+    RIG_LIST_COL_FSTEP,     /*!< Frequency step (not shown) */
     RIG_LIST_COL_NUM        /*!< The number of fields in the list. */
 } rig_list_col_t;
 
@@ -59,6 +59,7 @@ static GtkWidget *ptt;      /* PTT */
 static GtkWidget *vfo;      /* VFO Up/Down selector */
 static GtkWidget *lo;       /* local oscillator of downconverter */
 static GtkWidget *loup;     /* local oscillator of upconverter */
+static GtkWidget *fstep;    /* frequency step */
 
 
 static GtkWidget    *create_editor_widgets (radio_conf_t *conf);
@@ -148,7 +149,7 @@ create_editor_widgets (radio_conf_t *conf)
 
 
 
-    table = gtk_table_new (8, 4, FALSE);
+    table = gtk_table_new (9, 4, FALSE);
     gtk_container_set_border_width (GTK_CONTAINER (table), 5);
     gtk_table_set_col_spacings (GTK_TABLE (table), 5);
     gtk_table_set_row_spacings (GTK_TABLE (table), 5);
@@ -315,6 +316,22 @@ create_editor_widgets (radio_conf_t *conf)
     gtk_misc_set_alignment (GTK_MISC (label), 0.0, 0.5);
     gtk_table_attach_defaults (GTK_TABLE (table), label, 3, 4, 7, 8);
     
+    /* Frequency step */
+    label = gtk_label_new (_("Freq. step:"));
+    gtk_misc_set_alignment (GTK_MISC (label), 1.0, 0.5);
+    gtk_table_attach_defaults (GTK_TABLE (table), label, 0, 1, 8, 9);
+    
+    fstep = gtk_spin_button_new_with_range (1, 10000, 1);
+    gtk_spin_button_set_value (GTK_SPIN_BUTTON (fstep), 1);
+    gtk_spin_button_set_digits (GTK_SPIN_BUTTON (fstep), 0);
+    gtk_widget_set_tooltip_text (fstep,
+                                 _("Enter the smallest frequency change that is "                                   "sent to the radio. A larger step reduces the "                                   "number of commands while tracking the Doppler "                                   "shift."));
+    gtk_table_attach_defaults (GTK_TABLE (table), fstep, 1, 3, 8, 9);
+    
+    label = gtk_label_new (_("Hz"));
+    gtk_misc_set_alignment (GTK_MISC (label), 0.0, 0.5);
+    gtk_table_attach_defaults (GTK_TABLE (table), label, 3, 4, 8, 9);
+    
     
     if (conf->name != NULL)
         update_widgets (conf);
@@ -368,6 +385,9 @@ update_widgets (radio_conf_t *conf)
     /* lo up in MHz */
     gtk_spin_button_set_value (GTK_SPIN_BUTTON (loup), conf->loup / 1000000.0);
 
+    /* frequency step in Hz */
+    gtk_spin_button_set_value (GTK_SPIN_BUTTON (fstep), conf->fstep);
+
 }
 
 
@@ -385,6 +405,7 @@ clear_widgets ()
     gtk_spin_button_set_value (GTK_SPIN_BUTTON (port), 4532); /* hamlib default? */
     gtk_spin_button_set_value (GTK_SPIN_BUTTON (lo), 0);
     gtk_spin_button_set_value (GTK_SPIN_BUTTON (loup), 0);
+    gtk_spin_button_set_value (GTK_SPIN_BUTTON (fstep), 1);
     gtk_combo_box_set_active (GTK_COMBO_BOX (type), RIG_TYPE_RX);
     gtk_combo_box_set_active (GTK_COMBO_BOX (ptt), PTT_TYPE_NONE);
     gtk_combo_box_set_active (GTK_COMBO_BOX (vfo), 0);
@@ -423,6 +444,9 @@ apply_changes         (radio_conf_t *conf)
     /* lo up freq */
     conf->loup = 1000000.0*gtk_spin_button_get_value (GTK_SPIN_BUTTON (loup));
     
+    /* frequency step */
+    conf->fstep = gtk_spin_button_get_value (GTK_SPIN_BUTTON (fstep));
+    
     /* rig type */
     conf->type = gtk_combo_box_get_active (GTK_COMBO_BOX (type));
     
@@ -247,7 +247,8 @@ static GtkTreeModel *create_and_fill_model ()
                                     G_TYPE_INT,       // VFO Up
                                     G_TYPE_INT,       // VFO Down
                                     G_TYPE_DOUBLE,    // LO DOWN
-                                    G_TYPE_DOUBLE     // LO UO
+                                    G_TYPE_DOUBLE,    // LO UO
+                                    G_TYPE_DOUBLE     // Freq step
                                    );
 
      gtk_tree_sortable_set_sort_column_id( GTK_TREE_SORTABLE(liststore),RIG_LIST_COL_NAME,GTK_SORT_ASCENDING);
@@ -277,6 +278,7 @@ static GtkTreeModel *create_and_fill_model ()
                                         RIG_LIST_COL_VFODOWN, conf.vfoDown,
                                         RIG_LIST_COL_LO, conf.lo,
                                         RIG_LIST_COL_LOUP, conf.loup,
+                                        RIG_LIST_COL_FSTEP, conf.fstep,
                                         -1);
                     
                     sat_log_log (SAT_LOG_LEVEL_DEBUG,
@@ -391,6 +393,7 @@ void sat_pref_rig_ok     ()
         .vfoDown = 0,
         .lo    = 0.0,
         .loup  = 0.0,
+        .fstep = 1.0,
     };
 
     
@@ -433,6 +436,7 @@ void sat_pref_rig_ok     ()
                                 RIG_LIST_COL_VFODOWN, &conf.vfoDown,
                                 RIG_LIST_COL_LO, &conf.lo,
                                 RIG_LIST_COL_LOUP, &conf.loup,
+                                RIG_LIST_COL_FSTEP, &conf.fstep,
                                 -1);
             radio_conf_save (&conf);
         
@@ -479,6 +483,7 @@ static void add_cb    (GtkWidget *button, gpointer data)
         .vfoDown = 0,
         .lo    = 0.0,
         .loup  = 0.0,
+        .fstep = 1.0,
     };
     
     /* run rig conf editor */
@@ -498,6 +503,7 @@ static void add_cb    (GtkWidget *button, gpointer data)
                             RIG_LIST_COL_VFODOWN, conf.vfoDown,
                             RIG_LIST_COL_LO, conf.lo,
                             RIG_LIST_COL_LOUP, conf.loup,
+                            RIG_LIST_COL_FSTEP, conf.fstep,
                             -1);
         
         g_free (conf.name);
@@ -536,6 +542,7 @@ static void edit_cb   (GtkWidget *button, gpointer data)
         .vfoDown = 0,
         .lo    = 0.0,
         .loup  = 0.0,
+        .fstep = 1.0,
     };
 
     
@@ -566,6 +573,7 @@ static void edit_cb   (GtkWidget *button, gpointer data)
                             RIG_LIST_COL_VFODOWN, &conf.vfoDown,
                             RIG_LIST_COL_LO, &conf.lo,
                             RIG_LIST_COL_LOUP, &conf.loup,
+                            RIG_LIST_COL_FSTEP, &conf.fstep,
                             -1);
 
     }
@@ -599,6 +607,7 @@ static void edit_cb   (GtkWidget *button, gpointer data)
                             RIG_LIST_COL_VFODOWN, conf.vfoDown,
                             RIG_LIST_COL_LO, conf.lo,
                             RIG_LIST_COL_LOUP, conf.loup,
+                            RIG_LIST_COL_FSTEP, conf.fstep,
                             -1);
         
     }
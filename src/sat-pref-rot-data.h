@@ -38,6 +38,9 @@ typedef enum {
     ROT_LIST_COL_MINEL,     /*!< Lower El limit. */
     ROT_LIST_COL_MAXEL,     /*!< Upper El limit. */
     ROT_LIST_COL_AZTYPE,    /*!< Azimuth type. */
+    ROT_LIST_COL_AZRATE,    /*!< Azimuth slew rate (not shown). */
+    ROT_LIST_COL_ELRATE,    /*!< Elevation slew rate (not shown). */
+    ROT_LIST_COL_LATENCY,   /*!< Command latency (not shown). */
     ROT_LIST_COL_NUM        /*!< The number of fields in the list. */
 } rotor_list_col_t;
 
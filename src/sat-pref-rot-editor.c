@@ -59,6 +59,9 @@ static GtkWidget *minaz;
 static GtkWidget *maxaz;
 static GtkWidget *minel;
 static GtkWidget *maxel;
+static GtkWidget *azrate;
+static GtkWidget *elrate;
+static GtkWidget *latency;
 
 
 static GtkWidget    *create_editor_widgets (rotor_conf_t *conf);
@@ -145,7 +148,7 @@ create_editor_widgets (rotor_conf_t *conf)
      GtkWidget    *label;
 
 
-     table = gtk_table_new (7, 4, FALSE);
+     table = gtk_table_new (10, 4, FALSE);
      gtk_container_set_border_width (GTK_CONTAINER (table), 5);
      gtk_table_set_col_spacings (GTK_TABLE (table), 5);
      gtk_table_set_row_spacings (GTK_TABLE (table), 5);
@@ -252,6 +255,46 @@ create_editor_widgets (rotor_conf_t *conf)
     gtk_spin_button_set_wrap (GTK_SPIN_BUTTON (maxel), FALSE);
     gtk_table_attach_defaults (GTK_TABLE (table), maxel, 3, 4, 6, 7);
     
+    gtk_table_attach_defaults (GTK_TABLE (table), gtk_hseparator_new(), 0, 4, 7, 8);
+    
+    /* Slew rates and latency */
+    label = gtk_label_new (_(" Az rate"));
+    gtk_misc_set_alignment (GTK_MISC (label), 1.0, 0.5);
+    gtk_table_attach_defaults (GTK_TABLE (table), label, 0, 1, 8, 9);
+    azrate = gtk_spin_button_new_with_range (0, 100, 0.1);
+    gtk_spin_button_set_value (GTK_SPIN_BUTTON (azrate), 0);
+    gtk_spin_button_set_digits (GTK_SPIN_BUTTON (azrate), 1);
+    gtk_spin_button_set_numeric (GTK_SPIN_BUTTON (azrate), TRUE);
+    gtk_widget_set_tooltip_text (azrate,
+                                 _("Azimuth slew rate of the rotator in \302\260/sec. "\
+                                   "Use 0 if it is not known."));
+    gtk_table_attach_defaults (GTK_TABLE (table), azrate, 1, 2, 8, 9);
+    
+    label = gtk_label_new (_(" El rate"));
+    gtk_misc_set_alignment (GTK_MISC (label), 1.0, 0.5);
+    gtk_table_attach_defaults (GTK_TABLE (table), label, 2, 3, 8, 9);
+    elrate = gtk_spin_button_new_with_range (0, 100, 0.1);
+    gtk_spin_button_set_value (GTK_SPIN_BUTTON (elrate), 0);
+    gtk_spin_button_set_digits (GTK_SPIN_BUTTON (elrate), 1);
+    gtk_spin_button_set_numeric (GTK_SPIN_BUTTON (elrate), TRUE);
+    gtk_widget_set_tooltip_text (elrate,
+                                 _("Elevation slew rate of the rotator in \302\260/sec. "\
+                                   "Use 0 if it is not known."));
+    gtk_table_attach_defaults (GTK_TABLE (table), elrate, 3, 4, 8, 9);
+    
+    label = gtk_label_new (_(" Latency"));
+    gtk_misc_set_alignment (GTK_MISC (label), 1.0, 0.5);
+    gtk_table_attach_defaults (GTK_TABLE (table), label, 0, 1, 9, 10);
+    latency = gtk_spin_button_new_with_range (0, 10, 0.1);
+    gtk_spin_button_set_value (GTK_SPIN_BUTTON (latency), 0);
+    gtk_spin_button_set_digits (GTK_SPIN_BUTTON (latency), 1);
+    gtk_spin_button_set_numeric (GTK_SPIN_BUTTON (latency), TRUE);
+    gtk_widget_set_tooltip_text (latency,
+                                 _("Time in seconds from sending a new position to the "\
+                                   "rotator until it starts moving. Gpredict commands "\
+                                   "the position this much ahead."));
+    gtk_table_attach_defaults (GTK_TABLE (table), latency, 1, 2, 9, 10);
+    
     if (conf->name != NULL)
           update_widgets (conf);
 
@@ -288,6 +331,10 @@ update_widgets (rotor_conf_t *conf)
     gtk_spin_button_set_value (GTK_SPIN_BUTTON (minel), conf->minel);
     gtk_spin_button_set_value (GTK_SPIN_BUTTON (maxel), conf->maxel);
     
+    /* slew rates and latency */
+    gtk_spin_button_set_value (GTK_SPIN_BUTTON (azrate), conf->azrate);
+    gtk_spin_button_set_value (GTK_SPIN_BUTTON (elrate), conf->elrate);
+    gtk_spin_button_set_value (GTK_SPIN_BUTTON (latency), conf->latency);
 
 }
 
@@ -309,6 +356,9 @@ clear_widgets ()
     gtk_spin_button_set_value (GTK_SPIN_BUTTON (maxaz), 360);
     gtk_spin_button_set_value (GTK_SPIN_BUTTON (minel), 0);
     gtk_spin_button_set_value (GTK_SPIN_BUTTON (maxel), 90);
+    gtk_spin_button_set_value (GTK_SPIN_BUTTON (azrate), 0);
+    gtk_spin_button_set_value (GTK_SPIN_BUTTON (elrate), 0);
+    gtk_spin_button_set_value (GTK_SPIN_BUTTON (latency), 0);
 }
 
 
@@ -346,6 +396,11 @@ apply_changes         (rotor_conf_t *conf)
     conf->minel = gtk_spin_button_get_value (GTK_SPIN_BUTTON (minel));
     conf->maxel = gtk_spin_button_get_value (GTK_SPIN_BUTTON (maxel));
     
+    /* slew rates and latency */
+    conf->azrate = gtk_spin_button_get_value (GTK_SPIN_BUTTON (azrate));
+    conf->elrate = gtk_spin_button_get_value (GTK_SPIN_BUTTON (elrate));
+    conf->latency = gtk_spin_button_get_value (GTK_SPIN_BUTTON (latency));
+    
      return TRUE;
 }
 
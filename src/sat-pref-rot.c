@@ -215,7 +215,10 @@ static GtkTreeModel *create_and_fill_model ()
                                     G_TYPE_DOUBLE,    // Max Az
                                     G_TYPE_DOUBLE,    // Min El
                                     G_TYPE_DOUBLE,    // Max El
-                                    G_TYPE_INT        // Az type
+                                    G_TYPE_INT,       // Az type
+                                    G_TYPE_DOUBLE,    // Az rate
+                                    G_TYPE_DOUBLE,    // El rate
+                                    G_TYPE_DOUBLE     // Latency
                                    );
      gtk_tree_sortable_set_sort_column_id( GTK_TREE_SORTABLE(liststore),ROT_LIST_COL_NAME,GTK_SORT_ASCENDING);
     /* open configuration directory */
@@ -243,6 +246,9 @@ static GtkTreeModel *create_and_fill_model ()
                                         ROT_LIST_COL_MINEL, conf.minel,
                                         ROT_LIST_COL_MAXEL, conf.maxel,
                                         ROT_LIST_COL_AZTYPE, conf.aztype,
+                                        ROT_LIST_COL_AZRATE, conf.azrate,
+                                        ROT_LIST_COL_ELRATE, conf.elrate,
+                                        ROT_LIST_COL_LATENCY, conf.latency,
                                         -1);
                     
                     sat_log_log (SAT_LOG_LEVEL_DEBUG,
@@ -355,6 +361,9 @@ void sat_pref_rot_ok     ()
         .minel = 0,
         .maxel = 90,
         .aztype = ROT_AZ_TYPE_360,
+        .azrate = 0,
+        .elrate = 0,
+        .latency = 0,
     };
 
     
@@ -396,6 +405,9 @@ void sat_pref_rot_ok     ()
                                 ROT_LIST_COL_MINEL, &conf.minel,
                                 ROT_LIST_COL_MAXEL, &conf.maxel,
                                 ROT_LIST_COL_AZTYPE, &conf.aztype,
+                                ROT_LIST_COL_AZRATE, &conf.azrate,
+                                ROT_LIST_COL_ELRATE, &conf.elrate,
+                                ROT_LIST_COL_LATENCY, &conf.latency,
                                 -1);
             rotor_conf_save (&conf);
         
@@ -440,6 +452,9 @@ static void add_cb    (GtkWidget *button, gpointer data)
         .minel = 0,
         .maxel = 90,
         .aztype = ROT_AZ_TYPE_360,
+        .azrate = 0,
+        .elrate = 0,
+        .latency = 0,
     };
     
     /* run rot conf editor */
@@ -458,6 +473,9 @@ static void add_cb    (GtkWidget *button, gpointer data)
                             ROT_LIST_COL_MINEL, conf.minel,
                             ROT_LIST_COL_MAXEL, conf.maxel,
                             ROT_LIST_COL_AZTYPE, conf.aztype,
+                            ROT_LIST_COL_AZRATE, conf.azrate,
+                            ROT_LIST_COL_ELRATE, conf.elrate,
+                            ROT_LIST_COL_LATENCY, conf.latency,
                             -1);
         
         g_free (conf.name);
@@ -495,6 +513,9 @@ static void edit_cb   (GtkWidget *button, gpointer data)
         .minel = 0,
         .maxel = 90,
         .aztype = ROT_AZ_TYPE_360,
+        .azrate = 0,
+        .elrate = 0,
+        .latency = 0,
     };
 
     
@@ -524,6 +545,9 @@ static void edit_cb   (GtkWidget *button, gpointer data)
                             ROT_LIST_COL_MINEL, &conf.minel,
                             ROT_LIST_COL_MAXEL, &conf.maxel,
                             ROT_LIST_COL_AZTYPE, &conf.aztype,
+                            ROT_LIST_COL_AZRATE, &conf.azrate,
+                            ROT_LIST_COL_ELRATE, &conf.elrate,
+                            ROT_LIST_COL_LATENCY, &conf.latency,
                             -1);
 
     }
@@ -556,6 +580,9 @@ static void edit_cb   (GtkWidget *button, gpointer data)
                             ROT_LIST_COL_MINEL, conf.minel,
                             ROT_LIST_COL_MAXEL, conf.maxel,
                             ROT_LIST_COL_AZTYPE, conf.aztype,
+                            ROT_LIST_COL_AZRATE, conf.azrate,
+                            ROT_LIST_COL_ELRATE, conf.elrate,
+                            ROT_LIST_COL_LATENCY, conf.latency,
                             -1);
         
     }
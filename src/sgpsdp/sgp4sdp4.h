@@ -116,16 +116,40 @@ typedef struct {
 	double dec;  /*!< Declination [dec] */
 } obs_astro_t;
 
-
-/* Common arguments between deep-space functions */
+/** \brief Observer frame at one instant.
+ *  \ingroup sgpsdpif
+ *
+ * Holds everything about the observer that Calculate_Obs() and friends
+ * would otherwise recompute for every satellite: the sines and cosines of
+ * the latitude and the ECEF position (set once per location by
+ * Obs_Frame_Init()), and the sidereal angle, the LMST and the ECI
+ * position and velocity of the observer (set once per time step by
+ * Obs_Frame_Set_Time()). All satellites observed at the same time from
+ * the same location can share one frame.
+ */
+typedef struct {
+	geodetic_t geodetic;   /*!< Observer; theta is the LMST [rad] */
+	double sin_lat;        /*!< sin of the latitude */
+	double cos_lat;        /*!< cos of the latitude */
+	double rxy;            /*!< ECEF distance from the earth axis [km] */
+	double rz;             /*!< ECEF z [km] */
+	double jul_utc;        /*!< Time of the frame (Julian date) */
+	double thetag;         /*!< Greenwich sidereal angle [rad] */
+	double sin_theta;      /*!< sin of the LMST */
+	double cos_theta;      /*!< cos of the LMST */
+	vector_t pos;          /*!< ECI position of the observer [km] */
+	vector_t vel;          /*!< ECI velocity of the observer [km/s] */
+} obs_frame_t;
+
+
+/* Common arguments between deep-space functions.
+   Only the values computed at initialization are kept here;
+   the per-evaluation values live in sgpsdp_state_t. */
 typedef struct {
 	/* Used by dpinit part of Deep() */
 	double eosq,sinio,cosio,betao,aodp,theta2,sing,cosg;
 	double betao2,xmdot,omgdot,xnodot,xnodp;
 
-	/* Used by dpsec and dpper parts of Deep() */
-	double xll,omgadf,xnode,em,xinc,xn,t;
-
 	/* Used by thetg and Deep() */
 	double ds50;
 } deep_arg_t;
@@ -139,16 +163,56 @@ typedef struct {
 
 /* static data for DEEP */
 typedef struct {
-	double thgr,xnq,xqncl,omegaq,zmol,zmos,savtsn,ee2,e3,xi2;
+	double thgr,xnq,xqncl,omegaq,zmol,zmos,ee2,e3,xi2;
 	double xl2,xl3,xl4,xgh2,xgh3,xgh4,xh2,xh3,sse,ssi,ssg,xi3;
 	double se2,si2,sl2,sgh2,sh2,se3,si3,sl3,sgh3,sh3,sl4,sgh4;
 	double ssl,ssh,d3210,d3222,d4410,d4422,d5220,d5232,d5421;
 	double d5433,del1,del2,del3,fasx2,fasx4,fasx6,xlamo,xfact;
-	double xni,atime,stepp,stepn,step2,preep,pl,sghs,xli;
-	double d2201,d2211,sghl,sh1,pinc,pe,shs,zsingl,zcosgl;
+	double stepp,stepn,step2,preep;
+	double d2201,d2211,zsingl,zcosgl;
 	double zsinhl,zcoshl,zsinil,zcosil;
 } deep_static_t;
 
+/** \brief Propagator model.
+ *  \ingroup sgpsdpif
+ *
+ * The constant part of the SGP4/SDP4 propagator for one set of
+ * elements. It is computed once by select_ephemeris() and never
+ * modified afterwards, so one model can be shared between any number
+ * of sat_t copies and threads.
+ */
+typedef struct {
+	tle_t           tle;       /*!< Preprocessed Keplerian elements */
+	int             flags;     /*!< Ephemeris and resonance flags */
+	sgpsdp_static_t sgps;
+	deep_static_t   dps;
+	deep_arg_t      deep_arg;
+} sgpsdp_model_t;
+
+/** \brief Propagator state.
+ *  \ingroup sgpsdpif
+ *
+ * The part of the propagator that changes from one evaluation to
+ * the next: the output vectors, the deep-space intermediate values,
+ * the resonance integrator and the lunar-solar periodics cache.
+ * Use Init_State() to reset it for a given model.
+ */
+typedef struct {
+	vector_t pos;              /*!< Raw position */
+	vector_t vel;              /*!< Raw velocity */
+	double   phase;            /*!< Orbit phase */
+	double   omegao1,xincl1,xnodeo1;
+
+	/* Used by dpsec and dpper parts of Deep() */
+	double   xll,omgadf,xnode,em,xinc,xn,t;
+
+	/* Resonance integrator */
+	double   xli,xni,atime;
+
+	/* Lunar-solar periodics, recomputed every 30 minutes */
+	double   savtsn,sghs,shs,sghl,sh1,pe,pinc,pl;
+} sgpsdp_state_t;
+
 /** \brief Satellite data structure
  *  \ingroup sgpsdpif
  *
@@ -159,9 +223,8 @@ typedef struct {
         char           *website;
 	tle_t           tle;     /*!< Keplerian elements */
 	int             flags;   /*!< Flags for algo ctrl */
-	sgpsdp_static_t sgps;
-	deep_static_t   dps;
-	deep_arg_t      deep_arg;
+	sgpsdp_model_t *model;   /*!< Shared propagator model */
+	sgpsdp_state_t  state;   /*!< Propagator state */
 	vector_t        pos;       /*!< Raw position and range */
 	vector_t        vel;       /*!< Raw velocity */
 
@@ -265,7 +328,9 @@ FIXME: Change to enu */
 #define CR  0x0A
 #define LF  0x0D
 
-/* Flow control flag definitions */
+/* Flow control flag definitions.
+   These are kept in sat_t::flags; there is no global flag word, so the
+   propagator may be called concurrently for different satellites. */
 #define ALL_FLAGS              -1
 #define SGP_INITIALIZED_FLAG   0x000001
 #define SGP4_INITIALIZED_FLAG  0x000002
@@ -290,11 +355,21 @@ FIXME: Change to enu */
 /* sgp4sdp4.c */
 void    SGP4 (sat_t *sat, double tsince);
 void    SDP4 (sat_t *sat, double tsince);
-void    Deep (int ientry, sat_t *sat);
-int     isFlagSet(int flag);
-int     isFlagClear(int flag);
-void    SetFlag(int flag);
-void    ClearFlag(int flag);
+void    SGP4_Model (const sgpsdp_model_t *model, sgpsdp_state_t *state,
+                    double tsince);
+void    SDP4_Model (const sgpsdp_model_t *model, sgpsdp_state_t *state,
+                    double tsince);
+void    Deep (int ientry, const sgpsdp_model_t *model, sgpsdp_state_t *state);
+void    Init_Model (sgpsdp_model_t *model);
+void    Init_State (const sgpsdp_model_t *model, sgpsdp_state_t *state);
+void    Sat_From_State (sat_t *sat);
+
+/* sgp_event.c */
+double  Find_Crossing(sat_t *sat, geodetic_t *obs, double start, double maxdt,
+                      double min_el, int rising);
+double  Find_Max_Elevation(sat_t *sat, geodetic_t *obs, double a, double b,
+                           double *max_el);
+double  Find_Eclipse(sat_t *sat, double start, double maxdt, int entry);
 
 /* sgp_in.c */
 int     Checksum_Good(char *tle_set);
@@ -302,6 +377,8 @@ int     Good_Elements(char *tle_set);
 void    Convert_Satellite_Data(char *tle_set, tle_t *tle);
 int     Get_Next_Tle_Set( char lines[3][80], tle_t *tle );
 void    select_ephemeris(sat_t *sat);
+void    rebuild_ephemeris(sat_t *sat);
+void    free_ephemeris(sat_t *sat);
 
 /* sgp_math.c */
 int     Sign(double arg);
@@ -334,8 +411,21 @@ void    Calculate_User_PosVel(double _time, geodetic_t *geodetic,
 void    Calculate_LatLonAlt(double _time, vector_t *pos, geodetic_t *geodetic);
 void    Calculate_Obs(double _time, vector_t *pos, vector_t *vel,
                       geodetic_t *geodetic, obs_set_t *obs_set);
+void    Calculate_User_PosVel_ThetaG(double thetag, geodetic_t *geodetic,
+                                     vector_t *obs_pos, vector_t *obs_vel);
+void    Calculate_LatLonAlt_ThetaG(double thetag, vector_t *pos,
+                                   geodetic_t *geodetic);
+void    Calculate_Obs_ThetaG(double thetag, vector_t *pos, vector_t *vel,
+                             geodetic_t *geodetic, obs_set_t *obs_set);
 void    Calculate_RADec_and_Obs(double _time, vector_t *pos, vector_t *vel,
 				geodetic_t *geodetic, obs_astro_t *obs_set);
+void    Obs_Frame_Init(obs_frame_t *frame, const geodetic_t *geodetic);
+void    Obs_Frame_Set_Time(obs_frame_t *frame, double _time);
+void    Obs_Frame_Set_ThetaG(obs_frame_t *frame, double _time, double thetag);
+void    Calculate_Obs_Frame(const obs_frame_t *frame, const vector_t *pos,
+                            const vector_t *vel, obs_set_t *obs_set);
+void    Calculate_RADec_Frame(const obs_frame_t *frame, double az, double el,
+                              obs_astro_t *obs_set);
 
 /* sgp_time.c */
 double  Julian_Date_of_Epoch(double epoch);
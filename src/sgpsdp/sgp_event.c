@@ -0,0 +1,549 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: t; c-basic-offset: 4 -*- */
+/*
+ * Unit SGP_Event
+ *
+ * Horizon crossing (AOS/LOS) solver. The crossings are bracketed by
+ * stepping through time with steps that are as long as possible without
+ * skipping a pass, and then refined with Brent's method on the elevation.
+ *
+ * The step length follows from the geometry: the satellite is above the
+ * elevation limit only while the geocentric angle between observer and
+ * satellite is smaller than the half angle of the footprint. This angle
+ * can not change faster than the angular rate of the satellite around the
+ * earth plus the rotation rate of the earth, so the time until the next
+ * crossing is at least the angular distance to the footprint edge divided
+ * by that rate. In addition, the satellite can not be closer to the
+ * observer than the angular distance between the observer and the orbital
+ * plane, and this distance changes with the rotation of the earth, which
+ * is much slower. The longer of the two steps is used.
+ *
+ * Close to the footprint edge the steps are never shorter than a fixed
+ * fraction of the orbital period. Short grazing passes between two such
+ * steps are found by looking for the maximum elevation whenever three
+ * consecutive samples have a local maximum just below the limit.
+ *
+ * Umbra entries and exits are found the same way on the eclipse depth of
+ * Sat_Eclipsed(). The depth is an angle that can not change faster than
+ * the angular rate of the satellite around the earth plus the motion of
+ * the sun and the change of the apparent radius of the earth, which gives
+ * the step length.
+ */
+
+#include "sgp4sdp4.h"
+
+/* Search parameters */
+#define EVENT_STEPS_PER_ORBIT  180      /* shortest step = period / 180 */
+#define EVENT_MARGIN           1.75E-2  /* rad (1 deg) for non-spherical earth */
+#define EVENT_TOL              5.8E-7   /* days (0.05 sec) */
+#define EVENT_MAX_STEPS        100000   /* watchdog for the bracketing */
+#define EVENT_MAX_ITER         50       /* watchdog for the refinement */
+#define EVENT_GRAZE            2.0      /* degrees; look for grazing passes */
+#define ECLIPSE_SUN_RATE       1.9E-2   /* rad/day; motion of the sun with slack */
+
+/* Bounds used for the step length of one satellite */
+typedef struct {
+	double  lmax_far;   /* footprint half angle at apogee (radians) */
+	double  lmax_near;  /* footprint half angle at perigee (radians) */
+	double  rate;       /* upper limit of the angular rate (radians/day) */
+	double  plane_rate; /* upper limit of the rate of the observer to */
+	                    /* orbital plane distance (radians/day)       */
+	double  min_step;   /* shortest step (days) */
+} event_bound_t;
+
+typedef struct event_search_s event_search_t;
+
+/* Value whose sign changes at the events, at time t (Julian date) */
+typedef double (*event_value_t)(sat_t *sat, event_search_t *search, double t);
+
+/* Longest step that can not skip an event, for the current value f */
+typedef double (*event_step_t)(sat_t *sat, event_search_t *search, double f);
+
+/* One search for events */
+struct event_search_s {
+	event_value_t value;  /* event function */
+	event_step_t  step;   /* step length */
+	event_bound_t bound;  /* bounds of the step length */
+	obs_frame_t   frame;  /* observer of horizon crossings */
+	double        limit;  /* elevation limit (degrees) */
+	double        graze;  /* local maxima above -graze are searched */
+};
+
+/*------------------------------------------------------------------*/
+
+/* Moves the position and velocity of sat to time t (Julian date) */
+static void
+Propagate(sat_t *sat, double t)
+{
+	sat->jul_utc = t;
+	sat->tsince = (t - sat->jul_epoch) * xmnpda;
+
+	if (sat->flags & DEEP_SPACE_EPHEM_FLAG)
+		SDP4(sat, sat->tsince);
+	else
+		SGP4(sat, sat->tsince);
+
+	Convert_Sat_State(&sat->pos, &sat->vel);
+} /*Procedure Propagate*/
+
+/*------------------------------------------------------------------*/
+
+/* Returns the elevation of sat in degrees above the limit at time  */
+/* t (Julian date). The position, velocity and elevation of sat are */
+/* updated, but not the other derived values. The observer frame    */
+/* is moved to t.                                                   */
+static double
+Elevation_Above(sat_t *sat, event_search_t *search, double t)
+{
+	obs_set_t obs_set;
+
+	Propagate(sat, t);
+	Obs_Frame_Set_Time(&search->frame, t);
+	Calculate_Obs_Frame(&search->frame, &sat->pos, &sat->vel, &obs_set);
+	sat->el = Degrees(obs_set.el);
+
+	return sat->el - search->limit;
+} /*Function Elevation_Above*/
+
+/*------------------------------------------------------------------*/
+
+/* Returns the eclipse depth of sat (radians) at time t (Julian  */
+/* date), positive in the umbra. The position and velocity of    */
+/* sat are updated.                                              */
+static double
+Eclipse_Depth(sat_t *sat, event_search_t *search, double t)
+{
+	vector_t sun;
+	double depth;
+
+	(void) search;
+
+	Propagate(sat, t);
+	Calculate_Solar_Position(t, &sun);
+	Sat_Eclipsed(&sat->pos, &sun, &depth);
+
+	return depth;
+} /*Function Eclipse_Depth*/
+
+/*------------------------------------------------------------------*/
+
+/* Half angle of the footprint of a satellite at distance r (km) */
+/* from the centre of the earth for elevation el (radians)       */
+static double
+Footprint_Angle(double r, double el)
+{
+	double c = xkmper / r * cos(el);
+
+	if (c > 1.0)
+		c = 1.0;
+
+	return acos(c) - el;
+} /*Function Footprint_Angle*/
+
+/*------------------------------------------------------------------*/
+
+/* Calculates the step bounds for sat and elevation limit min_el */
+static void
+Event_Bounds(sat_t *sat, double min_el, event_bound_t *bound)
+{
+	double a,e,n,r_apo,r_peri;
+
+	/* semi-major axis (km) and mean motion (rad/day) from the TLE; */
+	/* the slack covers the periodic perturbations                  */
+	e = sat->tle.eo;
+	n = sat->tle.xno * xmnpda;
+	a = pow(xke / sat->tle.xno, tothrd) * xkmper;
+	r_apo = 1.02 * a * (1.0 + e);
+	r_peri = 0.98 * a * (1.0 - e);
+
+	bound->lmax_far = Footprint_Angle(r_apo, Radians(min_el));
+	bound->lmax_near = Footprint_Angle(r_peri, Radians(min_el));
+
+	/* the angular rate peaks at perigee */
+	bound->rate = 1.1 * n * Sqr(1.0 + e) / pow(1.0 - e * e, 1.5) +
+		twopi * omega_E;
+	/* rotation of the earth plus a generous allowance for the */
+	/* precession of the orbital plane                         */
+	bound->plane_rate = 1.2 * twopi * omega_E;
+	bound->min_step = twopi / n / EVENT_STEPS_PER_ORBIT;
+} /*Procedure Event_Bounds*/
+
+/*------------------------------------------------------------------*/
+
+/* Calculates the step bounds of an eclipse search for sat */
+static void
+Eclipse_Bounds(sat_t *sat, event_bound_t *bound)
+{
+	double a,e,n,r_peri,rdot;
+
+	e = sat->tle.eo;
+	n = sat->tle.xno * xmnpda;
+	a = pow(xke / sat->tle.xno, tothrd) * xkmper;
+	r_peri = 0.98 * a * (1.0 - e);
+	if (r_peri < 1.01 * xkmper)
+		r_peri = 1.01 * xkmper;
+
+	/* largest radial velocity (km/day) */
+	rdot = 1.1 * n * a * e / sqrt(1.0 - e * e);
+
+	/* angular rate of the satellite around the earth, the motion */
+	/* of the sun and the rate of the apparent earth radius       */
+	bound->rate = 1.1 * n * Sqr(1.0 + e) / pow(1.0 - e * e, 1.5) +
+		ECLIPSE_SUN_RATE +
+		xkmper * rdot / (r_peri * sqrt(Sqr(r_peri) - Sqr(xkmper)));
+	bound->lmax_far = 0.0;
+	bound->lmax_near = 0.0;
+	bound->plane_rate = 0.0;
+	bound->min_step = twopi / n / EVENT_STEPS_PER_ORBIT;
+} /*Procedure Eclipse_Bounds*/
+
+/*------------------------------------------------------------------*/
+
+/* Returns the longest time step from the current position of sat */
+/* that can not skip a crossing. f is the current return value of */
+/* Elevation_Above, which has also moved the frame to that time.  */
+static double
+Event_Step(sat_t *sat, event_search_t *search, double f)
+{
+	const event_bound_t *bound = &search->bound;
+	const obs_frame_t *frame = &search->frame;
+	vector_t h,u;
+	double lambda,delta,dist,dt;
+
+	lambda = Footprint_Angle(sat->pos.w, Radians(sat->el));
+
+	if (f >= 0.0) {
+		dist = bound->lmax_near - lambda - EVENT_MARGIN;
+		dt = dist / bound->rate;
+	}
+	else {
+		dist = lambda - bound->lmax_far - EVENT_MARGIN;
+		dt = dist / bound->rate;
+
+		/* angular distance between observer and orbital plane */
+		Cross(&sat->pos, &sat->vel, &h);
+		u.x = frame->cos_lat * frame->cos_theta;
+		u.y = frame->cos_lat * frame->sin_theta;
+		u.z = frame->sin_lat;
+		delta = asin(fabs(Dot(&u, &h)) / h.w);
+
+		dist = delta - bound->lmax_far - EVENT_MARGIN;
+		if (dist / bound->plane_rate > dt)
+			dt = dist / bound->plane_rate;
+	}
+
+	if (dt < bound->min_step)
+		return bound->min_step;
+
+	return dt;
+} /*Function Event_Step*/
+
+/*------------------------------------------------------------------*/
+
+/* Returns the longest time step from the current position of sat */
+/* that can not skip an umbra entry or exit. f is the current     */
+/* return value of Eclipse_Depth.                                 */
+static double
+Eclipse_Step(sat_t *sat, event_search_t *search, double f)
+{
+	double dt;
+
+	(void) sat;
+
+	dt = fabs(f) / search->bound.rate;
+	if (dt < search->bound.min_step)
+		return search->bound.min_step;
+
+	return dt;
+} /*Function Eclipse_Step*/
+
+/*------------------------------------------------------------------*/
+
+/* Refines the crossing bracketed by a and b with Brent's method */
+static double
+Refine_Crossing(sat_t *sat, event_search_t *search,
+		double a, double fa, double b, double fb)
+{
+	double c,fc,d,e,p,q,r,s,tol,xm;
+	int iter;
+
+	c = b;
+	fc = fb;
+	d = e = b - a;
+
+	for (iter = 0; iter < EVENT_MAX_ITER; iter++) {
+		/* keep the root between b and c */
+		if ((fb > 0.0 && fc > 0.0) || (fb < 0.0 && fc < 0.0)) {
+			c = a;
+			fc = fa;
+			d = e = b - a;
+		}
+		/* b is the best estimate so far */
+		if (fabs(fc) < fabs(fb)) {
+			a = b;
+			b = c;
+			c = a;
+			fa = fb;
+			fb = fc;
+			fc = fa;
+		}
+
+		tol = 0.5 * EVENT_TOL;
+		xm = 0.5 * (c - b);
+		if (fabs(xm) <= tol || fb == 0.0)
+			return b;
+
+		if (fabs(e) >= tol && fabs(fa) > fabs(fb)) {
+			s = fb / fa;
+			if (a == c) {
+				/* secant step */
+				p = 2.0 * xm * s;
+				q = 1.0 - s;
+			}
+			else {
+				/* inverse quadratic interpolation */
+				q = fa / fc;
+				r = fb / fc;
+				p = s * (2.0 * xm * q * (q - r) - (b - a) * (r - 1.0));
+				q = (q - 1.0) * (r - 1.0) * (s - 1.0);
+			}
+			if (p > 0.0)
+				q = -q;
+			p = fabs(p);
+
+			/* accept the interpolation only if it behaves */
+			if (2.0 * p < 3.0 * xm * q - fabs(tol * q) &&
+			    2.0 * p < fabs(e * q)) {
+				e = d;
+				d = p / q;
+			}
+			else {
+				d = xm;
+				e = d;
+			}
+		}
+		else {
+			/* bisection step */
+			d = xm;
+			e = d;
+		}
+
+		a = b;
+		fa = fb;
+		if (fabs(d) > tol)
+			b += d;
+		else
+			b += (xm > 0.0) ? tol : -tol;
+		fb = search->value(sat, search, b);
+	}
+
+	return b;
+} /*Function Refine_Crossing*/
+
+/*------------------------------------------------------------------*/
+
+/* Finds the maximum of the event function between a and b with a */
+/* golden section search and returns its time; the maximum is put */
+/* in fmax. If early is non-zero, the search stops as soon as the */
+/* function is no longer negative.                                */
+static double
+Max_Value(sat_t *sat, event_search_t *search,
+	  double a, double b, double *fmax, int early)
+{
+	const double g = 0.38196601125;  /* 2 - golden ratio */
+	double x1,x2,f1,f2;
+	int iter;
+
+	x1 = a + g * (b - a);
+	x2 = b - g * (b - a);
+	f1 = search->value(sat, search, x1);
+	f2 = search->value(sat, search, x2);
+
+	for (iter = 0; iter < EVENT_MAX_ITER && b - a > EVENT_TOL; iter++) {
+		/* stop as soon as the limit is reached */
+		if (early && (f1 >= 0.0 || f2 >= 0.0))
+			break;
+
+		if (f1 > f2) {
+			b = x2;
+			x2 = x1;
+			f2 = f1;
+			x1 = a + g * (b - a);
+			f1 = search->value(sat, search, x1);
+		}
+		else {
+			a = x1;
+			x1 = x2;
+			f1 = f2;
+			x2 = b - g * (b - a);
+			f2 = search->value(sat, search, x2);
+		}
+	}
+
+	if (f1 > f2) {
+		*fmax = f1;
+		return x1;
+	}
+
+	*fmax = f2;
+	return x2;
+} /*Function Max_Value*/
+
+/*------------------------------------------------------------------*/
+
+/* Returns the first time (Julian date) after start where the event */
+/* function of search becomes non-negative if rising is non-zero or */
+/* negative otherwise. See Find_Crossing for maxdt.                 */
+static double
+Search_Crossing(sat_t *sat, event_search_t *search, double start,
+		double maxdt, int rising)
+{
+	double t,f,tn,fn,tp,fp,end;
+	double ta,fa,tb,fb,tm,fm;
+	int dir,steps;
+
+	dir = (maxdt < 0.0) ? -1 : 1;
+	end = start + maxdt;
+
+	t = start;
+	f = search->value(sat, search, t);
+	tp = t;
+	fp = 0.0;
+
+	/* close to the limit, a sample behind the start tells whether a   */
+	/* grazing pass may begin right at the start, e.g. when the search */
+	/* for the LOS starts at the AOS of a grazing pass                 */
+	if (f < 0.0 && f > -search->graze) {
+		tp = t - dir * search->bound.min_step;
+		fp = search->value(sat, search, tp);
+		f = search->value(sat, search, t);
+	}
+
+	for (steps = 0; steps < EVENT_MAX_STEPS; steps++) {
+		tn = t + dir * search->step(sat, search, f);
+		if (maxdt != 0.0 && dir * (tn - end) > 0.0)
+			tn = end;
+		fn = search->value(sat, search, tn);
+
+		/* order the interval forward in time */
+		if (dir > 0) {
+			ta = t; fa = f;
+			tb = tn; fb = fn;
+		}
+		else {
+			ta = tn; fa = fn;
+			tb = t; fb = f;
+		}
+
+		if (rising && fa < 0.0 && fb >= 0.0)
+			return Refine_Crossing(sat, search, ta, fa, tb, fb);
+		if (!rising && fa >= 0.0 && fb < 0.0)
+			return Refine_Crossing(sat, search, ta, fa, tb, fb);
+
+		/* a grazing pass may hide between the last three samples; */
+		/* in the first step it is not searched before the start   */
+		if (tp != t && fp < 0.0 && fn < 0.0 &&
+		    f > fp && f > fn && f > -search->graze) {
+			if (steps == 0) {
+				tp = t;
+				fp = f;
+			}
+			ta = (dir > 0) ? tp : tn;
+			fa = (dir > 0) ? fp : fn;
+			tb = (dir > 0) ? tn : tp;
+			fb = (dir > 0) ? fn : fp;
+			tm = Max_Value(sat, search, ta, tb, &fm, 1);
+			if (fm >= 0.0) {
+				if (rising)
+					return Refine_Crossing(sat, search, ta, fa, tm, fm);
+				else
+					return Refine_Crossing(sat, search, tm, fm, tb, fb);
+			}
+		}
+
+		if (tn == end)
+			break;
+
+		tp = t;
+		fp = f;
+		t = tn;
+		f = fn;
+	}
+
+	return 0.0;
+} /*Function Search_Crossing*/
+
+/*------------------------------------------------------------------*/
+
+/* Function Find_Crossing returns the first time (Julian date) after */
+/* start where the elevation of sat seen from obs crosses min_el     */
+/* (degrees), upwards if rising is non-zero (AOS) or downwards (LOS).*/
+/* The search covers maxdt days forward in time or, for negative     */
+/* maxdt, backward in time; maxdt = 0 means no limit forward in time.*/
+/* Returns 0.0 if there is no crossing. The position, velocity and   */
+/* elevation of sat are left at the last time evaluated, the other   */
+/* derived values are not updated.                                   */
+double
+Find_Crossing(sat_t *sat, geodetic_t *obs, double start, double maxdt,
+	      double min_el, int rising)
+{
+	event_search_t search;
+
+	search.value = Elevation_Above;
+	search.step = Event_Step;
+	search.limit = min_el;
+	search.graze = EVENT_GRAZE;
+	Event_Bounds(sat, min_el, &search.bound);
+	Obs_Frame_Init(&search.frame, obs);
+
+	return Search_Crossing(sat, &search, start, maxdt, rising);
+} /*Function Find_Crossing*/
+
+/*------------------------------------------------------------------*/
+
+/* Function Find_Max_Elevation returns the time (Julian date) of the */
+/* maximum elevation of sat seen from obs between the times a and b, */
+/* e.g. the AOS and LOS of a pass. The elevation is assumed to have a */
+/* single maximum in the interval; the maximum (degrees) is put in   */
+/* max_el. The position, velocity and elevation of sat are left at   */
+/* the last time evaluated, the other derived values are not updated.*/
+double
+Find_Max_Elevation(sat_t *sat, geodetic_t *obs, double a, double b,
+		   double *max_el)
+{
+	event_search_t search;
+	double t;
+
+	search.value = Elevation_Above;
+	search.limit = 0.0;
+	Obs_Frame_Init(&search.frame, obs);
+	t = Max_Value(sat, &search, a, b, max_el, 0);
+
+	return t;
+} /*Function Find_Max_Elevation*/
+
+/*------------------------------------------------------------------*/
+
+/* Function Find_Eclipse returns the first time (Julian date) after */
+/* start where sat enters the umbra of the earth if entry is non-   */
+/* zero, or leaves it otherwise, using the eclipse depth of         */
+/* Sat_Eclipsed. maxdt has the same meaning as for Find_Crossing,   */
+/* but should not be 0 since some orbits stay in sunlight for       */
+/* months. Returns 0.0 if there is no such event. The position and  */
+/* velocity of sat are left at the last time evaluated.             */
+double
+Find_Eclipse(sat_t *sat, double start, double maxdt, int entry)
+{
+	event_search_t search;
+
+	search.value = Eclipse_Depth;
+	search.step = Eclipse_Step;
+	search.limit = 0.0;
+	Eclipse_Bounds(sat, &search.bound);
+
+	/* the depth can change this much between two shortest steps */
+	search.graze = search.bound.rate * search.bound.min_step;
+
+	return Search_Crossing(sat, &search, start, maxdt, entry);
+} /*Function Find_Eclipse*/
+
+/*------------------------------------------------------------------*/
@@ -342,6 +342,8 @@ Get_Next_Tle_Set (char line[3][80], tle_t *tle)
 /* for predictions according to the data in the TLE */
 /* It also processes values in the tle set so that  */
 /* they are apropriate for the sgp4/sdp4 routines   */
+/* and builds the read-only propagator model, which */
+/* must be released with free_ephemeris().          */
 void
 select_ephemeris (sat_t *sat)
 {
@@ -382,8 +384,39 @@ select_ephemeris (sat_t *sat)
 	else
 		sat->flags &= ~DEEP_SPACE_EPHEM_FLAG;
 
+	/* Build the model; sat_t copies made with memcpy share it */
+	rebuild_ephemeris (sat);
+
 	return;
 } /* End of select_ephemeris() */
 
 /*------------------------------------------------------------------*/
 
+/* Builds a new propagator model for a satellite whose  */
+/* tle set has already been processed by               */
+/* select_ephemeris(), e.g. a copy that must not share */
+/* the model of the original. The propagator state is  */
+/* reset. The model must be released with              */
+/* free_ephemeris().                                   */
+void
+rebuild_ephemeris (sat_t *sat)
+{
+	sat->model = g_new0 (sgpsdp_model_t, 1);
+	sat->model->tle = sat->tle;
+	sat->model->flags = sat->flags & DEEP_SPACE_EPHEM_FLAG;
+	Init_Model (sat->model);
+	Init_State (sat->model, &sat->state);
+} /* End of rebuild_ephemeris() */
+
+/*------------------------------------------------------------------*/
+
+/* Releases the propagator model created by select_ephemeris() */
+void
+free_ephemeris (sat_t *sat)
+{
+	g_free (sat->model);
+	sat->model = NULL;
+} /* End of free_ephemeris() */
+
+/*------------------------------------------------------------------*/
+
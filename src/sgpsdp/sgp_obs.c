@@ -22,23 +22,29 @@ Calculate_User_PosVel(double _time,
                       vector_t *obs_pos,
                       vector_t *obs_vel)
 {
-/* Reference:  The 1992 Astronomical Almanac, page K11. */
+	Calculate_User_PosVel_ThetaG(ThetaG_JD(_time), geodetic, obs_pos, obs_vel);
+} /*Procedure Calculate_User_PosVel*/
 
-	double c,sq,achcp;
+/*------------------------------------------------------------------*/
 
-	geodetic->theta = FMod2p(ThetaG_JD(_time) + geodetic->lon);/*LMST*/
-	c = 1/sqrt(1 + __f*(__f - 2)*Sqr(sin(geodetic->lat)));
-	sq = Sqr(1 - __f)*c;
-	achcp = (xkmper*c + geodetic->alt)*cos(geodetic->lat);
-	obs_pos->x = achcp*cos(geodetic->theta);/*kilometers*/
-	obs_pos->y = achcp*sin(geodetic->theta);
-	obs_pos->z = (xkmper*sq + geodetic->alt)*sin(geodetic->lat);
-	obs_vel->x = -mfactor*obs_pos->y;/*kilometers/second*/
-	obs_vel->y =  mfactor*obs_pos->x;
-	obs_vel->z =  0;
-	Magnitude(obs_pos);
-	Magnitude(obs_vel);
-} /*Procedure Calculate_User_PosVel*/
+/* Same as Calculate_User_PosVel but takes the Greenwich sidereal */
+/* time thetag = ThetaG_JD(time) instead of the time, so callers  */
+/* that need it more than once per time step compute it only once */
+void
+Calculate_User_PosVel_ThetaG(double thetag,
+                             geodetic_t *geodetic,
+                             vector_t *obs_pos,
+                             vector_t *obs_vel)
+{
+	obs_frame_t frame;
+
+	Obs_Frame_Init(&frame, geodetic);
+	Obs_Frame_Set_ThetaG(&frame, 0.0, thetag);
+
+	geodetic->theta = frame.geodetic.theta;
+	*obs_pos = frame.pos;
+	*obs_vel = frame.vel;
+} /*Procedure Calculate_User_PosVel_ThetaG*/
 
 /*------------------------------------------------------------------*/
 
@@ -49,13 +55,22 @@ Calculate_User_PosVel(double _time,
 /* oblate spheroid as defined in WGS '72.                     */
 void
 Calculate_LatLonAlt(double _time, vector_t *pos,  geodetic_t *geodetic)
+{
+	Calculate_LatLonAlt_ThetaG(ThetaG_JD(_time), pos, geodetic);
+} /*Procedure Calculate_LatLonAlt*/
+
+/*------------------------------------------------------------------*/
+
+/* Same as Calculate_LatLonAlt but takes thetag = ThetaG_JD(time) */
+void
+Calculate_LatLonAlt_ThetaG(double thetag, vector_t *pos,  geodetic_t *geodetic)
 {
 	/* Reference:  The 1992 Astronomical Almanac, page K12. */
 
 	double r,e2,phi,c;
 
 	geodetic->theta = AcTan(pos->y,pos->x);/*radians*/
-	geodetic->lon = FMod2p(geodetic->theta - ThetaG_JD(_time));/*radians*/
+	geodetic->lon = FMod2p(geodetic->theta - thetag);/*radians*/
 	r = sqrt(Sqr(pos->x) + Sqr(pos->y));
 	e2 = __f*(2 - __f);
 	geodetic->lat = AcTan(pos->z,r);/*radians*/
@@ -72,7 +87,7 @@ Calculate_LatLonAlt(double _time, vector_t *pos,  geodetic_t *geodetic)
 
 	if( geodetic->lat > pio2 ) geodetic->lat -= twopi;
   
-} /*Procedure Calculate_LatLonAlt*/
+} /*Procedure Calculate_LatLonAlt_ThetaG*/
 
 /*------------------------------------------------------------------*/
 
@@ -98,6 +113,97 @@ Calculate_Obs(double _time,
 	      vector_t *vel,
 	      geodetic_t *geodetic,
 	      obs_set_t *obs_set)
+{
+	Calculate_Obs_ThetaG(ThetaG_JD(_time), pos, vel, geodetic, obs_set);
+} /*Procedure Calculate_Obs*/
+
+/*------------------------------------------------------------------*/
+
+/* Same as Calculate_Obs but takes thetag = ThetaG_JD(time) */
+void
+Calculate_Obs_ThetaG(double thetag,
+		     vector_t *pos,
+		     vector_t *vel,
+		     geodetic_t *geodetic,
+		     obs_set_t *obs_set)
+{
+	obs_frame_t frame;
+
+	Obs_Frame_Init(&frame, geodetic);
+	Obs_Frame_Set_ThetaG(&frame, 0.0, thetag);
+	Calculate_Obs_Frame(&frame, pos, vel, obs_set);
+
+	geodetic->theta = frame.geodetic.theta;
+} /*Procedure Calculate_Obs_ThetaG*/
+
+/*------------------------------------------------------------------*/
+
+/* Procedure Obs_Frame_Init sets up the parts of the observer frame */
+/* that only depend on the geodetic position of the observer. The   */
+/* frame must be given a time with Obs_Frame_Set_Time before use.   */
+void
+Obs_Frame_Init(obs_frame_t *frame, const geodetic_t *geodetic)
+{
+/* Reference:  The 1992 Astronomical Almanac, page K11. */
+
+	double c,sq;
+
+	frame->geodetic = *geodetic;
+	frame->sin_lat = sin(geodetic->lat);
+	frame->cos_lat = cos(geodetic->lat);
+
+	c = 1/sqrt(1 + __f*(__f - 2)*Sqr(frame->sin_lat));
+	sq = Sqr(1 - __f)*c;
+	frame->rxy = (xkmper*c + geodetic->alt)*frame->cos_lat;
+	frame->rz = (xkmper*sq + geodetic->alt)*frame->sin_lat;
+
+	frame->jul_utc = 0.0;
+	frame->thetag = 0.0;
+} /*Procedure Obs_Frame_Init*/
+
+/*------------------------------------------------------------------*/
+
+/* Procedure Obs_Frame_Set_Time moves the observer frame to the */
+/* time of interest (Julian date).                              */
+void
+Obs_Frame_Set_Time(obs_frame_t *frame, double _time)
+{
+	Obs_Frame_Set_ThetaG(frame, _time, ThetaG_JD(_time));
+} /*Procedure Obs_Frame_Set_Time*/
+
+/*------------------------------------------------------------------*/
+
+/* Same as Obs_Frame_Set_Time for callers that already have */
+/* thetag = ThetaG_JD(_time). The velocity calculation      */
+/* assumes the observer is stationary relative to the earth.*/
+void
+Obs_Frame_Set_ThetaG(obs_frame_t *frame, double _time, double thetag)
+{
+	frame->jul_utc = _time;
+	frame->thetag = thetag;
+	frame->geodetic.theta = FMod2p(thetag + frame->geodetic.lon);/*LMST*/
+	frame->sin_theta = sin(frame->geodetic.theta);
+	frame->cos_theta = cos(frame->geodetic.theta);
+
+	frame->pos.x = frame->rxy*frame->cos_theta;/*kilometers*/
+	frame->pos.y = frame->rxy*frame->sin_theta;
+	frame->pos.z = frame->rz;
+	frame->vel.x = -mfactor*frame->pos.y;/*kilometers/second*/
+	frame->vel.y =  mfactor*frame->pos.x;
+	frame->vel.z =  0;
+	Magnitude(&frame->pos);
+	Magnitude(&frame->vel);
+} /*Procedure Obs_Frame_Set_ThetaG*/
+
+/*------------------------------------------------------------------*/
+
+/* Same as Calculate_Obs but with a prepared observer frame, which */
+/* is not changed, so it can be shared by many satellites.         */
+void
+Calculate_Obs_Frame(const obs_frame_t *frame,
+		    const vector_t *pos,
+		    const vector_t *vel,
+		    obs_set_t *obs_set)
 {
 	double
 		sin_lat,cos_lat,
@@ -106,24 +212,22 @@ Calculate_Obs(double _time,
 		top_s,top_e,top_z;
 
 	vector_t
-		obs_pos,obs_vel,range,rgvel;
-
-	Calculate_User_PosVel(_time, geodetic, &obs_pos, &obs_vel);
+		range,rgvel;
 
-	range.x = pos->x - obs_pos.x;
-	range.y = pos->y - obs_pos.y;
-	range.z = pos->z - obs_pos.z;
+	range.x = pos->x - frame->pos.x;
+	range.y = pos->y - frame->pos.y;
+	range.z = pos->z - frame->pos.z;
 
-	rgvel.x = vel->x - obs_vel.x;
-	rgvel.y = vel->y - obs_vel.y;
-	rgvel.z = vel->z - obs_vel.z;
+	rgvel.x = vel->x - frame->vel.x;
+	rgvel.y = vel->y - frame->vel.y;
+	rgvel.z = vel->z - frame->vel.z;
 
 	Magnitude(&range);
 
-	sin_lat = sin(geodetic->lat);
-	cos_lat = cos(geodetic->lat);
-	sin_theta = sin(geodetic->theta);
-	cos_theta = cos(geodetic->theta);
+	sin_lat = frame->sin_lat;
+	cos_lat = frame->cos_lat;
+	sin_theta = frame->sin_theta;
+	cos_theta = frame->cos_theta;
 	top_s = sin_lat * cos_theta * range.x
 		+ sin_lat * sin_theta * range.y
 		- cos_lat * range.z;
@@ -150,14 +254,9 @@ Calculate_Obs(double _time,
 /* Correction is meaningless when apparent elevation is below horizon */
 //	obs_set->el = obs_set->el + Radians((1.02/tan(Radians(Degrees(el)+
 //							      10.3/(Degrees(el)+5.11))))/60);
-	if( obs_set->el >= 0 )
-		SetFlag(VISIBLE_FLAG);
-	else
-	{
+	if( obs_set->el < 0 )
 		obs_set->el = el;  /*Reset to true elevation*/
-		ClearFlag(VISIBLE_FLAG);
-	} /*else*/
-} /*Procedure Calculate_Obs*/
+} /*Procedure Calculate_Obs_Frame*/
 
 /*------------------------------------------------------------------*/
 
@@ -167,28 +266,40 @@ Calculate_RADec_and_Obs ( double _time,
 			  vector_t *vel,
 			  geodetic_t *geodetic,
 			  obs_astro_t *obs_set)
+{
+	obs_frame_t frame;
+	obs_set_t obs;
+
+	Obs_Frame_Init(&frame, geodetic);
+	Obs_Frame_Set_Time(&frame, _time);
+	Calculate_Obs_Frame(&frame, pos, vel, &obs);
+	geodetic->theta = frame.geodetic.theta;
+
+	Calculate_RADec_Frame(&frame, obs.az, obs.el, obs_set);
+} /* Procedure Calculate_RADec */
+
+/*------------------------------------------------------------------*/
+
+/* Procedure Calculate_RADec_Frame calculates the topocentric Right */
+/* Ascension and Declination of a direction given by azimuth and    */
+/* elevation [rad] as seen from a prepared observer frame.          */
+void
+Calculate_RADec_Frame(const obs_frame_t *frame,
+		      double az,
+		      double el,
+		      obs_astro_t *obs_set)
 {
 /* Reference:  Methods of Orbit Determination by  */
 /*                Pedro Ramon Escobal, pp. 401-402 */
 
-	double phi,theta,sin_theta,cos_theta,sin_phi,cos_phi,
-		az,el,Lxh,Lyh,Lzh,Sx,Ex,Zx,Sy,Ey,Zy,Sz,Ez,Zz,
+	double sin_theta,cos_theta,sin_phi,cos_phi,
+		Lxh,Lyh,Lzh,Sx,Ex,Zx,Sy,Ey,Zy,Sz,Ez,Zz,
 		Lx,Ly,Lz,cos_delta,sin_alpha,cos_alpha;
 
-	obs_set_t obs;
-
-	Calculate_Obs(_time,pos,vel,geodetic,&obs);
-
-/*  if( isFlagSet(VISIBLE_FLAG) )
-    {*/
-	az = obs.az;
-	el = obs.el;
-	phi   = geodetic->lat;
-	theta = FMod2p(ThetaG_JD(_time) + geodetic->lon);
-	sin_theta = sin(theta);
-	cos_theta = cos(theta);
-	sin_phi = sin(phi);
-	cos_phi = cos(phi);
+	sin_theta = frame->sin_theta;
+	cos_theta = frame->cos_theta;
+	sin_phi = frame->sin_lat;
+	cos_phi = frame->cos_lat;
 	Lxh = -cos(az) * cos(el);
 	Lyh =  sin(az) * cos(el);
 	Lzh =  sin(el);
@@ -210,8 +321,7 @@ Calculate_RADec_and_Obs ( double _time,
 	cos_alpha = Lx / cos_delta;
 	obs_set->ra = AcTan(sin_alpha,cos_alpha); /* Right Ascension (radians)*/
 	obs_set->ra = FMod2p(obs_set->ra);
-	/*}*/  /*if*/
-} /* Procedure Calculate_RADec */
+} /* Procedure Calculate_RADec_Frame */
 
 /*------------------------------------------------------------------*/
 
@@ -202,7 +202,7 @@ Date_Time(double julian_date, struct tm *cdate)
   time_t jtime;
 
   jtime = (julian_date - 2440587.5)*86400.;
-  *cdate = *gmtime( &jtime );
+  gmtime_r( &jtime, cdate );
 
 } /* End of Date_Time() */
 
@@ -266,9 +266,11 @@ struct tm
 Time_from_UTC(struct tm *cdate)
 {
   time_t tdate;
+  struct tm odate;
 
   tdate = mktime(cdate);
-  return( *localtime(&tdate) );
+  localtime_r(&tdate, &odate);
+  return( odate );
 } /*Procedure Time_from_UTC*/
 
 /*------------------------------------------------------------------*/
@@ -430,7 +432,7 @@ UTC_Calendar_Now( struct tm *cdate )
   time_t t;
 
   t = time(0);
-  *cdate = *gmtime(&t);
+  gmtime_r(&t, cdate);
   cdate->tm_year += 1900;
   cdate->tm_mon += 1;
 
@@ -0,0 +1,227 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2012  Alexandru Csete.
+
+    Authors: Alexandru Csete <csete@users.sourceforge.net>
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the
+          Free Software Foundation, Inc.,
+      59 Temple Place, Suite 330,
+      Boston, MA  02111-1307
+      USA
+*/
+/** \defgroup test003 Reentrancy stress test for SGP4/SDP4
+ *  \ingroup tests
+ *
+ * Propagates a few hundred satellites derived from test-001.tle (SGP4)
+ * and test-002.tle (SDP4) first serially, then from several threads at
+ * the same time, and checks that the results are bit-for-bit identical.
+ * The threads share the read-only propagator models of the serial run
+ * and only keep a private sgpsdp_state_t. The test fails if any result
+ * differs.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <glib.h>
+#include "sgp4sdp4.h"
+#include "test-common.h"
+
+#define NUM_SATS    400
+#define NUM_THREADS 8
+#define NUM_STEPS   96
+#define TIME_STEP   15.0    /* minutes */
+
+/* structure to hold the result of a single propagation */
+typedef struct {
+    double x;
+    double y;
+    double z;
+    double vx;
+    double vy;
+    double vz;
+    double az;
+    double el;
+    double range_rate;
+} dataset_t;
+
+/* work unit for a propagation thread */
+typedef struct {
+    guint      first;
+    guint      stride;
+    dataset_t *results;
+} job_t;
+
+
+sat_t       sats[NUM_SATS];
+
+
+/* store one propagation result */
+static void
+store_result (dataset_t *res, vector_t *pos, vector_t *vel, double jul_utc)
+{
+    geodetic_t obs_geodetic;
+    obs_set_t  obs_set;
+
+    Convert_Sat_State (pos, vel);
+    Magnitude (vel);
+
+    /* Calculate_Obs() writes the LMST into the observer structure */
+    obs_geodetic = test_obs;
+    Calculate_Obs (jul_utc, pos, vel, &obs_geodetic, &obs_set);
+
+    res->x = pos->x;
+    res->y = pos->y;
+    res->z = pos->z;
+    res->vx = vel->x;
+    res->vy = vel->y;
+    res->vz = vel->z;
+    res->az = obs_set.az;
+    res->el = obs_set.el;
+    res->range_rate = obs_set.range_rate;
+}
+
+
+/* propagate satellite number idx over the whole time grid using sat_t */
+static void
+propagate_sat (guint idx, dataset_t *res)
+{
+    sat_t  *sat = &sats[idx];
+    double  jul_epoch;
+    double  tsince;
+    guint   i;
+
+    jul_epoch = Julian_Date_of_Epoch (sat->tle.epoch);
+
+    for (i = 0; i < NUM_STEPS; i++) {
+        tsince = i * TIME_STEP;
+
+        if (sat->flags & DEEP_SPACE_EPHEM_FLAG)
+            SDP4 (sat, tsince);
+        else
+            SGP4 (sat, tsince);
+
+        store_result (&res[i], &sat->pos, &sat->vel, jul_epoch + tsince / xmnpda);
+    }
+}
+
+
+/* same as propagate_sat() but with the shared model and a private state */
+static void
+propagate_model (guint idx, dataset_t *res)
+{
+    const sgpsdp_model_t *model = sats[idx].model;
+    sgpsdp_state_t        state;
+    double                jul_epoch;
+    double                tsince;
+    guint                 i;
+
+    Init_State (model, &state);
+    jul_epoch = Julian_Date_of_Epoch (model->tle.epoch);
+
+    for (i = 0; i < NUM_STEPS; i++) {
+        tsince = i * TIME_STEP;
+
+        if (model->flags & DEEP_SPACE_EPHEM_FLAG)
+            SDP4_Model (model, &state, tsince);
+        else
+            SGP4_Model (model, &state, tsince);
+
+        store_result (&res[i], &state.pos, &state.vel, jul_epoch + tsince / xmnpda);
+    }
+}
+
+
+static gpointer
+propagate_thread (gpointer data)
+{
+    job_t *job = (job_t *) data;
+    guint  idx;
+
+    for (idx = job->first; idx < NUM_SATS; idx += job->stride)
+        propagate_model (idx, &job->results[idx * NUM_STEPS]);
+
+    return NULL;
+}
+
+
+int
+main (int argc, char **argv)
+{
+    dataset_t *serial, *parallel;
+    GThread   *threads[NUM_THREADS];
+    job_t      jobs[NUM_THREADS];
+    guint      i, j, failed = 0;
+
+    (void) argc;
+    (void) argv;
+
+    if (test_read_base ())
+        return 1;
+
+    if (!g_thread_supported ())
+        g_thread_init (NULL);
+
+    serial = g_new0 (dataset_t, NUM_SATS * NUM_STEPS);
+    parallel = g_new0 (dataset_t, NUM_SATS * NUM_STEPS);
+
+    /* reference: serial propagation */
+    for (i = 0; i < NUM_SATS; i++) {
+        test_init_sat (&sats[i], i, 1.7, 0.9);
+        propagate_sat (i, &serial[i * NUM_STEPS]);
+    }
+
+    /* same work spread over NUM_THREADS concurrent threads */
+    for (i = 0; i < NUM_THREADS; i++) {
+        jobs[i].first = i;
+        jobs[i].stride = NUM_THREADS;
+        jobs[i].results = parallel;
+        threads[i] = g_thread_create (propagate_thread, &jobs[i], TRUE, NULL);
+    }
+    for (i = 0; i < NUM_THREADS; i++)
+        g_thread_join (threads[i]);
+
+    for (i = 0; i < NUM_SATS; i++) {
+        for (j = 0; j < NUM_STEPS; j++) {
+            if (memcmp (&serial[i * NUM_STEPS + j], &parallel[i * NUM_STEPS + j],
+                        sizeof (dataset_t))) {
+                printf ("MISMATCH  sat: %3d  t: %7.1f  X: %.8f / %.8f\n",
+                        i, j * TIME_STEP,
+                        serial[i * NUM_STEPS + j].x, parallel[i * NUM_STEPS + j].x);
+                failed++;
+            }
+        }
+    }
+
+    printf ("%d satellites x %d steps on %d threads: %s (%d mismatches)\n",
+            NUM_SATS, NUM_STEPS, NUM_THREADS,
+            failed ? "FAILED" : "PASSED", failed);
+
+    for (i = 0; i < NUM_SATS; i++)
+        free_ephemeris (&sats[i]);
+
+    g_free (serial);
+    g_free (parallel);
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,417 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2012  Alexandru Csete.
+
+    Authors: Alexandru Csete <csete@users.sourceforge.net>
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the
+          Free Software Foundation, Inc.,
+      59 Temple Place, Suite 330,
+      Boston, MA  02111-1307
+      USA
+*/
+/** \defgroup test006 Benchmark and accuracy test for the AOS/LOS solver
+ *  \ingroup tests
+ *
+ * Finds all passes over a ten day window for a catalogue of satellites
+ * derived from test-001.tle (SGP4) and test-002.tle (SDP4), once with the
+ * step heuristics that find_aos() and find_los() used before, which are
+ * copied below, and once with Find_Crossing(). The time of both is printed
+ * together with the error of the AOS/LOS times relative to a bisection to
+ * 1 ms, and the number of passes that only one of the methods found.
+ * Find_Crossing() must find every pass that gets more than 0.005 degrees
+ * above the horizon, each AOS/LOS must be within 0.5 sec of the crossing or
+ * within 0.005 degrees of the elevation limit (the tolerance of the old
+ * functions; grazing passes of SDP4 satellites have a numerical noise of
+ * about 0.001 degrees), and it also has to handle a non-zero minimum
+ * elevation.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <glib.h>
+#include "sgp4sdp4.h"
+#include "test-common.h"
+
+#define NUM_SATS    200
+#define WINDOW      10.0    /* days */
+#define MAX_PASSES  200     /* per satellite */
+#define MATCH_TOL   3.5E-3  /* days (5 min) to match passes */
+#define ERR_MAX     0.5     /* sec */
+#define EL_TOL      0.005   /* degrees; tolerance of the old functions */
+#define MIN_EL      10.0    /* degrees */
+
+/* the AOS/LOS times found by one method */
+typedef struct {
+    double aos[MAX_PASSES];
+    double los[MAX_PASSES];
+    guint  num;
+} passes_t;
+
+/* error statistics */
+typedef struct {
+    double sum;
+    double max;
+    guint  num;     /* number of events verified by bisection */
+    guint  el_ok;   /* number of events within EL_TOL */
+} stat_t;
+
+
+sat_t       sats[NUM_SATS];
+
+
+/* initialise satellite number idx; the SGP4 satellites also get
+   different mean motions */
+static void
+init_sat (sat_t *sat, guint idx)
+{
+    tle_t tle;
+
+    test_vary_tle (&tle, idx, 1.7, 0.9);
+    if (idx % 2 == 0)
+        tle.xno -= 0.1 * (idx % 17);
+
+    test_init_tle (sat, &tle);
+}
+
+
+/* same as predict_calc() but only el (degrees) and alt (km) are updated */
+static void
+calc (sat_t *sat, double t)
+{
+    obs_set_t  obs_set;
+    geodetic_t sat_geodetic;
+
+    sat->jul_utc = t;
+    sat->tsince = (t - sat->jul_epoch) * xmnpda;
+
+    if (sat->flags & DEEP_SPACE_EPHEM_FLAG)
+        SDP4 (sat, sat->tsince);
+    else
+        SGP4 (sat, sat->tsince);
+
+    Convert_Sat_State (&sat->pos, &sat->vel);
+    Calculate_Obs (t, &sat->pos, &sat->vel, &test_obs, &obs_set);
+    Calculate_LatLonAlt (t, &sat->pos, &sat_geodetic);
+    sat->el = Degrees (obs_set.el);
+    sat->alt = sat_geodetic.alt;
+}
+
+
+static double old_find_los (sat_t *sat, double start, double maxdt);
+
+/* find_aos() from predict-tools.c before the event solver (maxdt > 0) */
+static double
+old_find_aos (sat_t *sat, double start, double maxdt)
+{
+    double t = start;
+    double aostime = 0.0;
+
+    calc (sat, start);
+
+    if (sat->el > 0.0)
+        t = old_find_los (sat, start, maxdt) + 0.014;
+
+    if (t < 0.1)
+        return 0.0;
+
+    calc (sat, t);
+
+    while ((sat->el < -1.0) && (t <= (start + maxdt))) {
+        t -= 0.00035 * (sat->el * ((sat->alt / 8400.0) + 0.46) - 2.0);
+        calc (sat, t);
+    }
+
+    while ((aostime == 0.0) && (t <= (start + maxdt))) {
+        if (fabs (sat->el) < 0.005) {
+            aostime = t;
+        }
+        else {
+            t -= sat->el * sqrt (sat->alt) / 530000.0;
+            calc (sat, t);
+        }
+    }
+
+    return aostime;
+}
+
+
+/* find_los() from predict-tools.c before the event solver (maxdt > 0) */
+static double
+old_find_los (sat_t *sat, double start, double maxdt)
+{
+    double t = start;
+    double lostime = 0.0;
+    double eltemp;
+
+    calc (sat, start);
+
+    if (sat->el < 0.0)
+        t = old_find_aos (sat, start, maxdt) + 0.001;
+
+    if (t < 0.01)
+        return 0.0;
+
+    calc (sat, t);
+
+    while ((sat->el >= 1.0) && (t <= (start + maxdt))) {
+        t += cos ((sat->el - 1.0) * de2ra) * sqrt (sat->alt) / 25000.0;
+        calc (sat, t);
+    }
+
+    while ((lostime == 0.0) && (t <= (start + maxdt))) {
+        t += sat->el * sqrt (sat->alt) / 502500.0;
+        calc (sat, t);
+
+        if (fabs (sat->el) < 0.005) {
+            eltemp = sat->el;
+            calc (sat, t - 1.0 / 86400.0);
+            if (sat->el > eltemp)
+                lostime = t;
+        }
+    }
+
+    return lostime;
+}
+
+
+/* collect the passes in the window the same way as get_pass_engine() in
+   predict-tools.c; new selects Find_Crossing() or the old functions */
+static void
+get_passes (sat_t *sat, double start, double min_el, int new, passes_t *res)
+{
+    double t = start, end = start + WINDOW, aos, los;
+
+    res->num = 0;
+    while (res->num < MAX_PASSES) {
+        if (new) {
+            los = Find_Crossing (sat, &test_obs, t, end - t, min_el, 0);
+            aos = Find_Crossing (sat, &test_obs, t, end - t, min_el, 1);
+        }
+        else {
+            los = old_find_los (sat, t, end - t);
+            aos = old_find_aos (sat, t, end - t);
+        }
+
+        /* stop at the end of the window; skip a pass that is in progress */
+        if (aos == 0.0 || los == 0.0)
+            break;
+
+        if (aos < los) {
+            res->aos[res->num] = aos;
+            res->los[res->num] = los;
+            res->num++;
+        }
+        t = los + 0.014;
+    }
+}
+
+
+/* bisection for the crossing of min_el close to t; returns 0.0 if there
+   is none within +/- 2 minutes */
+static double
+true_crossing (sat_t *sat, double t, double min_el, int rising)
+{
+    double a, b, m, w;
+    double fa, fb, fm;
+
+    /* smallest bracket around t, so that short passes work too */
+    for (w = 1.0 / secday; w < 0.0014; w *= 2.0) {
+        a = t - w;
+        b = t + w;
+        calc (sat, a);
+        fa = sat->el - min_el;
+        calc (sat, b);
+        fb = sat->el - min_el;
+
+        if (rising ? (fa < 0.0 && fb >= 0.0) : (fa >= 0.0 && fb < 0.0))
+            break;
+    }
+    if (w >= 0.0014)
+        return 0.0;
+
+    while (b - a > 1.0E-8) {
+        m = 0.5 * (a + b);
+        calc (sat, m);
+        fm = sat->el - min_el;
+        if ((fm < 0.0) == (fa < 0.0))
+            a = m;
+        else
+            b = m;
+    }
+
+    return 0.5 * (a + b);
+}
+
+
+/* add the error of t (AOS or LOS) to st; returns FALSE if the event is
+   neither within ERR_MAX of the crossing nor within EL_TOL of min_el */
+static gboolean
+add_error (sat_t *sat, stat_t *st, double t, double min_el, int rising)
+{
+    double tc, err;
+
+    calc (sat, t);
+    if (fabs (sat->el - min_el) < EL_TOL)
+        st->el_ok++;
+
+    tc = true_crossing (sat, t, min_el, rising);
+    if (tc == 0.0)
+        return (fabs (sat->el - min_el) < EL_TOL);
+
+    err = fabs (t - tc) * secday;
+    st->sum += err;
+    if (err > st->max)
+        st->max = err;
+    st->num++;
+
+    return (err < ERR_MAX || fabs (sat->el - min_el) < EL_TOL);
+}
+
+
+/* maximum elevation between t1 and t2 sampled every second */
+static double
+max_el (sat_t *sat, double t1, double t2)
+{
+    double t, el = -90.0;
+
+    for (t = t1; t <= t2; t += 1.0 / secday) {
+        calc (sat, t);
+        if (sat->el > el)
+            el = sat->el;
+    }
+
+    return el;
+}
+
+
+/* number of passes in a with no pass in b with AOS within MATCH_TOL;
+   passes that never get EL_TOL above the horizon are not counted */
+static guint
+unmatched (sat_t *sat, passes_t *a, passes_t *b)
+{
+    guint i, j, num = 0;
+
+    for (i = 0; i < a->num; i++) {
+        for (j = 0; j < b->num; j++)
+            if (fabs (a->aos[i] - b->aos[j]) < MATCH_TOL)
+                break;
+        if (j == b->num && max_el (sat, a->aos[i], a->los[i]) >= EL_TOL)
+            num++;
+    }
+
+    return num;
+}
+
+
+static void
+print_stat (const char *name, guint num, double time, stat_t *st)
+{
+    printf ("%s %5d passes  %8.2f ms  error mean %.3f s  max %.3f s  "
+            "(%d/%d events verified, %d within %.3f deg)\n",
+            name, num, 1000.0 * time, st->num ? st->sum / st->num : 0.0,
+            st->max, st->num, 2 * num, st->el_ok, EL_TOL);
+}
+
+
+int
+main (int argc, char **argv)
+{
+    passes_t  old_res, new_res;
+    stat_t    old_err, new_err, min_err;
+    GTimer   *timer;
+    gdouble   t_old = 0.0, t_new = 0.0, t_min = 0.0;
+    guint     i, j, old_num = 0, new_num = 0, min_num = 0;
+    guint     old_only = 0, new_only = 0, bad = 0, failed = 0;
+
+    (void) argc;
+    (void) argv;
+
+    if (test_read_base ())
+        return 1;
+
+    memset (&old_err, 0, sizeof (stat_t));
+    memset (&new_err, 0, sizeof (stat_t));
+    memset (&min_err, 0, sizeof (stat_t));
+    timer = g_timer_new ();
+
+    for (i = 0; i < NUM_SATS; i++) {
+        init_sat (&sats[i], i);
+
+        g_timer_start (timer);
+        get_passes (&sats[i], sats[i].jul_epoch, 0.0, 0, &old_res);
+        t_old += g_timer_elapsed (timer, NULL);
+
+        g_timer_start (timer);
+        get_passes (&sats[i], sats[i].jul_epoch, 0.0, 1, &new_res);
+        t_new += g_timer_elapsed (timer, NULL);
+
+        old_num += old_res.num;
+        new_num += new_res.num;
+        old_only += unmatched (&sats[i], &old_res, &new_res);
+        new_only += unmatched (&sats[i], &new_res, &old_res);
+
+        for (j = 0; j < old_res.num; j++) {
+            add_error (&sats[i], &old_err, old_res.aos[j], 0.0, 1);
+            add_error (&sats[i], &old_err, old_res.los[j], 0.0, 0);
+        }
+        for (j = 0; j < new_res.num; j++) {
+            if (!add_error (&sats[i], &new_err, new_res.aos[j], 0.0, 1))
+                bad++;
+            if (!add_error (&sats[i], &new_err, new_res.los[j], 0.0, 0))
+                bad++;
+        }
+
+        /* non-zero minimum elevation */
+        g_timer_start (timer);
+        get_passes (&sats[i], sats[i].jul_epoch, MIN_EL, 1, &new_res);
+        t_min += g_timer_elapsed (timer, NULL);
+
+        min_num += new_res.num;
+        for (j = 0; j < new_res.num; j++) {
+            if (!add_error (&sats[i], &min_err, new_res.aos[j], MIN_EL, 1))
+                bad++;
+            if (!add_error (&sats[i], &min_err, new_res.los[j], MIN_EL, 0))
+                bad++;
+        }
+
+        free_ephemeris (&sats[i]);
+    }
+
+    printf ("%d satellites, %.0f day window\n", NUM_SATS, WINDOW);
+    print_stat ("heuristic:     ", old_num, t_old, &old_err);
+    print_stat ("Find_Crossing: ", new_num, t_new, &new_err);
+    print_stat ("min_el = 10:   ", min_num, t_min, &min_err);
+    printf ("passes found only by the heuristic: %d, only by Find_Crossing: %d\n",
+            old_only, new_only);
+    printf ("speedup: %.2fx\n", t_old / t_new);
+
+    /* the heuristic is allowed to miss passes, Find_Crossing is not */
+    failed = bad + old_only;
+    printf ("%s (%d bad events, %d missed passes)\n",
+            failed ? "FAILED" : "PASSED", bad, old_only);
+
+    g_timer_destroy (timer);
+
+    return failed ? 1 : 0;
+}
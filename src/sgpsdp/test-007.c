@@ -0,0 +1,195 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2012  Alexandru Csete.
+
+    Authors: Alexandru Csete <csete@users.sourceforge.net>
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+/** \defgroup test007 Regression test for private view state
+ *  \ingroup tests
+ *
+ * The views of a module (map, polar view, sky at a glance, ...) do their
+ * own calculations, e.g. ground tracks and pass predictions, on a private
+ * copy of the live sat_t. This test runs the prediction code of the views
+ * between module ticks:
+ *
+ *  - predict_ground_track(), used by the ground tracks of the map;
+ *  - get_next_pass(), get_current_pass() and get_passes(), used by the
+ *    polar view, the pass dialogs and the event list;
+ *  - get_passes_summary() far into the future, used by sky at a glance;
+ *
+ * and checks that
+ *
+ *  - the live satellites are bit-identical before and after each view update;
+ *  - the shared propagator models are not changed by the view updates;
+ *  - the following ticks give bit-identical results compared to satellites
+ *    that never had any view updates.
+ *
+ * The module does not check this at run time, so this test is where a view
+ * that writes to the live data is caught. Half of the satellites are derived
+ * from test-001.tle (SGP4) and half from test-002.tle (SDP4), whose
+ * propagator state depends on its history.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <glib.h>
+#include "sgp4sdp4.h"
+#include "test-common.h"
+#include "sat-log.h"
+#include "gtk-sat-data.h"
+#include "qth-data.h"
+#include "predict-tools.h"
+
+#define NUM_SATS    40
+#define NUM_TICKS   10
+#define TICK_STEP   (60.0/secday)   /* one minute */
+
+sat_t       live[NUM_SATS];     /* satellites used by the views */
+sat_t       ref[NUM_SATS];      /* satellites without view updates */
+qth_t       qth;
+
+
+/* ground track of the current and the next orbit, like ground_track_create */
+static void
+view_ground_track (sat_t *sat, double t)
+{
+    GSList *latlon, *node;
+
+    latlon = predict_ground_track (sat, &qth, t, 2);
+
+    for (node = latlon; node != NULL; node = node->next)
+        g_free (node->data);
+    g_slist_free (latlon);
+}
+
+
+/* next and current pass and the pass list, like the polar view */
+static void
+view_passes (sat_t *sat, double t)
+{
+    pass_t *pass;
+
+    pass = get_next_pass (sat, &qth, 3.0);
+    if (pass != NULL)
+        free_pass (pass);
+
+    pass = get_current_pass (sat, &qth, t);
+    if (pass != NULL)
+        free_pass (pass);
+
+    free_passes (get_passes (sat, &qth, t, 3.0, 10));
+}
+
+
+/* sky at a glance far into the future */
+static void
+view_far (sat_t *sat, double t)
+{
+    free_passes (get_passes_summary (sat, &qth, t + 30.0, 1.0, 10));
+}
+
+
+int
+main (int argc, char **argv)
+{
+    void      (*views[]) (sat_t *, double) = { view_ground_track, view_passes, view_far };
+    sat_t      before;
+    sgpsdp_model_t *models;
+    double     t0, t;
+    guint      i, j, k, nviews, failed = 0;
+
+    (void) argc;
+    (void) argv;
+
+    /* the configuration is not loaded, so do not complain about it */
+    sat_log_set_level (SAT_LOG_LEVEL_NONE);
+
+    if (test_read_base ())
+        return 1;
+
+    memset (&qth, 0, sizeof (qth));
+    qth.lat = Degrees (test_obs.lat);
+    qth.lon = Degrees (test_obs.lon);
+    qth.alt = (gint) (test_obs.alt * 1000.0);
+
+    nviews = sizeof (views) / sizeof (views[0]);
+    models = g_new (sgpsdp_model_t, NUM_SATS);
+
+    for (i = 0; i < NUM_SATS; i++) {
+        test_init_sat (&live[i], i, TEST_DMO, TEST_DNODE);
+        gtk_sat_data_init_sat (&live[i], &qth);
+        test_init_sat (&ref[i], i, TEST_DMO, TEST_DNODE);
+        gtk_sat_data_init_sat (&ref[i], &qth);
+        models[i] = *(live[i].model);
+    }
+
+    t0 = Julian_Date_of_Epoch (test_tle[0].epoch) + 0.5;
+
+    for (k = 0; k < NUM_TICKS; k++) {
+        t = t0 + k * TICK_STEP;
+
+        for (i = 0; i < NUM_SATS; i++) {
+            predict_calc (&live[i], &qth, t);
+            predict_calc (&ref[i], &qth, t);
+
+            /* the tick must give the same result as without views;
+               only the model pointers differ */
+            memcpy (&before, &ref[i], sizeof (sat_t));
+            before.model = live[i].model;
+            if (memcmp (&live[i], &before, sizeof (sat_t))) {
+                printf ("TICK MISMATCH  sat: %2d  tick: %2d  X: %.8f / %.8f\n",
+                        i, k, live[i].pos.x, ref[i].pos.x);
+                failed++;
+            }
+
+            /* update the views; the live data must not change */
+            for (j = 0; j < nviews; j++) {
+                memcpy (&before, &live[i], sizeof (sat_t));
+                views[j] (&live[i], t);
+
+                if (memcmp (&before, &live[i], sizeof (sat_t))) {
+                    printf ("VIEW %d CHANGED  sat: %2d  tick: %2d\n", j, i, k);
+                    failed++;
+                }
+            }
+
+            if (memcmp (&models[i], live[i].model, sizeof (sgpsdp_model_t))) {
+                printf ("MODEL CHANGED  sat: %2d  tick: %2d\n", i, k);
+                failed++;
+            }
+        }
+    }
+
+    printf ("%d satellites x %d ticks x %d views: %s (%d errors)\n",
+            NUM_SATS, NUM_TICKS, nviews, failed ? "FAILED" : "PASSED", failed);
+
+    for (i = 0; i < NUM_SATS; i++) {
+        free_ephemeris (&live[i]);
+        free_ephemeris (&ref[i]);
+    }
+    g_free (models);
+
+    return failed ? 1 : 0;
+}
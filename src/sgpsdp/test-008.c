@@ -0,0 +1,152 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2012  Alexandru Csete.
+
+    Authors: Alexandru Csete <csete@users.sourceforge.net>
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+/** \defgroup test008 Benchmark for the observer frame
+ *  \ingroup tests
+ *
+ * Calculates the look angles of many satellites at the same time, like a
+ * module tick does, first with Calculate_Obs for each satellite and then
+ * with one observer frame shared by all satellites. The look angles and
+ * RA/Dec of both must be bit-identical. The time of both is printed.
+ *
+ * Half of the satellites are derived from test-001.tle (SGP4) and half from
+ * test-002.tle (SDP4).
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <glib.h>
+#include "sgp4sdp4.h"
+#include "test-common.h"
+
+#define NUM_SATS    400
+#define NUM_TICKS   96
+#define TICK_STEP   (900.0/secday)  /* 15 minutes */
+
+sat_t       sats[NUM_SATS];
+vector_t    pos[NUM_SATS];
+vector_t    vel[NUM_SATS];
+
+
+/* propagate all satellites to time t */
+static void
+propagate (double t)
+{
+    sat_t *sat;
+    guint  i;
+
+    for (i = 0; i < NUM_SATS; i++) {
+        sat = &sats[i];
+        sat->tsince = (t - sat->jul_epoch) * xmnpda;
+
+        if (sat->flags & DEEP_SPACE_EPHEM_FLAG)
+            SDP4 (sat, sat->tsince);
+        else
+            SGP4 (sat, sat->tsince);
+
+        pos[i] = sat->pos;
+        vel[i] = sat->vel;
+        Convert_Sat_State (&pos[i], &vel[i]);
+        Magnitude (&vel[i]);
+    }
+}
+
+
+int
+main (int argc, char **argv)
+{
+    obs_set_t    ref[NUM_SATS], res[NUM_SATS];
+    obs_astro_t  astro_ref, astro_res;
+    obs_frame_t  frame;
+    geodetic_t   obs_geodetic;
+    GTimer      *timer;
+    double       t0, t, t_ref = 0.0, t_res = 0.0;
+    guint        i, k, failed = 0;
+
+    (void) argc;
+    (void) argv;
+
+    if (test_read_base ())
+        return 1;
+
+    for (i = 0; i < NUM_SATS; i++)
+        test_init_sat (&sats[i], i, TEST_DMO, TEST_DNODE);
+
+    timer = g_timer_new ();
+    t0 = Julian_Date_of_Epoch (test_tle[0].epoch);
+
+    for (k = 0; k < NUM_TICKS; k++) {
+        t = t0 + k * TICK_STEP;
+        propagate (t);
+
+        /* one observer set-up per satellite */
+        g_timer_start (timer);
+        for (i = 0; i < NUM_SATS; i++) {
+            obs_geodetic = test_obs;
+            Calculate_Obs (t, &pos[i], &vel[i], &obs_geodetic, &ref[i]);
+        }
+        t_ref += g_timer_elapsed (timer, NULL);
+
+        /* one observer set-up per tick */
+        g_timer_start (timer);
+        Obs_Frame_Init (&frame, &test_obs);
+        Obs_Frame_Set_Time (&frame, t);
+        for (i = 0; i < NUM_SATS; i++)
+            Calculate_Obs_Frame (&frame, &pos[i], &vel[i], &res[i]);
+        t_res += g_timer_elapsed (timer, NULL);
+
+        for (i = 0; i < NUM_SATS; i++) {
+            if (memcmp (&ref[i], &res[i], sizeof (obs_set_t))) {
+                printf ("OBS MISMATCH  sat: %3d  tick: %2d  AZ: %.10f / %.10f\n",
+                        i, k, ref[i].az, res[i].az);
+                failed++;
+            }
+
+            obs_geodetic = test_obs;
+            Calculate_RADec_and_Obs (t, &pos[i], &vel[i], &obs_geodetic, &astro_ref);
+            Calculate_RADec_Frame (&frame, res[i].az, res[i].el, &astro_res);
+            if (memcmp (&astro_ref, &astro_res, sizeof (obs_astro_t))) {
+                printf ("RADEC MISMATCH  sat: %3d  tick: %2d  RA: %.10f / %.10f\n",
+                        i, k, astro_ref.ra, astro_res.ra);
+                failed++;
+            }
+        }
+    }
+
+    printf ("Time per tick:  per satellite %.3f ms  shared frame %.3f ms  (%.2fx)\n",
+            1000.0 * t_ref / NUM_TICKS, 1000.0 * t_res / NUM_TICKS,
+            (t_res > 0.0) ? t_ref / t_res : 0.0);
+    printf ("%d satellites x %d ticks: %s (%d mismatches)\n",
+            NUM_SATS, NUM_TICKS, failed ? "FAILED" : "PASSED", failed);
+
+    for (i = 0; i < NUM_SATS; i++)
+        free_ephemeris (&sats[i]);
+    g_timer_destroy (timer);
+
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,204 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2012  Alexandru Csete.
+
+    Authors: Alexandru Csete <csete@users.sourceforge.net>
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+/** \defgroup test009 Benchmark for the configuration snapshot
+ *  \ingroup tests
+ *
+ * Predicts passes with get_pass() and times the configuration reads that
+ * one pass needs: the minimum elevation per pass, the resolution and the
+ * number of entries per pass, and the twilight threshold per detail in
+ * get_sat_vis(). They are read once with sat_cfg_get_int(), which is what
+ * these places used to do, and once from sat_cfg_get_snapshot(), which is
+ * what they do now. The values of both must be identical; the time per
+ * pass of get_pass() and of both sets of reads are printed.
+ *
+ * The configuration is not read from the user's gpredict.cfg; the values
+ * are set to their defaults with sat_cfg_set_int(), so that the key file
+ * lookups succeed as they do with a saved configuration.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <glib.h>
+#include "sgp4sdp4.h"
+#include "test-common.h"
+#include "sat-log.h"
+#include "sat-cfg.h"
+#include "gtk-sat-data.h"
+#include "qth-data.h"
+#include "predict-tools.h"
+
+#define NUM_SATS    20
+#define NUM_PASSES  10
+#define NUM_REPEAT  100     /* repetitions of the reads of one pass */
+
+
+/* the reads of one pass with n details from the key file */
+static gint
+read_key_file (guint n)
+{
+    gint  sum;
+    guint i;
+
+    sum = sat_cfg_get_int (SAT_CFG_INT_PRED_MIN_EL);
+    sum += sat_cfg_get_int (SAT_CFG_INT_PRED_RESOLUTION);
+    sum += sat_cfg_get_int (SAT_CFG_INT_PRED_NUM_ENTRIES);
+
+    for (i = 0; i < n; i++)
+        sum += sat_cfg_get_int (SAT_CFG_INT_PRED_TWILIGHT_THLD);
+
+    return sum;
+}
+
+
+/* the reads of one pass with n details from the snapshot */
+static gint
+read_snapshot (guint n)
+{
+    gint  sum;
+    guint i;
+
+    sum = sat_cfg_get_snapshot ()->pred_min_el;
+    sum += sat_cfg_get_snapshot ()->pred_resolution;
+    sum += sat_cfg_get_snapshot ()->pred_num_entries;
+
+    for (i = 0; i < n; i++)
+        sum += sat_cfg_get_snapshot ()->pred_twilight_thld;
+
+    return sum;
+}
+
+
+int
+main (int argc, char **argv)
+{
+    const sat_cfg_int_e params[] = {
+        SAT_CFG_INT_PRED_MIN_EL,
+        SAT_CFG_INT_PRED_RESOLUTION,
+        SAT_CFG_INT_PRED_NUM_ENTRIES,
+        SAT_CFG_INT_PRED_TWILIGHT_THLD
+    };
+    const sat_cfg_snapshot_t *cfg;
+    gint       values[G_N_ELEMENTS (params)];
+    qth_t      qth;
+    sat_t      sat;
+    pass_t    *pass;
+    GTimer    *timer;
+    double     t, t_pass = 0.0, t_key = 0.0, t_snap = 0.0;
+    gint       sum_key = 0, sum_snap = 0;
+    guint      i, j, k, n, num = 0, failed = 0;
+
+    (void) argc;
+    (void) argv;
+
+    /* do not read the configuration of the user */
+    g_setenv ("XDG_CONFIG_HOME", "/nonexistent", TRUE);
+    sat_log_set_level (SAT_LOG_LEVEL_NONE);
+    sat_cfg_load ();
+
+    for (i = 0; i < G_N_ELEMENTS (params); i++)
+        sat_cfg_set_int (params[i], sat_cfg_get_int_def (params[i]));
+
+    if (test_read_base ())
+        return 1;
+
+    memset (&qth, 0, sizeof (qth));
+    qth.lat = Degrees (test_obs.lat);
+    qth.lon = Degrees (test_obs.lon);
+    qth.alt = (gint) (test_obs.alt * 1000.0);
+
+    timer = g_timer_new ();
+
+    for (i = 0; i < NUM_SATS; i++) {
+        test_init_sat (&sat, i, TEST_DMO, TEST_DNODE);
+        gtk_sat_data_init_sat (&sat, &qth);
+        t = Julian_Date_of_Epoch (test_tle[0].epoch);
+
+        for (j = 0; j < NUM_PASSES; j++) {
+            g_timer_start (timer);
+            pass = get_pass (&sat, &qth, t, 3.0);
+            t_pass += g_timer_elapsed (timer, NULL);
+
+            if (pass == NULL)
+                break;
+
+            n = get_pass_num_details (pass);
+
+            g_timer_start (timer);
+            for (k = 0; k < NUM_REPEAT; k++)
+                sum_key += read_key_file (n);
+            t_key += g_timer_elapsed (timer, NULL);
+
+            g_timer_start (timer);
+            for (k = 0; k < NUM_REPEAT; k++)
+                sum_snap += read_snapshot (n);
+            t_snap += g_timer_elapsed (timer, NULL);
+
+            t = pass->los + 0.01;
+            free_pass (pass);
+            num++;
+        }
+
+        free_ephemeris (&sat);
+    }
+
+    /* the snapshot must have the same values as the key file */
+    cfg = sat_cfg_get_snapshot ();
+    values[0] = cfg->pred_min_el;
+    values[1] = cfg->pred_resolution;
+    values[2] = cfg->pred_num_entries;
+    values[3] = cfg->pred_twilight_thld;
+
+    for (i = 0; i < G_N_ELEMENTS (params); i++) {
+        if (sat_cfg_get_int (params[i]) != values[i]) {
+            printf ("MISMATCH  param: %d  key file %d / snapshot %d\n",
+                    params[i], sat_cfg_get_int (params[i]), values[i]);
+            failed++;
+        }
+    }
+    if (sum_key != sum_snap) {
+        printf ("MISMATCH  key file %d / snapshot %d\n", sum_key, sum_snap);
+        failed++;
+    }
+
+    if (num > 0) {
+        printf ("Time per pass:  get_pass %.3f ms  sat_cfg_get_int %.4f ms  snapshot %.4f ms\n",
+                1000.0 * t_pass / num,
+                1000.0 * t_key / (num * NUM_REPEAT),
+                1000.0 * t_snap / (num * NUM_REPEAT));
+        printf ("Key file reads: %.2f%% of get_pass\n",
+                100.0 * t_key / (NUM_REPEAT * t_pass));
+    }
+    printf ("%d passes: %s (%d mismatches)\n",
+            num, failed ? "FAILED" : "PASSED", failed);
+
+    g_timer_destroy (timer);
+    sat_cfg_close ();
+
+    return (failed > 0 || num == 0) ? 1 : 0;
+}
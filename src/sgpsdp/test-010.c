@@ -0,0 +1,178 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2012  Alexandru Csete.
+
+    Authors: Alexandru Csete <csete@users.sourceforge.net>
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+/** \defgroup test010 Benchmark for pass summaries
+ *  \ingroup tests
+ *
+ * Generates the passes for the sky at a glance of a module with 300
+ * satellites, i.e. up to 10 passes per satellite within 8 hours, with
+ * get_passes(), which samples each pass from AOS to LOS into details, and
+ * with get_passes_summary(), which does not.
+ *
+ * Both must find the same passes with the same AOS, TCA, LOS, maximum
+ * elevation and azimuths, and the details that a summary calculates when
+ * they are first accessed must be the same as those of get_passes(). The
+ * time of both is printed.
+ *
+ * The default settings of gpredict are used, not the user configuration.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <glib.h>
+#include "sgp4sdp4.h"
+#include "test-common.h"
+#include "sat-log.h"
+#include "gtk-sat-data.h"
+#include "qth-data.h"
+#include "predict-tools.h"
+
+#define NUM_SATS     300
+#define NUM_PASSES   10
+#define TIME_SPAN    (8.0/24.0)     /* SKY_AT_GLANCE TIME_SPAN_HOURS */
+#define TIME_TOL     (0.5/86400.0)  /* AOS, TCA and LOS [days] */
+#define ANGLE_TOL    0.01           /* elevation and azimuth [deg] */
+
+int failed = 0;
+
+
+static void
+check_value (const char *what, guint i, guint j, double res, double exp, double tol)
+{
+    if (fabs (res - exp) <= tol)
+        return;
+
+    printf ("MISMATCH  sat: %3d  pass: %d  %s: %.8f / %.8f\n", i, j, what, res, exp);
+    failed++;
+}
+
+
+/* compare the summaries of one satellite with its full passes */
+static guint
+check_passes (guint i, GSList *full, GSList *summary)
+{
+    pass_t *pf, *ps;
+    guint   j, k, n = 0;
+
+    if (g_slist_length (full) != g_slist_length (summary)) {
+        printf ("PASS COUNT  sat: %3d  full: %d  summary: %d\n",
+                i, g_slist_length (full), g_slist_length (summary));
+        failed++;
+        return 0;
+    }
+
+    for (j = 0; full != NULL; full = full->next, summary = summary->next, j++) {
+        pf = PASS (full->data);
+        ps = PASS (summary->data);
+
+        check_value ("AOS", i, j, ps->aos, pf->aos, TIME_TOL);
+        check_value ("TCA", i, j, ps->tca, pf->tca, TIME_TOL);
+        check_value ("LOS", i, j, ps->los, pf->los, TIME_TOL);
+        check_value ("max el", i, j, ps->max_el, pf->max_el, ANGLE_TOL);
+        check_value ("AOS az", i, j, ps->aos_az, pf->aos_az, ANGLE_TOL);
+        check_value ("max el az", i, j, ps->maxel_az, pf->maxel_az, ANGLE_TOL);
+        check_value ("LOS az", i, j, ps->los_az, pf->los_az, ANGLE_TOL);
+
+        /* the details of the summary are calculated here */
+        if (get_pass_num_details (ps) != get_pass_num_details (pf)) {
+            printf ("DETAIL COUNT  sat: %3d  pass: %d  %d / %d\n", i, j,
+                    get_pass_num_details (ps), get_pass_num_details (pf));
+            failed++;
+            continue;
+        }
+        for (k = 0; k < get_pass_num_details (pf); k++) {
+            check_value ("detail el", i, j, get_pass_detail (ps, k)->el,
+                         get_pass_detail (pf, k)->el, ANGLE_TOL);
+            if (get_pass_detail (ps, k)->vis != get_pass_detail (pf, k)->vis) {
+                printf ("MISMATCH  sat: %3d  pass: %d  detail %d visibility\n", i, j, k);
+                failed++;
+            }
+        }
+
+        n++;
+    }
+
+    return n;
+}
+
+
+int
+main (int argc, char **argv)
+{
+    qth_t      qth;
+    sat_t      sat;
+    GSList    *full, *summary;
+    GTimer    *timer;
+    double     t0, t_full = 0.0, t_sum = 0.0;
+    guint      i, npasses = 0;
+
+    (void) argc;
+    (void) argv;
+
+    /* the configuration is not loaded, so do not complain about it */
+    sat_log_set_level (SAT_LOG_LEVEL_NONE);
+
+    if (test_read_base ())
+        return 1;
+
+    memset (&qth, 0, sizeof (qth));
+    qth.lat = Degrees (test_obs.lat);
+    qth.lon = Degrees (test_obs.lon);
+    qth.alt = (gint) (test_obs.alt * 1000.0);
+
+    timer = g_timer_new ();
+    t0 = Julian_Date_of_Epoch (test_tle[0].epoch) + 0.5;
+
+    for (i = 0; i < NUM_SATS; i++) {
+        test_init_sat (&sat, i, TEST_DMO, TEST_DNODE);
+        gtk_sat_data_init_sat (&sat, &qth);
+
+        g_timer_start (timer);
+        full = get_passes (&sat, &qth, t0, TIME_SPAN, NUM_PASSES);
+        t_full += g_timer_elapsed (timer, NULL);
+
+        g_timer_start (timer);
+        summary = get_passes_summary (&sat, &qth, t0, TIME_SPAN, NUM_PASSES);
+        t_sum += g_timer_elapsed (timer, NULL);
+
+        npasses += check_passes (i, full, summary);
+
+        free_passes (full);
+        free_passes (summary);
+        free_ephemeris (&sat);
+    }
+
+    printf ("Sky at a glance, %d satellites, %.0f hours:\n", NUM_SATS, TIME_SPAN * 24.0);
+    printf ("  get_passes %.1f ms  get_passes_summary %.1f ms  (%.2fx)\n",
+            1000.0 * t_full, 1000.0 * t_sum, (t_sum > 0.0) ? t_full / t_sum : 0.0);
+    printf ("%d passes: %s (%d errors)\n", npasses, failed ? "FAILED" : "PASSED", failed);
+
+    g_timer_destroy (timer);
+
+    return (failed > 0 || npasses == 0) ? 1 : 0;
+}
@@ -0,0 +1,297 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2012  Alexandru Csete.
+
+    Authors: Alexandru Csete <csete@users.sourceforge.net>
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+/** \defgroup test012 Golden passes for get_passes
+ *  \ingroup tests
+ *
+ * Predicts three days of passes of the satellites in test-012.tle over a
+ * set of fixed ground stations with get_passes() and get_passes_summary()
+ * and compares them with the reference passes in test-012.ref. Each
+ * reference line is
+ *
+ *     catnr qth aos tca los max_el aos_az los_az
+ *
+ * with the times as Julian dates and the angles in degrees. The default
+ * settings of gpredict are used, not the user configuration.
+ *
+ * The passes of get_passes() and the summaries must both match the
+ * references within the tolerances below; TCA and the maximum elevation
+ * are found the same way with and without details.
+ *
+ * After a deliberate change of the results, the references can be written
+ * with "test-012 -g".
+ *
+ * The files are read from the directory in the srcdir environment variable,
+ * which is set by "make check", or from the current directory.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <glib.h>
+#include "sgp4sdp4.h"
+#include "test-common.h"
+#include "sat-log.h"
+#include "sat-cfg.h"
+#include "gtk-sat-data.h"
+#include "qth-data.h"
+#include "predict-tools.h"
+
+#define START        2454730.5      /* 2008-09-21 00:00 UTC */
+#define DAYS         3.0
+#define TIME_TOL     (0.5/86400.0)  /* AOS, TCA and LOS [days] */
+#define ANGLE_TOL    0.01           /* elevation and azimuth [deg] */
+
+
+/* a fixed ground station */
+typedef struct {
+    const char *name;
+    double      lat;
+    double      lon;
+    int         alt;
+} station_t;
+
+/* a reference pass */
+typedef struct {
+    int     catnr;
+    char    qth[32];
+    double  aos, tca, los;
+    double  max_el, aos_az, los_az;
+} ref_t;
+
+
+const station_t stations[] = {
+    { "mid-latitude",  55.6761,   12.5683,   10 },
+    { "equatorial",    -0.1807,  -78.4678, 2850 },
+    { "polar",         78.2232,   15.6267,  475 },
+    { "southern",     -33.8688,  151.2093,   50 }
+};
+
+GPtrArray *sats;
+GArray    *refs;
+int        failed = 0;
+
+
+/* read the three line element sets */
+static gboolean
+read_sats (void)
+{
+    char    path[1024];
+    gchar  *contents;
+    gchar **lines;
+    sat_t  *sat;
+    guint   i;
+
+    test_data_file (path, sizeof (path), "test-012.tle");
+    if (!g_file_get_contents (path, &contents, NULL, NULL)) {
+        printf ("Could not read %s\n", path);
+        return FALSE;
+    }
+
+    lines = g_strsplit (contents, "\n", 0);
+    g_free (contents);
+
+    sats = g_ptr_array_new ();
+    for (i = 0; lines[i] != NULL && lines[i+1] != NULL && lines[i+2] != NULL; i += 3) {
+        sat = g_new0 (sat_t, 1);
+        if (gtk_sat_data_read_tle (g_strstrip (lines[i]), lines[i+1], lines[i+2], sat)) {
+            printf ("Could not read TLE data of %s\n", lines[i]);
+            g_strfreev (lines);
+            return FALSE;
+        }
+        g_ptr_array_add (sats, sat);
+    }
+
+    g_strfreev (lines);
+
+    return (sats->len > 0);
+}
+
+
+/* read the reference passes */
+static gboolean
+read_refs (void)
+{
+    FILE  *fp;
+    char   path[1024];
+    char   line[256];
+    ref_t  ref;
+
+    test_data_file (path, sizeof (path), "test-012.ref");
+    fp = fopen (path, "r");
+    if (fp == NULL) {
+        printf ("Could not open %s\n", path);
+        return FALSE;
+    }
+
+    refs = g_array_new (FALSE, FALSE, sizeof (ref_t));
+    while (fgets (line, sizeof (line), fp) != NULL) {
+
+        if (line[0] == '#' || line[0] == '\n')
+            continue;
+
+        if (sscanf (line, "%d %31s %lf %lf %lf %lf %lf %lf",
+                    &ref.catnr, ref.qth, &ref.aos, &ref.tca, &ref.los,
+                    &ref.max_el, &ref.aos_az, &ref.los_az) != 8) {
+            printf ("Bad reference line: %s", line);
+            fclose (fp);
+            return FALSE;
+        }
+        g_array_append_val (refs, ref);
+    }
+
+    fclose (fp);
+
+    return TRUE;
+}
+
+
+static void
+check_value (const char *what, const ref_t *ref, int n, double res, double exp, double tol)
+{
+    if (fabs (res - exp) <= tol)
+        return;
+
+    printf ("FAIL %5d %-12s pass %d %s: %.8f expected %.8f delta %.8f > %.8f\n",
+            ref->catnr, ref->qth, n, what, res, exp, fabs (res - exp), tol);
+    failed++;
+}
+
+
+/* compare the passes of one satellite and ground station with the references */
+static int
+check_passes (sat_t *sat, const station_t *station, GSList *passes, gboolean summary)
+{
+    const char *mode = summary ? "summary" : "full";
+    GSList     *node = passes;
+    pass_t     *pass;
+    ref_t      *ref;
+    guint       i;
+    int         n = 0;
+
+    for (i = 0; i < refs->len; i++) {
+        ref = &g_array_index (refs, ref_t, i);
+        if (ref->catnr != sat->tle.catnr || strcmp (ref->qth, station->name))
+            continue;
+
+        if (node == NULL) {
+            printf ("FAIL %5d %-12s %s: pass %d is missing\n",
+                    ref->catnr, ref->qth, mode, n);
+            failed++;
+            n++;
+            continue;
+        }
+        pass = PASS (node->data);
+
+        check_value ("AOS", ref, n, pass->aos, ref->aos, TIME_TOL);
+        check_value ("LOS", ref, n, pass->los, ref->los, TIME_TOL);
+        check_value ("AOS az", ref, n, pass->aos_az, ref->aos_az, ANGLE_TOL);
+        check_value ("LOS az", ref, n, pass->los_az, ref->los_az, ANGLE_TOL);
+        check_value ("TCA", ref, n, pass->tca, ref->tca, TIME_TOL);
+        check_value ("max el", ref, n, pass->max_el, ref->max_el, ANGLE_TOL);
+
+        node = node->next;
+        n++;
+    }
+
+    if (node != NULL) {
+        printf ("FAIL %5d %-12s %s: %d passes more than expected\n",
+                sat->tle.catnr, station->name, mode, g_slist_length (node));
+        failed++;
+    }
+
+    return n;
+}
+
+
+int
+main (int argc, char **argv)
+{
+    qth_t    qth;
+    sat_t   *sat;
+    GSList  *passes, *node;
+    pass_t  *pass;
+    gboolean generate;
+    guint    i, j;
+    int      num = 0;
+
+
+    /* the configuration is not loaded, so do not complain about it */
+    sat_log_set_level (SAT_LOG_LEVEL_NONE);
+
+    generate = (argc > 1 && !strcmp (argv[1], "-g"));
+
+    if (!read_sats ())
+        return 1;
+    if (!generate && !read_refs ())
+        return 1;
+
+    for (i = 0; i < sats->len; i++) {
+        sat = g_ptr_array_index (sats, i);
+
+        for (j = 0; j < G_N_ELEMENTS (stations); j++) {
+            memset (&qth, 0, sizeof (qth));
+            qth.lat = stations[j].lat;
+            qth.lon = stations[j].lon;
+            qth.alt = stations[j].alt;
+
+            passes = get_passes (sat, &qth, START, DAYS, G_MAXINT);
+
+            if (generate) {
+                for (node = passes; node != NULL; node = node->next) {
+                    pass = PASS (node->data);
+                    printf ("%5d %-12s %.8f %.8f %.8f %8.4f %8.4f %8.4f\n",
+                            sat->tle.catnr, stations[j].name,
+                            pass->aos, pass->tca, pass->los,
+                            pass->max_el, pass->aos_az, pass->los_az);
+                }
+                free_passes (passes);
+                continue;
+            }
+
+            num += check_passes (sat, &stations[j], passes, FALSE);
+            free_passes (passes);
+
+            passes = get_passes_summary (sat, &qth, START, DAYS, G_MAXINT);
+            check_passes (sat, &stations[j], passes, TRUE);
+            free_passes (passes);
+        }
+    }
+
+    for (i = 0; i < sats->len; i++)
+        gtk_sat_data_free_sat (g_ptr_array_index (sats, i));
+    g_ptr_array_free (sats, TRUE);
+
+    if (generate)
+        return 0;
+
+    g_array_free (refs, TRUE);
+
+    printf ("%d reference passes, %d failures\n", num, failed);
+
+    return (failed > 0 || num == 0) ? 1 : 0;
+}
@@ -0,0 +1,167 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2012  Alexandru Csete.
+
+    Authors: Alexandru Csete <csete@users.sourceforge.net>
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+/** \defgroup test013 Accuracy of the ephemeris cache
+ *  \ingroup tests
+ *
+ * Evaluates the satellites in test-012.tle from the ephemeris cache of
+ * gpredict (sat-ephem-cache.c) for three days and compares the position,
+ * velocity and phase with SGP4 or SDP4 at the same time. The test fails if
+ * the difference is larger than the tolerances below, which are twice the
+ * tolerances of the fits plus the numerical noise of the propagator, or if
+ * the cache falls back to direct propagation for one of these satellites.
+ *
+ * The file is read from the directory in the srcdir environment variable,
+ * which is set by "make check", or from the current directory.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <glib.h>
+#include "sgp4sdp4.h"
+#include "test-common.h"
+#include "sat-ephem-cache.h"
+
+#define MAX_SATS     16
+#define START        2454730.5      /* 2008-09-21 00:00 UTC */
+#define DAYS         3.0
+#define STEP         (37.0/86400.0) /* not a divisor of any span */
+#define POS_TOL      0.1            /* km */
+#define VEL_TOL      1.0E-4         /* km/s */
+#define PHASE_TOL    2.0E-5         /* rad */
+
+
+sat_t  sats[MAX_SATS];
+int    num_sats = 0;
+
+
+/* read the three line element sets */
+static int
+read_sats (void)
+{
+    FILE *fp;
+    char  path[1024];
+    char  tle_str[3][80];
+
+    test_data_file (path, sizeof (path), "test-012.tle");
+    fp = fopen (path, "r");
+    if (fp == NULL) {
+        printf ("Could not open %s\n", path);
+        return 0;
+    }
+
+    while (num_sats < MAX_SATS &&
+           fgets (tle_str[0], 80, fp) != NULL &&
+           fgets (tle_str[1], 80, fp) != NULL &&
+           fgets (tle_str[2], 80, fp) != NULL) {
+
+        memset (&sats[num_sats], 0, sizeof (sat_t));
+        if (Get_Next_Tle_Set (tle_str, &sats[num_sats].tle) != 1) {
+            printf ("Could not read TLE data of %s", tle_str[0]);
+            fclose (fp);
+            return 0;
+        }
+        select_ephemeris (&sats[num_sats]);
+        sats[num_sats].jul_epoch = Julian_Date_of_Epoch (sats[num_sats].tle.epoch);
+        num_sats++;
+    }
+
+    fclose (fp);
+
+    return num_sats;
+}
+
+
+static int
+check (const char *what, int catnr, double t, double delta, double tol)
+{
+    if (delta <= tol)
+        return 0;
+
+    printf ("FAIL %5d t: %.8f %s: delta %.8f > %.8f\n", catnr, t, what, delta, tol);
+
+    return 1;
+}
+
+
+int
+main (void)
+{
+    sat_ephem_cache_t *cache;
+    sat_t              ref, sat;
+    double             t, dpos, dvel, dphase;
+    int                i;
+    int                num = 0;
+    int                failed = 0;
+
+
+    if (!read_sats ())
+        return 1;
+
+    cache = sat_ephem_cache_new ();
+
+    for (i = 0; i < num_sats; i++) {
+        sat_ephem_cache_invalidate (cache);
+        ref = sats[i];
+        sat = sats[i];
+
+        for (t = START; t < START + DAYS; t += STEP) {
+
+            if (!sat_ephem_cache_get (cache, &sat, t)) {
+                printf ("FAIL %5d t: %.8f: not cached\n", sats[i].tle.catnr, t);
+                failed++;
+                continue;
+            }
+
+            /* a fresh state, so SDP4 evaluates its lunar-solar terms at t */
+            Init_State (ref.model, &ref.state);
+            if (ref.flags & DEEP_SPACE_EPHEM_FLAG)
+                SDP4 (&ref, (t - ref.jul_epoch) * xmnpda);
+            else
+                SGP4 (&ref, (t - ref.jul_epoch) * xmnpda);
+            Convert_Sat_State (&ref.pos, &ref.vel);
+
+            dpos = sqrt (Sqr (sat.pos.x - ref.pos.x) + Sqr (sat.pos.y - ref.pos.y) +
+                         Sqr (sat.pos.z - ref.pos.z));
+            dvel = sqrt (Sqr (sat.vel.x - ref.vel.x) + Sqr (sat.vel.y - ref.vel.y) +
+                         Sqr (sat.vel.z - ref.vel.z));
+            dphase = fabs (FMod2p (sat.phase - ref.phase + pi) - pi);
+
+            failed += check ("position", sats[i].tle.catnr, t, dpos, POS_TOL);
+            failed += check ("velocity", sats[i].tle.catnr, t, dvel, VEL_TOL);
+            failed += check ("phase", sats[i].tle.catnr, t, dphase, PHASE_TOL);
+            num++;
+        }
+    }
+
+    sat_ephem_cache_free (cache);
+
+    printf ("%d satellites, %d samples, %d failures\n", num_sats, num, failed);
+
+    return (failed > 0 || num == 0) ? 1 : 0;
+}
@@ -0,0 +1,281 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2012  Alexandru Csete.
+
+    Authors: Alexandru Csete <csete@users.sourceforge.net>
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+/** \defgroup test014 Accuracy test for the eclipse solver
+ *  \ingroup tests
+ *
+ * Finds all umbra entries and exits of the satellites in test-011.tle over
+ * three days from their epoch with Find_Eclipse() and compares them with
+ * the sign changes of the eclipse depth sampled every REF_STEP seconds and
+ * refined by bisection to 1 ms. The test fails if
+ *
+ *  - a sampled event is not found by the solver,
+ *  - an event of the solver is more than ERR_MAX seconds off, unless the
+ *    depth there is within DEPTH_TOL of zero (grazing eclipse), or
+ *  - the solver finds an event that is not a sign change of the depth.
+ *
+ * The solver may find short eclipses that the sampling misses; they are
+ * counted but are not errors. The time of the sampling and of the solver
+ * is printed.
+ *
+ * The file is read from the directory in the srcdir environment variable,
+ * which is set by "make check", or from the current directory.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "sgp4sdp4.h"
+#include "test-common.h"
+
+#define MAX_SATS     16
+#define WINDOW       3.0        /* days */
+#define MAX_EVENTS   512        /* per satellite */
+#define REF_STEP     10.0       /* sec */
+#define MATCH_TOL    60.0       /* sec; to match events */
+#define ERR_MAX      0.5        /* sec */
+#define DEPTH_TOL    1.0E-5     /* rad */
+
+
+/* an umbra entry or exit */
+typedef struct {
+    double  t;
+    int     entry;
+} event_t;
+
+
+sat_t  sats[MAX_SATS];
+int    num_sats = 0;
+
+
+/* read the three line element sets */
+static int
+read_sats (void)
+{
+    FILE *fp;
+    char  path[1024];
+    char  tle_str[3][80];
+
+    test_data_file (path, sizeof (path), "test-011.tle");
+    fp = fopen (path, "r");
+    if (fp == NULL) {
+        printf ("Could not open %s\n", path);
+        return 0;
+    }
+
+    while (num_sats < MAX_SATS &&
+           fgets (tle_str[0], 80, fp) != NULL &&
+           fgets (tle_str[1], 80, fp) != NULL &&
+           fgets (tle_str[2], 80, fp) != NULL) {
+
+        memset (&sats[num_sats], 0, sizeof (sat_t));
+        if (Get_Next_Tle_Set (tle_str, &sats[num_sats].tle) != 1) {
+            printf ("Could not read TLE data of %s", tle_str[0]);
+            fclose (fp);
+            return 0;
+        }
+        select_ephemeris (&sats[num_sats]);
+        sats[num_sats].jul_epoch = Julian_Date_of_Epoch (sats[num_sats].tle.epoch);
+        num_sats++;
+    }
+
+    fclose (fp);
+
+    return num_sats;
+}
+
+
+/* eclipse depth in radians at time t (Julian date) */
+static double
+depth_at (sat_t *sat, double t)
+{
+    vector_t sun;
+    double   depth;
+
+    sat->tsince = (t - sat->jul_epoch) * xmnpda;
+    if (sat->flags & DEEP_SPACE_EPHEM_FLAG)
+        SDP4 (sat, sat->tsince);
+    else
+        SGP4 (sat, sat->tsince);
+    Convert_Sat_State (&sat->pos, &sat->vel);
+
+    Calculate_Solar_Position (t, &sun);
+    Sat_Eclipsed (&sat->pos, &sun, &depth);
+
+    return depth;
+}
+
+
+/* events from the sampled depth */
+static int
+sample_events (sat_t *sat, double start, event_t *ev)
+{
+    double t, f, tn, fn, a, b, fa, m, fm;
+    int    n = 0;
+
+    t = start;
+    f = depth_at (sat, t);
+
+    while (t < start + WINDOW && n < MAX_EVENTS) {
+        tn = t + REF_STEP / secday;
+        fn = depth_at (sat, tn);
+
+        if ((f < 0.0) != (fn < 0.0)) {
+            a = t;
+            fa = f;
+            b = tn;
+            while ((b - a) * secday > 1.0E-3) {
+                m = 0.5 * (a + b);
+                fm = depth_at (sat, m);
+                if ((fm < 0.0) == (fa < 0.0)) {
+                    a = m;
+                    fa = fm;
+                }
+                else {
+                    b = m;
+                }
+            }
+            ev[n].t = 0.5 * (a + b);
+            ev[n].entry = (fn >= 0.0);
+            n++;
+        }
+
+        t = tn;
+        f = fn;
+    }
+
+    return n;
+}
+
+
+/* events from the solver */
+static int
+solver_events (sat_t *sat, double start, event_t *ev)
+{
+    double t = start;
+    int    eclipsed;
+    int    n = 0;
+
+    eclipsed = (depth_at (sat, t) >= 0.0);
+
+    while (n < MAX_EVENTS) {
+        t = Find_Eclipse (sat, t, start + WINDOW - t, !eclipsed);
+        if (t == 0.0)
+            break;
+
+        eclipsed = !eclipsed;
+        ev[n].t = t;
+        ev[n].entry = eclipsed;
+        n++;
+    }
+
+    return n;
+}
+
+
+int
+main (void)
+{
+    static event_t ref[MAX_EVENTS], res[MAX_EVENTS];
+    clock_t  c0;
+    double   t_ref = 0.0, t_res = 0.0;
+    double   err, err_max = 0.0, start;
+    int      nref, nres, i, j, best;
+    int      total = 0, extra = 0, failed = 0;
+
+
+    if (!read_sats ())
+        return 1;
+
+    for (i = 0; i < num_sats; i++) {
+        start = sats[i].jul_epoch;
+
+        c0 = clock ();
+        nref = sample_events (&sats[i], start, ref);
+        t_ref += (double) (clock () - c0) / CLOCKS_PER_SEC;
+
+        c0 = clock ();
+        nres = solver_events (&sats[i], start, res);
+        t_res += (double) (clock () - c0) / CLOCKS_PER_SEC;
+
+        /* every sampled event must be found */
+        for (j = 0; j < nref; j++) {
+            for (best = 0; best < nres; best++)
+                if (res[best].entry == ref[j].entry &&
+                    fabs (res[best].t - ref[j].t) * secday < MATCH_TOL)
+                    break;
+
+            if (best == nres) {
+                printf ("FAIL %5d %s at %.6f not found\n", sats[i].tle.catnr,
+                        ref[j].entry ? "entry" : "exit ", ref[j].t);
+                failed++;
+                continue;
+            }
+
+            err = fabs (res[best].t - ref[j].t) * secday;
+            if (err > ERR_MAX && fabs (depth_at (&sats[i], res[best].t)) > DEPTH_TOL) {
+                printf ("FAIL %5d %s at %.6f: error %.3f s\n", sats[i].tle.catnr,
+                        ref[j].entry ? "entry" : "exit ", ref[j].t, err);
+                failed++;
+            }
+            if (err > err_max)
+                err_max = err;
+        }
+
+        /* events of the solver that the sampling missed must be real */
+        for (j = 0; j < nres; j++) {
+            for (best = 0; best < nref; best++)
+                if (ref[best].entry == res[j].entry &&
+                    fabs (res[j].t - ref[best].t) * secday < MATCH_TOL)
+                    break;
+
+            if (best < nref)
+                continue;
+
+            if ((depth_at (&sats[i], res[j].t - 1.0 / secday) < 0.0) ==
+                (depth_at (&sats[i], res[j].t + 1.0 / secday) < 0.0)) {
+                printf ("FAIL %5d %s at %.6f is no event\n", sats[i].tle.catnr,
+                        res[j].entry ? "entry" : "exit ", res[j].t);
+                failed++;
+            }
+            else {
+                extra++;
+            }
+        }
+
+        printf ("%5d %-20s %3d events\n", sats[i].tle.catnr, sats[i].tle.sat_name, nref);
+        total += nref;
+    }
+
+    printf ("sampling %.0f s: %4d events %8.2f ms\n", REF_STEP, total, 1000.0 * t_ref);
+    printf ("Find_Eclipse:    %4d events %8.2f ms  error max %.3f s  (%d not sampled)\n",
+            total + extra, 1000.0 * t_res, err_max, extra);
+    printf ("%d failures\n", failed);
+
+    return (failed > 0 || total == 0) ? 1 : 0;
+}
@@ -0,0 +1,373 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2012  Alexandru Csete.
+
+    Authors: Alexandru Csete <csete@users.sourceforge.net>
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+/** \defgroup test015 Regression test for the rotator trajectory planner
+ *  \ingroup tests
+ *
+ * Builds rotator plans (rotor-plan.c) for the next pass of a few satellites
+ * and checks that
+ *
+ *  - without slew rates every point is the satellite position at its time,
+ *    or the AOS position before AOS, mapped to rotator coordinates: no
+ *    elevation below the horizon, -180..+180 azimuth for ROT_AZ_TYPE_180,
+ *    and the flip only if the rotator can go beyond 90 degrees elevation;
+ *  - with slew rates no two points are further apart than the rotator can
+ *    move in one step, and a profile that the rotator can follow anyway is
+ *    left unchanged;
+ *  - the lead point of every point is the last one ahead within tolerance
+ *    and within the search horizon, for several tolerances;
+ *  - rotor_plan_get returns the interpolated position and the lead point of
+ *    the point at or before t, and nothing outside the plan.
+ *
+ * The satellites are derived from test-001.tle (SGP4) and test-002.tle
+ * (SDP4).
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <glib.h>
+#include "sgp4sdp4.h"
+#include "test-common.h"
+#include "sat-log.h"
+#include "gtk-sat-data.h"
+#include "qth-data.h"
+#include "predict-tools.h"
+#include "rotor-conf.h"
+#include "rotor-plan.h"
+
+#define NUM_SATS    8
+#define PREPOS      (60.0/secday)   /* plan start before AOS */
+#define HORIZON     1200.0          /* ROTOR_PLAN_HORIZON [sec] */
+#define EPS         1.0e-9
+
+qth_t       qth;
+
+
+/* a rotator without slew rates */
+static void
+init_conf (rotor_conf_t *conf, rot_az_type_t aztype, gdouble maxel)
+{
+    memset (conf, 0, sizeof (*conf));
+    conf->aztype = aztype;
+    conf->minaz = (aztype == ROT_AZ_TYPE_180) ? -180.0 : 0.0;
+    conf->maxaz = conf->minaz + 360.0;
+    conf->minel = 0.0;
+    conf->maxel = maxel;
+}
+
+
+/* build a plan on a private copy of the satellite */
+static rotor_plan_t *
+make_plan (sat_t *sat, const rotor_conf_t *conf, pass_t *pass,
+           gboolean flipped, gdouble tolerance)
+{
+    sat_t copy = *sat;
+
+    return rotor_plan_new (&copy, &qth, conf, pass->aos - PREPOS, pass->aos,
+                           pass->los, flipped, tolerance);
+}
+
+
+/* satellite position of every point of the plan, held at AOS before AOS */
+static void
+raw_profile (sat_t *sat, pass_t *pass, rotor_plan_t *plan,
+             gdouble *az, gdouble *el)
+{
+    sat_t   copy = *sat;
+    gdouble t;
+    guint   i;
+
+    for (i = 0; i < plan->num; i++) {
+        t = MAX (plan->start + i * plan->step, pass->aos);
+        predict_calc (&copy, &qth, t);
+        az[i] = copy.az;
+        el[i] = MAX (copy.el, 0.0);
+    }
+}
+
+
+/* the plan must be the raw profile mapped to rotator coordinates */
+static guint
+check_mapping (const char *name, rotor_plan_t *plan, const gdouble *az,
+               const gdouble *el, gboolean flip, gboolean az180)
+{
+    gdouble a, e;
+    guint   i;
+
+    for (i = 0; i < plan->num; i++) {
+        a = az[i];
+        e = el[i];
+        if (flip) {
+            e = 180.0 - e;
+            a = (a > 180.0) ? a - 180.0 : a + 180.0;
+        }
+        if (az180 && (a > 180.0))
+            a -= 360.0;
+
+        if ((fabs (plan->az[i] - a) > EPS) || (fabs (plan->el[i] - e) > EPS)) {
+            printf ("%s: point %u at %.4f/%.4f instead of %.4f/%.4f\n",
+                    name, i, plan->az[i], plan->el[i], a, e);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+
+/* no step of the plan may be larger than the rotator can move */
+static guint
+check_rates (rotor_plan_t *plan, const rotor_conf_t *conf)
+{
+    gdouble daz = conf->azrate * plan->step * secday;
+    gdouble del = conf->elrate * plan->step * secday;
+    guint   i;
+
+    for (i = 1; i < plan->num; i++) {
+        if ((fabs (plan->az[i] - plan->az[i-1]) > daz * (1.0 + EPS)) ||
+            (fabs (plan->el[i] - plan->el[i-1]) > del * (1.0 + EPS))) {
+            printf ("RATE %.1f/%.1f deg/s: step %u is %.4f/%.4f deg, limit %.4f/%.4f\n",
+                    conf->azrate, conf->elrate, i,
+                    plan->az[i] - plan->az[i-1], plan->el[i] - plan->el[i-1],
+                    daz, del);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+
+/* lead[i] must be the last point ahead within tolerance and horizon */
+static guint
+check_lead (rotor_plan_t *plan)
+{
+    gdouble tol = plan->tolerance;
+    guint   horizon = (guint) (HORIZON / (plan->step * secday));
+    guint   i, j, lead;
+
+    for (i = 0; i < plan->num; i++) {
+        lead = plan->lead[i];
+
+        if ((lead < i) || (lead >= plan->num) || (lead - i > horizon)) {
+            printf ("LEAD tol %.1f: point %u has lead %u\n", tol, i, lead);
+            return 1;
+        }
+
+        for (j = i + 1; j <= lead; j++) {
+            if ((fabs (plan->az[j] - plan->az[i]) > tol) ||
+                (fabs (plan->el[j] - plan->el[i]) > tol)) {
+                printf ("LEAD tol %.1f: point %u is out of tolerance of %u\n",
+                        tol, j, i);
+                return 1;
+            }
+        }
+
+        if ((lead + 1 < plan->num) && (lead + 1 - i <= horizon) &&
+            (fabs (plan->az[lead+1] - plan->az[i]) <= tol) &&
+            (fabs (plan->el[lead+1] - plan->el[i]) <= tol)) {
+            printf ("LEAD tol %.1f: lead of point %u stops early at %u\n",
+                    tol, i, lead);
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+
+/* rotor_plan_get a quarter step after every point, at the end and outside */
+static guint
+check_get (rotor_plan_t *plan)
+{
+    gdouble az, el, leadaz, leadel, a, e, tol;
+    guint   i, n = plan->num;
+
+    for (i = 0; i + 1 < n; i++) {
+        if (!rotor_plan_get (plan, plan->start + (i + 0.25) * plan->step,
+                             &az, &el, &leadaz, &leadel)) {
+            printf ("GET: point %u not found\n", i);
+            return 1;
+        }
+
+        a = plan->az[i] + 0.25 * (plan->az[i+1] - plan->az[i]);
+        if (fabs (plan->az[i+1] - plan->az[i]) > 180.0)
+            a = plan->az[i];
+        e = plan->el[i] + 0.25 * (plan->el[i+1] - plan->el[i]);
+
+        /* t has a resolution of about 40 usec near the current Julian date */
+        tol = 1.0e-3 * MAX (fabs (plan->az[i+1] - plan->az[i]),
+                            fabs (plan->el[i+1] - plan->el[i])) + EPS;
+        if ((fabs (az - a) > tol) || (fabs (el - e) > tol)) {
+            printf ("GET: point %u at %.4f/%.4f instead of %.4f/%.4f\n",
+                    i, az, el, a, e);
+            return 1;
+        }
+
+        /* without a lead point the rotator goes to the position itself */
+        a = az;
+        e = el;
+        if (plan->lead[i] > i) {
+            a = plan->az[plan->lead[i]];
+            e = plan->el[plan->lead[i]];
+        }
+        if ((leadaz != a) || (leadel != e)) {
+            printf ("GET: lead of point %u at %.4f/%.4f instead of %.4f/%.4f\n",
+                    i, leadaz, leadel, a, e);
+            return 1;
+        }
+    }
+
+    /* the end may be found as the previous point plus almost one step */
+    if (!rotor_plan_get (plan, plan->end, &az, &el, &leadaz, &leadel)) {
+        printf ("GET: end of plan not found\n");
+        return 1;
+    }
+    tol = EPS;
+    if (n > 1)
+        tol += 1.0e-3 * MAX (fabs (plan->az[n-1] - plan->az[n-2]),
+                             fabs (plan->el[n-1] - plan->el[n-2]));
+    if ((fabs (az - plan->az[n-1]) > tol) || (fabs (el - plan->el[n-1]) > tol)) {
+        printf ("GET: end at %.4f/%.4f instead of %.4f/%.4f\n",
+                az, el, plan->az[n-1], plan->el[n-1]);
+        return 1;
+    }
+
+    if (rotor_plan_get (plan, plan->start - plan->step, &az, &el, &leadaz, &leadel) ||
+        rotor_plan_get (plan, plan->end + plan->step, &az, &el, &leadaz, &leadel)) {
+        printf ("GET: time outside of the plan found\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+
+int
+main (int argc, char **argv)
+{
+    gdouble        tolerances[] = { 0.0, 2.0, 5.0, 20.0 };
+    gdouble        rates[] = { 0.5, 2.0, 6.0 };
+    rotor_conf_t   c360, c180, cflip, cfast;
+    rotor_plan_t  *plan, *ref;
+    sat_t          sat;
+    pass_t        *pass;
+    gdouble       *az, *el, t0;
+    guint          i, j, npasses = 0, failed = 0;
+
+    (void) argc;
+    (void) argv;
+
+    /* the configuration is not loaded, so do not complain about it */
+    sat_log_set_level (SAT_LOG_LEVEL_NONE);
+
+    if (test_read_base ())
+        return 1;
+
+    memset (&qth, 0, sizeof (qth));
+    qth.lat = Degrees (test_obs.lat);
+    qth.lon = Degrees (test_obs.lon);
+    qth.alt = (gint) (test_obs.alt * 1000.0);
+
+    init_conf (&c360, ROT_AZ_TYPE_360, 90.0);
+    init_conf (&c180, ROT_AZ_TYPE_180, 90.0);
+    init_conf (&cflip, ROT_AZ_TYPE_360, 180.0);
+
+    t0 = Julian_Date_of_Epoch (test_tle[0].epoch) + 0.5;
+
+    for (i = 0; i < NUM_SATS; i++) {
+        test_init_sat (&sat, i, TEST_DMO, TEST_DNODE);
+        gtk_sat_data_init_sat (&sat, &qth);
+        predict_calc (&sat, &qth, t0);
+
+        pass = get_pass (&sat, &qth, t0, 3.0);
+        if (pass == NULL) {
+            free_ephemeris (&sat);
+            continue;
+        }
+        npasses++;
+
+        /* az type and flip mapping */
+        ref = make_plan (&sat, &c360, pass, FALSE, 5.0);
+        az = g_new (gdouble, ref->num);
+        el = g_new (gdouble, ref->num);
+        raw_profile (&sat, pass, ref, az, el);
+
+        failed += check_mapping ("AZ 360", ref, az, el, FALSE, FALSE);
+
+        plan = make_plan (&sat, &c180, pass, FALSE, 5.0);
+        failed += check_mapping ("AZ 180", plan, az, el, FALSE, TRUE);
+        rotor_plan_free (plan);
+
+        plan = make_plan (&sat, &cflip, pass, TRUE, 5.0);
+        failed += check_mapping ("FLIP", plan, az, el, TRUE, FALSE);
+        rotor_plan_free (plan);
+
+        /* no flip if the rotator can not go beyond 90 degrees */
+        plan = make_plan (&sat, &c360, pass, TRUE, 5.0);
+        failed += check_mapping ("NO FLIP", plan, az, el, FALSE, FALSE);
+        rotor_plan_free (plan);
+
+        /* slew rates */
+        for (j = 0; j < G_N_ELEMENTS (rates); j++) {
+            cfast = c360;
+            cfast.azrate = rates[j];
+            cfast.elrate = rates[j];
+            plan = make_plan (&sat, &cfast, pass, FALSE, 5.0);
+            failed += check_rates (plan, &cfast);
+            failed += check_lead (plan);
+            rotor_plan_free (plan);
+        }
+
+        /* faster than any step, even across north */
+        cfast = c360;
+        cfast.azrate = 1000.0;
+        cfast.elrate = 1000.0;
+        plan = make_plan (&sat, &cfast, pass, FALSE, 5.0);
+        failed += check_mapping ("FAST", plan, az, el, FALSE, FALSE);
+        rotor_plan_free (plan);
+
+        /* lead points and look-up */
+        for (j = 0; j < G_N_ELEMENTS (tolerances); j++) {
+            rotor_plan_set_tolerance (ref, tolerances[j]);
+            failed += check_lead (ref);
+            failed += check_get (ref);
+        }
+
+        g_free (az);
+        g_free (el);
+        rotor_plan_free (ref);
+        free_pass (pass);
+        free_ephemeris (&sat);
+    }
+
+    printf ("%d passes: %s (%d errors)\n",
+            npasses, (failed || !npasses) ? "FAILED" : "PASSED", failed);
+
+    return (failed || !npasses) ? 1 : 0;
+}
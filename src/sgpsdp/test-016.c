@@ -0,0 +1,184 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2012  Alexandru Csete.
+
+    Authors: Alexandru Csete <csete@users.sourceforge.net>
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+/** \defgroup test016 Regression test for the AOS/LOS event cache
+ *  \ingroup tests
+ *
+ * Asks the event cache of gpredict (sat-event-cache.c) for the next AOS
+ * and LOS of a few satellites and compares the answers with find_aos and
+ * find_los at the same time and look-ahead. Each satellite gets 1000
+ * queries with time running forward, 1000 with time running backward and
+ * 1000 at random times. For every query the test also checks that the
+ * cache was filled again exactly when the query left the cached window
+ * [t - 0.5; t + maxdt + 1] of the previous fill.
+ *
+ * Then it checks that the cache is filled again when the TLE epoch of the
+ * satellite changes and when the QTH moves more than 1 km, but not when
+ * the QTH moves less than that, and that the answers after the change are
+ * those of the new TLE or QTH.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <glib.h>
+#include "sgp4sdp4.h"
+#include "test-common.h"
+#include "predict-tools.h"
+#include "qth-data.h"
+#include "sat-event-cache.h"
+
+#define NUM_SATS     3
+#define NUM_QUERIES  1000
+#define MAXDT        2.0              /* look-ahead [days] */
+#define STEP         (127.0/86400.0)  /* forward and backward step */
+#define JUMP_SPAN    8.0              /* range of the random times [days] */
+/* SDP4 keeps its lunar-solar periodics for 30 minutes of propagation, so
+   the same event found from another start time can move a few seconds */
+#define TOL          (10.0/86400.0)
+
+
+static qth_t  qth;
+static int    num_fills = 0;
+
+
+/* compare a cached event with the one from the solver */
+static int
+check (const char *what, int catnr, double t, double res, double exp)
+{
+    if ((res == 0.0) == (exp == 0.0) && fabs (res - exp) <= TOL)
+        return 0;
+
+    printf ("FAIL %5d t: %.8f %s: %.8f expected %.8f\n", catnr, t, what, res, exp);
+
+    return 1;
+}
+
+
+/* one query; checks the answer and whether the cache was filled again,
+   which it must be if t leaves the window or changed is TRUE */
+static int
+query (sat_event_cache_t *cache, sat_t *sat, double t, gboolean changed)
+{
+    sat_t    ref = *sat;
+    gdouble  aos, los;
+    gdouble  start = cache->start;
+    gdouble  end = cache->end;
+    gboolean refill, filled;
+    int      failed = 0;
+
+    refill = changed || !cache->valid || (t < start) || (t + MAXDT > end);
+
+    sat_event_cache_get (cache, sat, &qth, t, MAXDT, &aos, &los);
+
+    filled = (cache->start != start || cache->end != end);
+    if (filled)
+        num_fills++;
+
+    if (refill != filled) {
+        printf ("FAIL %5d t: %.8f window [%.8f;%.8f] %s\n",
+                sat->tle.catnr, t, start, end,
+                refill ? "not filled again" : "filled again");
+        failed++;
+    }
+
+    failed += check ("AOS", sat->tle.catnr, t, aos,
+                     find_aos (&ref, &qth, t, MAXDT, 0.0));
+    failed += check ("LOS", sat->tle.catnr, t, los,
+                     find_los (&ref, &qth, t, MAXDT, 0.0));
+
+    return failed;
+}
+
+
+int
+main (void)
+{
+    sat_event_cache_t *cache;
+    sat_t              sat;
+    tle_t              tle;
+    double             t0, t;
+    guint32            seed = 12345;
+    int                i, j;
+    int                num = 0;
+    int                failed = 0;
+
+
+    if (test_read_base ())
+        return 1;
+
+    memset (&qth, 0, sizeof (qth));
+    qth.lat = Degrees (test_obs.lat);
+    qth.lon = Degrees (test_obs.lon);
+    qth.alt = (gint) (test_obs.alt * 1000.0);
+
+    for (i = 0; i < NUM_SATS; i++) {
+        test_init_sat (&sat, i, TEST_DMO, TEST_DNODE);
+        cache = sat_event_cache_new ();
+        t0 = sat.jul_epoch + 0.25;
+
+        /* forward, leaving the window at its end */
+        for (j = 0, t = t0; j < NUM_QUERIES; j++, t += STEP, num++)
+            failed += query (cache, &sat, t, FALSE);
+
+        /* backward, leaving the window at its start */
+        for (j = 0; j < NUM_QUERIES; j++, t -= STEP, num++)
+            failed += query (cache, &sat, t, FALSE);
+
+        /* jumps */
+        for (j = 0; j < NUM_QUERIES; j++, num++) {
+            seed = seed * 1103515245 + 12345;
+            t = t0 + JUMP_SPAN * ((seed >> 8) & 0xffff) / 65536.0;
+            failed += query (cache, &sat, t, FALSE);
+        }
+
+        /* a new TLE epoch well inside the window */
+        t = cache->start + 1.0;
+        failed += query (cache, &sat, t, FALSE);
+        test_vary_tle (&tle, i, TEST_DMO, TEST_DNODE);
+        tle.epoch += 0.25;
+        free_ephemeris (&sat);
+        test_init_tle (&sat, &tle);
+        failed += query (cache, &sat, t + 0.1, TRUE);
+
+        /* QTH moves of about 0.6 km and 2.2 km to the north */
+        qth.lat += 0.005;
+        failed += query (cache, &sat, t + 0.2, FALSE);
+        qth.lat += 0.02;
+        failed += query (cache, &sat, t + 0.3, TRUE);
+        qth.lat = Degrees (test_obs.lat);
+        num += 4;
+
+        sat_event_cache_free (cache);
+        free_ephemeris (&sat);
+    }
+
+    printf ("%d satellites, %d queries, %d fills, %d failures\n",
+            NUM_SATS, num, num_fills, failed);
+
+    return (failed > 0) ? 1 : 0;
+}
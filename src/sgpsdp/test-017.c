@@ -0,0 +1,210 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2012  Alexandru Csete.
+
+    Authors: Alexandru Csete <csete@users.sourceforge.net>
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+/** \defgroup test017 Accuracy of the Doppler curve
+ *  \ingroup tests
+ *
+ * Computes the Doppler curve of the radio controller (doppler-curve.c) for
+ * the passes of the ISS in test-012.tle over the test ground station on
+ * one day and compares the interpolated range rate with predict_calc at
+ * times between the points of the curve.
+ *
+ * Each pass is checked twice: with a curve from AOS to LOS, which has one
+ * point per second, and with a curve that reaches three hours before and
+ * after the pass. The latter needs more than DOPPLER_CURVE_MAX points, so
+ * it must keep that many and widen the step instead. The tolerances are
+ * about 1 Hz at 70 cm for the one second step and scale with the square of
+ * the step, like the error of a linear interpolation.
+ *
+ * The curve must also refuse times outside it and remember the TLE epoch
+ * it was computed with.
+ *
+ * The file is read from the directory in the srcdir environment variable,
+ * which is set by "make check", or from the current directory.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <glib.h>
+#include "sgp4sdp4.h"
+#include "test-common.h"
+#include "qth-data.h"
+#include "predict-tools.h"
+#include "doppler-curve.h"
+
+#define START        2454730.5      /* 2008-09-21 00:00 UTC */
+#define DAYS         1.0
+#define MARGIN       (3.0/24.0)     /* before and after the long curves */
+#define CURVE_MAX    8192           /* DOPPLER_CURVE_MAX in doppler-curve.c */
+#define SAMPLE       (0.37/86400.0) /* not a divisor of the step */
+#define RR_TOL       7.0E-4         /* km/s for a step of 1 s */
+
+
+static qth_t  qth;
+
+
+/* compare a curve with predict_calc over [start;end] */
+static int
+check_curve (sat_t *sat, doppler_curve_t *curve, double start, double end,
+             const char *what)
+{
+    sat_t   ref = *sat;
+    double  t, rr, tol, err;
+    double  max = 0.0;
+    int     failed = 0;
+
+    tol = RR_TOL * Sqr (curve->step * secday);
+
+    for (t = start; t <= MIN (end, curve->end); t += SAMPLE) {
+        if (!doppler_curve_get (curve, t, &rr)) {
+            printf ("FAIL %s t: %.8f: not in the curve [%.8f;%.8f]\n",
+                    what, t, curve->start, curve->end);
+            failed++;
+            continue;
+        }
+        predict_calc (&ref, &qth, t);
+        err = fabs (rr - ref.range_rate);
+        if (err > max)
+            max = err;
+        if (err > tol) {
+            printf ("FAIL %s t: %.8f: range rate %.6f expected %.6f\n",
+                    what, t, rr, ref.range_rate);
+            failed++;
+        }
+    }
+
+    printf ("%s: %u points, step %.3f s, max error %.2e km/s (tol %.2e)\n",
+            what, curve->num, curve->step * secday, max, tol);
+
+    return failed;
+}
+
+
+/* the properties of a new curve over [start;end] */
+static int
+check_layout (sat_t *sat, doppler_curve_t *curve, double start, double end,
+              guint num, const char *what)
+{
+    double rr;
+    int    failed = 0;
+
+    if (curve == NULL) {
+        printf ("FAIL %s: no curve\n", what);
+        return 1;
+    }
+    if (curve->num != num) {
+        printf ("FAIL %s: %u points, expected %u\n", what, curve->num, num);
+        failed++;
+    }
+    if (curve->start != start || curve->end < end - 1.0E-9) {
+        printf ("FAIL %s: [%.8f;%.8f] does not cover [%.8f;%.8f]\n",
+                what, curve->start, curve->end, start, end);
+        failed++;
+    }
+    if (curve->epoch != sat->tle.epoch) {
+        printf ("FAIL %s: epoch %.8f, expected %.8f\n",
+                what, curve->epoch, sat->tle.epoch);
+        failed++;
+    }
+    if (doppler_curve_get (curve, curve->start - SAMPLE, &rr) ||
+        doppler_curve_get (curve, curve->end + SAMPLE, &rr)) {
+        printf ("FAIL %s: a time outside the curve was accepted\n", what);
+        failed++;
+    }
+
+    return failed;
+}
+
+
+int
+main (void)
+{
+    doppler_curve_t *curve;
+    sat_t            sat, copy;
+    tle_t            tle;
+    double           t, aos, los;
+    guint            num;
+    int              passes = 0;
+    int              failed = 0;
+
+
+    if (test_read_tle ("test-012.tle", &tle))
+        return 1;
+    test_init_tle (&sat, &tle);
+
+    memset (&qth, 0, sizeof (qth));
+    qth.lat = Degrees (test_obs.lat);
+    qth.lon = Degrees (test_obs.lon);
+    qth.alt = (gint) (test_obs.alt * 1000.0);
+
+    for (t = START; t < START + DAYS; t = los + 1.0E-4) {
+        copy = sat;
+        aos = find_aos (&copy, &qth, t, START + DAYS - t, 0.0);
+        if (aos == 0.0)
+            break;
+        los = find_los (&copy, &qth, aos, 1.0, 0.0);
+        if (los == 0.0)
+            break;
+        passes++;
+
+        /* one point per second */
+        copy = sat;
+        curve = doppler_curve_new (&copy, &qth, aos, los);
+        num = (guint) ceil ((los - aos) * secday) + 1;
+        failed += check_layout (&sat, curve, aos, los, num, "pass");
+        if (curve != NULL)
+            failed += check_curve (&sat, curve, aos, los, "pass");
+        doppler_curve_free (curve);
+
+        /* too many points, so the step is widened */
+        copy = sat;
+        curve = doppler_curve_new (&copy, &qth, aos - MARGIN, los + MARGIN);
+        failed += check_layout (&sat, curve, aos - MARGIN, los + MARGIN,
+                                CURVE_MAX, "long");
+        if (curve != NULL) {
+            if (curve->step * secday <= 1.0) {
+                printf ("FAIL long: step %.3f s not widened\n",
+                        curve->step * secday);
+                failed++;
+            }
+            failed += check_curve (&sat, curve, aos - MARGIN, los + MARGIN, "long");
+        }
+        doppler_curve_free (curve);
+    }
+
+    if (doppler_curve_new (&sat, &qth, START, START) != NULL) {
+        printf ("FAIL an empty window gave a curve\n");
+        failed++;
+    }
+
+    free_ephemeris (&sat);
+
+    printf ("%d passes, %d failures\n", passes, failed);
+
+    return (failed > 0 || passes == 0) ? 1 : 0;
+}
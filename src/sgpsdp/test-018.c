@@ -0,0 +1,429 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2012  Alexandru Csete.
+
+    Authors: Alexandru Csete <csete@users.sourceforge.net>
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+/** \defgroup test018 Regression test for the rigctld connections
+ *  \ingroup tests
+ *
+ * Talks to a fake rigctld on a local socket through the connections of
+ * gpredict (hamlib-io.c) and checks that
+ *
+ *  - the commands of several batches are pipelined: the fake daemon only
+ *    answers when it has received the commands of all batches, and the
+ *    batches are still finished in order with the right answers;
+ *  - an "RPRT" error ends the answer of a get command that normally has
+ *    two lines, and the following commands get their own answers;
+ *  - when the daemon drops the connection, the commands that are waiting
+ *    for an answer fail, and the next batch connects again;
+ *  - after hamlib_io_close the commands in flight are still written and
+ *    answered before the connection says goodbye with "q", but their
+ *    done-function is not called, only the function that frees the data.
+ *
+ * The fake daemon answers "F <freq>" with "RPRT 0", "f" with a frequency,
+ * "m" with a mode and a passband on two lines and "y" with "RPRT -11". It
+ * closes the connection when it receives "DROP" and waits 0.2 s before it
+ * answers "SLOW".
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <glib.h>
+#include "hamlib-io.h"
+
+#define NUM_BATCHES  3
+#define TIMEOUT      10000     /* msec to wait for the done-functions */
+#define FREQ         "145000000"
+
+
+/* the fake rigctld */
+static gint          listen_sock = -1;
+static gint          port = 0;
+static GStaticMutex  lock = G_STATIC_MUTEX_INIT;
+static GString      *received = NULL;  /* commands received, space separated */
+static gint          accepted = 0;     /* connections accepted */
+static gint          hold = 0;         /* commands to receive before answering */
+
+/* what the done-functions have seen */
+static gint          done_count = 0;
+static gint          done_order[NUM_BATCHES];
+static gint          done_failed = 0;
+static gint          notified = 0;
+static gboolean      timed_out = FALSE;
+
+
+/* answer one command; FALSE if the connection must be closed */
+static gboolean
+serve_cmd (const gchar *cmd, GString *out)
+{
+    g_static_mutex_lock (&lock);
+    g_string_append_printf (received, "%s%s", received->len ? " " : "", cmd);
+    g_static_mutex_unlock (&lock);
+
+    if (!strcmp (cmd, "q") || !strcmp (cmd, "DROP"))
+        return FALSE;
+
+    if (!strncmp (cmd, "F ", 2))
+        g_string_append (out, "RPRT 0\n");
+    else if (!strcmp (cmd, "f"))
+        g_string_append (out, FREQ "\n");
+    else if (!strcmp (cmd, "m"))
+        g_string_append (out, "FM\n15000\n");
+    else if (!strcmp (cmd, "y"))
+        g_string_append (out, "RPRT -11\n");
+    else if (!strcmp (cmd, "SLOW")) {
+        g_usleep (200000);
+        g_string_append (out, "RPRT 0\n");
+    }
+    else
+        g_string_append (out, "RPRT -1\n");
+
+    return TRUE;
+}
+
+
+/* serve one connection until it is closed by either side */
+static void
+serve (gint sock)
+{
+    GString  *in = g_string_new (NULL);
+    GString  *out = g_string_new (NULL);
+    gchar     buff[256];
+    gchar    *nl;
+    gint      size;
+    gint      num = 0;
+    gboolean  open = TRUE;
+
+    while (open && (size = recv (sock, buff, sizeof (buff), 0)) > 0) {
+        g_string_append_len (in, buff, size);
+        while (open && (nl = memchr (in->str, '\n', in->len)) != NULL) {
+            *nl = '\0';
+            open = serve_cmd (in->str, out);
+            g_string_erase (in, 0, nl - in->str + 1);
+            num++;
+        }
+        if ((num >= g_atomic_int_get (&hold) || !open) && out->len > 0) {
+            if (send (sock, out->str, out->len, 0) != (gssize) out->len)
+                open = FALSE;
+            g_string_truncate (out, 0);
+        }
+    }
+
+    g_string_free (in, TRUE);
+    g_string_free (out, TRUE);
+}
+
+
+/* main function of the fake rigctld */
+static gpointer
+server_run (gpointer data)
+{
+    gint sock;
+
+    (void) data;
+
+    while ((sock = accept (listen_sock, NULL, NULL)) >= 0) {
+        g_atomic_int_inc (&accepted);
+        serve (sock);
+        close (sock);
+    }
+
+    return NULL;
+}
+
+
+/* start the fake rigctld on a free port of the loopback interface */
+static gboolean
+server_start (void)
+{
+    struct sockaddr_in addr;
+    socklen_t          len = sizeof (addr);
+
+    listen_sock = socket (PF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listen_sock < 0)
+        return FALSE;
+
+    memset (&addr, 0, sizeof (addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+    addr.sin_port = 0;
+
+    if (bind (listen_sock, (struct sockaddr *) &addr, sizeof (addr)) < 0 ||
+        listen (listen_sock, 4) < 0 ||
+        getsockname (listen_sock, (struct sockaddr *) &addr, &len) < 0)
+        return FALSE;
+
+    port = ntohs (addr.sin_port);
+    received = g_string_new (NULL);
+
+    return g_thread_create (server_run, NULL, FALSE, NULL) != NULL;
+}
+
+
+/* whether the fake rigctld has received a command */
+static gboolean
+server_has (const gchar *cmd)
+{
+    gboolean found;
+
+    g_static_mutex_lock (&lock);
+    found = (strstr (received->str, cmd) != NULL);
+    g_static_mutex_unlock (&lock);
+
+    return found;
+}
+
+
+/* the commands received since the last call */
+static gchar *
+server_log (void)
+{
+    gchar *str;
+
+    g_static_mutex_lock (&lock);
+    str = g_strdup (received->str);
+    g_string_truncate (received, 0);
+    g_static_mutex_unlock (&lock);
+
+    return str;
+}
+
+
+static gboolean
+timeout_cb (gpointer data)
+{
+    (void) data;
+    timed_out = TRUE;
+
+    return FALSE;
+}
+
+
+/* run the main loop until *counter reaches value */
+static gboolean
+wait_for (gint *counter, gint value)
+{
+    guint id;
+
+    timed_out = FALSE;
+    id = g_timeout_add (TIMEOUT, timeout_cb, NULL);
+    while (*counter < value && !timed_out)
+        g_main_context_iteration (NULL, TRUE);
+    if (!timed_out)
+        g_source_remove (id);
+
+    return !timed_out;
+}
+
+
+static int
+check_reply (const gchar *what, hamlib_batch_t *batch, guint i, const gchar *exp)
+{
+    const gchar *reply = hamlib_batch_reply (batch, i);
+
+    if ((reply == NULL && exp == NULL) ||
+        (reply != NULL && exp != NULL && !strcmp (reply, exp)))
+        return 0;
+
+    printf ("FAIL %s: reply %u is \"%s\", expected \"%s\"\n", what, i,
+            reply ? reply : "(null)", exp ? exp : "(null)");
+
+    return 1;
+}
+
+
+static int
+check_str (const gchar *what, gchar *res, const gchar *exp)
+{
+    int failed = strcmp (res, exp) ? 1 : 0;
+
+    if (failed)
+        printf ("FAIL %s: \"%s\", expected \"%s\"\n", what, res, exp);
+    g_free (res);
+
+    return failed;
+}
+
+
+static int
+check_int (const gchar *what, gint res, gint exp)
+{
+    if (res == exp)
+        return 0;
+
+    printf ("FAIL %s: %d, expected %d\n", what, res, exp);
+
+    return 1;
+}
+
+
+/* done-function of the pipelined batches */
+static void
+pipeline_done (hamlib_batch_t *batch, gpointer data)
+{
+    if (done_count < NUM_BATCHES)
+        done_order[done_count] = GPOINTER_TO_INT (data);
+    done_count++;
+
+    done_failed += check_reply ("pipeline", batch, 0, "RPRT 0");
+    done_failed += check_reply ("pipeline", batch, 1, FREQ);
+    done_failed += check_reply ("pipeline", batch, 2, "FM\n15000");
+}
+
+
+/* done-function that must not be called after hamlib_io_close */
+static void
+closed_done (hamlib_batch_t *batch, gpointer data)
+{
+    (void) batch;
+    (void) data;
+
+    done_count++;
+}
+
+
+static void
+closed_notify (gpointer data)
+{
+    (void) data;
+
+    notified++;
+}
+
+
+int
+main (void)
+{
+    hamlib_io_t       *io;
+    hamlib_batch_t    *batch;
+    hamlib_io_stats_t  stats;
+    gchar             *log;
+    gint               i;
+    int                failed = 0;
+
+
+    if (!g_thread_supported ())
+        g_thread_init (NULL);
+
+    if (!server_start ()) {
+        printf ("Could not start the fake rigctld\n");
+        return 1;
+    }
+
+    io = hamlib_io_new ("127.0.0.1", port);
+
+    /* pipelining: nothing is answered before all batches have arrived */
+    g_atomic_int_set (&hold, 3 * NUM_BATCHES);
+    for (i = 0; i < NUM_BATCHES; i++) {
+        batch = hamlib_batch_new ();
+        hamlib_batch_add (batch, 1, "F %d", 145000000 + i);
+        hamlib_batch_add (batch, 1, "f");
+        hamlib_batch_add (batch, 2, "m");
+        hamlib_io_send (io, batch, pipeline_done, GINT_TO_POINTER (i), NULL);
+    }
+    if (!wait_for (&done_count, NUM_BATCHES)) {
+        printf ("FAIL pipeline: %d of %d batches finished\n", done_count, NUM_BATCHES);
+        failed++;
+    }
+    for (i = 0; i < MIN (done_count, NUM_BATCHES); i++)
+        failed += check_int ("pipeline: batch finished", done_order[i], i);
+    failed += done_failed;
+    hamlib_io_get_stats (io, &stats);
+    failed += check_int ("pipeline: answered", stats.num, 3 * NUM_BATCHES);
+    failed += check_int ("pipeline: errors", stats.errors, 0);
+    g_atomic_int_set (&hold, 0);
+    g_free (server_log ());
+
+    /* an error ends the answer of a get command */
+    batch = hamlib_batch_new ();
+    hamlib_batch_add (batch, 2, "y");
+    hamlib_batch_add (batch, 2, "m");
+    hamlib_batch_add (batch, 1, "f");
+    if (!hamlib_io_send_wait (io, batch)) {
+        printf ("FAIL get error: the batch failed\n");
+        failed++;
+    }
+    failed += check_reply ("get error", batch, 0, "RPRT -11");
+    failed += check_reply ("get error", batch, 1, "FM\n15000");
+    failed += check_reply ("get error", batch, 2, FREQ);
+    hamlib_batch_free (batch);
+    failed += check_str ("get error: commands", server_log (), "y m f");
+
+    /* the daemon drops the connection */
+    batch = hamlib_batch_new ();
+    hamlib_batch_add (batch, 1, "f");
+    hamlib_batch_add (batch, 1, "DROP");
+    hamlib_batch_add (batch, 1, "f");
+    if (hamlib_io_send_wait (io, batch)) {
+        printf ("FAIL drop: the batch did not fail\n");
+        failed++;
+    }
+    failed += check_reply ("drop", batch, 0, FREQ);
+    failed += check_reply ("drop", batch, 1, NULL);
+    failed += check_reply ("drop", batch, 2, NULL);
+    hamlib_batch_free (batch);
+    hamlib_io_get_stats (io, &stats);
+    failed += check_int ("drop: errors", stats.errors, 2);
+
+    /* the next batch connects again */
+    batch = hamlib_batch_new ();
+    hamlib_batch_add (batch, 1, "f");
+    if (!hamlib_io_send_wait (io, batch)) {
+        printf ("FAIL reconnect: the batch failed\n");
+        failed++;
+    }
+    failed += check_reply ("reconnect", batch, 0, FREQ);
+    hamlib_batch_free (batch);
+    failed += check_int ("reconnect: connections", g_atomic_int_get (&accepted), 2);
+    g_free (server_log ());
+
+    /* close with commands in flight */
+    done_count = 0;
+    batch = hamlib_batch_new ();
+    hamlib_batch_add (batch, 1, "SLOW");
+    hamlib_batch_add (batch, 1, "SLOW");
+    hamlib_batch_add (batch, 1, "f");
+    hamlib_io_send (io, batch, closed_done, NULL, closed_notify);
+    hamlib_io_close (io);
+    if (!wait_for (&notified, 1)) {
+        printf ("FAIL close: the data of the batch was not freed\n");
+        failed++;
+    }
+    failed += check_int ("close: done-functions called", done_count, 0);
+
+    /* the goodbye comes after the answers, so give it some time */
+    for (i = 0; i < 100 && !server_has ("q"); i++)
+        g_usleep (10000);
+    failed += check_str ("close: commands", server_log (), "SLOW SLOW f q");
+
+    printf ("%d failures\n", failed);
+
+    return (failed > 0) ? 1 : 0;
+}
@@ -0,0 +1,510 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2012  Alexandru Csete.
+
+    Authors: Alexandru Csete <csete@users.sourceforge.net>
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+/** \defgroup test019 Regression test for the rotator control loop
+ *  \ingroup tests
+ *
+ * Runs the rotator control loop of gpredict (rotor-loop.c) against a fake
+ * rotctld on a local socket and checks that
+ *
+ *  - the loop runs one cycle per period, counted from its start, and that
+ *    every cycle is reported to the main loop;
+ *  - when a cycle takes longer than the period, the cycles that are over
+ *    are skipped and counted as missed, so that the cycles and the missed
+ *    cycles still add up to the schedule;
+ *  - a rotator that is out of tolerance is sent to the lead point of the
+ *    plan of the pass at the target time plus the latency of the rotator;
+ *  - after MAX_ERROR_COUNT failed cycles in a row the next failed cycle
+ *    tells the owner to disengage the rotator.
+ *
+ * The fake rotctld answers "p" with a position that the test sets and "P"
+ * with "RPRT 0" without moving. It can wait before it answers "p", and it
+ * can stop serving altogether, after which every command fails.
+ *
+ * The TLE is read from the directory in the srcdir environment variable,
+ * which is set by "make check", or from the current directory.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <glib.h>
+#include "sgp4sdp4.h"
+#include "test-common.h"
+#include "qth-data.h"
+#include "predict-tools.h"
+#include "rotor-conf.h"
+#include "rotor-plan.h"
+#include "rotor-loop.h"
+
+#define START            2454730.5  /* 2008-09-21 00:00 UTC */
+#define DELAY            100        /* period of the loop [msec] */
+#define SLOW             250000     /* time to answer "p" when slow [usec] */
+#define RUN_TIME         1000       /* time to run the schedule checks [msec] */
+#define TIMEOUT          10000      /* msec to wait for a state */
+#define TOLERANCE        5.0        /* [deg] */
+#define LATENCY          2.0        /* [sec] */
+#define MAX_ERROR_COUNT  5          /* as in rotor-loop.c */
+#define POS_TOL          1.0E-6     /* [deg] */
+
+
+/* the fake rotctld */
+static gint          listen_sock = -1;
+static gint          port = 0;
+static GStaticMutex  lock = G_STATIC_MUTEX_INIT;
+static GString      *received = NULL;  /* "P" commands received */
+static gdouble       rotaz = 0.0;      /* position of the rotator */
+static gdouble       rotel = 0.0;
+static gint          slow = 0;         /* wait before answering "p" */
+static gint          broken = 0;       /* stop serving */
+
+/* what the loop has reported */
+static gint          num_states = 0;
+static gint          num_moved = 0;
+static gint          num_failed = 0;
+static gint          errors_in_row = 0;
+static gint          failed_after = -1;  /* errors_in_row at the first failure */
+static rotor_state_t last;
+static gboolean      timed_out = FALSE;
+
+
+/* answer one command; FALSE if the connection must be closed */
+static gboolean
+serve_cmd (const gchar *cmd, GString *out)
+{
+    gchar az[G_ASCII_DTOSTR_BUF_SIZE], el[G_ASCII_DTOSTR_BUF_SIZE];
+
+    if (!strcmp (cmd, "q") || g_atomic_int_get (&broken))
+        return FALSE;
+
+    if (!strcmp (cmd, "p")) {
+        if (g_atomic_int_get (&slow))
+            g_usleep (SLOW);
+        g_static_mutex_lock (&lock);
+        g_ascii_formatd (az, sizeof (az), "%.6f", rotaz);
+        g_ascii_formatd (el, sizeof (el), "%.6f", rotel);
+        g_static_mutex_unlock (&lock);
+        g_string_append_printf (out, "%s\n%s\n", az, el);
+    }
+    else if (!strncmp (cmd, "P ", 2)) {
+        g_static_mutex_lock (&lock);
+        g_string_append_printf (received, "%s\n", cmd);
+        g_static_mutex_unlock (&lock);
+        g_string_append (out, "RPRT 0\n");
+    }
+    else {
+        g_string_append (out, "RPRT -1\n");
+    }
+
+    return TRUE;
+}
+
+
+/* serve one connection until it is closed by either side */
+static void
+serve (gint sock)
+{
+    GString  *in = g_string_new (NULL);
+    GString  *out = g_string_new (NULL);
+    gchar     buff[256];
+    gchar    *nl;
+    gint      size;
+    gboolean  open = TRUE;
+
+    while (open && (size = recv (sock, buff, sizeof (buff), 0)) > 0) {
+        g_string_append_len (in, buff, size);
+        while (open && (nl = memchr (in->str, '\n', in->len)) != NULL) {
+            *nl = '\0';
+            open = serve_cmd (in->str, out);
+            g_string_erase (in, 0, nl - in->str + 1);
+        }
+        if (open && out->len > 0) {
+            if (send (sock, out->str, out->len, 0) != (gssize) out->len)
+                open = FALSE;
+            g_string_truncate (out, 0);
+        }
+    }
+
+    g_string_free (in, TRUE);
+    g_string_free (out, TRUE);
+}
+
+
+/* main function of the fake rotctld; once it is broken the connections
+   are refused */
+static gpointer
+server_run (gpointer data)
+{
+    gint sock;
+
+    (void) data;
+
+    while ((sock = accept (listen_sock, NULL, NULL)) >= 0) {
+        serve (sock);
+        close (sock);
+        if (g_atomic_int_get (&broken)) {
+            close (listen_sock);
+            break;
+        }
+    }
+
+    return NULL;
+}
+
+
+/* start the fake rotctld on a free port of the loopback interface */
+static gboolean
+server_start (void)
+{
+    struct sockaddr_in addr;
+    socklen_t          len = sizeof (addr);
+
+    listen_sock = socket (PF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (listen_sock < 0)
+        return FALSE;
+
+    memset (&addr, 0, sizeof (addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+    addr.sin_port = 0;
+
+    if (bind (listen_sock, (struct sockaddr *) &addr, sizeof (addr)) < 0 ||
+        listen (listen_sock, 4) < 0 ||
+        getsockname (listen_sock, (struct sockaddr *) &addr, &len) < 0)
+        return FALSE;
+
+    port = ntohs (addr.sin_port);
+    received = g_string_new (NULL);
+
+    return g_thread_create (server_run, NULL, FALSE, NULL) != NULL;
+}
+
+
+/* the "P" commands received since the last call */
+static gchar *
+server_log (void)
+{
+    gchar *str;
+
+    g_static_mutex_lock (&lock);
+    str = g_strdup (received->str);
+    g_string_truncate (received, 0);
+    g_static_mutex_unlock (&lock);
+
+    return str;
+}
+
+
+/* function of the loop called after every cycle */
+static void
+state_cb (const rotor_state_t *state, gpointer data)
+{
+    (void) data;
+
+    num_states++;
+    last = *state;
+
+    if (state->moved)
+        num_moved++;
+
+    /* with a target out of tolerance every good cycle moves the rotator */
+    if (!state->valid || !state->moved)
+        errors_in_row++;
+    else
+        errors_in_row = 0;
+
+    if (state->failed) {
+        if (num_failed == 0)
+            failed_after = errors_in_row - 1;
+        num_failed++;
+    }
+}
+
+
+static gboolean
+timeout_cb (gpointer data)
+{
+    (void) data;
+    timed_out = TRUE;
+
+    return FALSE;
+}
+
+
+/* run the main loop until *counter reaches value or for msec if counter
+   is NULL */
+static gboolean
+wait_for (gint *counter, gint value, guint msec)
+{
+    guint id;
+
+    timed_out = FALSE;
+    id = g_timeout_add (msec, timeout_cb, NULL);
+    while ((counter == NULL || *counter < value) && !timed_out)
+        g_main_context_iteration (NULL, TRUE);
+    if (!timed_out)
+        g_source_remove (id);
+
+    return !timed_out;
+}
+
+
+/* compare the cycles and the missed cycles with the slots of the schedule
+   between two times */
+static int
+check_schedule (const gchar *what, const rotor_loop_stats_t *s0,
+                const rotor_loop_stats_t *s1, const GTimeVal *t0,
+                const GTimeVal *t1, gboolean missed)
+{
+    gdouble  elapsed;
+    gint     cycles, skipped, slots;
+    int      failed = 0;
+
+    elapsed = (t1->tv_sec - t0->tv_sec) + 1.0e-6 * (t1->tv_usec - t0->tv_usec);
+    slots = (gint) floor (elapsed * 1000.0 / DELAY);
+    cycles = s1->cycles - s0->cycles;
+    skipped = s1->missed - s0->missed;
+
+    printf ("%s: %.3f s, %d cycles, %d missed, %d slots\n",
+            what, elapsed, cycles, skipped, slots);
+
+    /* the cycle running at either end may or may not be counted */
+    if (abs (cycles + skipped - slots) > 2 + (missed ? SLOW / 1000 / DELAY : 0)) {
+        printf ("FAIL %s: %d cycles and %d missed in %d slots\n",
+                what, cycles, skipped, slots);
+        failed++;
+    }
+    if (!missed && skipped != 0) {
+        printf ("FAIL %s: %d cycles missed\n", what, skipped);
+        failed++;
+    }
+    if (missed && (cycles < 2 || skipped < cycles)) {
+        printf ("FAIL %s: only %d of %d cycles missed\n", what, skipped, cycles);
+        failed++;
+    }
+
+    return failed;
+}
+
+
+static int
+check_pos (const gchar *what, gdouble res, gdouble exp)
+{
+    if (fabs (res - exp) <= POS_TOL)
+        return 0;
+
+    printf ("FAIL %s: %.6f, expected %.6f\n", what, res, exp);
+
+    return 1;
+}
+
+
+int
+main (void)
+{
+    rotor_loop_t       *loop;
+    rotor_loop_stats_t  s0, s1;
+    rotor_target_t      target;
+    rotor_conf_t        conf;
+    rotor_plan_t       *plan;
+    qth_t               qth;
+    sat_t               sat, copy;
+    tle_t               tle;
+    GTimeVal            t0, t1;
+    gdouble             aos, los, setaz, setel, leadaz, leadel;
+    gchar               azstr[8], elstr[8];
+    gchar              *cmd, *log;
+    gint                num;
+    int                 failed = 0;
+
+
+    if (!g_thread_supported ())
+        g_thread_init (NULL);
+
+    /* the loop may write to a connection that the fake rotctld has closed */
+    signal (SIGPIPE, SIG_IGN);
+
+    if (test_read_tle ("test-012.tle", &tle))
+        return 1;
+    test_init_tle (&sat, &tle);
+
+    memset (&qth, 0, sizeof (qth));
+    qth.lat = Degrees (test_obs.lat);
+    qth.lon = Degrees (test_obs.lon);
+    qth.alt = (gint) (test_obs.alt * 1000.0);
+
+    memset (&conf, 0, sizeof (conf));
+    conf.host = "127.0.0.1";
+    conf.aztype = ROT_AZ_TYPE_360;
+    conf.minaz = 0.0;
+    conf.maxaz = 360.0;
+    conf.minel = 0.0;
+    conf.maxel = 90.0;
+    conf.latency = LATENCY;
+
+    if (!server_start ()) {
+        printf ("Could not start the fake rotctld\n");
+        return 1;
+    }
+    conf.port = port;
+
+    /* one cycle per period from the start */
+    memset (&s0, 0, sizeof (s0));
+    g_get_current_time (&t0);
+    loop = rotor_loop_new (&conf, &qth, DELAY, state_cb, NULL);
+    if (loop == NULL) {
+        printf ("Could not start the loop\n");
+        return 1;
+    }
+    wait_for (NULL, 0, RUN_TIME);
+    rotor_loop_get_stats (loop, &s1);
+    g_get_current_time (&t1);
+    failed += check_schedule ("schedule", &s0, &s1, &t0, &t1, FALSE);
+    wait_for (NULL, 0, DELAY / 2);
+    if (abs (num_states - (gint) s1.cycles) > 1) {
+        printf ("FAIL schedule: %d states reported for %u cycles\n",
+                num_states, s1.cycles);
+        failed++;
+    }
+    if (!last.valid || last.az != 0.0 || last.el != 0.0) {
+        printf ("FAIL schedule: position not read back\n");
+        failed++;
+    }
+
+    /* cycles longer than the period */
+    g_atomic_int_set (&slow, 1);
+    wait_for (NULL, 0, RUN_TIME / 2);
+    rotor_loop_get_stats (loop, &s0);
+    g_get_current_time (&t0);
+    wait_for (NULL, 0, 2 * RUN_TIME);
+    rotor_loop_get_stats (loop, &s1);
+    g_get_current_time (&t1);
+    failed += check_schedule ("slow", &s0, &s1, &t0, &t1, TRUE);
+    g_atomic_int_set (&slow, 0);
+
+    /* a target in the middle of the first pass, frozen in time */
+    copy = sat;
+    aos = find_aos (&copy, &qth, START, 1.0, 0.0);
+    los = find_los (&copy, &qth, aos, 1.0, 0.0);
+    if (aos == 0.0 || los == 0.0) {
+        printf ("FAIL no pass of %d\n", sat.tle.catnr);
+        return 1;
+    }
+
+    memset (&target, 0, sizeof (target));
+    target.t = aos + 0.4 * (los - aos);
+    g_get_current_time (&target.stamp);
+    target.rate = 0.0;
+    target.tolerance = TOLERANCE;
+    target.track = TRUE;
+    target.aos = aos;
+    target.los = los;
+    target.flipped = FALSE;
+
+    /* the plan that the loop should build */
+    copy = sat;
+    plan = rotor_plan_new (&copy, &qth, &conf,
+                           MAX (aos - rotor_plan_prepos (&conf), target.t),
+                           aos, los, FALSE, TOLERANCE);
+    if (plan == NULL ||
+        !rotor_plan_get (plan, target.t + LATENCY / secday,
+                         &setaz, &setel, &leadaz, &leadel)) {
+        printf ("FAIL no plan\n");
+        return 1;
+    }
+    rotor_plan_free (plan);
+    target.az = setaz;
+    target.el = setel;
+    if (setaz == leadaz && setel == leadel) {
+        printf ("FAIL lead: the lead point is the set point\n");
+        failed++;
+    }
+
+    /* a rotator out of tolerance in elevation only */
+    g_static_mutex_lock (&lock);
+    rotaz = leadaz;
+    rotel = setel + 3.0 * TOLERANCE;
+    g_static_mutex_unlock (&lock);
+    g_free (server_log ());
+
+    num = num_moved;
+    rotor_loop_set_target (loop, &target, &sat);
+    if (!wait_for (&num_moved, num + 2, TIMEOUT)) {
+        printf ("FAIL lead: the rotator was not moved\n");
+        failed++;
+    }
+    else {
+        failed += check_pos ("lead: az", last.setaz, leadaz);
+        failed += check_pos ("lead: el", last.setel, leadel);
+        g_ascii_formatd (azstr, 8, "%7.2f", leadaz);
+        g_ascii_formatd (elstr, 8, "%7.2f", leadel);
+        cmd = g_strdup_printf ("P %s %s\n", azstr, elstr);
+        log = server_log ();
+        if (strstr (log, cmd) == NULL) {
+            printf ("FAIL lead: \"%s\" not sent, got \"%s\"\n",
+                    g_strchomp (cmd), log);
+            failed++;
+        }
+        g_free (cmd);
+        g_free (log);
+        printf ("lead: set point %.2f %.2f, lead point %.2f %.2f\n",
+                setaz, setel, leadaz, leadel);
+    }
+
+    /* a broken rotctld */
+    if (num_failed != 0) {
+        printf ("FAIL %d cycles failed before rotctld broke\n", num_failed);
+        failed++;
+        num_failed = 0;
+    }
+    errors_in_row = 0;
+    g_atomic_int_set (&broken, 1);
+    if (!wait_for (&num_failed, 1, TIMEOUT)) {
+        printf ("FAIL disengage: no failure after %d failed cycles\n",
+                errors_in_row);
+        failed++;
+    }
+    else if (failed_after != MAX_ERROR_COUNT) {
+        printf ("FAIL disengage: failure after %d failed cycles, expected %d\n",
+                failed_after, MAX_ERROR_COUNT);
+        failed++;
+    }
+
+    rotor_loop_stop (loop);
+    wait_for (NULL, 0, DELAY);
+    free_ephemeris (&sat);
+
+    printf ("%d failures\n", failed);
+
+    return (failed > 0) ? 1 : 0;
+}
@@ -0,0 +1,375 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2012  Alexandru Csete.
+
+    Authors: Alexandru Csete <csete@users.sourceforge.net>
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, visit http://www.fsf.org/
+*/
+/** \defgroup test020 Regression test for the tracking scheduler
+ *  \ingroup tests
+ *
+ * Checks the two steps of the scheduler of the priority tracker
+ * (target-sat.c) on the passes of the ISS in test-012.tle over the test
+ * ground station on one day:
+ *
+ *  - schedule_window gives the part of a pass above the minimum elevation,
+ *    which is the whole pass for 0 degrees, and the position of the
+ *    satellite at both ends;
+ *  - schedule_insert cuts a window around a slot of higher priority and
+ *    keeps both parts, exactly up to the slot without slew rates, and
+ *    leaving the time to slew the rotator to and from the slot with slew
+ *    rates;
+ *  - a part that is shorter than the minimum communication time of the
+ *    satellite is dropped, and a window inside a slot of higher priority
+ *    gives nothing;
+ *  - the schedule stays in time order without overlaps.
+ *
+ * The TLE is read from the directory in the srcdir environment variable,
+ * which is set by "make check", or from the current directory.
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <glib.h>
+#include "sgp4sdp4.h"
+#include "test-common.h"
+#include "qth-data.h"
+#include "predict-tools.h"
+#include "target-sat.h"
+
+#define START       2454730.5      /* 2008-09-21 00:00 UTC */
+#define DAYS        1.0
+#define MIN_EL      10.0           /* [deg] */
+#define EL_TOL      0.05           /* [deg] */
+#define RATE        5.0            /* slew rate of the rotator [deg/sec] */
+#define SLEW_TOL    (1.0/secday)   /* error of the slew gaps */
+
+
+static qth_t  qth;
+static sat_t  sat;
+
+
+/* position of the satellite at t */
+static void
+position (double t, double *az, double *el)
+{
+    sat_t copy = sat;
+
+    predict_calc (&copy, &qth, t);
+    *az = copy.az;
+    *el = copy.el;
+}
+
+
+/* time to slew between two positions, like schedule_slew */
+static double
+slew (double az1, double el1, double az2, double el2)
+{
+    return MAX (fabs (az2 - az1) / RATE, fabs (el2 - el1) / RATE) / secday;
+}
+
+
+/* the slots of the schedule are in time order and do not overlap */
+static int
+check_order (TargetSat *target, const char *what)
+{
+    target_slot_t *a, *b;
+    guint          i;
+    int            failed = 0;
+
+    for (i = 0; i + 1 < target->schedule->len; i++) {
+        a = &g_array_index (target->schedule, target_slot_t, i);
+        b = &g_array_index (target->schedule, target_slot_t, i + 1);
+        if (a->start >= a->end || a->end > b->start) {
+            printf ("FAIL %s: slot %u [%.8f;%.8f] before [%.8f;%.8f]\n",
+                    what, i, a->start, a->end, b->start, b->end);
+            failed++;
+        }
+    }
+
+    return failed;
+}
+
+
+/* the ends of a slot have the position of the satellite */
+static int
+check_ends (const target_slot_t *slot, const char *what)
+{
+    double az, el;
+    int    failed = 0;
+
+    position (slot->start, &az, &el);
+    if (fabs (az - slot->startaz) > 1.0E-6 || fabs (el - slot->startel) > 1.0E-6) {
+        printf ("FAIL %s: start position %.3f %.3f expected %.3f %.3f\n",
+                what, slot->startaz, slot->startel, az, el);
+        failed++;
+    }
+    position (slot->end, &az, &el);
+    if (fabs (az - slot->endaz) > 1.0E-6 || fabs (el - slot->endel) > 1.0E-6) {
+        printf ("FAIL %s: end position %.3f %.3f expected %.3f %.3f\n",
+                what, slot->endaz, slot->endel, az, el);
+        failed++;
+    }
+
+    return failed;
+}
+
+
+static int
+check_time (const char *what, double res, double exp, double tol)
+{
+    if (fabs (res - exp) <= tol)
+        return 0;
+
+    printf ("FAIL %s: %.8f expected %.8f (%+.1f s)\n",
+            what, res, exp, (res - exp) * secday);
+
+    return 1;
+}
+
+
+static int
+check_len (TargetSat *target, guint len, const char *what)
+{
+    if (target->schedule->len == len)
+        return 0;
+
+    printf ("FAIL %s: %u slots, expected %u\n", what, target->schedule->len, len);
+
+    return 1;
+}
+
+
+/* the window of a pass above the minimum elevation */
+static int
+check_window (TargetSat *target, const pass_t *pass, target_slot_t *win)
+{
+    sat_t  copy = sat;
+    double az, el;
+    int    failed = 0;
+
+    memset (win, 0, sizeof (*win));
+    win->sat = &sat;
+    win->aos = pass->aos;
+    win->tca = pass->tca;
+    win->los = pass->los;
+    win->max_el = pass->max_el;
+
+    schedule_window (target, &qth, &copy, win);
+    failed += check_ends (win, "window");
+
+    if (target->minel <= 0.0) {
+        failed += check_time ("window start", win->start, pass->aos, 0.0);
+        failed += check_time ("window end", win->end, pass->los, 0.0);
+    }
+    else {
+        if (win->start <= pass->aos || win->start >= pass->tca ||
+            win->end <= pass->tca || win->end >= pass->los) {
+            printf ("FAIL window [%.8f;%.8f] not inside [%.8f;%.8f]\n",
+                    win->start, win->end, pass->aos, pass->los);
+            failed++;
+        }
+        position (win->start, &az, &el);
+        if (fabs (el - target->minel) > EL_TOL) {
+            printf ("FAIL window start elevation %.3f\n", el);
+            failed++;
+        }
+        position (win->end, &az, &el);
+        if (fabs (el - target->minel) > EL_TOL) {
+            printf ("FAIL window end elevation %.3f\n", el);
+            failed++;
+        }
+    }
+
+    return failed;
+}
+
+
+/* a slot of higher priority at a fraction of a window */
+static target_slot_t
+make_slot (const target_slot_t *win, double from, double to)
+{
+    target_slot_t x;
+    double        len = win->end - win->start;
+
+    memset (&x, 0, sizeof (x));
+    x.sat = &sat;
+    x.index = 1;
+    x.priority = 0;
+    x.start = win->start + from * len;
+    x.end = win->start + to * len;
+
+    /* somewhere else in the sky */
+    x.startaz = 20.0;
+    x.startel = 40.0;
+    x.endaz = 340.0;
+    x.endel = 10.0;
+
+    return x;
+}
+
+
+/* cut one window around slots of higher priority */
+static int
+check_insert (TargetSat *target, const target_slot_t *win)
+{
+    target_slot_t  x, *a, *b;
+    sat_t          copy;
+    double         len = win->end - win->start;
+    int            failed = 0;
+
+    /* without slew rates the window is cut exactly at the slot */
+    target->azrate = target->elrate = 0.0;
+    target->minCommunication[0] = 0.0f;
+    g_array_set_size (target->schedule, 0);
+    x = make_slot (win, 0.4, 0.6);
+    g_array_append_val (target->schedule, x);
+    copy = sat;
+    schedule_insert (target, &qth, &copy, win);
+    failed += check_len (target, 3, "cut");
+    failed += check_order (target, "cut");
+    if (target->schedule->len == 3) {
+        a = &g_array_index (target->schedule, target_slot_t, 0);
+        b = &g_array_index (target->schedule, target_slot_t, 2);
+        failed += check_time ("cut first start", a->start, win->start, 0.0);
+        failed += check_time ("cut first end", a->end, x.start, 0.0);
+        failed += check_time ("cut second start", b->start, x.end, 0.0);
+        failed += check_time ("cut second end", b->end, win->end, 0.0);
+        failed += check_ends (a, "cut first");
+        failed += check_ends (b, "cut second");
+    }
+
+    /* with slew rates the parts leave time to slew to and from the slot */
+    target->azrate = target->elrate = RATE;
+    g_array_set_size (target->schedule, 0);
+    g_array_append_val (target->schedule, x);
+    copy = sat;
+    schedule_insert (target, &qth, &copy, win);
+    failed += check_len (target, 3, "slew");
+    failed += check_order (target, "slew");
+    if (target->schedule->len == 3) {
+        a = &g_array_index (target->schedule, target_slot_t, 0);
+        b = &g_array_index (target->schedule, target_slot_t, 2);
+        failed += check_time ("slew first start", a->start, win->start, 0.0);
+        failed += check_time ("slew to the slot", a->end,
+                              x.start - slew (a->endaz, a->endel, x.startaz, x.startel),
+                              SLEW_TOL);
+        failed += check_time ("slew from the slot", b->start,
+                              x.end + slew (x.endaz, x.endel, b->startaz, b->startel),
+                              SLEW_TOL);
+        failed += check_time ("slew second end", b->end, win->end, 0.0);
+        failed += check_ends (a, "slew first");
+        failed += check_ends (b, "slew second");
+    }
+
+    /* a part shorter than the minimum communication time is dropped */
+    target->azrate = target->elrate = 0.0;
+    target->minCommunication[0] = (float) (0.4 * len * secday);
+    g_array_set_size (target->schedule, 0);
+    x = make_slot (win, 0.2, 0.3);
+    g_array_append_val (target->schedule, x);
+    copy = sat;
+    schedule_insert (target, &qth, &copy, win);
+    failed += check_len (target, 2, "min communication");
+    failed += check_order (target, "min communication");
+    if (target->schedule->len == 2) {
+        b = &g_array_index (target->schedule, target_slot_t, 1);
+        failed += check_time ("min communication start", b->start, x.end, 0.0);
+        failed += check_time ("min communication end", b->end, win->end, 0.0);
+    }
+
+    /* nothing is left of a window inside a slot of higher priority */
+    target->minCommunication[0] = 0.0f;
+    g_array_set_size (target->schedule, 0);
+    x = make_slot (win, -0.1, 1.1);
+    g_array_append_val (target->schedule, x);
+    copy = sat;
+    schedule_insert (target, &qth, &copy, win);
+    failed += check_len (target, 1, "covered");
+
+    /* a window well before a slot is kept as a whole, before it */
+    target->azrate = target->elrate = RATE;
+    g_array_set_size (target->schedule, 0);
+    x = make_slot (win, 3.0, 4.0);
+    g_array_append_val (target->schedule, x);
+    copy = sat;
+    schedule_insert (target, &qth, &copy, win);
+    failed += check_len (target, 2, "before");
+    failed += check_order (target, "before");
+    if (target->schedule->len == 2) {
+        a = &g_array_index (target->schedule, target_slot_t, 0);
+        failed += check_time ("before start", a->start, win->start, 0.0);
+        failed += check_time ("before end", a->end, win->end, 0.0);
+    }
+
+    return failed;
+}
+
+
+int
+main (void)
+{
+    TargetSat     *target;
+    target_slot_t  win;
+    GSList        *passes, *l;
+    sat_t          copy;
+    tle_t          tle;
+    int            num = 0;
+    int            failed = 0;
+
+
+    if (test_read_tle ("test-012.tle", &tle))
+        return 1;
+    test_init_tle (&sat, &tle);
+
+    memset (&qth, 0, sizeof (qth));
+    qth.lat = Degrees (test_obs.lat);
+    qth.lon = Degrees (test_obs.lon);
+    qth.alt = (gint) (test_obs.alt * 1000.0);
+
+    target = new_priority_queue (2);
+
+    copy = sat;
+    passes = get_passes_min_el (&copy, &qth, START, DAYS, 0, 0.0, TRUE);
+
+    for (l = passes; l != NULL; l = l->next, num++) {
+        target->minel = 0.0;
+        failed += check_window (target, PASS (l->data), &win);
+        failed += check_insert (target, &win);
+
+        if (PASS (l->data)->max_el > MIN_EL + 1.0) {
+            target->minel = MIN_EL;
+            failed += check_window (target, PASS (l->data), &win);
+            failed += check_insert (target, &win);
+        }
+    }
+
+    free_passes (passes);
+    free_priority_queue (target);
+    free_ephemeris (&sat);
+
+    printf ("%d passes, %d failures\n", num, failed);
+
+    return (failed > 0 || num == 0) ? 1 : 0;
+}
@@ -0,0 +1,156 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2012  Alexandru Csete.
+
+    Authors: Alexandru Csete <csete@users.sourceforge.net>
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the
+          Free Software Foundation, Inc.,
+      59 Temple Place, Suite 330,
+      Boston, MA  02111-1307
+      USA
+*/
+/** \ingroup testcommon */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "test-common.h"
+
+
+geodetic_t  test_obs = { 0.9724, 0.2108, 0.05, 0.0 };
+tle_t       test_tle[2];
+
+
+/** \brief Build the path of a data file.
+ *  \param path Buffer for the path.
+ *  \param size Size of path.
+ *  \param name The name of the file.
+ */
+void
+test_data_file (char *path, size_t size, const char *name)
+{
+    const char *dir = getenv ("srcdir");
+
+    snprintf (path, size, "%s/%s", (dir != NULL) ? dir : ".", name);
+}
+
+
+/** \brief Read the first element set of a data file.
+ *  \param name The name of the file.
+ *  \param tle Where the elements are stored.
+ *  \return 0 on success, 1 if the file could not be read.
+ */
+int
+test_read_tle (const char *name, tle_t *tle)
+{
+    FILE *fp;
+    char  path[1024];
+    char  tle_str[3][80];
+
+    test_data_file (path, sizeof (path), name);
+    fp = fopen (path, "r");
+    if (fp == NULL) {
+        printf ("Could not open %s\n", path);
+        return 1;
+    }
+
+    if (fgets (tle_str[0], 80, fp) == NULL ||
+        fgets (tle_str[1], 80, fp) == NULL ||
+        fgets (tle_str[2], 80, fp) == NULL ||
+        Get_Next_Tle_Set (tle_str, tle) != 1) {
+        printf ("Could not read TLE data from %s\n", path);
+        fclose (fp);
+        return 1;
+    }
+
+    fclose (fp);
+
+    return 0;
+}
+
+
+/** \brief Read test-001.tle and test-002.tle into test_tle.
+ *  \return 0 on success, 1 on error.
+ */
+int
+test_read_base (void)
+{
+    return test_read_tle ("test-001.tle", &test_tle[0]) ||
+           test_read_tle ("test-002.tle", &test_tle[1]);
+}
+
+
+/** \brief Elements of satellite number idx of a test catalogue.
+ *  \param tle Where the elements are stored.
+ *  \param idx The number of the satellite.
+ *  \param dmo Mean anomaly step between satellites [deg].
+ *  \param dnode RAAN step between satellites [deg].
+ *
+ * Even numbers are derived from test_tle[0] (SGP4), odd numbers from
+ * test_tle[1] (SDP4). Each one gets a slightly different orbit and its
+ * own catalogue number.
+ */
+void
+test_vary_tle (tle_t *tle, unsigned int idx, double dmo, double dnode)
+{
+    *tle = test_tle[idx % 2];
+    tle->xmo = fmod (tle->xmo + dmo * idx, 360.0);
+    tle->xnodeo = fmod (tle->xnodeo + dnode * idx, 360.0);
+    tle->catnr += idx;
+}
+
+
+/** \brief Initialise a satellite from unprocessed elements.
+ *  \param sat The satellite.
+ *  \param tle The elements, e.g. from test_vary_tle().
+ *
+ * The propagator model must be released with free_ephemeris().
+ */
+void
+test_init_tle (sat_t *sat, const tle_t *tle)
+{
+    memset (sat, 0, sizeof (sat_t));
+
+    sat->tle = *tle;
+    sat->flags = 0;
+    select_ephemeris (sat);
+    sat->jul_epoch = Julian_Date_of_Epoch (sat->tle.epoch);
+}
+
+
+/** \brief Initialise satellite number idx of a test catalogue.
+ *  \param sat The satellite.
+ *  \param idx The number of the satellite.
+ *  \param dmo Mean anomaly step between satellites [deg].
+ *  \param dnode RAAN step between satellites [deg].
+ *
+ * See test_vary_tle() and test_init_tle().
+ */
+void
+test_init_sat (sat_t *sat, unsigned int idx, double dmo, double dnode)
+{
+    tle_t tle;
+
+    test_vary_tle (&tle, idx, dmo, dnode);
+    test_init_tle (sat, &tle);
+}
@@ -0,0 +1,68 @@
+/* -*- Mode: C; tab-width: 4; indent-tabs-mode: nil; c-basic-offset: 4 -*- */
+/*
+    Gpredict: Real-time satellite tracking and orbit prediction program
+
+    Copyright (C)  2001-2012  Alexandru Csete.
+
+    Authors: Alexandru Csete <csete@users.sourceforge.net>
+
+    Comments, questions and bugreports should be submitted via
+    http://sourceforge.net/projects/gpredict/
+    More details can be found at the project home page:
+
+            http://gpredict.oz9aec.net/
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the
+          Free Software Foundation, Inc.,
+      59 Temple Place, Suite 330,
+      Boston, MA  02111-1307
+      USA
+*/
+/** \defgroup testcommon Fixtures shared by the test programs
+ *  \ingroup tests
+ *
+ * The test programs derive their satellite catalogues from the SGP4
+ * satellite in test-001.tle and the SDP4 satellite in test-002.tle and
+ * observe them from the same ground station.
+ *
+ * Data files are read from the directory in the srcdir environment
+ * variable, which is set by "make check", or from the current directory.
+ */
+#ifndef TEST_COMMON_H
+#define TEST_COMMON_H 1
+
+#include <stddef.h>
+#include "sgp4sdp4.h"
+
+/** \brief Default mean anomaly step between catalogue satellites [deg]. */
+#define TEST_DMO    7.3
+
+/** \brief Default RAAN step between catalogue satellites [deg]. */
+#define TEST_DNODE  11.1
+
+/** \brief The ground station, ~55.7N 12.1E. */
+extern geodetic_t  test_obs;
+
+/** \brief The elements of test-001.tle (SGP4) and test-002.tle (SDP4). */
+extern tle_t       test_tle[2];
+
+
+void test_data_file (char *path, size_t size, const char *name);
+int  test_read_tle  (const char *name, tle_t *tle);
+int  test_read_base (void);
+void test_vary_tle  (tle_t *tle, unsigned int idx, double dmo, double dnode);
+void test_init_tle  (sat_t *sat, const tle_t *tle);
+void test_init_sat  (sat_t *sat, unsigned int idx, double dmo, double dnode);
+
+#endif
@@ -26,8 +26,12 @@
   along with this program; if not, visit http://www.fsf.org/
 */
 
+#include <math.h>
+#include <string.h>
 #include "target-sat.h"
 #include "sat-log.h"
+#include "sat-cfg.h"
+#include "time-tools.h"
 
 #ifdef HAVE_CONFIG_H
 #  include <build-config.h>
@@ -48,22 +52,79 @@
 #define FMTSTR "%7.2f\302\260"
 #define MAX_ERROR_COUNT 5
 
+/** \brief Time covered by the schedule [days]. */
+#define SCHED_HORIZON 1.0
+
+/** \brief Age of the schedule when it is computed again [days]. */
+#define SCHED_RENEW   0.5
+
+/** \brief Iterations for the slew time, which depends on where the slew starts. */
+#define SCHED_SLEW_ITER 3
+
+
+static gboolean schedule_outdated (TargetSat *target);
+static void    schedule_build  (TargetSat *target, qth_t *qth, gdouble t);
+static void    schedule_build_cb (pass_job_t *job, gpointer data);
+static void    schedule_point  (sat_t *sat, qth_t *qth, gdouble t,
+                                gdouble *az, gdouble *el);
+static gdouble schedule_slew   (TargetSat *target, gdouble az1, gdouble el1,
+                                gdouble az2, gdouble el2);
+
 TargetSat *
         new_priority_queue(int num_sats)
 {
     TargetSat *t = malloc(sizeof(TargetSat));
+    int i;
 
     t->numSatToTrack = 0;
     t->sats = malloc(sizeof(int)*num_sats);
     t->minCommunication = malloc(sizeof(float)*num_sats);
     t->priorityQueue = malloc(sizeof(int)*num_sats);
+    for(i = 0; i < num_sats; i++){
+        t->sats[i] = NOT_IN_PRIORITY_QUEUE;
+        t->minCommunication[i] = 0.0f;
+    }
 
     t->targeting = NULL;
     t->pass = NULL;
 
+    t->numSats = 0;
+    t->satv = NULL;
+    t->epoch = NULL;
+    t->schedule = g_array_new (FALSE, FALSE, sizeof (target_slot_t));
+    t->current = 0;
+    t->start = 0.0;
+    t->end = 0.0;
+    t->minel = 0.0;
+    t->azrate = 0.0;
+    t->elrate = 0.0;
+    memset (&t->qth, 0, sizeof (qth_small_t));
+    t->dirty = TRUE;
+    t->job = NULL;
+    t->jobqth = NULL;
+
+    t->ref_count = 1;
+    t->serial = 0;
+    t->target_serial = 0;
+
     return t;
 }
 
+/** \brief Share a priority queue.
+ *  \param target The priority queue.
+ *  \return The priority queue, which must be released with free_priority_queue.
+ *
+ * The radio and the rotator controller of a module use the same queue, so
+ * they track the same satellites and the schedule is computed once.
+ */
+TargetSat *
+        ref_priority_queue(TargetSat *target)
+{
+    target->ref_count++;
+
+    return target;
+}
+
 void
         append_elem_priority_queue(TargetSat *target, int i)
 {
@@ -74,6 +135,8 @@ void
 
     target->priorityQueue[n-1] = i;
     target->sats[i] = n-1;
+    target->dirty = TRUE;
+    target->serial++;
 }
 
 void
@@ -95,11 +158,8 @@ void
         target->priorityQueue[j] = NOT_IN_PRIORITY_QUEUE;
 
         target->numSatToTrack--;
-
-        if(target->numSatToTrack == 0){
-            target->targeting = NULL;
-            target->pass = NULL;
-        }
+        target->dirty = TRUE;
+        target->serial++;
     }
 }
 
@@ -115,6 +175,8 @@ void
     target->priorityQueue[j] = target->priorityQueue[i];
     target->priorityQueue[i] = aux;
 
+    target->dirty = TRUE;
+    target->serial++;
 }
 
 int get_elem_index_priority_queue(TargetSat *target, int i){
@@ -127,3 +189,486 @@ int get_elem_index_priority_queue(TargetSat *target, int i){
     }
     return j;
 }
+
+/** \brief Set the satellites that the indices refer to.
+ *  \param target The priority queue.
+ *  \param sats The satellites of the controller in the order of their indices.
+ *
+ * The satellites are kept in an array, so the scheduler does not have to
+ * walk the list to find a satellite.
+ */
+void
+        set_sats_priority_queue(TargetSat *target, GSList *sats)
+{
+    GSList *l;
+    int i = 0;
+
+    g_free(target->satv);
+    g_free(target->epoch);
+
+    target->numSats = g_slist_length(sats);
+    target->satv = g_new(sat_t *, target->numSats);
+    target->epoch = g_new0(gdouble, target->numSats);
+    for(l = sats; l != NULL; l = l->next)
+        target->satv[i++] = SAT(l->data);
+
+    target->dirty = TRUE;
+}
+
+/** \brief Set the slew rates of the rotator.
+ *  \param target The priority queue.
+ *  \param azrate The azimuth rate [deg/sec]; 0 if unknown.
+ *  \param elrate The elevation rate [deg/sec]; 0 if unknown.
+ *
+ * The scheduler leaves time between two satellites to move the rotator
+ * from one to the other. Use 0 for both rates when there is no rotator.
+ */
+void
+        set_slew_priority_queue(TargetSat *target, gdouble azrate, gdouble elrate)
+{
+    if(azrate != target->azrate || elrate != target->elrate){
+        target->azrate = azrate;
+        target->elrate = elrate;
+        target->dirty = TRUE;
+    }
+}
+
+/** \brief Compute the schedule again on the next update.
+ *  \param target The priority queue.
+ *
+ * Call this when something that the schedule depends on has changed outside
+ * of the priority queue functions, e.g. the minimum communication time. The
+ * other controllers sharing the queue see it as a change of the queue.
+ */
+void
+        invalidate_priority_queue(TargetSat *target)
+{
+    target->dirty = TRUE;
+    target->serial++;
+}
+
+/** \brief Update the target from the schedule.
+ *  \param target The priority queue.
+ *  \param qth The QTH.
+ *  \param t The current time (Julian date).
+ *  \param serial The target_serial that the caller has seen last; it is
+ *                updated. Start with 0.
+ *  \return TRUE if the target or its pass has changed since the last call
+ *          with \a serial.
+ *
+ * A new schedule is computed if the queue, the minimum communication
+ * times, the slew rates, the minimum elevation, the QTH or the TLE of a
+ * queued satellite have changed, if t is before the schedule, or when half
+ * of it has passed. The passes are predicted by the pass prediction service
+ * and the previous schedule is used until they are done. Otherwise this is
+ * a lookup of the slot at t, or of the next slot if t is between two slots
+ * so that the rotator moves there in time.
+ *
+ * The target is stored in target->targeting and target->pass; the pass is
+ * owned by the priority queue. Each controller sharing the queue passes
+ * its own \a serial, so each one learns about a new target.
+ */
+gboolean
+        schedule_priority_queue(TargetSat *target, qth_t *qth, gdouble t, guint *serial)
+{
+    target_slot_t *slot = NULL;
+    gboolean same = FALSE;
+
+    if(schedule_outdated(target) || (t < target->start) || (t > target->start + SCHED_RENEW) ||
+       (target->minel != sat_cfg_get_snapshot()->pred_min_el) ||
+       (qth_small_dist(qth, target->qth) > 1.0)){
+        schedule_build(target, qth, t);
+    }
+
+    /* skip the slots that have ended */
+    while(target->current < target->schedule->len &&
+          g_array_index(target->schedule, target_slot_t, target->current).end <= t)
+        target->current++;
+
+    if(target->current < target->schedule->len)
+        slot = &g_array_index(target->schedule, target_slot_t, target->current);
+
+    /* nothing to do if the target and its pass are the same */
+    if(slot == NULL){
+        same = (target->targeting == NULL);
+    }
+    else if(slot->sat == target->targeting){
+        if(target->pass == NULL && slot->aos == 0.0)
+            same = TRUE;
+        if(target->pass != NULL && slot->aos > 0.0 &&
+           fabs(target->pass->aos - slot->aos) < 60.0/secday)
+            same = TRUE;
+    }
+
+    if(!same){
+        if(target->pass != NULL){
+            free_pass(target->pass);
+            target->pass = NULL;
+        }
+
+        if(slot == NULL){
+            target->targeting = NULL;
+        }
+        else{
+            target->targeting = slot->sat;
+
+            /* the pass is ongoing at its TCA */
+            if(slot->aos > 0.0)
+                target->pass = get_pass(slot->sat, qth, slot->tca, 3.0);
+        }
+
+        target->target_serial++;
+    }
+
+    if(*serial == target->target_serial)
+        return FALSE;
+
+    *serial = target->target_serial;
+
+    return TRUE;
+}
+
+/** \brief Export the schedule as text.
+ *  \param target The priority queue.
+ *  \return The schedule, one slot per line; free it with g_free.
+ *
+ * While a new schedule is predicted the previous one is exported.
+ */
+gchar *
+        export_priority_queue(TargetSat *target)
+{
+    GString *str;
+    target_slot_t *slot;
+    gchar *fmtstr;
+    gchar start[TIME_FORMAT_MAX_LENGTH], end[TIME_FORMAT_MAX_LENGTH];
+    guint i;
+
+    fmtstr = sat_cfg_get_str(SAT_CFG_STR_TIME_FORMAT);
+    str = g_string_new(NULL);
+
+    daynum_to_str(start, TIME_FORMAT_MAX_LENGTH, fmtstr, target->start);
+    daynum_to_str(end, TIME_FORMAT_MAX_LENGTH, fmtstr, target->end);
+    g_string_append_printf(str, _("Tracking schedule from %s to %s\n"), start, end);
+    g_string_append_printf(str, _("Minimum elevation: %.0f\302\260\n\n"), target->minel);
+    g_string_append_printf(str, "%-*s %-*s %8s %7s %4s  %s\n",
+                           (int) strlen(start), _("Start"), (int) strlen(end), _("End"),
+                           _("Dur (s)"), _("Max El"), _("Prio"), _("Satellite"));
+
+    for(i = 0; i < target->schedule->len; i++){
+        slot = &g_array_index(target->schedule, target_slot_t, i);
+        daynum_to_str(start, TIME_FORMAT_MAX_LENGTH, fmtstr, slot->start);
+        daynum_to_str(end, TIME_FORMAT_MAX_LENGTH, fmtstr, slot->end);
+        g_string_append_printf(str, "%s %s %8.0f %7.1f %4d  %s\n",
+                               start, end, (slot->end - slot->start) * secday,
+                               slot->max_el, slot->priority + 1, slot->sat->nickname);
+    }
+
+    g_free(fmtstr);
+
+    return g_string_free(str, FALSE);
+}
+
+/** \brief Release a priority queue.
+ *  \param target The priority queue.
+ *
+ * The queue and its schedule are freed with the last reference; a
+ * prediction that is still running is cancelled.
+ */
+void
+        free_priority_queue(TargetSat *target)
+{
+    if(--target->ref_count > 0)
+        return;
+
+    pass_job_free(target->job);
+
+    if(target->pass != NULL)
+        free_pass(target->pass);
+
+    g_array_free(target->schedule, TRUE);
+    g_free(target->satv);
+    g_free(target->epoch);
+    free(target->sats);
+    free(target->minCommunication);
+    free(target->priorityQueue);
+    free(target);
+}
+
+/** \brief Check whether the schedule is out of date.
+ *  \param target The priority queue.
+ *  \return TRUE if the queue, its parameters or the TLE of a queued
+ *          satellite have changed since the schedule was started.
+ */
+static gboolean
+        schedule_outdated(TargetSat *target)
+{
+    int i, idx;
+
+    for(i = 0; i < target->numSatToTrack && !target->dirty; i++){
+        idx = target->priorityQueue[i];
+        if(target->satv[idx]->tle.epoch != target->epoch[idx])
+            target->dirty = TRUE;
+    }
+
+    return target->dirty;
+}
+
+/** \brief Start the computation of a new schedule.
+ *  \param target The priority queue.
+ *  \param qth The QTH; it must exist until the prediction is done.
+ *  \param t The start of the schedule (Julian date).
+ *
+ * The pass summaries of the queued satellites are predicted by the pass
+ * prediction service outside of the main loop, and schedule_build_cb
+ * replaces the schedule when they are done. The parameters of the new
+ * schedule are stored right away, so it is not started again on every
+ * update. A prediction that is still running is cancelled.
+ */
+static void
+        schedule_build(TargetSat *target, qth_t *qth, gdouble t)
+{
+    pass_filter_t filter;
+    int i, idx;
+
+    pass_job_free(target->job);
+
+    target->start = t;
+    target->end = t + SCHED_HORIZON;
+    target->minel = sat_cfg_get_snapshot()->pred_min_el;
+    qth_small_save(qth, &target->qth);
+    target->dirty = FALSE;
+
+    filter.num = 0;
+    filter.min_el = target->minel;
+    filter.visible = FALSE;
+    filter.summary = TRUE;
+
+    target->jobqth = qth;
+    target->job = pass_job_new(qth, &filter, NULL, schedule_build_cb, target);
+
+    /* one satellite per queue entry, in the order of their priority */
+    for(i = 0; i < target->numSatToTrack; i++){
+        idx = target->priorityQueue[i];
+        target->epoch[idx] = target->satv[idx]->tle.epoch;
+        pass_job_add(target->job, target->satv[idx], t, target->end);
+    }
+
+    pass_job_start(target->job);
+}
+
+/** \brief Compute the schedule from the predicted passes.
+ *  \param job The finished prediction.
+ *  \param data The priority queue.
+ *
+ * This function is called in the main loop by the pass prediction service.
+ * The satellites are scheduled in the order of their priority. Each one
+ * gets the parts of its passes above the minimum elevation that are not
+ * used by a satellite of higher priority, including the time needed to
+ * slew the rotator to and from it. Parts shorter than the minimum
+ * communication time of the satellite are dropped.
+ *
+ * If the queue has changed since the prediction was started, the passes
+ * are dropped and the next update starts a new prediction.
+ */
+static void
+        schedule_build_cb(pass_job_t *job, gpointer data)
+{
+    TargetSat *target = (TargetSat *) data;
+    qth_t *qth = target->jobqth;
+    target_slot_t win;
+    GSList *passes, *l;
+    pass_t *pass;
+    sat_t *sat, copy;
+    gdouble t = target->start;
+    int i, idx;
+
+    target->job = NULL;
+
+    if(schedule_outdated(target)){
+        pass_job_free(job);
+        return;
+    }
+
+    g_array_set_size(target->schedule, 0);
+    target->current = 0;
+
+    for(i = 0; i < target->numSatToTrack; i++){
+        idx = target->priorityQueue[i];
+        sat = target->satv[idx];
+
+        /* the crossings are searched on a copy; the live satellite is not changed */
+        memcpy(&copy, sat, sizeof(sat_t));
+
+        memset(&win, 0, sizeof(target_slot_t));
+        win.sat = sat;
+        win.index = idx;
+        win.priority = i;
+
+        passes = pass_job_steal_passes(job, i);
+        if(passes == NULL){
+            /* a satellite that does not set, e.g. a geostationary one */
+            predict_calc(&copy, qth, t);
+            if(copy.el >= MAX(target->minel, 0.0)){
+                win.start = t;
+                win.end = target->end;
+                win.max_el = copy.el;
+                win.startaz = win.endaz = copy.az;
+                win.startel = win.endel = copy.el;
+                schedule_insert(target, qth, &copy, &win);
+            }
+        }
+
+        for(l = passes; l != NULL; l = l->next){
+            pass = PASS(l->data);
+            win.aos = pass->aos;
+            win.tca = pass->tca;
+            win.los = pass->los;
+            win.max_el = pass->max_el;
+            schedule_window(target, qth, &copy, &win);
+            if(win.end > t)
+                schedule_insert(target, qth, &copy, &win);
+        }
+        free_passes(passes);
+    }
+
+    pass_job_free(job);
+
+    sat_log_log(SAT_LOG_LEVEL_INFO,
+                _("%s: Scheduled %d slots for %d satellites in [%f;%f]"),
+                __FUNCTION__, target->schedule->len, target->numSatToTrack,
+                target->start, target->end);
+}
+
+/** \brief Find the part of a pass above the minimum elevation.
+ *  \param target The priority queue.
+ *  \param qth The QTH.
+ *  \param sat A copy of the satellite, which is propagated.
+ *  \param win The pass; start, end and the positions there are set.
+ */
+void
+        schedule_window(TargetSat *target, qth_t *qth, sat_t *sat, target_slot_t *win)
+{
+    gdouble t;
+
+    win->start = win->aos;
+    win->end = win->los;
+
+    if(target->minel > 0.0){
+        t = find_aos(sat, qth, win->aos, win->tca - win->aos, target->minel);
+        if(t > 0.0 && t < win->tca)
+            win->start = t;
+        t = find_los(sat, qth, win->tca, win->los - win->tca, target->minel);
+        if(t > win->tca)
+            win->end = t;
+    }
+
+    schedule_point(sat, qth, win->start, &win->startaz, &win->startel);
+    schedule_point(sat, qth, win->end, &win->endaz, &win->endel);
+}
+
+/** \brief Add the free parts of a window to the schedule.
+ *  \param target The priority queue.
+ *  \param qth The QTH.
+ *  \param sat A copy of the satellite, which is propagated.
+ *  \param win The window.
+ *
+ * The schedule holds the slots of the satellites with higher priority. The
+ * window is cut where it overlaps them, leaving time to slew the rotator
+ * between the satellites, and the remaining parts that are long enough are
+ * inserted in time order. The slew time depends on the position of the
+ * satellite at the cut, so the cut is found by a few fixed point iterations.
+ */
+void
+        schedule_insert(TargetSat *target, qth_t *qth, sat_t *sat, const target_slot_t *win)
+{
+    target_slot_t *x, piece;
+    gdouble min, maxslew, cur, last, next, az, el;
+    guint i, n;
+
+    min = target->minCommunication[win->index] / secday;
+    maxslew = schedule_slew(target, 0.0, 0.0, 360.0, 180.0);
+    cur = win->start;
+
+    for(i = 0; i <= target->schedule->len; i++){
+        x = NULL;
+        last = win->end;
+
+        if(i < target->schedule->len){
+            x = &g_array_index(target->schedule, target_slot_t, i);
+
+            /* x is well before the remaining window */
+            if(x->end + maxslew <= cur)
+                continue;
+
+            /* the last time before x that leaves time to slew to x */
+            if(x->start - maxslew < win->end){
+                last = x->start;
+                for(n = 0; n < SCHED_SLEW_ITER; n++){
+                    schedule_point(sat, qth, last, &az, &el);
+                    last = x->start - schedule_slew(target, az, el, x->startaz, x->startel);
+                }
+                last = MIN(win->end, last);
+            }
+        }
+
+        if(last > cur && last - cur >= min){
+            piece = *win;
+            piece.start = cur;
+            piece.end = last;
+            if(cur != win->start)
+                schedule_point(sat, qth, cur, &piece.startaz, &piece.startel);
+            if(last != win->end)
+                schedule_point(sat, qth, last, &piece.endaz, &piece.endel);
+            g_array_insert_val(target->schedule, i, piece);
+            i++;
+            x = (x != NULL) ? &g_array_index(target->schedule, target_slot_t, i) : NULL;
+        }
+
+        /* the window ends before x */
+        if(x == NULL || last >= win->end)
+            break;
+
+        /* continue after x, leaving time to slew from x */
+        next = x->end;
+        for(n = 0; n < SCHED_SLEW_ITER; n++){
+            schedule_point(sat, qth, next, &az, &el);
+            next = x->end + schedule_slew(target, x->endaz, x->endel, az, el);
+        }
+        cur = MAX(cur, next);
+        if(cur >= win->end)
+            break;
+    }
+}
+
+/** \brief Position of a satellite at a given time.
+ *  \param sat The satellite, which is propagated.
+ *  \param qth The QTH.
+ *  \param t The time (Julian date).
+ *  \param az Where the azimuth is stored [deg].
+ *  \param el Where the elevation is stored [deg].
+ */
+static void
+        schedule_point(sat_t *sat, qth_t *qth, gdouble t, gdouble *az, gdouble *el)
+{
+    predict_calc(sat, qth, t);
+    *az = sat->az;
+    *el = sat->el;
+}
+
+/** \brief Time to slew the rotator between two positions [days].
+ *
+ * The axes move at the same time. The azimuth is not wrapped, as a rotator
+ * with its stop at north can not cross it.
+ */
+static gdouble
+        schedule_slew(TargetSat *target, gdouble az1, gdouble el1, gdouble az2, gdouble el2)
+{
+    gdouble taz = 0.0, tel = 0.0;
+
+    if(target->azrate > 0.0)
+        taz = fabs(az2 - az1) / target->azrate;
+    if(target->elrate > 0.0)
+        tel = fabs(el2 - el1) / target->elrate;
+
+    return MAX(taz, tel) / secday;
+}
@@ -29,6 +29,7 @@
 #define __TARGET_SAT_H__ 1
 
 #include "predict-tools.h"
+#include "pass-service.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -50,6 +51,23 @@ enum {
     N_COLUMN_PRIORITY
 };
 
+/** \brief A scheduled tracking interval of one satellite. */
+typedef struct {
+    sat_t   *sat;       /*!< The satellite */
+    int      index;     /*!< Index of the satellite */
+    int      priority;  /*!< Position in the priority queue */
+    gdouble  start;     /*!< Start of tracking (Julian date) */
+    gdouble  end;       /*!< End of tracking (Julian date) */
+    gdouble  aos;       /*!< AOS of the pass; 0 if the satellite is always up */
+    gdouble  tca;       /*!< Time of the maximum elevation of the pass */
+    gdouble  los;       /*!< LOS of the pass */
+    gdouble  max_el;    /*!< Maximum elevation of the pass */
+    gdouble  startaz;   /*!< Azimuth at start */
+    gdouble  startel;   /*!< Elevation at start */
+    gdouble  endaz;     /*!< Azimuth at end */
+    gdouble  endel;     /*!< Elevation at end */
+} target_slot_t;
+
 struct _target_sat
 {
     int numSatToTrack;              /*!< Number of satellites in the list */
@@ -58,13 +76,45 @@ struct _target_sat
     float * minCommunication;        /*!< Minimun communication time of the satellite */
     sat_t *targeting;
     pass_t *pass;
+
+    /* schedule */
+    int          numSats;           /*!< Number of satellites in satv */
+    sat_t      **satv;              /*!< Satellite of each index */
+    gdouble     *epoch;             /*!< TLE epoch of each satellite in the schedule */
+    GArray      *schedule;          /*!< The target_slot_t in time order */
+    guint        current;           /*!< Slot of the target */
+    gdouble      start;             /*!< Start of the schedule (Julian date) */
+    gdouble      end;               /*!< End of the schedule (Julian date) */
+    gdouble      minel;             /*!< Minimum elevation of the schedule [deg] */
+    gdouble      azrate;            /*!< Rotator azimuth rate [deg/sec]; 0 = no slew time */
+    gdouble      elrate;            /*!< Rotator elevation rate [deg/sec]; 0 = no slew time */
+    qth_small_t  qth;               /*!< QTH of the schedule */
+    gboolean     dirty;             /*!< The schedule has to be recomputed */
+    pass_job_t  *job;               /*!< Prediction of the next schedule, or NULL */
+    qth_t       *jobqth;            /*!< QTH of the running prediction */
+
+    /* sharing */
+    gint         ref_count;         /*!< Number of controllers using the queue */
+    guint        serial;            /*!< Incremented when the queue changes */
+    guint        target_serial;     /*!< Incremented when the target or its pass changes */
 };
 
 TargetSat *new_priority_queue(int num_sats);
+TargetSat *ref_priority_queue(TargetSat *target);
 void append_elem_priority_queue(TargetSat* target, int i);
 void remove_elem_priority_queue(TargetSat* target, int i);
 void swap_elem_priority_queue(TargetSat* target, int i, int j);
 int get_elem_index_priority_queue(TargetSat *target, int i);
+void set_sats_priority_queue(TargetSat *target, GSList *sats);
+void set_slew_priority_queue(TargetSat *target, gdouble azrate, gdouble elrate);
+void invalidate_priority_queue(TargetSat *target);
+gboolean schedule_priority_queue(TargetSat *target, qth_t *qth, gdouble t, guint *serial);
+gchar *export_priority_queue(TargetSat *target);
+void free_priority_queue(TargetSat *target);
+
+/* steps of the scheduler, public for test-020 */
+void schedule_window(TargetSat *target, qth_t *qth, sat_t *sat, target_slot_t *win);
+void schedule_insert(TargetSat *target, qth_t *qth, sat_t *sat, const target_slot_t *win);
 
 #ifdef __cplusplus
 }